@@ -0,0 +1,70 @@
+/**
+ * @file    Benchmark.h
+ * @brief   Minimal timing helpers shared by the microbenchmarks
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+#include <chrono>
+#include <cstdio>
+
+class BenchTimer
+{
+	public:
+		BenchTimer() : m_start(std::chrono::steady_clock::now()) {}
+
+		inline void reset() { m_start = std::chrono::steady_clock::now(); }
+
+		inline double elapsedSeconds() const
+		{
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+		}
+
+		inline double elapsedMilliseconds() const { return elapsedSeconds() * 1e3; }
+	private:
+		std::chrono::steady_clock::time_point m_start;
+};
+
+/**
+ * Run fn() until at least minSeconds have passed (and at least once),
+ * return the average seconds per run.
+ */
+template<typename Fn>
+inline double benchRepeat(Fn fn, double minSeconds = 0.25)
+{
+	size_t runs = 0;
+	BenchTimer timer;
+	do
+	{
+		fn();
+		runs++;
+	} while (timer.elapsedSeconds() < minSeconds);
+
+	return timer.elapsedSeconds() / runs;
+}
+
+/**
+ * Keep the optimizer from discarding a computed value.
+ */
+template<typename T>
+inline void benchKeep(const T& value)
+{
+	asm volatile("" : : "g"(&value) : "memory");
+}
+#endif // __BENCHMARK_H__
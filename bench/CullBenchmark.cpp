@@ -0,0 +1,122 @@
+/**
+ * @file    CullBenchmark.cpp
+ * @brief   Frustum culling of 100k boxes and spheres, scalar against batched
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "Benchmark.h"
+#include "util/Frustum.h"
+
+#include <algorithm>
+#include <vector>
+
+static const size_t COUNT = 100000;
+static const float WORLD = 2000.0f;  // volumes spread over a cube this wide around the camera
+
+static inline uint32_t xorshift(uint32_t& state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+static inline float uniform(uint32_t& state, float lo, float hi)
+{
+	return lo + (hi - lo) * (xorshift(state) >> 8) * (1.0f / 16777216.0f);
+}
+
+int main(int argc, char const *argv[])
+{
+	const glm::mat4 projection = glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+	const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 20.0f, 0.0f), glm::vec3(1.0f, 19.5f, 0.3f), glm::vec3(0.0f, 1.0f, 0.0f));
+	const Frustum frustum(projection * view);
+
+	uint32_t state = 0x9E3779B9u;
+	std::vector<glm::vec3> mins(COUNT), maxs(COUNT), centers(COUNT);
+	std::vector<float> radii(COUNT);
+	BoxBatch boxes;
+	SphereBatch spheres;
+	boxes.reserve(COUNT);
+	spheres.reserve(COUNT);
+	for (size_t i = 0; i < COUNT; i++)
+	{
+		const glm::vec3 center(uniform(state, -WORLD, WORLD) * 0.5f, uniform(state, -WORLD, WORLD) * 0.05f, uniform(state, -WORLD, WORLD) * 0.5f);
+		const glm::vec3 half(uniform(state, 1.0f, 16.0f), uniform(state, 1.0f, 16.0f), uniform(state, 1.0f, 16.0f));
+		mins[i] = center - half;
+		maxs[i] = center + half;
+		boxes.add(mins[i], maxs[i]);
+
+		centers[i] = center;
+		radii[i] = glm::length(half);
+		spheres.add(centers[i], radii[i]);
+	}
+
+	std::vector<uint32_t> expected(COUNT), actual(COUNT);
+	size_t expectedCount = 0, actualCount = 0;
+	bool identical = true;
+
+	printf("Frustum culling benchmark (%zu volumes, %s batches)\n", COUNT, Frustum::simdName());
+
+	double scalar = benchRepeat([&]() {
+		expectedCount = 0;
+		for (size_t i = 0; i < COUNT; i++)
+		{
+			if (frustum.testBox(mins[i], maxs[i]))
+				expected[expectedCount++] = static_cast<uint32_t>(i);
+		}
+		benchKeep(expected);
+	});
+	double batched = benchRepeat([&]() {
+		actualCount = frustum.cull(boxes, actual.data());
+		benchKeep(actual);
+	});
+
+	printf("  boxes:   %zu visible (%.1f%%)\n", actualCount, 100.0 * actualCount / COUNT);
+	printf("    scalar testBox       %8.3f ms/frame  %6.2f ns/box\n", scalar * 1e3, scalar * 1e9 / COUNT);
+	printf("    batched cull         %8.3f ms/frame  %6.2f ns/box  %5.2fx\n", batched * 1e3, batched * 1e9 / COUNT, scalar / batched);
+	if (expectedCount != actualCount || !std::equal(expected.begin(), expected.begin() + expectedCount, actual.begin()))
+	{
+		printf("  MISMATCH: batched box culling differs from testBox\n");
+		identical = false;
+	}
+
+	scalar = benchRepeat([&]() {
+		expectedCount = 0;
+		for (size_t i = 0; i < COUNT; i++)
+		{
+			if (frustum.testSphere(centers[i], radii[i]))
+				expected[expectedCount++] = static_cast<uint32_t>(i);
+		}
+		benchKeep(expected);
+	});
+	batched = benchRepeat([&]() {
+		actualCount = frustum.cull(spheres, actual.data());
+		benchKeep(actual);
+	});
+
+	printf("  spheres: %zu visible (%.1f%%)\n", actualCount, 100.0 * actualCount / COUNT);
+	printf("    scalar testSphere    %8.3f ms/frame  %6.2f ns/sphere\n", scalar * 1e3, scalar * 1e9 / COUNT);
+	printf("    batched cull         %8.3f ms/frame  %6.2f ns/sphere  %5.2fx\n", batched * 1e3, batched * 1e9 / COUNT, scalar / batched);
+	if (expectedCount != actualCount || !std::equal(expected.begin(), expected.begin() + expectedCount, actual.begin()))
+	{
+		printf("  MISMATCH: batched sphere culling differs from testSphere\n");
+		identical = false;
+	}
+
+	return identical ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file    LightGridBenchmark.cpp
+ * @brief   Light to cluster assignment of a 16 x 9 x 24 grid, one thread against the pool
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "Benchmark.h"
+#include "lighting/LightGrid.h"
+
+#include <algorithm>
+#include <vector>
+
+static const size_t COUNTS[] = { 256, 1024, 4096, 16384 };
+static const float VIEW_DEPTH = 1500.0f;  // lights spread over the view frustum up to this depth
+
+static inline uint32_t xorshift(uint32_t& state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+static inline float uniform(uint32_t& state, float lo, float hi)
+{
+	return lo + (hi - lo) * (xorshift(state) >> 8) * (1.0f / 16777216.0f);
+}
+
+static bool sameClusters(const LightGrid& a, const LightGrid& b)
+{
+	if (a.getIndices() != b.getIndices())
+		return false;
+	return std::equal(a.getClusters().begin(), a.getClusters().end(), b.getClusters().begin(),
+		[](const LightGrid::Cluster& x, const LightGrid::Cluster& y) { return x.offset == y.offset && x.count == y.count; });
+}
+
+int main(int argc, char const *argv[])
+{
+	const glm::mat4 projection = glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+	const LightGrid::Settings settings = { 16, 9, 24, 4.0f, 2048.0f, 1 };
+	LightGrid::Settings pooledSettings = settings;
+	pooledSettings.threads = 0;
+	LightGrid single(settings), pooled(pooledSettings);
+	bool identical = true;
+
+	printf("Light grid benchmark (%ux%ux%u clusters, %s kernel)\n", settings.tilesX, settings.tilesY, settings.slices, LightGrid::simdName());
+
+	uint32_t state = 0x9E3779B9u;
+	for (size_t count : COUNTS)
+	{
+		// View space, inside the frustum or just outside of it
+		SphereBatch lights;
+		lights.reserve(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			const float depth = uniform(state, 1.0f, VIEW_DEPTH);
+			const glm::vec3 center(uniform(state, -1.2f, 1.2f) * depth / projection[0][0],
+				uniform(state, -1.2f, 1.2f) * depth / projection[1][1], -depth);
+			lights.add(center, uniform(state, 2.0f, 64.0f));
+		}
+
+		const double one = benchRepeat([&]() {
+			single.assign(lights, projection[0][0], projection[1][1]);
+			benchKeep(single.getIndices());
+		});
+		const double many = benchRepeat([&]() {
+			pooled.assign(lights, projection[0][0], projection[1][1]);
+			benchKeep(pooled.getIndices());
+		});
+
+		const LightGrid::Stats stats = pooled.getStats();
+		printf("  %5zu lights: %zu indices in %zu clusters, at most %u per cluster\n", count, stats.indices, stats.occupied, stats.maxPerCluster);
+		printf("    one thread           %8.3f ms/frame  %6.2f us/light\n", one * 1e3, one * 1e6 / count);
+		printf("    thread pool          %8.3f ms/frame  %6.2f us/light  %5.2fx\n", many * 1e3, many * 1e6 / count, one / many);
+		if (!sameClusters(single, pooled))
+		{
+			printf("  MISMATCH: pooled assignment differs from one thread\n");
+			identical = false;
+		}
+	}
+
+	return identical ? 0 : 1;
+}
@@ -0,0 +1,157 @@
+/**
+ * @file    MesherBenchmark.cpp
+ * @brief   Greedy chunk meshing speed and output size on SimplexNoise terrain
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "Benchmark.h"
+#include "util/SimplexNoise.h"
+#include "voxel/ChunkMesher.h"
+
+#include <algorithm>
+#include <vector>
+
+static const int WORLD_X = 8, WORLD_Y = 4, WORLD_Z = 8;
+static const int SIZE = VoxelChunk::SIZE;
+static const Voxel STONE = 1, DIRT = 2, GRASS = 3;
+
+// Layered terrain under a fBm heightmap, with 3D noise caves carved out of the stone
+static void terrain(ChunkStore& store)
+{
+	SimplexNoise noise(0.01f, 1.0f, 2.0f, 0.5f);
+	SimplexNoise caves(0.05f, 1.0f, 2.0f, 0.5f);
+	caves.setSeed(7);
+
+	std::vector<float> heights(SIZE * SIZE), density(VoxelChunk::VOLUME);
+	std::vector<Voxel> voxels(VoxelChunk::VOLUME);
+	for (int cz = 0; cz < WORLD_Z; cz++)
+		for (int cx = 0; cx < WORLD_X; cx++)
+		{
+			noise.fractalGrid(5, heights.data(), SIZE, SIZE, float(cx * SIZE), float(cz * SIZE), 1.0f, SIZE);
+			for (int cy = 0; cy < WORLD_Y; cy++)
+			{
+				caves.fractalGrid(2, density.data(), SIZE, SIZE, SIZE,
+					float(cx * SIZE), float(cy * SIZE), float(cz * SIZE), 1.0f, SIZE, SIZE * SIZE);
+				for (int z = 0; z < SIZE; z++)
+					for (int y = 0; y < SIZE; y++)
+					{
+						const int wy = cy * SIZE + y;
+						for (int x = 0; x < SIZE; x++)
+						{
+							const int height = static_cast<int>(WORLD_Y * SIZE * (0.5f + 0.3f * heights[x + z * SIZE]));
+							Voxel voxel = VOXEL_AIR;
+							if (wy < height)
+								voxel = wy == height - 1 ? GRASS : wy > height - 4 ? DIRT : STONE;
+							if (voxel == STONE && density[VoxelChunk::index(x, y, z)] > 0.45f)
+								voxel = VOXEL_AIR;
+							voxels[VoxelChunk::index(x, y, z)] = voxel;
+						}
+					}
+				VoxelChunk& chunk = store.getOrCreateChunk({ cx, cy, cz });
+				chunk.load(voxels.data());
+			}
+		}
+}
+
+// Area covered by the quads of a mesh, must equal the number of visible unit faces
+static size_t quadArea(const ChunkMesh& mesh)
+{
+	size_t area = 0;
+	for (size_t q = 0; q < mesh.vertices.size(); q += 4)
+	{
+		int lo[3] = { 64, 64, 64 }, hi[3] = { 0, 0, 0 };
+		for (size_t n = q; n < q + 4; n++)
+		{
+			const int p[3] = { mesh.vertices[n].x(), mesh.vertices[n].y(), mesh.vertices[n].z() };
+			for (int a = 0; a < 3; a++)
+			{
+				lo[a] = std::min(lo[a], p[a]);
+				hi[a] = std::max(hi[a], p[a]);
+			}
+		}
+		const int axis = mesh.vertices[q].face() / 2;
+		area += static_cast<size_t>(hi[(axis + 1) % 3] - lo[(axis + 1) % 3]) * (hi[(axis + 2) % 3] - lo[(axis + 2) % 3]);
+	}
+	return area;
+}
+
+int main(int argc, char const *argv[])
+{
+	bool ok = true;
+	ChunkStore store;
+	terrain(store);
+
+	std::vector<ChunkCoord> coords;
+	for (const auto& entry : store.getChunks())
+		coords.push_back(entry.first);
+	std::sort(coords.begin(), coords.end(), [](const ChunkCoord& a, const ChunkCoord& b)
+	{
+		return a.z != b.z ? a.z < b.z : a.y != b.y ? a.y < b.y : a.x < b.x;
+	});
+
+	printf("Greedy mesher benchmark (%zu chunks of %d^3, SimplexNoise terrain with caves)\n", coords.size(), SIZE);
+
+	std::vector<Voxel> padded(ChunkMesher::PADDED_VOLUME);
+	ChunkMesher mesher;
+	ChunkMesh mesh;
+	size_t faces = 0, triangles = 0, vertices = 0, meshed = 0;
+	uint64_t checksum = 0;
+	double gatherSeconds = 0.0, meshSeconds = 0.0;
+
+	for (const ChunkCoord& coord : coords)
+	{
+		gatherSeconds += benchRepeat([&]() { ChunkMesher::gather(store, coord, padded.data()); benchKeep(padded); }, 0.002);
+		meshSeconds += benchRepeat([&]() { mesher.mesh(padded.data(), mesh); benchKeep(mesh); }, 0.005);
+
+		faces += mesh.faces;
+		triangles += mesh.getTriangleCount();
+		vertices += mesh.vertices.size();
+		meshed += mesh.empty() ? 0 : 1;
+		checksum = checksum * 31 + mesh.checksum();
+
+		if (quadArea(mesh) != mesh.faces)
+		{
+			printf("  MISMATCH: chunk %d %d %d quads cover %zu faces instead of %zu\n",
+				coord.x, coord.y, coord.z, quadArea(mesh), mesh.faces);
+			ok = false;
+		}
+	}
+
+	// Same input, same mesh: remesh everything and compare
+	uint64_t again = 0;
+	for (const ChunkCoord& coord : coords)
+	{
+		ChunkMesher::gather(store, coord, padded.data());
+		mesher.mesh(padded.data(), mesh);
+		again = again * 31 + mesh.checksum();
+	}
+	if (again != checksum)
+	{
+		printf("  MISMATCH: meshing is not deterministic\n");
+		ok = false;
+	}
+
+	printf("  chunks with geometry        %8zu\n", meshed);
+	printf("  visible faces               %8zu (%zu triangles unmerged)\n", faces, faces * 2);
+	printf("  greedy triangles            %8zu (%.1f%% of unmerged)\n", triangles, 100.0 * triangles / (faces * 2));
+	printf("  vertex bytes                %8zu (%zu bytes/vertex)\n", vertices * sizeof(ChunkVertex), sizeof(ChunkVertex));
+	printf("  gather                      %8.3f ms/chunk\n", gatherSeconds * 1e3 / coords.size());
+	printf("  mesh                        %8.3f ms/chunk\n", meshSeconds * 1e3 / coords.size());
+	printf("  checksum                    %016llx\n", static_cast<unsigned long long>(checksum));
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,140 @@
+/**
+ * @file    NoiseBenchmark.cpp
+ * @brief   Scalar versus batched SimplexNoise throughput
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "Benchmark.h"
+#include "util/SimplexNoise.h"
+
+#include <cstring>
+#include <vector>
+
+static const size_t CHUNK = 32;
+static const size_t MAP = 256;
+static const size_t OCTAVES = 5;
+static const float STEP = 0.0625f;
+static const float ORIGIN_X = -13.7f, ORIGIN_Y = 4.2f, ORIGIN_Z = 101.3f;
+
+static const SimplexNoise::Backend BACKENDS[] = {
+	SimplexNoise::Backend::Scalar,
+	SimplexNoise::Backend::SSE2,
+	SimplexNoise::Backend::AVX2,
+	SimplexNoise::Backend::NEON
+};
+
+static bool s_mismatch = false;
+
+static void report(const char* name, const char* backend, double seconds, size_t samples, double reference)
+{
+	double ns = seconds * 1e9 / samples;
+	printf("  %-24s %-7s %8.2f ns/sample", name, backend, ns);
+	if (reference > 0.0)
+		printf("  x%.2f", reference / ns);
+	printf("\n");
+}
+
+static void compare(const std::vector<float>& expected, const std::vector<float>& actual, const char* what)
+{
+	if (memcmp(expected.data(), actual.data(), expected.size() * sizeof(float)) != 0)
+	{
+		printf("  MISMATCH: %s is not bit-identical to the scalar path\n", what);
+		s_mismatch = true;
+	}
+}
+
+int main(int argc, char const *argv[])
+{
+	SimplexNoise fbm(0.5f, 1.0f, 2.0f, 0.5f);
+	std::vector<float> expected(CHUNK * CHUNK * CHUNK), actual(CHUNK * CHUNK * CHUNK);
+	std::vector<float> expected2D(MAP * MAP), actual2D(MAP * MAP);
+
+	printf("SimplexNoise benchmark (%zux%zux%zu chunk, %zux%zu map, %zu octaves)\n",
+		CHUNK, CHUNK, CHUNK, MAP, MAP, OCTAVES);
+
+	// Reference: one scalar call per sample, as terrain code does today
+	double scalar3 = benchRepeat([&]() {
+		for (size_t k = 0; k < CHUNK; k++)
+			for (size_t j = 0; j < CHUNK; j++)
+				for (size_t i = 0; i < CHUNK; i++)
+					expected[i + j * CHUNK + k * CHUNK * CHUNK] = SimplexNoise::noise(
+						ORIGIN_X + i * STEP, ORIGIN_Y + j * STEP, ORIGIN_Z + k * STEP);
+		benchKeep(expected);
+	}) / expected.size();
+	report("noise 3D", "loop", scalar3 * expected.size(), expected.size(), 0.0);
+
+	for (SimplexNoise::Backend backend : BACKENDS)
+	{
+		if (!SimplexNoise::setBackend(backend))
+			continue;
+
+		double t = benchRepeat([&]() {
+			SimplexNoise::noiseGrid(actual.data(), CHUNK, CHUNK, CHUNK,
+				ORIGIN_X, ORIGIN_Y, ORIGIN_Z, STEP, CHUNK, CHUNK * CHUNK);
+			benchKeep(actual);
+		});
+		report("noiseGrid 3D", SimplexNoise::backendName(backend), t, actual.size(), scalar3 * 1e9);
+		compare(expected, actual, "noiseGrid 3D");
+	}
+
+	double scalarFbm3 = benchRepeat([&]() {
+		for (size_t k = 0; k < CHUNK; k++)
+			for (size_t j = 0; j < CHUNK; j++)
+				for (size_t i = 0; i < CHUNK; i++)
+					expected[i + j * CHUNK + k * CHUNK * CHUNK] = fbm.fractal(OCTAVES,
+						ORIGIN_X + i * STEP, ORIGIN_Y + j * STEP, ORIGIN_Z + k * STEP);
+		benchKeep(expected);
+	}) / expected.size();
+	report("fractal 3D", "loop", scalarFbm3 * expected.size(), expected.size(), 0.0);
+
+	for (SimplexNoise::Backend backend : BACKENDS)
+	{
+		if (!SimplexNoise::setBackend(backend))
+			continue;
+
+		double t = benchRepeat([&]() {
+			fbm.fractalGrid(OCTAVES, actual.data(), CHUNK, CHUNK, CHUNK,
+				ORIGIN_X, ORIGIN_Y, ORIGIN_Z, STEP, CHUNK, CHUNK * CHUNK);
+			benchKeep(actual);
+		});
+		report("fractalGrid 3D", SimplexNoise::backendName(backend), t, actual.size(), scalarFbm3 * 1e9);
+		compare(expected, actual, "fractalGrid 3D");
+	}
+
+	double scalarFbm2 = benchRepeat([&]() {
+		for (size_t j = 0; j < MAP; j++)
+			for (size_t i = 0; i < MAP; i++)
+				expected2D[i + j * MAP] = fbm.fractal(OCTAVES, ORIGIN_X + i * STEP, ORIGIN_Y + j * STEP);
+		benchKeep(expected2D);
+	}) / expected2D.size();
+	report("fractal 2D", "loop", scalarFbm2 * expected2D.size(), expected2D.size(), 0.0);
+
+	for (SimplexNoise::Backend backend : BACKENDS)
+	{
+		if (!SimplexNoise::setBackend(backend))
+			continue;
+
+		double t = benchRepeat([&]() {
+			fbm.fractalGrid(OCTAVES, actual2D.data(), MAP, MAP, ORIGIN_X, ORIGIN_Y, STEP, MAP);
+			benchKeep(actual2D);
+		});
+		report("fractalGrid 2D", SimplexNoise::backendName(backend), t, actual2D.size(), scalarFbm2 * 1e9);
+		compare(expected2D, actual2D, "fractalGrid 2D");
+	}
+
+	return s_mismatch ? 1 : 0;
+}
@@ -0,0 +1,217 @@
+/**
+ * @file    NoiseDerivativeBenchmark.cpp
+ * @brief   Analytic SimplexNoise gradients vs central-difference normals
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "Benchmark.h"
+#include "util/SimplexNoise.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+static const size_t MAP = 256;
+static const size_t CHUNK = 32;
+static const size_t OCTAVES = 5;
+static const float STEP = 0.0625f;
+static const float EPSILON = 1.0f / 512.0f;
+
+static const SimplexNoise::Backend BACKENDS[] = {
+	SimplexNoise::Backend::Scalar,
+	SimplexNoise::Backend::SSE2,
+	SimplexNoise::Backend::AVX2,
+	SimplexNoise::Backend::NEON
+};
+
+struct Field
+{
+	std::vector<float> value, dx, dy, dz;
+
+	explicit Field(size_t size) : value(size), dx(size), dy(size), dz(size) {}
+
+	bool operator==(const Field& other) const
+	{
+		size_t bytes = value.size() * sizeof(float);
+		return memcmp(value.data(), other.value.data(), bytes) == 0
+			&& memcmp(dx.data(), other.dx.data(), bytes) == 0
+			&& memcmp(dy.data(), other.dy.data(), bytes) == 0
+			&& memcmp(dz.data(), other.dz.data(), bytes) == 0;
+	}
+};
+
+// Heightmap normals the way they are computed without derivatives: 4 extra fBm evaluations
+static void centralDifference2(const SimplexNoise& noise, Field& field)
+{
+	for (size_t j = 0; j < MAP; j++)
+		for (size_t i = 0; i < MAP; i++)
+		{
+			float x = i * STEP, y = j * STEP;
+			size_t n = i + j * MAP;
+			field.value[n] = noise.fractal(OCTAVES, x, y);
+			field.dx[n] = (noise.fractal(OCTAVES, x + EPSILON, y) - noise.fractal(OCTAVES, x - EPSILON, y)) / (2.0f * EPSILON);
+			field.dy[n] = (noise.fractal(OCTAVES, x, y + EPSILON) - noise.fractal(OCTAVES, x, y - EPSILON)) / (2.0f * EPSILON);
+		}
+}
+
+static void analytic2(const SimplexNoise& noise, Field& field)
+{
+	for (size_t j = 0; j < MAP; j++)
+		for (size_t i = 0; i < MAP; i++)
+		{
+			SimplexNoise::Derivative2 d = noise.fractalWithDerivative(OCTAVES, i * STEP, j * STEP);
+			size_t n = i + j * MAP;
+			field.value[n] = d.value;
+			field.dx[n] = d.dx;
+			field.dy[n] = d.dy;
+		}
+}
+
+static void centralDifference3(const SimplexNoise& noise, Field& field)
+{
+	for (size_t k = 0; k < CHUNK; k++)
+		for (size_t j = 0; j < CHUNK; j++)
+			for (size_t i = 0; i < CHUNK; i++)
+			{
+				float x = i * STEP, y = j * STEP, z = k * STEP;
+				size_t n = i + j * CHUNK + k * CHUNK * CHUNK;
+				field.value[n] = noise.fractal(OCTAVES, x, y, z);
+				field.dx[n] = (noise.fractal(OCTAVES, x + EPSILON, y, z) - noise.fractal(OCTAVES, x - EPSILON, y, z)) / (2.0f * EPSILON);
+				field.dy[n] = (noise.fractal(OCTAVES, x, y + EPSILON, z) - noise.fractal(OCTAVES, x, y - EPSILON, z)) / (2.0f * EPSILON);
+				field.dz[n] = (noise.fractal(OCTAVES, x, y, z + EPSILON) - noise.fractal(OCTAVES, x, y, z - EPSILON)) / (2.0f * EPSILON);
+			}
+}
+
+static void analytic3(const SimplexNoise& noise, Field& field)
+{
+	for (size_t k = 0; k < CHUNK; k++)
+		for (size_t j = 0; j < CHUNK; j++)
+			for (size_t i = 0; i < CHUNK; i++)
+			{
+				SimplexNoise::Derivative3 d = noise.fractalWithDerivative(OCTAVES, i * STEP, j * STEP, k * STEP);
+				size_t n = i + j * CHUNK + k * CHUNK * CHUNK;
+				field.value[n] = d.value;
+				field.dx[n] = d.dx;
+				field.dy[n] = d.dy;
+				field.dz[n] = d.dz;
+			}
+}
+
+// Median of the gradient difference, relative to the largest gradient magnitude of the field.
+// The 3D noise keeps the reference 0.6 kernel radius, which leaves small value discontinuities that
+// central differences turn into spikes on a few percent of the samples.
+static float gradientError(const Field& a, const Field& b)
+{
+	std::vector<float> errors(a.value.size());
+	float scale = 0.0f;
+	for (size_t n = 0; n < a.value.size(); n++)
+	{
+		float ex = a.dx[n] - b.dx[n], ey = a.dy[n] - b.dy[n], ez = a.dz[n] - b.dz[n];
+		errors[n] = std::sqrt(ex * ex + ey * ey + ez * ez);
+		scale = std::max(scale, std::sqrt(a.dx[n] * a.dx[n] + a.dy[n] * a.dy[n] + a.dz[n] * a.dz[n]));
+	}
+	std::nth_element(errors.begin(), errors.begin() + errors.size() / 2, errors.end());
+	return errors[errors.size() / 2] / scale;
+}
+
+static void report(const char* name, double ns, double reference)
+{
+	printf("  %-34s %8.2f ns/sample  x%.2f\n", name, ns, reference / ns);
+}
+
+int main(int argc, char const *argv[])
+{
+	bool ok = true;
+	SimplexNoise noise(0.1f, 1.0f, 2.0f, 0.5f);
+
+	printf("SimplexNoise derivative benchmark (%zux%zu map, %zu^3 chunk, %zu octaves)\n", MAP, MAP, CHUNK, OCTAVES);
+
+	// 2D heightmap normals
+	Field fd2(MAP * MAP), an2(MAP * MAP), grid2(MAP * MAP), scalar2(MAP * MAP);
+	double base = benchRepeat([&]() { centralDifference2(noise, fd2); benchKeep(fd2.value); }) * 1e9 / (MAP * MAP);
+	report("2D central differences", base, base);
+	report("2D fractalWithDerivative", benchRepeat([&]() { analytic2(noise, an2); benchKeep(an2.value); }) * 1e9 / (MAP * MAP), base);
+
+	for (size_t n = 0; n < MAP * MAP; n++)
+	{
+		if (an2.value[n] != fd2.value[n])
+		{
+			printf("  MISMATCH: 2D fractalWithDerivative value differs from fractal\n");
+			ok = false;
+			break;
+		}
+	}
+	float error = gradientError(an2, fd2);
+	printf("  2D gradient vs central differences: %.2e relative error\n", error);
+	ok = ok && error < 1e-2f;
+
+	for (SimplexNoise::Backend backend : BACKENDS)
+	{
+		if (!SimplexNoise::setBackend(backend))
+			continue;
+		char name[64];
+		snprintf(name, sizeof(name), "2D fractalGridWithDerivative %s", SimplexNoise::backendName(backend));
+		Field& target = backend == SimplexNoise::Backend::Scalar ? scalar2 : grid2;
+		report(name, benchRepeat([&]() {
+			noise.fractalGridWithDerivative(OCTAVES, target.value.data(), target.dx.data(), target.dy.data(),
+				MAP, MAP, 0.0f, 0.0f, STEP, MAP);
+			benchKeep(target.value);
+		}) * 1e9 / (MAP * MAP), base);
+		if (!(target == scalar2))
+		{
+			printf("  MISMATCH: %s derivative grid differs from the scalar one\n", SimplexNoise::backendName(backend));
+			ok = false;
+		}
+	}
+
+	// 3D density gradients
+	Field fd3(CHUNK * CHUNK * CHUNK), an3(CHUNK * CHUNK * CHUNK), grid3(CHUNK * CHUNK * CHUNK), scalar3(CHUNK * CHUNK * CHUNK);
+	base = benchRepeat([&]() { centralDifference3(noise, fd3); benchKeep(fd3.value); }) * 1e9 / fd3.value.size();
+	report("3D central differences", base, base);
+	report("3D fractalWithDerivative", benchRepeat([&]() { analytic3(noise, an3); benchKeep(an3.value); }) * 1e9 / an3.value.size(), base);
+
+	if (memcmp(an3.value.data(), fd3.value.data(), an3.value.size() * sizeof(float)) != 0)
+	{
+		printf("  MISMATCH: 3D fractalWithDerivative value differs from fractal\n");
+		ok = false;
+	}
+	error = gradientError(an3, fd3);
+	printf("  3D gradient vs central differences: %.2e relative error\n", error);
+	ok = ok && error < 1e-2f;
+
+	for (SimplexNoise::Backend backend : BACKENDS)
+	{
+		if (!SimplexNoise::setBackend(backend))
+			continue;
+		char name[64];
+		snprintf(name, sizeof(name), "3D fractalGridWithDerivative %s", SimplexNoise::backendName(backend));
+		Field& target = backend == SimplexNoise::Backend::Scalar ? scalar3 : grid3;
+		report(name, benchRepeat([&]() {
+			noise.fractalGridWithDerivative(OCTAVES, target.value.data(), target.dx.data(), target.dy.data(), target.dz.data(),
+				CHUNK, CHUNK, CHUNK, 0.0f, 0.0f, 0.0f, STEP, CHUNK, CHUNK * CHUNK);
+			benchKeep(target.value);
+		}) * 1e9 / target.value.size(), base);
+		if (!(target == scalar3))
+		{
+			printf("  MISMATCH: %s derivative grid differs from the scalar one\n", SimplexNoise::backendName(backend));
+			ok = false;
+		}
+	}
+
+	return ok ? 0 : 1;
+}
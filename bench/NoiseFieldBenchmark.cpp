@@ -0,0 +1,86 @@
+/**
+ * @file    NoiseFieldBenchmark.cpp
+ * @brief   NoiseFieldGenerator scaling over thread counts
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "Benchmark.h"
+#include "terrain/NoiseFieldGenerator.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static const size_t MAP = 1024;
+static const size_t VOLUME = 128;
+static const size_t OCTAVES = 6;
+
+int main(int argc, char const *argv[])
+{
+	size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+	if (argc > 1)
+		maxThreads = std::max(1, atoi(argv[1]));
+
+	NoiseFieldGenerator generator(SimplexNoise(0.01f, 1.0f, 2.0f, 0.5f), OCTAVES);
+
+	std::vector<float> reference2D(MAP * MAP), field2D(MAP * MAP);
+	std::vector<float> reference3D(VOLUME * VOLUME * VOLUME), field3D(VOLUME * VOLUME * VOLUME);
+	double base2D = 0.0, base3D = 0.0;
+	bool deterministic = true;
+
+	printf("NoiseFieldGenerator benchmark (%zux%zu heightmap, %zu^3 volume, %zu octaves, tile %zu, %s)\n",
+		MAP, MAP, VOLUME, OCTAVES, generator.getTileSize(), SimplexNoise::backendName(SimplexNoise::getBackend()));
+	printf("  %7s %12s %8s %12s %8s %8s\n", "threads", "heightmap", "speedup", "volume", "speedup", "steals");
+
+	// Powers of two, plus the full thread count
+	std::vector<size_t> sweep;
+	for (size_t threads = 1; threads < maxThreads; threads *= 2)
+		sweep.push_back(threads);
+	sweep.push_back(maxThreads);
+
+	for (size_t threads : sweep)
+	{
+		ThreadPool pool(threads);
+
+		double t2 = benchRepeat([&]() {
+			generator.generate(pool, field2D.data(), MAP, MAP, 0.0f, 0.0f, 1.0f);
+		}, 1.0);
+		double t3 = benchRepeat([&]() {
+			generator.generate(pool, field3D.data(), VOLUME, VOLUME, VOLUME, 0.0f, 0.0f, 0.0f, 1.0f);
+		}, 1.0);
+
+		if (threads == 1)
+		{
+			base2D = t2;
+			base3D = t3;
+			reference2D = field2D;
+			reference3D = field3D;
+		}
+		else if (memcmp(reference2D.data(), field2D.data(), field2D.size() * sizeof(float)) != 0 ||
+			memcmp(reference3D.data(), field3D.data(), field3D.size() * sizeof(float)) != 0)
+		{
+			printf("  MISMATCH: output with %zu threads differs from the single thread output\n", threads);
+			deterministic = false;
+		}
+
+		printf("  %7zu %9.2f ms %7.2fx %9.2f ms %7.2fx %8zu\n", threads,
+			t2 * 1e3, base2D / t2, t3 * 1e3, base3D / t3, pool.getStealCount());
+	}
+
+	return deterministic ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file    NoiseHashBenchmark.cpp
+ * @brief   Cost of the seeded and integer lattice hashes of SimplexNoise
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "Benchmark.h"
+#include "util/SimplexNoise.h"
+
+#include <cstring>
+#include <vector>
+
+static const size_t CHUNK = 32;
+static const float STEP = 0.0625f;
+static const double BUDGET = 1.10;
+
+static const SimplexNoise::Backend BACKENDS[] = {
+	SimplexNoise::Backend::Scalar,
+	SimplexNoise::Backend::SSE2,
+	SimplexNoise::Backend::AVX2,
+	SimplexNoise::Backend::NEON
+};
+
+static double perPoint(const SimplexNoise& noise, std::vector<float>& out, float origin)
+{
+	return benchRepeat([&]() {
+		for (size_t k = 0; k < CHUNK; k++)
+			for (size_t j = 0; j < CHUNK; j++)
+				for (size_t i = 0; i < CHUNK; i++)
+					out[i + j * CHUNK + k * CHUNK * CHUNK] = noise.sample(origin + i * STEP, origin + j * STEP, origin + k * STEP);
+		benchKeep(out);
+	}) * 1e9 / out.size();
+}
+
+static double grid(const SimplexNoise& noise, std::vector<float>& out, float origin)
+{
+	return benchRepeat([&]() {
+		noise.sampleGrid(out.data(), CHUNK, CHUNK, CHUNK, origin, origin, origin, STEP, CHUNK, CHUNK * CHUNK);
+		benchKeep(out);
+	}) * 1e9 / out.size();
+}
+
+static void report(const char* name, double ns, double reference)
+{
+	printf("  %-34s %8.2f ns/sample  %5.1f%%%s\n", name, ns, (ns / reference - 1.0) * 100.0,
+		ns / reference > BUDGET ? "  (over budget)" : "");
+}
+
+int main(int argc, char const *argv[])
+{
+	std::vector<float> expected(CHUNK * CHUNK * CHUNK), actual(CHUNK * CHUNK * CHUNK);
+	bool identical = true;
+
+	SimplexNoise reference;
+	SimplexNoise seeded;
+	seeded.setSeed(1337);
+	SimplexNoise hashed;
+	hashed.setSeed(1337);
+	hashed.setHashMode(SimplexNoise::HashMode::Integer);
+
+	// Far from the origin, where the integer hash is meant to be used
+	const float near = 3.7f, far = 250000.3f;
+
+	printf("SimplexNoise hash benchmark (%zu^3 samples, overhead vs the reference permutation table)\n", CHUNK);
+
+	double base = perPoint(reference, actual, near);
+	report("scalar permutation (reference)", base, base);
+	report("scalar permutation (seeded)", perPoint(seeded, actual, near), base);
+	report("scalar integer hash", perPoint(hashed, actual, near), base);
+	report("scalar integer hash, far origin", perPoint(hashed, expected, far), base);
+
+	for (SimplexNoise::Backend backend : BACKENDS)
+	{
+		if (!SimplexNoise::setBackend(backend))
+			continue;
+
+		char name[64];
+		double gridBase = grid(seeded, actual, near);
+		snprintf(name, sizeof(name), "%s grid permutation", SimplexNoise::backendName(backend));
+		report(name, gridBase, gridBase);
+		snprintf(name, sizeof(name), "%s grid integer hash", SimplexNoise::backendName(backend));
+		report(name, grid(hashed, actual, far), gridBase);
+
+		if (memcmp(expected.data(), actual.data(), expected.size() * sizeof(float)) != 0)
+		{
+			printf("  MISMATCH: %s integer hash grid differs from the scalar integer hash\n",
+				SimplexNoise::backendName(backend));
+			identical = false;
+		}
+	}
+
+	return identical ? 0 : 1;
+}
@@ -0,0 +1,195 @@
+/**
+ * @file    OctreeBenchmark.cpp
+ * @brief   Sparse voxel octree and DAG memory, build and query timings against flat chunks
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "Benchmark.h"
+#include "terrain/TerrainGenerator.h"
+#include "voxel/SparseVoxelOctree.h"
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Asteroid in a 2^LEVELS cube, and the flat chunks covering the same cube
+static const int LEVELS = 8;
+static const int SIDE = 1 << LEVELS;
+static const int CHUNKS = SIDE / VoxelChunk::SIZE;
+static const SparseVoxelOctree::NoiseBody ASTEROID = {
+	96.0f,          // radius
+	20.0f,          // roughness
+	5,              // octaves
+	VOXEL_STONE     // material
+};
+static const size_t RAYS = 20000;
+
+static void reportMemory(const char* name, double ms, size_t bytes)
+{
+	const double voxels = static_cast<double>(SIDE) * SIDE * SIDE;
+	printf("  %-28s %9.1f ms  %8.2f MiB  %7.4f bytes/voxel\n", name, ms, bytes / 1048576.0, bytes / voxels);
+}
+
+static void reportTree(const char* name, const SparseVoxelOctree& tree)
+{
+	const SparseVoxelOctree::Stats stats = tree.getStats();
+	reportMemory(name, stats.buildMs, stats.bytes);
+	printf("  %-28s %9zu nodes, %zu shared\n", "", stats.nodes, stats.sharedNodes);
+}
+
+static bool sameVoxels(const SparseVoxelOctree& tree, const ChunkStore& store, const ChunkCoord& origin)
+{
+	const int x0 = origin.x * VoxelChunk::SIZE, y0 = origin.y * VoxelChunk::SIZE, z0 = origin.z * VoxelChunk::SIZE;
+	for (int z = 0; z < SIDE; z++)
+		for (int y = 0; y < SIDE; y++)
+			for (int x = 0; x < SIDE; x++)
+				if (tree.get(x, y, z) != store.getVoxel(x0 + x, y0 + y, z0 + z))
+				{
+					printf("  MISMATCH: voxel %d %d %d\n", x, y, z);
+					return false;
+				}
+	return true;
+}
+
+static bool compare(const char* name, const SparseVoxelOctree& tree, const ChunkStore& store, const ChunkCoord& origin)
+{
+	if (sameVoxels(tree, store, origin))
+		return true;
+	printf("  FAILED: %s differs from the flat chunks\n", name);
+	return false;
+}
+
+int main(int argc, char const *argv[])
+{
+	bool ok = true;
+	SimplexNoise noise(0.013f, 1.0f, 2.0f, 0.5f);
+	noise.setSeed(4242);
+
+	printf("Sparse voxel octree benchmark (asteroid of radius %.0f in %d^3 voxels)\n", ASTEROID.radius, SIDE);
+
+	// Flat chunks sample every voxel of the cube
+	ChunkStore flat;
+	std::vector<Voxel> voxels(VoxelChunk::VOLUME);
+	BenchTimer timer;
+	for (int z = 0; z < CHUNKS; z++)
+		for (int y = 0; y < CHUNKS; y++)
+			for (int x = 0; x < CHUNKS; x++)
+			{
+				SparseVoxelOctree::sampleBody(noise, ASTEROID, LEVELS, glm::ivec3(x, y, z) * VoxelChunk::SIZE, VoxelChunk::SIZE, voxels.data());
+				std::unique_ptr<VoxelChunk> chunk(new VoxelChunk());
+				chunk->load(voxels.data());
+				flat.insertChunk({ x, y, z }, std::move(chunk));
+			}
+	flat.compact();
+	reportMemory("flat chunks", timer.elapsedMilliseconds(), flat.getMemoryStats().bytes);
+	reportMemory("flat dense", 0.0, static_cast<size_t>(SIDE) * SIDE * SIDE * sizeof(Voxel));
+
+	SparseVoxelOctree tree({ LEVELS, false }), dag({ LEVELS, true });
+	tree.build(noise, ASTEROID);
+	reportTree("octree from noise", tree);
+	dag.build(noise, ASTEROID);
+	reportTree("DAG from noise", dag);
+	ok &= compare("octree from noise", tree, flat, { 0, 0, 0 });
+	ok &= compare("DAG from noise", dag, flat, { 0, 0, 0 });
+
+	SparseVoxelOctree fromChunks({ LEVELS, true });
+	fromChunks.build(flat, { 0, 0, 0 });
+	reportTree("DAG from chunks", fromChunks);
+	ok &= compare("DAG from chunks", fromChunks, flat, { 0, 0, 0 });
+
+	// Rays from a shell around the body, aimed near its center
+	std::mt19937 random(7);
+	std::normal_distribution<float> gauss;
+	std::uniform_real_distribution<float> jitter(-0.5f, 0.5f);
+	std::vector<glm::vec3> origins(RAYS), directions(RAYS);
+	const glm::vec3 center(SIDE * 0.5f);
+	for (size_t i = 0; i < RAYS; i++)
+	{
+		const glm::vec3 away = glm::normalize(glm::vec3(gauss(random), gauss(random), gauss(random)));
+		origins[i] = center + away * (SIDE * 0.75f);
+		directions[i] = glm::normalize(center + glm::vec3(jitter(random), jitter(random), jitter(random)) * ASTEROID.radius * 2.0f - origins[i]);
+	}
+
+	for (int depth : { -1, LEVELS - 3 })
+	{
+		size_t hits = 0;
+		SparseVoxelOctree::Hit hit;
+		const double seconds = benchRepeat([&]() {
+			hits = 0;
+			for (size_t i = 0; i < RAYS; i++)
+				hits += dag.raycast(origins[i], directions[i], SIDE * 2.0f, hit, depth);
+		});
+		printf("  raycast, %-19s %9.2f Mrays/s  %zu of %zu hit\n", depth < 0 ? "full detail" : "3 levels coarser",
+			RAYS / seconds * 1e-6, hits, RAYS);
+	}
+
+	// A full detail hit is a solid cell entered from an air one; the ray may only graze
+	// its corner, so the cell itself is tested rather than a point past the entry
+	for (size_t i = 0; i < RAYS; i++)
+	{
+		SparseVoxelOctree::Hit hit;
+		if (!dag.raycast(origins[i], directions[i], SIDE * 2.0f, hit))
+			continue;
+		const glm::vec3 before = origins[i] + directions[i] * (hit.distance - 0.01f);
+		if (dag.get(hit.cell.x, hit.cell.y, hit.cell.z) == VOXEL_AIR ||
+			dag.get(static_cast<int>(std::floor(before.x)), static_cast<int>(std::floor(before.y)), static_cast<int>(std::floor(before.z))) != VOXEL_AIR)
+		{
+			printf("  FAILED: ray %zu hit at %.3f is not an air to solid crossing\n", i, hit.distance);
+			ok = false;
+			break;
+		}
+	}
+
+	std::vector<SparseVoxelOctree::LodCell> cells;
+	for (float distance : { 1.5f, 6.0f, 24.0f })
+	{
+		const glm::vec3 viewer = center + glm::vec3(0.0f, 0.0f, ASTEROID.radius * distance);
+		const double seconds = benchRepeat([&]() {
+			dag.selectLod(viewer, 0.02f, cells);
+			benchKeep(cells);
+		});
+		printf("  LOD at %4.1f radii            %9.3f ms  %8zu cells\n", distance, seconds * 1e3, cells.size());
+	}
+
+	// Game terrain, caves included, as chunks and as a DAG
+	TerrainGenerator generator;
+	ChunkStore terrain;
+	const ChunkCoord origin = { 0, -CHUNKS / 2, 0 };
+	std::vector<Voxel> padded(ChunkMesher::PADDED_VOLUME);
+	for (int z = 0; z < CHUNKS; z++)
+		for (int y = 0; y < CHUNKS; y++)
+			for (int x = 0; x < CHUNKS; x++)
+			{
+				const ChunkCoord coord = { origin.x + x, origin.y + y, origin.z + z };
+				generator.generatePadded(coord, padded.data());
+				std::unique_ptr<VoxelChunk> chunk(new VoxelChunk());
+				TerrainGenerator::extract(padded.data(), *chunk);
+				terrain.insertChunk(coord, std::move(chunk));
+			}
+	terrain.compact();
+	printf("Terrain (%d^3 chunks)\n", CHUNKS);
+	reportMemory("flat chunks", 0.0, terrain.getMemoryStats().bytes);
+	SparseVoxelOctree terrainTree({ LEVELS, false }), terrainDag({ LEVELS, true });
+	terrainTree.build(terrain, origin);
+	reportTree("octree from chunks", terrainTree);
+	terrainDag.build(terrain, origin);
+	reportTree("DAG from chunks", terrainDag);
+	ok &= compare("terrain DAG", terrainDag, terrain, origin);
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,151 @@
+/**
+ * @file    PhysicsBenchmark.cpp
+ * @brief   Character controller timings and a deterministic walk over generated terrain
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "Benchmark.h"
+#include "physics/CharacterController.h"
+#include "terrain/TerrainGenerator.h"
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+// World of WORLD_X x WORLD_Y x WORLD_Z chunks around the surface, bodies walk on it
+static const int WORLD_X = 8, WORLD_Y = 6, WORLD_Z = 8;
+static const int MIN_Y = -4;
+static const int BODIES = 48;
+static const int TICKS = 600;
+static const double STEP = 1.0 / 60.0;
+static const double WALK_SPEED = 4.3;
+
+static const CharacterController::Settings BODY = {
+	0.3,     // halfWidth
+	1.8,     // height
+	1.6,     // eyeHeight
+	1.0,     // stepHeight
+	28.0,    // gravity
+	9.0,     // jumpSpeed
+	60.0     // maxFallSpeed
+};
+
+struct Run
+{
+	std::vector<glm::dvec3> positions;
+	double seconds;
+	size_t climbs;      // steps up a ledge while walking
+	size_t overlaps;    // body inside a solid voxel after a tick, should never happen
+	size_t grounded;    // body ticks ended standing
+};
+
+// Every body walks in circles of its own, some of them jumping now and then
+static Run simulate(const ChunkStore& store)
+{
+	Run run = { {}, 0.0, 0, 0, 0 };
+	VoxelCollider collider(store);
+	std::vector<CharacterController> bodies;
+	for (int i = 0; i < BODIES; i++)
+	{
+		const double x = 48.0 + (i % 8) * 20.0 + 0.5, z = 48.0 + (i / 8) * 24.0 + 0.5;
+		bodies.emplace_back(BODY, glm::dvec3(x, 60.0, z));
+	}
+
+	for (int tick = 0; tick < TICKS; tick++)
+	{
+		BenchTimer timer;
+		for (int i = 0; i < BODIES; i++)
+		{
+			const double heading = i * 0.7 + tick * STEP * (0.3 + 0.05 * (i % 5));
+			const glm::dvec3 wish(std::cos(heading) * WALK_SPEED, 0.0, std::sin(heading) * WALK_SPEED);
+			const bool jump = i % 3 == 0 && tick % 90 == 45;
+
+			CharacterController& body = bodies[i];
+			const bool wasOnGround = body.isOnGround();
+			const double y = body.getPosition().y;
+			body.step(collider, wish, jump, STEP);
+			if (wasOnGround && body.isOnGround() && body.getPosition().y > y + 0.5)
+				run.climbs++;
+		}
+		run.seconds += timer.elapsedSeconds();
+
+		for (const CharacterController& body : bodies)
+		{
+			run.overlaps += collider.overlaps(body.getBox());
+			run.grounded += body.isOnGround();
+		}
+	}
+
+	for (const CharacterController& body : bodies)
+		run.positions.push_back(body.getPosition());
+	return run;
+}
+
+int main(int argc, char const *argv[])
+{
+	bool ok = true;
+
+	TerrainGenerator generator;
+	ChunkStore store;
+	std::vector<Voxel> padded(ChunkMesher::PADDED_VOLUME);
+	for (int z = 0; z < WORLD_Z; z++)
+		for (int y = 0; y < WORLD_Y; y++)
+			for (int x = 0; x < WORLD_X; x++)
+			{
+				const ChunkCoord coord = { x, y + MIN_Y, z };
+				generator.generatePadded(coord, padded.data());
+				std::unique_ptr<VoxelChunk> chunk(new VoxelChunk());
+				TerrainGenerator::extract(padded.data(), *chunk);
+				store.insertChunk(coord, std::move(chunk));
+			}
+	store.compact();
+
+	printf("Character controller benchmark (%d bodies, %d ticks of %.1f ms)\n", BODIES, TICKS, STEP * 1e3);
+
+	const Run first = simulate(store);
+	const Run second = simulate(store);
+	printf("  %-28s %8.4f ms/tick  %6.3f us/body\n", "step all bodies",
+		first.seconds * 1e3 / TICKS, first.seconds * 1e6 / (TICKS * BODIES));
+
+	// Sweep cost alone, without the overlap checks
+	{
+		VoxelCollider collider(store);
+		std::vector<CharacterController> bodies;
+		for (const glm::dvec3& position : first.positions)
+			bodies.emplace_back(BODY, position);
+		for (int tick = 0; tick < TICKS; tick++)
+			for (int i = 0; i < BODIES; i++)
+			{
+				const double heading = i * 0.7 + tick * STEP * 0.3;
+				bodies[i].step(collider, glm::dvec3(std::cos(heading), 0.0, std::sin(heading)) * WALK_SPEED, false, STEP);
+			}
+		printf("  %-28s %8.1f per body and tick\n", "voxels tested", collider.getVoxelsTested() / double(TICKS * BODIES));
+	}
+	printf("  %zu ledges climbed, on the ground %.1f%% of the time\n", first.climbs, 100.0 * first.grounded / (TICKS * BODIES));
+
+	if (first.positions != second.positions)
+	{
+		printf("  FAILED: two runs of the same ticks ended in different positions\n");
+		ok = false;
+	}
+	if (first.overlaps)
+	{
+		printf("  FAILED: bodies ended %zu ticks inside solid voxels\n", first.overlaps);
+		ok = false;
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,215 @@
+/**
+ * @file    RaycastBenchmark.cpp
+ * @brief   Voxel raycast and line of sight timings on generated terrain
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "Benchmark.h"
+#include "terrain/TerrainGenerator.h"
+#include "voxel/VoxelRaycaster.h"
+
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+// World of WORLD_X x WORLD_Y x WORLD_Z chunks around the surface
+static const int WORLD_X = 16, WORLD_Y = 8, WORLD_Z = 16;
+static const int MIN_Y = -4;
+static const size_t RAYS = 20000;
+static const double PICK_DISTANCE = 256.0;
+
+// Every voxel through ChunkStore::getVoxel, no skipping, to check against; with a stop
+// voxel the walk ends without a hit when it steps into it
+static bool naiveRaycast(const ChunkStore& store, const glm::dvec3& origin, const glm::dvec3& direction,
+	double maxDistance, VoxelRaycaster::Hit& hit, const glm::ivec3* stop = nullptr)
+{
+	const glm::dvec3 d = glm::normalize(direction);
+	glm::ivec3 voxel(static_cast<int>(std::floor(origin.x)), static_cast<int>(std::floor(origin.y)), static_cast<int>(std::floor(origin.z)));
+	glm::ivec3 step;
+	glm::dvec3 tMax, tDelta;
+	for (int i = 0; i < 3; i++)
+	{
+		step[i] = d[i] > 0.0 ? 1 : d[i] < 0.0 ? -1 : 0;
+		tMax[i] = step[i] ? (voxel[i] + (step[i] > 0 ? 1 : 0) - origin[i]) / d[i] : std::numeric_limits<double>::infinity();
+		tDelta[i] = step[i] ? std::abs(1.0 / d[i]) : std::numeric_limits<double>::infinity();
+	}
+
+	double t = 0.0;
+	int axis = -1;
+	for (;;)
+	{
+		if (stop && axis >= 0 && voxel == *stop)
+			return false;
+		const Voxel value = store.getVoxel(voxel.x, voxel.y, voxel.z);
+		if (value != VOXEL_AIR)
+		{
+			hit.cell = voxel;
+			hit.normal = glm::ivec3(0);
+			if (axis >= 0)
+				hit.normal[axis] = -step[axis];
+			hit.distance = t;
+			hit.voxel = value;
+			return true;
+		}
+		const int next = tMax.x < tMax.y ? (tMax.x < tMax.z ? 0 : 2) : (tMax.y < tMax.z ? 1 : 2);
+		if (tMax[next] > maxDistance)
+			return false;
+		t = tMax[next];
+		axis = next;
+		voxel[next] += step[next];
+		tMax[next] += tDelta[next];
+	}
+}
+
+// Nothing solid from the voxel holding from up to the one holding to
+static bool naiveLineOfSight(const ChunkStore& store, const VoxelRaycaster::Segment& segment)
+{
+	const glm::ivec3 target(static_cast<int>(std::floor(segment.to.x)), static_cast<int>(std::floor(segment.to.y)),
+		static_cast<int>(std::floor(segment.to.z)));
+	VoxelRaycaster::Hit hit;
+	return !naiveRaycast(store, segment.from, segment.to - segment.from, glm::length(segment.to - segment.from), hit, &target);
+}
+
+static bool sameHit(bool a, const VoxelRaycaster::Hit& hitA, bool b, const VoxelRaycaster::Hit& hitB)
+{
+	if (a != b)
+		return false;
+	return !a || (hitA.cell == hitB.cell && hitA.normal == hitB.normal && hitA.voxel == hitB.voxel
+		&& std::abs(hitA.distance - hitB.distance) < 1e-6);
+}
+
+static void report(const char* name, double seconds, size_t rays, size_t hits)
+{
+	printf("  %-34s %8.3f Mrays/s  %7.2f us/ray  %6zu of %zu hit\n", name, rays / seconds * 1e-6, seconds * 1e6 / rays, hits, rays);
+}
+
+int main(int argc, char const *argv[])
+{
+	bool ok = true;
+
+	// Terrain as the game generates it, caves included, compacted like loaded chunks
+	TerrainGenerator generator;
+	ChunkStore store;
+	std::vector<Voxel> padded(ChunkMesher::PADDED_VOLUME);
+	for (int z = 0; z < WORLD_Z; z++)
+		for (int y = 0; y < WORLD_Y; y++)
+			for (int x = 0; x < WORLD_X; x++)
+			{
+				const ChunkCoord coord = { x, y + MIN_Y, z };
+				generator.generatePadded(coord, padded.data());
+				std::unique_ptr<VoxelChunk> chunk(new VoxelChunk());
+				TerrainGenerator::extract(padded.data(), *chunk);
+				store.insertChunk(coord, std::move(chunk));
+			}
+	store.compact();
+
+	printf("Voxel raycast benchmark (%d x %d x %d chunks, %zu stored)\n", WORLD_X, WORLD_Y, WORLD_Z, store.getChunkCount());
+
+	// Picking: from above the surface, looking down at various angles
+	std::mt19937 random(11);
+	std::uniform_real_distribution<double> across(64.0, WORLD_X * VoxelChunk::SIZE - 64.0);
+	std::uniform_real_distribution<double> unit(-1.0, 1.0), down(0.15, 1.0);
+	std::vector<glm::dvec3> origins(RAYS), directions(RAYS);
+	for (size_t i = 0; i < RAYS; i++)
+	{
+		origins[i] = glm::dvec3(across(random), 60.0 + 20.0 * down(random), across(random));
+		directions[i] = glm::dvec3(unit(random), -down(random), unit(random));
+	}
+
+	// Line of sight: between points around the surface, some of them underground
+	std::vector<VoxelRaycaster::Segment> segments(RAYS);
+	std::uniform_real_distribution<double> height(-8.0, 56.0), offset(-48.0, 48.0);
+	for (VoxelRaycaster::Segment& segment : segments)
+	{
+		segment.from = glm::dvec3(across(random), height(random), across(random));
+		segment.to = segment.from + glm::dvec3(offset(random), offset(random) * 0.25, offset(random));
+	}
+
+	VoxelRaycaster raycaster(store);
+	VoxelRaycaster::Hit hit;
+	size_t hits = 0;
+	double seconds;
+
+	seconds = benchRepeat([&]() {
+		hits = 0;
+		for (size_t i = 0; i < RAYS; i++)
+			hits += naiveRaycast(store, origins[i], directions[i], PICK_DISTANCE, hit);
+	});
+	report("picking, every voxel", seconds, RAYS, hits);
+	seconds = benchRepeat([&]() {
+		hits = 0;
+		for (size_t i = 0; i < RAYS; i++)
+			hits += raycaster.raycast(origins[i], directions[i], PICK_DISTANCE, hit);
+	});
+	report("picking, raycast()", seconds, RAYS, hits);
+
+	seconds = benchRepeat([&]() {
+		hits = 0;
+		for (const VoxelRaycaster::Segment& segment : segments)
+			hits += !naiveLineOfSight(store, segment);
+	});
+	report("line of sight, every voxel", seconds, RAYS, hits);
+	seconds = benchRepeat([&]() {
+		hits = 0;
+		for (const VoxelRaycaster::Segment& segment : segments)
+			hits += raycaster.raycast(segment.from, segment.to - segment.from, glm::length(segment.to - segment.from), hit);
+	});
+	report("segments, raycast() to the end", seconds, RAYS, hits);
+
+	std::vector<uint8_t> visible(RAYS);
+	seconds = benchRepeat([&]() {
+		hits = RAYS - raycaster.lineOfSight(segments.data(), segments.size(), visible.data());
+	});
+	report("line of sight, lineOfSight()", seconds, RAYS, hits);
+
+	ThreadPool pool;
+	char name[64];
+	snprintf(name, sizeof(name), "line of sight, %zu threads", pool.getThreadCount());
+	seconds = benchRepeat([&]() {
+		hits = RAYS - raycaster.lineOfSight(segments.data(), segments.size(), visible.data(), &pool);
+	});
+	report(name, seconds, RAYS, hits);
+
+	// Same answers as walking every voxel
+	VoxelRaycaster::Hit expected;
+	for (size_t i = 0; i < RAYS && ok; i++)
+	{
+		const bool a = naiveRaycast(store, origins[i], directions[i], PICK_DISTANCE, expected);
+		const bool b = raycaster.raycast(origins[i], directions[i], PICK_DISTANCE, hit);
+		if (!sameHit(a, expected, b, hit))
+		{
+			printf("  MISMATCH: picking ray %zu\n", i);
+			ok = false;
+		}
+	}
+	for (size_t i = 0; i < RAYS && ok; i++)
+	{
+		const glm::dvec3 direction = segments[i].to - segments[i].from;
+		const bool a = naiveRaycast(store, segments[i].from, direction, glm::length(direction), expected);
+		const bool b = raycaster.raycast(segments[i].from, direction, glm::length(direction), hit);
+		if (!sameHit(a, expected, b, hit) || visible[i] != naiveLineOfSight(store, segments[i]))
+		{
+			printf("  MISMATCH: line of sight segment %zu\n", i);
+			ok = false;
+		}
+	}
+	if (!ok)
+		printf("  FAILED: raycasts differ from the voxel by voxel walk\n");
+	return ok ? 0 : 1;
+}
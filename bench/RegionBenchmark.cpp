@@ -0,0 +1,172 @@
+/**
+ * @file    RegionBenchmark.cpp
+ * @brief   Region file save and load throughput on generated terrain chunks
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "Benchmark.h"
+#include "terrain/TerrainGenerator.h"
+#include "voxel/RegionStore.h"
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+// World of WORLD_X x WORLD_Y x WORLD_Z chunks around the surface, 2 x 1 x 2 regions
+static const int WORLD_X = 16, WORLD_Y = 8, WORLD_Z = 16;
+static const int MIN_Y = -4;
+// Times every chunk is saved, past two the superseded payloads of the denser regions
+// outgrow the live ones plus the slack and save() compacts them
+static const int SAVE_PASSES = 4;
+
+struct Saved
+{
+	ChunkCoord coord;
+	std::unique_ptr<VoxelChunk> chunk;
+};
+
+static void report(const char* name, double seconds, size_t chunks, size_t bytes)
+{
+	printf("  %-30s %8.1f chunks/ms  %8.1f MB/s  %7.2f us/chunk\n", name, chunks / seconds * 1e-3,
+		bytes / seconds * 1e-6, seconds * 1e6 / chunks);
+}
+
+static bool sameChunk(const VoxelChunk& a, const VoxelChunk& b)
+{
+	for (size_t i = 0; i < VoxelChunk::VOLUME; i++)
+		if (a.get(i) != b.get(i))
+			return false;
+	return true;
+}
+
+int main(int argc, char const *argv[])
+{
+	bool ok = true;
+	const std::string directory = (std::filesystem::temp_directory_path() / "voxspatium-region-benchmark").string();
+	std::error_code error;
+	std::filesystem::remove_all(directory, error);
+
+	// Terrain as the game generates it, caves included
+	TerrainGenerator generator;
+	std::vector<Voxel> padded(ChunkMesher::PADDED_VOLUME);
+	std::vector<Saved> chunks;
+	for (int z = 0; z < WORLD_Z; z++)
+		for (int y = 0; y < WORLD_Y; y++)
+			for (int x = 0; x < WORLD_X; x++)
+			{
+				Saved saved = { { x, y + MIN_Y, z }, std::unique_ptr<VoxelChunk>(new VoxelChunk()) };
+				generator.generatePadded(saved.coord, padded.data());
+				TerrainGenerator::extract(padded.data(), *saved.chunk);
+				chunks.push_back(std::move(saved));
+			}
+	const size_t rawBytes = chunks.size() * VoxelChunk::VOLUME * sizeof(Voxel);
+	size_t memoryBytes = 0;
+	for (const Saved& saved : chunks)
+		memoryBytes += saved.chunk->getMemoryUsage();
+
+	printf("Region file benchmark (%zu chunks of %d^3, regions of %d^3 chunks)\n", chunks.size(), VoxelChunk::SIZE, RegionFile::REGION);
+
+	// Codec alone, in memory
+	std::vector<std::vector<uint8_t>> payloads(chunks.size());
+	report("encode", benchRepeat([&]() {
+		for (size_t i = 0; i < chunks.size(); i++)
+		{
+			payloads[i].clear();
+			RegionFile::encode(*chunks[i].chunk, payloads[i]);
+		}
+		benchKeep(payloads);
+	}), chunks.size(), rawBytes);
+
+	size_t encodedBytes = 0;
+	for (const std::vector<uint8_t>& payload : payloads)
+		encodedBytes += payload.size();
+
+	std::vector<Voxel> voxels(VoxelChunk::VOLUME);
+	report("decode", benchRepeat([&]() {
+		for (const std::vector<uint8_t>& payload : payloads)
+			RegionFile::decode(payload.data(), payload.size(), voxels.data());
+		benchKeep(voxels);
+	}), chunks.size(), rawBytes);
+
+	// Every pass rewrites all chunks, which has save() compact along the way
+	const RegionFile::Generator stamp = { generator.getSettings().seed, TerrainGenerator::VERSION };
+	RegionStore store(directory, stamp);
+	int passes = 0;
+	const auto saveAll = [&]() {
+		for (const Saved& saved : chunks)
+			ok &= store.save(saved.coord, *saved.chunk);
+		passes++;
+	};
+	report("save (append)", benchRepeat(saveAll), chunks.size(), rawBytes);
+	while (passes < SAVE_PASSES)
+		saveAll();
+	const RegionStore::Stats saved = store.getStats();
+	if (saved.compactions == 0 || saved.failedCompactions != 0)
+	{
+		printf("  MISMATCH: %d save passes compacted %zu times, %zu failed\n", passes, saved.compactions, saved.failedCompactions);
+		ok = false;
+	}
+
+	VoxelChunk loaded;
+	report("load (mapped)", benchRepeat([&]() {
+		for (const Saved& saved : chunks)
+			ok &= store.load(saved.coord, loaded);
+		benchKeep(loaded);
+	}), chunks.size(), rawBytes);
+
+	// Reopening maps the files again, the page cache still holds them
+	report("open and load", benchRepeat([&]() {
+		store.close();
+		for (const Saved& saved : chunks)
+			ok &= store.load(saved.coord, loaded);
+		benchKeep(loaded);
+	}), chunks.size(), rawBytes);
+
+	store.compact();
+	const RegionStore::Stats compacted = store.getStats();
+	printf("  %zu chunks in %zu regions: %.2f MiB dense, %.2f MiB in memory, %.2f MiB encoded (%.1f%% of dense)\n",
+		compacted.chunks, compacted.regions, rawBytes / 1048576.0, memoryBytes / 1048576.0,
+		encodedBytes / 1048576.0, 100.0 * encodedBytes / rawBytes);
+	printf("  files: %.2f MiB after %d save passes (%zu compactions), %.2f MiB compacted\n",
+		saved.fileBytes / 1048576.0, passes, saved.compactions, compacted.fileBytes / 1048576.0);
+
+	for (const Saved& saved : chunks)
+	{
+		if (!store.load(saved.coord, loaded) || !sameChunk(loaded, *saved.chunk))
+		{
+			printf("  MISMATCH: chunk %d %d %d did not load back\n", saved.coord.x, saved.coord.y, saved.coord.z);
+			ok = false;
+			break;
+		}
+	}
+
+	store.close();
+
+	// Files of another seed must not load
+	RegionStore other(directory, { stamp.seed + 1, stamp.version });
+	if (other.load(chunks.front().coord, loaded) || other.getStats().rejected == 0)
+	{
+		printf("  MISMATCH: region files of another generator were loaded\n");
+		ok = false;
+	}
+
+	if (!ok)
+		printf("  FAILED: region file operations\n");
+
+	std::filesystem::remove_all(directory, error);
+	return ok ? 0 : 1;
+}
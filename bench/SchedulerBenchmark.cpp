@@ -0,0 +1,117 @@
+/**
+ * @file    SchedulerBenchmark.cpp
+ * @brief   Sleep estimate of the frame pacing over long runs, and real pacing at a cap
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "Benchmark.h"
+#include "FrameScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <random>
+#include <vector>
+
+// Synthetic 1 ms sleeps: 1.08 ms +- 0.05 ms, and one in a hundred preempted to 3 ms.
+// Ten million of them are about three and a half hours of pacing at a 60 fps cap.
+static const size_t SAMPLES = 10000000;
+static const double SLEEP_MEAN = 1.08e-3, SLEEP_DEVIATION = 0.05e-3, PREEMPTED = 3e-3;
+// Then the scheduler gets slower
+static const double SHIFTED_MEAN = 2e-3;
+static const size_t SHIFTED_SAMPLES = 10 * FrameScheduler::SLEEP_WINDOW;
+
+// Real pacing at a cap with next to no work per frame
+static const double FRAME_CAP = 250.0;
+static const int PACED_FRAMES = 500;
+
+int main(int argc, char const *argv[])
+{
+	bool ok = true;
+	printf("Frame scheduler benchmark (%zu synthetic sleeps, window of %zu)\n", SAMPLES, FrameScheduler::SLEEP_WINDOW);
+
+	std::mt19937 random(7);
+	std::normal_distribution<double> jitter(SLEEP_MEAN, SLEEP_DEVIATION);
+	std::uniform_int_distribution<int> preempt(0, 99);
+	std::vector<double> samples(SAMPLES);
+	for (double& sample : samples)
+		sample = preempt(random) == 0 ? PREEMPTED : jitter(random);
+
+	// Exact deviation of all samples, which the windowed estimate should stay around
+	double mean = 0.0, m2 = 0.0;
+	for (size_t i = 0; i < SAMPLES; i++)
+	{
+		const double delta = samples[i] - mean;
+		mean += delta / (i + 1);
+		m2 += delta * (samples[i] - mean);
+	}
+	const double deviation = std::sqrt(m2 / SAMPLES);
+
+	FrameScheduler::SleepEstimate estimate = { 1e-3, 0.0, 0 };
+	double maxDeviation = 0.0;
+	const double seconds = benchRepeat([&]() {
+		estimate = { 1e-3, 0.0, 0 };
+		maxDeviation = 0.0;
+		for (size_t i = 0; i < SAMPLES; i++)
+		{
+			estimate.add(samples[i]);
+			if (i >= FrameScheduler::SLEEP_WINDOW)
+				maxDeviation = std::max(maxDeviation, estimate.variance);
+		}
+		benchKeep(estimate);
+	}, 0.0);
+	maxDeviation = std::sqrt(maxDeviation);
+	printf("  add()                 %8.2f ns/sample\n", seconds * 1e9 / SAMPLES);
+	printf("  deviation             %8.4f ms of all samples, %.4f ms estimated at the end, %.4f ms at most\n",
+		deviation * 1e3, std::sqrt(estimate.variance) * 1e3, maxDeviation * 1e3);
+	printf("  mean                  %8.4f ms of all samples, %.4f ms estimated at the end\n", mean * 1e3, estimate.mean * 1e3);
+
+	// A window holds a handful of preemptions, so allow for their count to vary
+	if (maxDeviation > 2.0 * deviation || std::abs(estimate.mean - mean) > 0.2 * mean)
+	{
+		printf("  MISMATCH: the estimate drifted away from the samples\n");
+		ok = false;
+	}
+
+	for (size_t i = 0; i < SHIFTED_SAMPLES; i++)
+		estimate.add(SHIFTED_MEAN);
+	printf("  after a shift to %.1f ms, %zu samples later: %.4f ms +- %.4f ms\n",
+		SHIFTED_MEAN * 1e3, SHIFTED_SAMPLES, estimate.mean * 1e3, std::sqrt(estimate.variance) * 1e3);
+	if (std::abs(estimate.mean - SHIFTED_MEAN) > 0.01 * SHIFTED_MEAN)
+	{
+		printf("  MISMATCH: the estimate did not follow the slower sleeps\n");
+		ok = false;
+	}
+
+	// CPU time against wall time shows how much of the pacing is spent spinning
+	const FrameScheduler::Settings settings = { 60.0, 8, FRAME_CAP };
+	FrameScheduler scheduler(settings);
+	BenchTimer timer;
+	const std::clock_t cpuStart = std::clock();
+	for (int frame = 0; frame <= PACED_FRAMES; frame++)
+	{
+		scheduler.beginFrame();
+		scheduler.endFrame();
+	}
+	const double cpu = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+	const double wall = timer.elapsedSeconds();
+	const FrameScheduler::SleepEstimate& sleep = scheduler.getSleepEstimate();
+	printf("  paced at %.0f fps      %8.3f ms/frame (%.3f ms target), %.1f%% CPU, sleeps %.4f ms +- %.4f ms\n",
+		FRAME_CAP, wall * 1e3 / (PACED_FRAMES + 1), 1e3 / FRAME_CAP, 100.0 * cpu / wall, sleep.mean * 1e3, std::sqrt(sleep.variance) * 1e3);
+
+	return ok ? 0 : 1;
+}
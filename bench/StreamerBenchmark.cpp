@@ -0,0 +1,134 @@
+/**
+ * @file    StreamerBenchmark.cpp
+ * @brief   Chunk streaming along a flight, generated against loaded from region files
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "Benchmark.h"
+#include "voxel/ChunkJobSystem.h"
+
+#include <filesystem>
+#include <thread>
+#include <unordered_map>
+
+// Straight flight across STEPS chunk borders, loading a box of chunks around every stop
+static const int STEPS = 12;
+static const int RADIUS = 4, VERTICAL_RADIUS = 2;
+static const float SPEED = 64.0f;  // world units per second, simulated
+
+struct Pass
+{
+	double seconds;
+	size_t chunks;
+	std::unordered_map<ChunkCoord, uint64_t, ChunkCoordHash> meshes;
+	ChunkStreamer::Stats stats;
+};
+
+static Pass fly(const ChunkStreamer::Settings& settings)
+{
+	Pass pass = {};
+	const TerrainGenerator generator;
+	ChunkStreamer streamer(settings, { generator.getSettings().seed, TerrainGenerator::VERSION });
+	ChunkJobSystem jobs(generator, 0, &streamer);
+	std::unordered_map<ChunkCoord, bool, ChunkCoordHash> requested;
+
+	BenchTimer timer;
+	for (int step = 0; step <= STEPS; step++)
+	{
+		const glm::dvec3 position(step * VoxelChunk::SIZE + 0.5, 16.0, 0.5);
+		const ChunkCoord center = ChunkStore::chunkOf(static_cast<int>(position.x), static_cast<int>(position.y), static_cast<int>(position.z));
+		streamer.update(position);
+		jobs.setFocus(static_cast<float>(position.x), static_cast<float>(position.y), static_cast<float>(position.z));
+		for (int z = center.z - RADIUS; z <= center.z + RADIUS; z++)
+			for (int y = center.y - VERTICAL_RADIUS; y <= center.y + VERTICAL_RADIUS; y++)
+				for (int x = center.x - RADIUS; x <= center.x + RADIUS; x++)
+				{
+					const ChunkCoord coord = { x, y, z };
+					if (!requested[coord])
+						requested[coord] = jobs.request(coord);
+				}
+
+		// A simulated frame per chunk border, then whatever is still missing is waited for
+		std::this_thread::sleep_for(std::chrono::duration<double>(VoxelChunk::SIZE / SPEED));
+		ChunkJobSystem::Result result;
+		while (pass.meshes.size() < requested.size())
+		{
+			if (jobs.popCompleted(result))
+				pass.meshes[result.coord] = result.mesh.checksum();
+			else
+				std::this_thread::yield();
+		}
+	}
+	pass.seconds = timer.elapsedSeconds() - (STEPS + 1) * VoxelChunk::SIZE / SPEED;
+	pass.chunks = pass.meshes.size();
+	pass.stats = streamer.getStats();
+	return pass;
+}
+
+static void report(const char* name, const Pass& pass)
+{
+	const ChunkStreamer::Stats& s = pass.stats;
+	printf("  %-10s %6.1f ms for %zu chunks  %6.1f us/chunk  hit rate %5.1f%% (%zu stalls)  %zu generated\n",
+		name, pass.seconds * 1e3, pass.chunks, pass.seconds * 1e6 / pass.chunks, s.hitRate() * 100.0, s.stalls, s.absent);
+	printf("             %zu reads, %.1f KiB read, %.1f KiB written, latency %.2f ms average %.2f ms max, %zu resident (%.1f KiB)\n",
+		s.reads, s.bytesRead / 1024.0, s.bytesWritten / 1024.0, s.averageLatencyMs, s.maxLatencyMs, s.resident, s.residentBytes / 1024.0);
+}
+
+int main(int argc, char const *argv[])
+{
+	const std::string directory = (std::filesystem::temp_directory_path() / "voxspatium-streamer-benchmark").string();
+	std::error_code error;
+	std::filesystem::remove_all(directory, error);
+
+	const ChunkStreamer::Settings settings = {
+		directory,
+		RADIUS + 2,        // ringRadius
+		VERTICAL_RADIUS,   // ringVerticalRadius
+		2.0f,              // prefetchSeconds
+		64 * 1024 * 1024,  // memoryBudgetBytes
+		true               // saveGenerated
+	};
+
+	printf("Chunk streamer benchmark (%d steps of a chunk, %dx%dx%d chunks around each)\n",
+		STEPS, 2 * RADIUS + 1, 2 * VERTICAL_RADIUS + 1, 2 * RADIUS + 1);
+
+	// The first flight generates and saves everything, the second loads it back
+	const Pass generated = fly(settings);
+	report("generate", generated);
+	const Pass loaded = fly(settings);
+	report("load", loaded);
+
+	bool ok = generated.meshes.size() == loaded.meshes.size();
+	for (const auto& mesh : generated.meshes)
+	{
+		auto it = loaded.meshes.find(mesh.first);
+		if (it == loaded.meshes.end() || it->second != mesh.second)
+		{
+			printf("  MISMATCH: chunk %d %d %d meshes differently when loaded\n", mesh.first.x, mesh.first.y, mesh.first.z);
+			ok = false;
+			break;
+		}
+	}
+	if (loaded.stats.absent != 0)
+	{
+		printf("  MISMATCH: %zu chunks were generated again\n", loaded.stats.absent);
+		ok = false;
+	}
+
+	std::filesystem::remove_all(directory, error);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file    UniformBenchmark.cpp
+ * @brief   Per-draw uniform update cost, string lookups vs UniformHandle
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "Benchmark.h"
+#include "Camera.h"
+#include "Shader.h"
+#include "StreamBuffer.h"
+#include "UniformBlocks.h"
+
+// Uniform updates of one chunk draw, repeated DRAWS times per run
+static const size_t DRAWS = 10000;
+
+static void report(const char* name, double seconds, double reference)
+{
+	printf("  %-40s %8.1f ns/draw  x%.2f\n", name, seconds * 1e9 / DRAWS, reference / seconds);
+}
+
+int main(int argc, char* argv[])
+{
+	if (SDL_Init(SDL_INIT_VIDEO) < 0)
+	{
+		printf("SDL could not initialize! SDL_Error: %s\n", SDL_GetError());
+		return 1;
+	}
+
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+
+	SDL_Window* window = SDL_CreateWindow("uniform_benchmark", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+		64, 64, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+	SDL_GLContext context = window ? SDL_GL_CreateContext(window) : NULL;
+	if (!context)
+	{
+		printf("OpenGL context could not be created! SDL Error: %s\n", SDL_GetError());
+		return 1;
+	}
+	glewExperimental = GL_TRUE;
+	glewInit();
+
+	// Camera matrices come from the Camera uniform block, the model matrix is per draw
+	Shader& shader = Shader::createShader("data/shaders/planet.vert", "data/shaders/planet.frag");
+	shader.linkShaders();
+	shader.start();
+
+	Camera camera(glm::dvec3(0.0, 64.0, 0.0));
+	UniformHandle<glm::mat4> model = shader.getUniform<glm::mat4>("modelMatrix");
+
+	printf("Uniform update benchmark (%s, model per draw)\n",
+		reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+
+	glm::mat4 matrix(1.0f);
+	double strings = benchRepeat([&]() {
+		for (size_t i = 0; i < DRAWS; i++)
+			shader.setUniform("modelMatrix", matrix);
+		glFinish();
+	});
+	report("setUniform(std::string)", strings, strings);
+
+	report("UniformHandle", benchRepeat([&]() {
+		for (size_t i = 0; i < DRAWS; i++)
+			model.set(matrix);
+		glFinish();
+	}), strings);
+
+	// What a frame adds for the camera: one block upload, however many programs read it
+	report("UniformHandle + camera block per frame", benchRepeat([&]() {
+		CameraBlock block;
+		camera.writeUniforms(block);
+		UniformBlocks::getInstance().upload(UNIFORM_BLOCK_CAMERA, block);
+		for (size_t i = 0; i < DRAWS; i++)
+			model.set(matrix);
+		glFinish();
+		StreamBuffer::getInstance().frame();
+	}), strings);
+
+	// Without the GL calls: only what the engine adds on top of the driver
+	GLuint sum = 0;
+	double lookups = benchRepeat([&]() {
+		for (size_t i = 0; i < DRAWS; i++)
+			sum += shader.getUniformLocation("modelMatrix");
+		benchKeep(sum);
+	});
+	report("string lookups only", lookups, lookups);
+	report("handle locations only", benchRepeat([&]() {
+		for (size_t i = 0; i < DRAWS; i++)
+			sum += model.getLocation();
+		benchKeep(sum);
+	}), lookups);
+
+	UniformBlocks::getInstance().release();
+	StreamBuffer::getInstance().release();
+
+	SDL_GL_DeleteContext(context);
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+	return 0;
+}
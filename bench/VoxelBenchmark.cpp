@@ -0,0 +1,169 @@
+/**
+ * @file    VoxelBenchmark.cpp
+ * @brief   ChunkStore get/set throughput and memory per chunk
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "Benchmark.h"
+#include "util/SimplexNoise.h"
+#include "voxel/ChunkStore.h"
+
+#include <vector>
+
+// World of WORLD_X x WORLD_Y x WORLD_Z chunks, centered on the origin horizontally
+static const int WORLD_X = 8, WORLD_Y = 4, WORLD_Z = 8;
+static const int SIZE_X = WORLD_X * VoxelChunk::SIZE;
+static const int SIZE_Y = WORLD_Y * VoxelChunk::SIZE;
+static const int SIZE_Z = WORLD_Z * VoxelChunk::SIZE;
+static const int MIN_X = -SIZE_X / 2, MIN_Z = -SIZE_Z / 2;
+static const size_t RANDOM_OPS = 1 << 22;
+
+static const Voxel STONE = 1, DIRT = 2, GRASS = 3;
+
+static inline uint32_t xorshift(uint32_t& state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+// Layered terrain: stone, dirt and grass under a fBm heightmap, air above
+static std::vector<Voxel> terrain()
+{
+	SimplexNoise noise(0.01f, 1.0f, 2.0f, 0.5f);
+	std::vector<Voxel> voxels(static_cast<size_t>(SIZE_X) * SIZE_Y * SIZE_Z, VOXEL_AIR);
+	for (int z = 0; z < SIZE_Z; z++)
+		for (int x = 0; x < SIZE_X; x++)
+		{
+			int height = static_cast<int>(SIZE_Y * (0.5f + 0.3f * noise.fractal(5, x + MIN_X, z + MIN_Z)));
+			for (int y = 0; y < height && y < SIZE_Y; y++)
+				voxels[x + y * SIZE_X + static_cast<size_t>(z) * SIZE_X * SIZE_Y] =
+					y == height - 1 ? GRASS : y > height - 4 ? DIRT : STONE;
+		}
+	return voxels;
+}
+
+static void report(const char* name, double seconds, size_t operations)
+{
+	printf("  %-34s %8.1f Mvoxel/s  %6.2f ns/voxel\n", name, operations / seconds * 1e-6, seconds * 1e9 / operations);
+}
+
+static void reportMemory(const char* name, const ChunkStore& store)
+{
+	ChunkStore::MemoryStats stats = store.getMemoryStats();
+	printf("  %-20s %4zu chunks (%zu uniform, %zu paletted, %zu direct)  %9.0f bytes/chunk  %5.1f%% of dense\n",
+		name, stats.chunks, stats.uniformChunks, stats.palettedChunks, stats.directChunks,
+		stats.bytesPerChunk, 100.0 * stats.bytes / stats.denseBytes);
+}
+
+int main(int argc, char const *argv[])
+{
+	bool ok = true;
+	const std::vector<Voxel> reference = terrain();
+	const size_t volume = reference.size();
+
+	printf("ChunkStore benchmark (%dx%dx%d chunks of %d^3)\n", WORLD_X, WORLD_Y, WORLD_Z, VoxelChunk::SIZE);
+
+	// Sequential, in chunk-friendly order so the last-chunk cache hits
+	ChunkStore store;
+	report("sequential set", benchRepeat([&]() {
+		store.clear();
+		for (int z = 0; z < SIZE_Z; z++)
+			for (int y = 0; y < SIZE_Y; y++)
+				for (int x = 0; x < SIZE_X; x++)
+					store.setVoxel(x + MIN_X, y, z + MIN_Z, reference[x + y * SIZE_X + static_cast<size_t>(z) * SIZE_X * SIZE_Y]);
+	}), volume);
+
+	size_t sum = 0;
+	report("sequential get", benchRepeat([&]() {
+		for (int z = 0; z < SIZE_Z; z++)
+			for (int y = 0; y < SIZE_Y; y++)
+				for (int x = 0; x < SIZE_X; x++)
+					sum += store.getVoxel(x + MIN_X, y, z + MIN_Z);
+		benchKeep(sum);
+	}), volume);
+
+	for (int z = 0; z < SIZE_Z && ok; z++)
+		for (int y = 0; y < SIZE_Y && ok; y++)
+			for (int x = 0; x < SIZE_X && ok; x++)
+				if (store.getVoxel(x + MIN_X, y, z + MIN_Z) != reference[x + y * SIZE_X + static_cast<size_t>(z) * SIZE_X * SIZE_Y])
+				{
+					printf("  MISMATCH: sequential store differs at %d %d %d\n", x + MIN_X, y, z + MIN_Z);
+					ok = false;
+				}
+
+	reportMemory("terrain", store);
+
+	// Random access, every operation in a different chunk most of the time
+	std::vector<int> coords(RANDOM_OPS * 3);
+	uint32_t state = 2463534242u;
+	for (size_t i = 0; i < RANDOM_OPS; i++)
+	{
+		coords[i * 3 + 0] = static_cast<int>(xorshift(state) % SIZE_X) + MIN_X;
+		coords[i * 3 + 1] = static_cast<int>(xorshift(state) % SIZE_Y);
+		coords[i * 3 + 2] = static_cast<int>(xorshift(state) % SIZE_Z) + MIN_Z;
+	}
+
+	report("random get", benchRepeat([&]() {
+		for (size_t i = 0; i < RANDOM_OPS; i++)
+			sum += store.getVoxel(coords[i * 3], coords[i * 3 + 1], coords[i * 3 + 2]);
+		benchKeep(sum);
+	}), RANDOM_OPS);
+
+	std::vector<Voxel> dense(reference);
+	report("random set", benchRepeat([&]() {
+		for (size_t i = 0; i < RANDOM_OPS; i++)
+		{
+			Voxel voxel = static_cast<Voxel>(i & 7);
+			store.setVoxel(coords[i * 3], coords[i * 3 + 1], coords[i * 3 + 2], voxel);
+			dense[(coords[i * 3] - MIN_X) + coords[i * 3 + 1] * SIZE_X + static_cast<size_t>(coords[i * 3 + 2] - MIN_Z) * SIZE_X * SIZE_Y] = voxel;
+		}
+	}), RANDOM_OPS);
+
+	for (int z = 0; z < SIZE_Z && ok; z++)
+		for (int y = 0; y < SIZE_Y && ok; y++)
+			for (int x = 0; x < SIZE_X && ok; x++)
+				if (store.getVoxel(x + MIN_X, y, z + MIN_Z) != dense[x + y * SIZE_X + static_cast<size_t>(z) * SIZE_X * SIZE_Y])
+				{
+					printf("  MISMATCH: random store differs at %d %d %d\n", x + MIN_X, y, z + MIN_Z);
+					ok = false;
+				}
+
+	reportMemory("after random sets", store);
+
+	// The chunk looked up last must still be found once compact() dropped the cache
+	const ChunkCoord solid = { -1000, 0, 0 };
+	store.insertChunk(solid, std::unique_ptr<VoxelChunk>(new VoxelChunk(STONE)));
+	store.compact();
+	reportMemory("compacted", store);
+	if (store.getVoxel(solid.x * VoxelChunk::SIZE, solid.y * VoxelChunk::SIZE, solid.z * VoxelChunk::SIZE) != STONE)
+	{
+		printf("  MISMATCH: the last inserted chunk reads as air after compact()\n");
+		ok = false;
+	}
+
+	// Noise with more than 256 materials per chunk falls back to direct storage
+	ChunkStore noisy;
+	for (int z = 0; z < VoxelChunk::SIZE; z++)
+		for (int y = 0; y < VoxelChunk::SIZE; y++)
+			for (int x = 0; x < VoxelChunk::SIZE; x++)
+				noisy.setVoxel(x, y, z, static_cast<Voxel>(1 + xorshift(state) % 1024));
+	reportMemory("random materials", noisy);
+
+	return ok ? 0 : 1;
+}
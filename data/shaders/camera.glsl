@@ -0,0 +1,7 @@
+// Per frame, see CameraBlock
+layout(std140) uniform Camera {
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 position;
+} camera;
@@ -0,0 +1,19 @@
+#version 330
+
+in vec3 normal;
+in vec3 surfacePosition;
+in float occlusion;
+flat in uint voxelMaterial;
+
+out vec4 fragColor;
+
+#include "lighting.glsl"
+
+void main(void) {
+	// Placeholder palette until materials get textures
+	vec3 albedo = vec3(
+		float((voxelMaterial * 97u) % 255u),
+		float((voxelMaterial * 57u) % 255u),
+		float((voxelMaterial * 23u) % 255u)) / 255.0 * 0.6 + 0.3;
+	fragColor = vec4(shade(albedo * (0.4 + 0.6 * occlusion), normal, surfacePosition), 1.0);
+}
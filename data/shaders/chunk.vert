@@ -0,0 +1,28 @@
+#version 330
+
+layout(location = 0) in uint position;
+layout(location = 1) in uint material;
+// Chunk corner relative to the camera's floating origin, per draw
+layout(location = 2) in vec3 chunkOffset;
+
+out vec3 normal;
+out vec3 surfacePosition;
+out float occlusion;
+flat out uint voxelMaterial;
+
+#include "camera.glsl"
+
+const vec3 faceNormals[6] = vec3[6](
+	vec3(1.0, 0.0, 0.0), vec3(-1.0, 0.0, 0.0),
+	vec3(0.0, 1.0, 0.0), vec3(0.0, -1.0, 0.0),
+	vec3(0.0, 0.0, 1.0), vec3(0.0, 0.0, -1.0)
+);
+
+void main(void) {
+	vec3 local = vec3(float(position & 63u), float((position >> 6) & 63u), float((position >> 12) & 63u));
+	normal = faceNormals[(position >> 18) & 7u];
+	occlusion = float((position >> 21) & 3u) / 3.0;
+	voxelMaterial = material;
+	surfacePosition = chunkOffset + local;
+	gl_Position = camera.viewProjection * vec4(surfacePosition, 1.0);
+}
@@ -0,0 +1,59 @@
+// Ambient, sun and clustered lights with fog, for the lit fragment shaders
+#include "camera.glsl"
+
+// Per frame, see EnvironmentBlock
+layout(std140) uniform Environment {
+	vec4 ambient;
+	vec4 sunDirection;
+	vec4 sunColor;
+	vec4 fogColor;
+	vec4 fogRange;
+} environment;
+
+// Per frame, see ClustersBlock
+layout(std140) uniform Clusters {
+	vec4 scale;
+	ivec4 grid;
+} clusters;
+
+// Four texels per light: position and range, color and cos inner angle,
+// direction and cos outer angle, attenuation
+uniform samplerBuffer lightData;
+// Offset and count into lightIndices for every cluster
+uniform usamplerBuffer clusterData;
+uniform usamplerBuffer lightIndices;
+
+// Point and spot lights of the fragment's cluster
+vec3 clusterLights(vec3 n, vec3 position) {
+	float depth = max(-(camera.view * vec4(position, 1.0)).z, 1e-3);
+	ivec3 cell = ivec3(ivec2(gl_FragCoord.xy * clusters.scale.xy), int(floor(log(depth) * clusters.scale.z + clusters.scale.w)));
+	cell = clamp(cell, ivec3(0), clusters.grid.xyz - 1);
+	uvec2 range = texelFetch(clusterData, cell.x + clusters.grid.x * (cell.y + clusters.grid.y * cell.z)).xy;
+
+	vec3 light = vec3(0.0);
+	for (uint i = range.x; i < range.x + range.y; i++) {
+		int base = int(texelFetch(lightIndices, int(i)).x) * 4;
+		vec4 positionRange = texelFetch(lightData, base);
+		vec4 colorInner = texelFetch(lightData, base + 1);
+		vec4 directionOuter = texelFetch(lightData, base + 2);
+		vec3 k = texelFetch(lightData, base + 3).xyz;
+
+		vec3 toLight = positionRange.xyz - position;
+		float d = length(toLight);
+		vec3 l = toLight / d;
+		// Faded out towards the range the light was clustered with
+		float window = clamp(1.0 - pow(d / positionRange.w, 4.0), 0.0, 1.0);
+		float cone = smoothstep(directionOuter.w, colorInner.w, dot(-l, directionOuter.xyz));
+		light += colorInner.rgb * max(dot(n, l), 0.0) * window * window * cone / (k.x + k.y * d + k.z * d * d);
+	}
+	return light;
+}
+
+// Ambient, sun and clustered lights, then fog by the distance from the camera
+vec3 shade(vec3 albedo, vec3 n, vec3 position) {
+	vec3 light = environment.ambient.rgb + environment.sunColor.rgb * max(dot(n, environment.sunDirection.xyz), 0.0);
+	light += clusterLights(n, position);
+	float fog = clamp((length(position - camera.position.xyz) - environment.fogRange.x) /
+		(environment.fogRange.y - environment.fogRange.x), 0.0, 1.0);
+	return mix(albedo * light, environment.fogColor.rgb, fog);
+}
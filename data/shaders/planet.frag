@@ -0,0 +1,19 @@
+#version 330
+
+in vec3 surfaceNormal;
+in vec3 surfacePosition;
+in float surfaceElevation;
+
+out vec4 fragColor;
+
+#include "lighting.glsl"
+
+void main(void) {
+	// Placeholder elevation bands: sea, shore, lowland, rock and snow
+	vec3 albedo = vec3(0.10, 0.25, 0.55);
+	albedo = mix(albedo, vec3(0.76, 0.70, 0.50), step(0.0, surfaceElevation));
+	albedo = mix(albedo, vec3(0.25, 0.50, 0.20), step(0.03, surfaceElevation));
+	albedo = mix(albedo, vec3(0.45, 0.40, 0.35), step(0.25, surfaceElevation));
+	albedo = mix(albedo, vec3(0.95, 0.95, 0.97), step(0.45, surfaceElevation));
+	fragColor = vec4(shade(albedo, normalize(surfaceNormal), surfacePosition), 1.0);
+}
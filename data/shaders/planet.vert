@@ -0,0 +1,20 @@
+#version 330
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+layout(location = 2) in float elevation;
+
+out vec3 surfaceNormal;
+out vec3 surfacePosition;
+out float surfaceElevation;
+
+#include "camera.glsl"
+
+uniform mat4 modelMatrix;
+
+void main(void) {
+	surfaceNormal = normal;
+	surfaceElevation = elevation;
+	surfacePosition = (modelMatrix * vec4(position, 1.0)).xyz;
+	gl_Position = camera.viewProjection * vec4(surfacePosition, 1.0);
+}
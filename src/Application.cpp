@@ -22,25 +22,174 @@
 #include "Application.h"
 #include "util/Log.h"
 #include "Shader.h"
+#include "ShaderCache.h"
+#include "GLState.h"
+#include "GPUProfiler.h"
+#include "StreamBuffer.h"
+#include "UniformBlocks.h"
+#include "Environment.h"
+#include "util/Profiler.h"
+#include "CameraPath.h"
+#include "util/FrameReport.h"
+#include "voxel/ChunkWorld.h"
+#include "voxel/VoxelRaycaster.h"
+#include "planet/PlanetTerrain.h"
+#include "lighting/ClusteredLighting.h"
+#include "physics/CharacterController.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Terrain streaming around the camera
+static const ChunkWorld::Settings WORLD_SETTINGS = {
+	8,                  // viewRadius
+	3,                  // verticalRadius
+	4 * 1024 * 1024,    // uploadBudgetBytes
+	16,                 // maxUploadsPerFrame
+	0,                  // threads
+	{
+		1 << 21,        // renderer.pageVertices, 16 MiB
+		1 << 22,        // renderer.pageIndices, 16 MiB
+		true            // renderer.multiDrawIndirect
+	},
+	{
+		"",             // streamer.directory, see setSaveDirectory()
+		10,             // streamer.ringRadius, two past the view radius
+		4,              // streamer.ringVerticalRadius
+		2.0f,           // streamer.prefetchSeconds
+		32 * 1024 * 1024, // streamer.memoryBudgetBytes
+		true            // streamer.saveGenerated
+	}
+};
+
+// Per frame region of the stream buffer: the chunk upload budget, which the last mesh
+// of a frame may overshoot, and the frame's draw data
+static const size_t STREAM_REGION_BYTES = 2 * WORLD_SETTINGS.uploadBudgetBytes;
+
+// Planet in the sky of the voxel terrain, at radius 4096 +- 160
+static const glm::dvec3 PLANET_CENTER(0.0, 2000.0, 12000.0);
+static const PlanetTerrain::Settings PLANET_SETTINGS = {
+	{
+		4242,           // seed
+		4096.0,         // radius
+		160.0f,         // heightScale
+		0.002f,         // frequency
+		8               // octaves
+	},
+	12,                 // maxLevel
+	2.0f,               // maxScreenError
+	2.0,                // generationBudgetMs
+	16                  // maxPatchesPerFrame
+};
+
+// Point and spot lights, clustered on a 16 x 9 screen grid with 24 depth slices
+static const ClusteredLighting::Settings LIGHTING_SETTINGS = {
+	{
+		16,             // grid.tilesX
+		9,              // grid.tilesY
+		24,             // grid.slices
+		4.0f,           // grid.sliceNear
+		2048.0f,        // grid.sliceFar
+		0               // grid.threads
+	},
+	1.0f / 64.0f,       // minIntensity
+	256.0f              // maxRange
+};
+
+// Colored point lights scattered over the terrain around the spawn
+static const int DEMO_LIGHTS = 256;
 
-/* TEMPORARY TEST CODE */
+const char* const Application::SAVE_DIRECTORY = "saves/world";
+
+const Application::HeadlessSettings Application::HEADLESS_DEFAULTS = {
+	600,                // frames
+	1280,               // width
+	720,                // height
+	1200,               // maxWarmupFrames
+	"",                 // cameraPath
+	"perf-report.json", // reportPath
+	""                  // tracePath
+};
+
+// Written when P is pressed
+static const char* TRACE_FILE = "trace.json";
+
+// Reach of the voxel picked with the left mouse button
+static const double PICK_DISTANCE = 256.0;
+
+// Body the camera rides when walking (F toggles walking and flying)
+static const CharacterController::Settings WALKER_SETTINGS = {
+	0.3,     // halfWidth
+	1.8,     // height
+	1.6,     // eyeHeight
+	1.0,     // stepHeight
+	28.0,    // gravity
+	9.0,     // jumpSpeed
+	60.0     // maxFallSpeed
+};
+static const double WALK_SPEED = 4.3;
+
+// Simulation runs at a fixed rate, rendering interpolates between the last two steps
+static const FrameScheduler::Settings FRAME_SETTINGS = {
+	60.0,               // simulationRate
+	8,                  // maxStepsPerFrame
+	0.0                 // frameRateCap
+};
 
-float vertices[] = {
-	10.0f, 0.0f,  10.0f,  // top right
-	10.0f, 0.0f, -10.0f,  // bottom right
-	-10.0f, 0.0f, -10.0f, // bottom left
-	-10.0f, 0.0f,  10.0f   // top left
+// Frame stages timed by the headless report
+enum FrameStage
+{
+	STAGE_EVENTS,
+	STAGE_SIMULATION,
+	STAGE_WORLD,
+	STAGE_RENDER,
+	STAGE_PRESENT,
+	FRAME_STAGES
 };
 
-unsigned int indices[] = {
-	0, 1, 3, 1, 2, 3
+// Per-frame counters of the headless report
+enum FrameCounter
+{
+	COUNTER_CHUNK_DRAW_CALLS,
+	COUNTER_CHUNKS_DRAWN,
+	COUNTER_CHUNK_FRAGMENTATION,
+	COUNTER_LIGHT_CLUSTER_MS,
+	FRAME_COUNTERS
 };
 
-/* END OF TEMPORARY TEST CODE */
+static double elapsedMs(Uint64 from, Uint64 to)
+{
+	return (to - from) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+Application::Application() : m_width(1920), m_height(1080), m_world(nullptr), m_planet(nullptr), m_lighting(nullptr), m_walker(nullptr), m_scheduler(FRAME_SETTINGS), m_multiDraw(true), m_saveDirectory(SAVE_DIRECTORY), m_headless(false),
+	m_offscreenFBO(0), m_offscreenColor(0), m_offscreenDepth(0)
+{
+
+}
+
+void Application::setHeadless(const HeadlessSettings& settings)
+{
+	m_headless = true;
+	m_headlessSettings = settings;
+	m_width = settings.width;
+	m_height = settings.height;
+	m_mouselock = false;
+}
 
-Application::Application() : m_width(1920), m_height(1080)
+void Application::setSaveDirectory(const std::string& directory)
 {
+	m_saveDirectory = directory;
+}
 
+void Application::setFrameRateCap(double framesPerSecond)
+{
+	m_scheduler.setFrameRateCap(framesPerSecond);
+}
+
+void Application::setMultiDrawIndirect(bool enabled)
+{
+	m_multiDraw = enabled;
 }
 
 Application::~Application()
@@ -50,6 +199,8 @@ Application::~Application()
 
 void Application::initialize()
 {
+	m_startup = SDL_GetPerformanceCounter();
+
 	if (SDL_Init(SDL_INIT_VIDEO) < 0)
 	{
 		printf("SDL could not initialize! SDL_Error: %s\n", SDL_GetError());
@@ -63,7 +214,7 @@ void Application::initialize()
 		SDL_WINDOWPOS_CENTERED,
 		m_width,
 		m_height,
-		SDL_WINDOW_OPENGL
+		SDL_WINDOW_OPENGL | (m_headless ? SDL_WINDOW_HIDDEN : 0)
 	);
 
 	if (!m_window)
@@ -88,18 +239,81 @@ void Application::initialize()
 
 	SDL_GL_MakeCurrent(m_window, m_glContext);
 
+	// The frame cap does the pacing, waiting on vsync as well would only add latency
+	if (m_scheduler.getFrameRateCap() > 0.0)
+		SDL_GL_SetSwapInterval(0);
+
 	// Initialize GLEW
 	glewInit();
 
+	// Reverse-Z needs clip space depth in [0, 1], without it the remap to [-1, 1]
+	// throws away the precision gained from storing 1/z
+	bool reverseZ = GLEW_VERSION_4_5 || GLEW_ARB_clip_control;
+	if (reverseZ)
+	{
+		glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
+		glClearDepth(0.0);
+	}
+
+	// A hidden window has no guaranteed default framebuffer, render into our own
+	if (m_headless && !createOffscreenTarget(reverseZ))
+	{
+		printf("Offscreen framebuffer could not be created!\n");
+		return;
+	}
+
 	// Create camera
-	m_camera = new Camera(glm::vec3(0.0f, 1.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f), 90.0f, 0.0f);
+	m_camera = new Camera(glm::dvec3(0.0, 64.0, -1.0), glm::vec3(0.0f, 1.0f, 0.0f), 90.0f, 0.0f);
+	m_camera->setReverseZ(reverseZ);
 
 	// Run the engine
 	run();
 }
 
+bool Application::createOffscreenTarget(bool floatDepth)
+{
+	glGenFramebuffers(1, &m_offscreenFBO);
+	glGenRenderbuffers(1, &m_offscreenColor);
+	glGenRenderbuffers(1, &m_offscreenDepth);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, m_offscreenColor);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_width, m_height);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_offscreenDepth);
+	// Reverse-Z only pays off with a floating point depth buffer
+	glRenderbufferStorage(GL_RENDERBUFFER, floatDepth ? GL_DEPTH_COMPONENT32F : GL_DEPTH_COMPONENT24, m_width, m_height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_offscreenFBO);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_offscreenColor);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_offscreenDepth);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		releaseOffscreenTarget();
+		return false;
+	}
+
+	// Stays bound for the whole run
+	glViewport(0, 0, m_width, m_height);
+	return true;
+}
+
+void Application::releaseOffscreenTarget()
+{
+	if (m_offscreenFBO == 0)
+		return;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &m_offscreenFBO);
+	glDeleteRenderbuffers(1, &m_offscreenColor);
+	glDeleteRenderbuffers(1, &m_offscreenDepth);
+	m_offscreenFBO = m_offscreenColor = m_offscreenDepth = 0;
+}
+
 void Application::handleEvents()
 {
+	PROFILE_SCOPE("events");
+
 	/* Update the input manager */
 	Input::getInstance().flush();
 
@@ -133,6 +347,10 @@ void Application::handleEvents()
 		}
 	}
 
+	// The scripted camera path drives headless runs
+	if (m_headless)
+		return;
+
 	glm::vec2 mousepos = Input::getInstance().getMouseCoords();
 
 	// Handle Camera Movement
@@ -159,26 +377,46 @@ void Application::handleEvents()
 		}
 	}
 
-	// Handle Camera Movement Keys
-	if(Input::getInstance().isKeyDown(SDLK_w))
-		m_camera->processKeyboard(Camera_Movement::FORWARD, 0.01f);
-
-	if(Input::getInstance().isKeyDown(SDLK_s))
-		m_camera->processKeyboard(Camera_Movement::BACKWARD, 0.01f);
-
-	if(Input::getInstance().isKeyDown(SDLK_d))
-		m_camera->processKeyboard(Camera_Movement::RIGHT, 0.01f);
-
-	if(Input::getInstance().isKeyDown(SDLK_a))
-		m_camera->processKeyboard(Camera_Movement::LEFT, 0.01f);
-
-	// Print mouse position on click
+	// Pick the voxel the camera looks at
 	if(Input::getInstance().isKeyPressed(SDL_BUTTON_LEFT))
-		std::cout << "mX: " << mousepos.x << " mY: " << mousepos.y << std::endl;
+	{
+		VoxelRaycaster::Hit hit;
+		if (VoxelRaycaster(m_world->getStore()).raycast(m_camera->getPosition(), glm::dvec3(m_camera->getFront()), PICK_DISTANCE, hit))
+			logInfo("Picked voxel " + std::to_string(hit.cell.x) + " " + std::to_string(hit.cell.y) + " " + std::to_string(hit.cell.z)
+				+ " (material " + std::to_string(hit.voxel) + "), face " + std::to_string(hit.normal.x) + " "
+				+ std::to_string(hit.normal.y) + " " + std::to_string(hit.normal.z) + ", " + std::to_string(hit.distance) + " away");
+		else
+			logInfo("Picked nothing within " + std::to_string(PICK_DISTANCE));
+	}
 
 	// Toggle wireframe
 	if(Input::getInstance().isKeyPressed(SDLK_x))
 		m_wireframe = !m_wireframe;
+
+	// Toggle walking, the body starts with its eyes where the camera is
+	if(Input::getInstance().isKeyPressed(SDLK_f))
+	{
+		if (m_walker)
+		{
+			delete m_walker;
+			m_walker = nullptr;
+			logInfo("Camera: flying");
+		}
+		else
+		{
+			m_walker = new CharacterController(WALKER_SETTINGS, m_camera->getPosition() - glm::dvec3(0.0, WALKER_SETTINGS.eyeHeight, 0.0));
+			logInfo("Camera: walking");
+		}
+	}
+
+	// Dump the profiler rings
+	if(Input::getInstance().isKeyPressed(SDLK_p))
+	{
+		if (!Profiler::COMPILED_IN)
+			logWarn("Profiling markers are compiled out of this build");
+		else if (Profiler::getInstance().exportChromeTrace(TRACE_FILE))
+			logInfo(std::string("Trace written to ") + TRACE_FILE);
+	}
 }
 
 
@@ -187,79 +425,310 @@ void Application::run()
 	m_run = true;
 	m_wireframe = false;
 	m_now = SDL_GetPerformanceCounter();
-	m_last = 0;
-
-	/* TEMPORARY TEST CODE */
-	GLuint m_vao, m_vbo, m_ebo;
-
-	glGenVertexArrays(1, &m_vao);
-	glBindVertexArray(m_vao);
 
-	glGenBuffers(1, &m_vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+	Shader& chunkShader = Shader::createShader("data/shaders/chunk.vert", "data/shaders/chunk.frag");
+	chunkShader.linkShaders();
+	Shader& planetShader = Shader::createShader("data/shaders/planet.vert", "data/shaders/planet.frag");
+	planetShader.linkShaders();
+
+	// Resolved once, setting them per draw is a plain glUniform call; camera and
+	// environment come from the per-frame uniform blocks
+	UniformHandle<glm::mat4> planetModel = planetShader.getUniform<glm::mat4>("modelMatrix");
+	ClusteredLighting::setupProgram(chunkShader);
+	ClusteredLighting::setupProgram(planetShader);
+
+	ShaderCache::getInstance().report();
+
+	// Generation and meshing run on worker threads, the loop only uploads finished meshes
+	StreamBuffer& streamBuffer = StreamBuffer::getInstance();
+	streamBuffer.setRegionSize(STREAM_REGION_BYTES);
+	streamBuffer.getBuffer();
+	logInfo(streamBuffer.isPersistent() ? "Stream buffer: persistent mapping" : "Stream buffer: unsynchronized mapping");
+	ChunkWorld::Settings worldSettings = WORLD_SETTINGS;
+	worldSettings.renderer.multiDrawIndirect = m_multiDraw;
+	worldSettings.streamer.directory = m_saveDirectory;
+	m_world = new ChunkWorld(TerrainGenerator(), worldSettings);
+	logInfo(m_world->getRenderer().isMultiDrawIndirect() ? "Chunks: indirect multi-draw" : "Chunks: one draw per chunk");
+	logInfo(m_saveDirectory.empty() ? "Chunks: not saved" : "Chunks: saved to " + m_saveDirectory);
+	// Planet patches are generated on this thread, a few per frame
+	m_planet = new PlanetTerrain(PLANET_CENTER, PLANET_SETTINGS);
+
+	// Same lights on every run, on a golden angle spiral so headless reports compare
+	Environment& environment = Environment::getInstance();
+	for (int i = 0; i < DEMO_LIGHTS; i++)
+	{
+		const float angle = i * 2.39996323f;
+		const float distance = 8.0f * std::sqrt(static_cast<float>(i));
+		const glm::vec3 color(0.5f + 0.5f * std::cos(angle), 0.5f + 0.5f * std::cos(angle + 2.094f), 0.5f + 0.5f * std::cos(angle + 4.189f));
+		environment.addLight(Light(glm::vec3(distance * std::cos(angle), 48.0f + (i % 5) * 4.0f, distance * std::sin(angle)),
+			color * 2.0f, glm::vec3(1.0f, 0.1f, 0.05f)));
+	}
+	m_lighting = new ClusteredLighting(LIGHTING_SETTINGS);
 
-	glGenBuffers(1, &m_ebo);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+	CameraPath path;
+	FrameReport report({ "events", "simulation", "world", "render", "present" },
+		{ "chunkDrawCalls", "chunksDrawn", "chunkBufferFragmentation", "lightClusterMs" });
+	bool measuring = false;
+	int warmupFrames = 0;
 
-	Shader& testShader = Shader::createShader("data/shaders/test.vert", "data/shaders/test.frag");
-	testShader.linkShaders();
+	if (m_headless)
+	{
+		if (!m_headlessSettings.cameraPath.empty() && !path.load(m_headlessSettings.cameraPath))
+			logWarn("Camera path " + m_headlessSettings.cameraPath + " could not be read, using the built-in flight");
+		report.reserve(m_headlessSettings.frames);
+		measuring = m_headlessSettings.maxWarmupFrames <= 0;
+	}
+	else
+	{
+		// Grab the mouse, disable cursor and place it in the center
+		SDL_SetWindowGrab(m_window, SDL_TRUE);
+		SDL_ShowCursor(SDL_DISABLE);
+		SDL_WarpMouseInWindow(m_window, m_width/2, m_height/2);
+	}
 
-	// Set attribute arrays
-	testShader.setAttribute("position", 3, GL_FALSE, 3, 0, GL_FLOAT);
-	/* END OF TEMPORARY TEST CODE */
+	GLState& state = GLState::getInstance();
+	state.invalidate();
+	Profiler::getInstance().setThreadName("main");
 
-	// Grab the mouse, disable cursor and place it in the center
-	SDL_SetWindowGrab(m_window, SDL_TRUE);
-	SDL_ShowCursor(SDL_DISABLE);
-	SDL_WarpMouseInWindow(m_window, m_width/2, m_height/2);
+	// Headless runs are frame-indexed, pacing them would only make them slower
+	if (m_headless)
+		m_scheduler.setFrameRateCap(0.0);
+	m_scheduler.reset();
 
 	while(m_run)
 	{
-		m_last = m_now;
+		PROFILE_SCOPE("frame");
+		double stageMs[FRAME_STAGES];
 		m_now = SDL_GetPerformanceCounter();
+		Uint64 mark = m_now;
+		int steps = m_scheduler.beginFrame();
 
 		handleEvents();
 
+		Uint64 stageEnd = SDL_GetPerformanceCounter();
+		stageMs[STAGE_EVENTS] = elapsedMs(mark, stageEnd);
+		mark = stageEnd;
+
+		for (int i = 0; i < steps; i++)
+		{
+			m_camera->storePrevious();
+			update(m_scheduler.getStep());
+		}
+		m_camera->interpolate(m_scheduler.getAlpha());
+
+		if (m_headless)
+		{
+			// Frame-indexed rather than timed, every run visits the same poses; warmup holds the first one
+			const int frames = m_headlessSettings.frames;
+			float t = measuring && frames > 1 ? path.getDuration() * report.getFrameCount() / (frames - 1) : 0.0f;
+			CameraPath::Keyframe pose = path.sample(t);
+			m_camera->setPose(glm::dvec3(pose.position), pose.yaw, pose.pitch);
+		}
+
+		stageEnd = SDL_GetPerformanceCounter();
+		stageMs[STAGE_SIMULATION] = elapsedMs(mark, stageEnd);
+		mark = stageEnd;
+
+		m_world->update(m_camera->getRenderPosition());
+		m_planet->update(m_camera->getRenderPosition(), m_camera->getFOV(), m_height);
+
+		stageEnd = SDL_GetPerformanceCounter();
+		stageMs[STAGE_WORLD] = elapsedMs(mark, stageEnd);
+		mark = stageEnd;
+
 		// Clear color buffer
 		glClearColor(0.39f, 0.58f, 0.93f, 1.f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		// Calculate time of previous frame
-		deltaTime = ((m_now - m_last) / (double)SDL_GetPerformanceFrequency());
+		// Only reaches GL on the first frame and when wireframe gets toggled
+		state.polygonMode(m_wireframe ? GL_LINE : GL_FILL);
+		state.enable(GL_DEPTH_TEST);
+		state.depthFunc(m_camera->isReverseZ() ? GL_GREATER : GL_LESS);
+		state.enable(GL_CULL_FACE);
+		state.cullFace(GL_BACK);
+
+		// Once for every program that declares the blocks
+		CameraBlock cameraBlock;
+		m_camera->writeUniforms(cameraBlock);
+		UniformBlocks::getInstance().upload(UNIFORM_BLOCK_CAMERA, cameraBlock);
+		EnvironmentBlock environmentBlock;
+		environment.writeUniforms(environmentBlock);
+		UniformBlocks::getInstance().upload(UNIFORM_BLOCK_ENVIRONMENT, environmentBlock);
+		m_lighting->update(environment, *m_camera, m_width, m_height);
 
-		// Enable wireframe rendering
-		if (m_wireframe)
-			glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
+		{
+			PROFILE_GPU_SCOPE("world");
+			chunkShader.start();
+			m_world->render(m_camera->getFrustum(), m_camera->getOrigin());
+		}
+		{
+			PROFILE_GPU_SCOPE("planet");
+			planetShader.start();
+			m_planet->render(planetModel, m_camera->getFrustum(), m_camera->getOrigin());
+		}
 
-		glEnable(GL_DEPTH_TEST);
-		glEnable(GL_CULL_FACE);
-		glCullFace(GL_BACK);
+		// Disable wireframe rendering
+		state.polygonMode(GL_FILL);
 
-		/* TEMPORARY TEST CODE */
-		testShader.setBuffers(m_vao, m_vbo, m_ebo);
-		testShader.use();
+		render();
 
-		m_camera->shaderViewProjection(testShader);
+		stageEnd = SDL_GetPerformanceCounter();
+		stageMs[STAGE_RENDER] = elapsedMs(mark, stageEnd);
+		mark = stageEnd;
 
-		testShader.setUniform("modelMatrix", glm::mat4(1.0f));
+		// Update window with OpenGL rendering, offscreen wait for the frame to finish
+		// so the GPU (or llvmpipe) work is part of the timing
+		{
+			PROFILE_SCOPE("present");
+			if (m_headless)
+				glFinish();
+			else
+				SDL_GL_SwapWindow(m_window);
+		}
+		GPUProfiler::getInstance().frame();
+		streamBuffer.frame();
 
-		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-		/* END OF TEMPORARY TEST CODE */
+		stageEnd = SDL_GetPerformanceCounter();
+		stageMs[STAGE_PRESENT] = elapsedMs(mark, stageEnd);
 
-		// Disable wireframe rendering
-		if (m_wireframe)
-			glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
+		if (m_startup != 0)
+		{
+			double startup = (SDL_GetPerformanceCounter() - m_startup) * 1000.0 / SDL_GetPerformanceFrequency();
+			logInfo("Startup: first frame after " + std::to_string(startup) + " ms");
+			m_startup = 0;
+		}
 
-		update(deltaTime);
-		render();
+		m_scheduler.endFrame();
+
+		if (!m_headless)
+			continue;
 
-		// Update window with OpenGL rendering
-		SDL_GL_SwapWindow(m_window);
+		if (measuring)
+		{
+			const ChunkRenderer::Stats chunks = m_world->getRenderer().getStats();
+			double counters[FRAME_COUNTERS];
+			counters[COUNTER_CHUNK_DRAW_CALLS] = static_cast<double>(chunks.drawCalls);
+			counters[COUNTER_CHUNKS_DRAWN] = static_cast<double>(chunks.chunks);
+			counters[COUNTER_CHUNK_FRAGMENTATION] = chunks.fragmentation;
+			counters[COUNTER_LIGHT_CLUSTER_MS] = m_lighting->getStats().assignMs;
+			report.addFrame(stageMs, elapsedMs(m_now, stageEnd), counters);
+			if (static_cast<int>(report.getFrameCount()) >= m_headlessSettings.frames)
+				exit();
+			continue;
+		}
+
+		// Start measuring once everything around the first pose is generated and uploaded
+		ChunkJobSystem::Stats jobs = m_world->getJobs().getStats();
+		bool settled = jobs.pending == 0 && jobs.running == 0 && m_world->getLastFrameUploads() == 0
+			&& m_planet->getStats().pending == 0 && m_planet->getStats().generated == 0;
+		if (settled || ++warmupFrames >= m_headlessSettings.maxWarmupFrames)
+		{
+			if (!settled)
+				logWarn("Headless: streaming did not settle within " + std::to_string(warmupFrames) + " warmup frames");
+			measuring = true;
+			state.resetStats();
+		}
 	}
 
 	// After loop exits
+	logInfo(state.formatStats());
+
+	const ChunkRenderer::Stats chunks = m_world->getRenderer().getStats();
+	logInfo("Chunk buffers: " + std::to_string(chunks.drawCalls) + " draw calls for " + std::to_string(chunks.chunks) +
+		" chunks, " + std::to_string(chunks.usedBytes >> 20) + " of " + std::to_string(chunks.capacityBytes >> 20) +
+		" MiB in " + std::to_string(chunks.pages) + " pages, " + std::to_string(chunks.freeRanges) + " free ranges, " +
+		std::to_string(static_cast<int>(chunks.fragmentation * 100.0)) + "% fragmented");
+
+	ChunkStreamer::Stats loader = {};
+	if (m_world->getStreamer())
+	{
+		loader = m_world->getStreamer()->getStats();
+		logInfo("Chunk loader: " + std::to_string(loader.hits) + " of " + std::to_string(loader.hits + loader.stalls) +
+			" saved chunks resident when needed, " + std::to_string(loader.absent) + " generated, " +
+			std::to_string(loader.bytesRead >> 10) + " KiB read, " + std::to_string(loader.bytesWritten >> 10) +
+			" KiB written, " + std::to_string(loader.averageLatencyMs) + " ms average read latency");
+	}
+
+	const StreamBuffer::Stats stream = streamBuffer.getStats();
+	logInfo("Stream buffer: " + std::to_string(stream.usedBytes >> 10) + " of " + std::to_string(stream.regionBytes >> 10) +
+		" KiB used last frame, " + std::to_string(stream.overflows) + " writes did not fit, waited " +
+		std::to_string(stream.waits) + " times for " + std::to_string(stream.waitMs) + " ms");
+
+	const ClusteredLighting::Stats lights = m_lighting->getStats();
+	logInfo("Lights: " + std::to_string(lights.grid.lights) + " in " + std::to_string(lights.grid.occupied) +
+		" clusters, " + std::to_string(lights.grid.indices) + " indices, at most " + std::to_string(lights.grid.maxPerCluster) +
+		" per cluster, assigned in " + std::to_string(lights.assignMs) + " ms");
+
+	FrameScheduler::FrameTiming average = m_scheduler.getAverage();
+	logInfo("Frames: " + std::to_string(average.frameMs) + " ms average over the last " +
+		std::to_string(m_scheduler.getHistorySize()) + " (" + std::to_string(average.workMs) + " ms work, " +
+		std::to_string(average.sleepMs) + " ms paced), " + std::to_string(m_scheduler.getDroppedSeconds()) +
+		" s of simulation dropped");
+
+	if (m_headless)
+	{
+		const GLubyte* renderer = glGetString(GL_RENDERER);
+		const GLubyte* version = glGetString(GL_VERSION);
+		const double frames = std::max<double>(report.getFrameCount(), 1.0);
+		const GLState::Stats& calls = state.getStats();
+
+		report.setInfo("renderer", renderer ? (const char*) renderer : "unknown");
+		report.setInfo("glVersion", version ? (const char*) version : "unknown");
+		report.setInfo("width", m_width);
+		report.setInfo("height", m_height);
+		report.setInfo("cameraPath", m_headlessSettings.cameraPath.empty() ? "built-in" : m_headlessSettings.cameraPath);
+		report.setInfo("pathSeconds", path.getDuration());
+		report.setInfo("warmupFrames", warmupFrames);
+		report.setInfo("viewRadius", WORLD_SETTINGS.viewRadius);
+		report.setInfo("saveDirectory", m_saveDirectory.empty() ? "none" : m_saveDirectory);
+		report.setInfo("reverseZ", m_camera->isReverseZ() ? "yes" : "no");
+		report.setInfo("workerThreads", m_world->getJobs().getThreadCount());
+		report.setInfo("loadedChunks", m_world->getLoadedCount());
+		report.setInfo("drawnChunksLastFrame", m_world->getLastFrameDrawn());
+		report.setInfo("culledChunksLastFrame", m_world->getLastFrameCulled());
+		report.setInfo("chunkMultiDrawIndirect", m_world->getRenderer().isMultiDrawIndirect() ? "yes" : "no");
+		report.setInfo("loaderHitRate", loader.hitRate());
+		report.setInfo("loaderGeneratedChunks", loader.absent);
+		report.setInfo("loaderBytesRead", loader.bytesRead);
+		report.setInfo("loaderBytesWritten", loader.bytesWritten);
+		report.setInfo("loaderAverageLatencyMs", loader.averageLatencyMs);
+		report.setInfo("loaderMaxLatencyMs", loader.maxLatencyMs);
+		report.setInfo("streamPersistent", stream.persistent ? "yes" : "no");
+		report.setInfo("streamOverflows", stream.overflows);
+		report.setInfo("streamWaitMs", stream.waitMs);
+		report.setInfo("clusteredLights", lights.grid.lights);
+		report.setInfo("lightGridSimd", LightGrid::simdName());
+		report.setInfo("planetPatches", m_planet->getStats().nodes);
+		report.setInfo("drawnPatchesLastFrame", m_planet->getStats().drawn);
+		report.setInfo("glCallsIssuedPerFrame", calls.totalIssued() / frames);
+		report.setInfo("glCallsSkippedPerFrame", calls.totalSkipped() / frames);
+
+		FrameReport::Summary frame = report.getFrameSummary();
+		logInfo("Headless: " + std::to_string(report.getFrameCount()) + " frames, p50 " + std::to_string(frame.p50) +
+			" ms, p99 " + std::to_string(frame.p99) + " ms");
+		if (report.write(m_headlessSettings.reportPath))
+			logInfo("Headless: report written to " + m_headlessSettings.reportPath);
+		else
+			logError("Headless: could not write the report to " + m_headlessSettings.reportPath);
+
+		if (!m_headlessSettings.tracePath.empty() && Profiler::getInstance().exportChromeTrace(m_headlessSettings.tracePath))
+			logInfo("Headless: trace written to " + m_headlessSettings.tracePath);
+	}
+
+	delete m_walker;
+	m_walker = nullptr;
+
+	// Stop the workers and free the chunk and patch buffers while the context still exists
+	delete m_world;
+	m_world = nullptr;
+	delete m_planet;
+	m_planet = nullptr;
+	delete m_lighting;
+	m_lighting = nullptr;
+	GPUProfiler::getInstance().release();
+	UniformBlocks::getInstance().release();
+	streamBuffer.release();
+	releaseOffscreenTarget();
 
 	// Destroy window
 	SDL_DestroyWindow(m_window);
@@ -272,9 +741,53 @@ void Application::run()
 	SDL_Quit();
 }
 
-void Application::update(GLfloat dtime)
+void Application::update(double step)
 {
+	PROFILE_SCOPE("simulation step");
 
+	if (m_walker)
+	{
+		// Walk along the view direction flattened onto the ground
+		const glm::vec3 front = m_camera->getFront();
+		const glm::dvec3 forward = glm::normalize(glm::dvec3(front.x, 0.0, front.z));
+		const glm::dvec3 right(-forward.z, 0.0, forward.x);
+		glm::dvec3 wish(0.0);
+		if(Input::getInstance().isKeyDown(SDLK_w))
+			wish += forward;
+		if(Input::getInstance().isKeyDown(SDLK_s))
+			wish -= forward;
+		if(Input::getInstance().isKeyDown(SDLK_d))
+			wish += right;
+		if(Input::getInstance().isKeyDown(SDLK_a))
+			wish -= right;
+		if (glm::dot(wish, wish) > 0.0)
+			wish = glm::normalize(wish) * WALK_SPEED;
+
+		// Hold still above chunks that are not loaded yet instead of falling through them
+		const glm::dvec3 feet = m_walker->getPosition();
+		if (m_world->isLoaded(ChunkStore::chunkOf(static_cast<int>(std::floor(feet.x)), static_cast<int>(std::floor(feet.y)), static_cast<int>(std::floor(feet.z)))))
+		{
+			VoxelCollider collider(m_world->getStore());
+			m_walker->step(collider, wish, Input::getInstance().isKeyDown(SDLK_SPACE), step);
+		}
+		m_camera->setPosition(m_walker->getEyePosition());
+		return;
+	}
+
+	// Handle Camera Movement Keys
+	const GLfloat dt = static_cast<GLfloat>(step);
+
+	if(Input::getInstance().isKeyDown(SDLK_w))
+		m_camera->processKeyboard(Camera_Movement::FORWARD, dt);
+
+	if(Input::getInstance().isKeyDown(SDLK_s))
+		m_camera->processKeyboard(Camera_Movement::BACKWARD, dt);
+
+	if(Input::getInstance().isKeyDown(SDLK_d))
+		m_camera->processKeyboard(Camera_Movement::RIGHT, dt);
+
+	if(Input::getInstance().isKeyDown(SDLK_a))
+		m_camera->processKeyboard(Camera_Movement::LEFT, dt);
 }
 
 void Application::render()
@@ -24,6 +24,12 @@
 #include "util/Singleton.h"
 #include "Camera.h"
 #include "Input.h"
+#include "FrameScheduler.h"
+
+class ChunkWorld;
+class PlanetTerrain;
+class ClusteredLighting;
+class CharacterController;
 
 class Application : public Singleton<Application>
 {
@@ -31,6 +37,34 @@ class Application : public Singleton<Application>
 		Application();
 		~Application();
 
+		// Offscreen perf run: hidden window, scripted camera path, JSON timing report
+		struct HeadlessSettings
+		{
+			int frames;
+			int width;
+			int height;
+			int maxWarmupFrames;     // frames held at the first pose until streaming settles
+			std::string cameraPath;  // empty for the built-in flight
+			std::string reportPath;
+			std::string tracePath;   // Chrome trace of the measured frames, empty for none
+		};
+		static const HeadlessSettings HEADLESS_DEFAULTS;
+
+		// Call before initialize()
+		void setHeadless(const HeadlessSettings& settings);
+
+		// Region files of the voxel terrain, chunks saved there are loaded on later runs
+		static const char* const SAVE_DIRECTORY;
+		// Empty to neither load nor save chunks (default SAVE_DIRECTORY); call before initialize()
+		void setSaveDirectory(const std::string& directory);
+
+		// Frames per second, 0 for uncapped (vsync is turned off while capped)
+		void setFrameRateCap(double framesPerSecond);
+
+		// Draw chunks with glMultiDrawElementsIndirect when supported (default), or one
+		// draw call each; call before initialize()
+		void setMultiDrawIndirect(bool enabled);
+
 		void initialize();
 		void exit() { m_run = false; }
 
@@ -41,20 +75,34 @@ class Application : public Singleton<Application>
 		int m_width, m_height;
 
 		Camera* m_camera;
+		ChunkWorld* m_world;
+		PlanetTerrain* m_planet;
+		ClusteredLighting* m_lighting;
+		CharacterController* m_walker;  // null while flying
 		SDL_Window* m_window;
 		SDL_GLContext m_glContext;
 
-		GLuint m_now;
-		GLuint m_last;
-		double deltaTime;
+		Uint64 m_startup;
+		Uint64 m_now;
+		FrameScheduler m_scheduler;
+		bool m_multiDraw;
+		std::string m_saveDirectory;
 
 		bool m_run;
 		bool m_wireframe;
 		bool m_mouselock = true;
 
+		bool m_headless;
+		HeadlessSettings m_headlessSettings;
+		GLuint m_offscreenFBO, m_offscreenColor, m_offscreenDepth;
+
+		bool createOffscreenTarget(bool floatDepth);
+		void releaseOffscreenTarget();
+
 		void handleEvents();
 		void run();
 		void render();
-		void update(GLfloat dtime);
+		// One fixed simulation step of step seconds
+		void update(double step);
 };
 #endif // __APPLICATION_H__
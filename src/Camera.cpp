@@ -25,13 +25,15 @@
 
 // TODO: use Roll
 
-Camera::Camera(glm::vec3 position, glm::vec3 up, GLfloat yaw, GLfloat pitch, GLfloat roll) :
+Camera::Camera(glm::dvec3 position, glm::vec3 up, GLfloat yaw, GLfloat pitch, GLfloat roll) :
+	m_origin(position),
+	m_reverseZ(false),
 	m_front(glm::vec3(0.0f, 0.0f, -1.0f)),
 	m_movementSpeed(SPEED),
 	m_mouseSensitivity(SENSITIVTY),
 	m_zoom(ZOOM)
 {
-	m_position = position;
+	m_position = m_previousPosition = m_renderPosition = position;
 	m_worldUp = up;
 	m_yaw = yaw;
 	m_pitch = pitch;
@@ -41,12 +43,14 @@ Camera::Camera(glm::vec3 position, glm::vec3 up, GLfloat yaw, GLfloat pitch, GLf
 }
 
 Camera::Camera(GLfloat posX, GLfloat posY, GLfloat posZ, GLfloat upX, GLfloat upY, GLfloat upZ, GLfloat yaw, GLfloat pitch, GLfloat roll) :
+	m_origin(posX, posY, posZ),
+	m_reverseZ(false),
 	m_front(glm::vec3(0.0f, 0.0f, -1.0f)),
 	m_movementSpeed(SPEED),
 	m_mouseSensitivity(SENSITIVTY),
 	m_zoom(ZOOM)
 {
-	m_position = glm::vec3(posX, posY, posZ);
+	m_position = m_previousPosition = m_renderPosition = glm::dvec3(posX, posY, posZ);
 	m_worldUp = glm::vec3(upX, upY, upZ);
 	m_yaw = yaw;
 	m_pitch = pitch;
@@ -60,29 +64,44 @@ Camera::~Camera()
 
 }
 
-glm::mat4 Camera::getViewMatrix()
+glm::mat4 Camera::getViewMatrix() const
 {
-	return glm::lookAt(m_position, m_position + m_front, m_up);
+	const glm::vec3 eye = toOrigin(m_renderPosition);
+	return glm::lookAt(eye, eye + m_front, m_up);
 }
 
-void Camera::shaderViewProjection(Shader& shader)
+Frustum Camera::getFrustum() const
 {
-	shader.setUniform("viewMatrix", getViewMatrix());
-	shader.setUniform("projectionMatrix", m_projection);
+	return Frustum(m_projection * getViewMatrix(),
+		m_reverseZ ? Frustum::CLIP_ZERO_TO_ONE : Frustum::CLIP_NEGATIVE_ONE_TO_ONE);
+}
+
+void Camera::setReverseZ(bool reverseZ)
+{
+	m_reverseZ = reverseZ;
+	updateProjection();
+}
+
+void Camera::writeUniforms(CameraBlock& block) const
+{
+	block.view = getViewMatrix();
+	block.projection = m_projection;
+	block.viewProjection = m_projection * block.view;
+	block.position = glm::vec4(toOrigin(m_renderPosition), 1.0f);
 }
 
 void Camera::processKeyboard(Camera_Movement direction, GLfloat deltaTime)
 {
-	GLfloat velocity = m_movementSpeed * deltaTime;
+	double velocity = m_movementSpeed * deltaTime;
 
 	if (direction == FORWARD)
-		m_position += m_front * velocity;
+		m_position += glm::dvec3(m_front) * velocity;
 	if (direction == BACKWARD)
-		m_position -= m_front * velocity;
+		m_position -= glm::dvec3(m_front) * velocity;
 	if (direction == LEFT)
-		m_position -= m_right * velocity;
+		m_position -= glm::dvec3(m_right) * velocity;
 	if (direction == RIGHT)
-		m_position += m_right * velocity;
+		m_position += glm::dvec3(m_right) * velocity;
 }
 
 void Camera::processMouseMovement(GLfloat xoffset, GLfloat yoffset, GLboolean constrainPitch = true)
@@ -131,11 +150,51 @@ void Camera::processMouseScroll(GLfloat yoffset)
 	updateProjection();
 }
 
+void Camera::setPose(const glm::dvec3& position, GLfloat yaw, GLfloat pitch)
+{
+	m_position = m_previousPosition = m_renderPosition = position;
+	m_yaw = yaw;
+	m_pitch = pitch;
+	updateCameraVectors();
+	rebase();
+}
+
+void Camera::interpolate(GLfloat alpha)
+{
+	m_renderPosition = glm::mix(m_previousPosition, m_position, static_cast<double>(alpha));
+	rebase();
+}
+
+void Camera::rebase(void)
+{
+	const glm::dvec3 offset = m_renderPosition - m_origin;
+	if (glm::dot(offset, offset) > REBASE_DISTANCE * REBASE_DISTANCE)
+		m_origin = glm::floor(m_renderPosition);
+}
+
 void Camera::updateProjection(void)
 {
 	// Recalculate the projection matrix
 	glm::vec2 screenDims = Application::getInstance().getScreenDimensions();
-	m_projection = glm::perspective(getFOV(), (GLfloat)screenDims.x/(GLfloat)screenDims.y, 0.1f, 1000.0f);
+	const GLfloat focal = 1.0f / std::tan(glm::radians(getFOV()) * 0.5f);
+	const GLfloat aspect = (GLfloat)screenDims.x/(GLfloat)screenDims.y;
+
+	// Infinite far plane either way, the depth range only depends on the near plane
+	m_projection = glm::mat4(0.0f);
+	m_projection[0][0] = focal / aspect;
+	m_projection[1][1] = focal;
+	m_projection[2][3] = -1.0f;
+	if (m_reverseZ)
+	{
+		// Depth is near / distance: 1 at the near plane, towards 0 at infinity, where
+		// the floating point depth buffer has its precision
+		m_projection[3][2] = NEAR_PLANE;
+	}
+	else
+	{
+		m_projection[2][2] = -1.0f;
+		m_projection[3][2] = -2.0f * NEAR_PLANE;
+	}
 }
 
 void Camera::updateCameraVectors(void)
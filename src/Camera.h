@@ -22,7 +22,7 @@
 #define __CAMERA_H__
 
 #include "util/Common.h"
-#include "Shader.h"
+#include "util/Frustum.h"
 
 // Defines several possible options for camera movement. Used as abstraction to stay away from window-system specific input methods
 enum Camera_Movement {
@@ -39,26 +39,70 @@ const GLfloat ROLL       =  0.0f;
 const GLfloat SPEED      =  10.0f;
 const GLfloat SENSITIVTY =  0.25f;
 const GLfloat ZOOM       =  45.0f;
+const GLfloat NEAR_PLANE =  0.1f;
+
+// The render origin follows the camera in jumps of this many units, so positions
+// relative to it stay small enough for float precision anywhere in the world
+const double REBASE_DISTANCE = 1024.0;
+
+// std140 layout of uniform Camera (UNIFORM_BLOCK_CAMERA), see data/shaders
+struct CameraBlock
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::mat4 viewProjection;
+	glm::vec4 position;        // relative to the render origin, w is 1
+};
 
 class Camera
 {
 public:
-	Camera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), GLfloat yaw = YAW, GLfloat pitch = PITCH, GLfloat roll = ROLL);
+	Camera(glm::dvec3 position = glm::dvec3(0.0, 0.0, 0.0), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), GLfloat yaw = YAW, GLfloat pitch = PITCH, GLfloat roll = ROLL);
 	Camera(GLfloat posX, GLfloat posY, GLfloat posZ, GLfloat upX, GLfloat upY, GLfloat upZ, GLfloat yaw, GLfloat pitch, GLfloat roll);
 	~Camera();
 
-	glm::mat4 getViewMatrix(void);
+	// View matrix relative to the render origin, world positions must go through toOrigin()
+	glm::mat4 getViewMatrix(void) const;
+	inline const glm::mat4& getProjectionMatrix(void) const { return m_projection; }
+	// Clip planes of the current view and projection, relative to the render origin
+	Frustum getFrustum(void) const;
+
+	// Reverse-Z infinite projection, needs zero-to-one clip depth (glClipControl), a
+	// depth clear of 0 and GL_GREATER; otherwise a conventional infinite projection
+	void setReverseZ(bool reverseZ);
+	inline bool isReverseZ() const { return m_reverseZ; }
+
+	// Floating origin: rendering happens in single precision relative to this point
+	inline const glm::dvec3& getOrigin(void) const { return m_origin; }
+	inline glm::vec3 toOrigin(const glm::dvec3& world) const { return glm::vec3(world - m_origin); }
+
 	void processKeyboard(Camera_Movement direction, GLfloat deltaTime);
 	void processMouseMovement(GLfloat xoffset, GLfloat yoffset, GLboolean constrainPitch);
 	void processMouseScroll(GLfloat yoffset);
+	// Place the camera directly, angles in degrees, without interpolating from the old pose
+	void setPose(const glm::dvec3& position, GLfloat yaw, GLfloat pitch);
+	// Move the camera within a simulation step, keeping the interpolation going
+	inline void setPosition(const glm::dvec3& position) { m_position = position; }
+
+	// Fixed-step interpolation: remember the position before a simulation step, then
+	// render at the blend of that and the current one. Also rebases the origin.
+	inline void storePrevious() { m_previousPosition = m_position; }
+	void interpolate(GLfloat alpha);
 
-	void shaderViewProjection(Shader& shader);
+	// This frame's contents of the camera uniform block
+	void writeUniforms(CameraBlock& block) const;
 
 	inline GLfloat getFOV() const { return m_zoom; }
-	inline glm::vec3 getPosition(void) const { return m_position; }
+	inline const glm::dvec3& getPosition(void) const { return m_position; }
+	inline const glm::dvec3& getRenderPosition(void) const { return m_renderPosition; }
+	inline const glm::vec3& getFront(void) const { return m_front; }
 
 private:
-	glm::vec3 m_position;
+	glm::dvec3 m_position;
+	glm::dvec3 m_previousPosition;
+	glm::dvec3 m_renderPosition;
+	glm::dvec3 m_origin;
+	bool m_reverseZ;
 	glm::vec3 m_front;
 	glm::vec3 m_up;
 	glm::vec3 m_right;
@@ -78,6 +122,7 @@ private:
 	glm::mat4 m_projection;
 
 	void updateCameraVectors(void);
+	void rebase(void);
 	void updateProjection(void);
 };
 #endif // __CAMERA_H__
@@ -0,0 +1,100 @@
+/**
+ * @file    CameraPath.cpp
+ * @brief   Scripted camera flight for repeatable perf runs
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "CameraPath.h"
+
+#include <fstream>
+#include <sstream>
+
+// Default flight: cross the terrain, turn around and climb, so streaming and
+// unloading both show up in the numbers
+static const CameraPath::Keyframe DEFAULT_PATH[] = {
+	{  0.0f, glm::vec3(   0.0f,  64.0f,    0.0f),  0.0f, -15.0f },
+	{ 10.0f, glm::vec3( 320.0f,  72.0f,    0.0f),  0.0f, -15.0f },
+	{ 15.0f, glm::vec3( 400.0f,  96.0f,  120.0f), 90.0f, -25.0f },
+	{ 25.0f, glm::vec3( 160.0f, 128.0f,  320.0f), 180.0f, -35.0f },
+	{ 30.0f, glm::vec3(   0.0f,  64.0f,  160.0f), 270.0f, -15.0f }
+};
+
+CameraPath::CameraPath() :
+	m_keyframes(std::begin(DEFAULT_PATH), std::end(DEFAULT_PATH))
+{
+
+}
+
+bool CameraPath::load(const std::string& path)
+{
+	std::ifstream file(path);
+	if (!file)
+		return false;
+
+	std::vector<Keyframe> keyframes;
+	std::string line;
+	while (std::getline(file, line))
+	{
+		line = line.substr(0, line.find('#'));
+		if (line.find_first_not_of(" \t\r") == std::string::npos)
+			continue;
+
+		std::istringstream fields(line);
+		Keyframe key;
+		if (!(fields >> key.time >> key.position.x >> key.position.y >> key.position.z >> key.yaw >> key.pitch))
+			return false;
+		if (!keyframes.empty() && key.time < keyframes.back().time)
+			return false;
+		keyframes.push_back(key);
+	}
+
+	if (keyframes.empty())
+		return false;
+
+	m_keyframes = keyframes;
+	return true;
+}
+
+void CameraPath::setKeyframes(const std::vector<Keyframe>& keyframes)
+{
+	if (!keyframes.empty())
+		m_keyframes = keyframes;
+}
+
+CameraPath::Keyframe CameraPath::sample(float time) const
+{
+	if (time <= m_keyframes.front().time)
+		return m_keyframes.front();
+
+	for (size_t i = 1; i < m_keyframes.size(); i++)
+	{
+		const Keyframe& a = m_keyframes[i - 1];
+		const Keyframe& b = m_keyframes[i];
+		if (time > b.time)
+			continue;
+
+		float t = b.time > a.time ? (time - a.time) / (b.time - a.time) : 1.0f;
+		Keyframe key;
+		key.time = time;
+		key.position = glm::mix(a.position, b.position, t);
+		key.yaw = a.yaw + (b.yaw - a.yaw) * t;
+		key.pitch = a.pitch + (b.pitch - a.pitch) * t;
+		return key;
+	}
+
+	return m_keyframes.back();
+}
@@ -0,0 +1,59 @@
+/**
+ * @file    CameraPath.h
+ * @brief   Scripted camera flight for repeatable perf runs
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __CAMERAPATH_H__
+#define __CAMERAPATH_H__
+
+#include "util/Math3D.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * Keyframed camera poses, linearly interpolated. A path file has one keyframe per line,
+ * "time x y z yaw pitch" with time in seconds and angles in degrees, keyframes in
+ * increasing time; '#' starts a comment.
+ */
+class CameraPath
+{
+	public:
+		struct Keyframe
+		{
+			float time;
+			glm::vec3 position;
+			float yaw;
+			float pitch;
+		};
+
+		CameraPath();
+
+		// Replaces the keyframes, false (path unchanged) if the file can't be read or is malformed
+		bool load(const std::string& path);
+		void setKeyframes(const std::vector<Keyframe>& keyframes);
+
+		// Pose at time seconds, clamped to the ends of the path
+		Keyframe sample(float time) const;
+
+		inline float getDuration() const { return m_keyframes.back().time; }
+		inline const std::vector<Keyframe>& getKeyframes() const { return m_keyframes; }
+	private:
+		std::vector<Keyframe> m_keyframes;
+};
+#endif // __CAMERAPATH_H__
@@ -20,6 +20,20 @@
 */
 #include "Environment.h"
 
-void Environment::draw (Shader* shader)
+Environment::Environment () :
+	m_sun(glm::vec3(0.0f), -glm::normalize(glm::vec3(0.4f, 1.0f, 0.3f)), glm::vec3(0.7f)),
+	m_ambient(0.3f),
+	m_fogColor(0.39f, 0.58f, 0.93f),
+	m_fogStart(20000.0f),
+	m_fogEnd(60000.0f)
 {
 }
+
+void Environment::writeUniforms (EnvironmentBlock& block) const
+{
+	block.ambient = glm::vec4(m_ambient, 1.0f);
+	block.sunDirection = glm::vec4(-glm::normalize(m_sun.direction), 0.0f);
+	block.sunColor = glm::vec4(m_sun.color, 1.0f);
+	block.fogColor = glm::vec4(m_fogColor, 1.0f);
+	block.fogRange = glm::vec4(m_fogStart, m_fogEnd, 0.0f, 0.0f);
+}
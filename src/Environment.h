@@ -23,9 +23,9 @@
 
 #include "util/Common.h"
 #include "util/Singleton.h"
-#include "Shader.h"
 
-#define MAX_LIGHTS 4
+#include <cmath>
+#include <vector>
 
 struct Light {
 	Light (glm::vec3 position, glm::vec3 color, glm::vec3 attenuation = glm::vec3(1.0, 0.0, 0.0)) :
@@ -35,10 +35,14 @@ struct Light {
 	glm::vec3 attenuation;
 };
 
+// Full intensity within innerAngle of the direction, fading out towards outerAngle (degrees)
 struct SpotLight : public Light {
-	SpotLight (glm::vec3 position, glm::vec3 dir, glm::vec3 color, glm::vec3 attenuation) :
-		Light(position, color, attenuation), direction(dir) {}
+	SpotLight (glm::vec3 position, glm::vec3 dir, glm::vec3 color, glm::vec3 attenuation, float innerAngle = 20.0f, float outerAngle = 30.0f) :
+		Light(position, color, attenuation), direction(dir),
+		cosInner(std::cos(glm::radians(innerAngle))), cosOuter(std::cos(glm::radians(outerAngle))) {}
 	glm::vec3 direction;
+	float cosInner;
+	float cosOuter;
 };
 
 struct DirectionalLight : public SpotLight {
@@ -46,17 +50,39 @@ struct DirectionalLight : public SpotLight {
 		SpotLight(position, dir, color, glm::vec3(1.0, 0.0, 0.0)) {}
 };
 
+// std140 layout of uniform Environment (UNIFORM_BLOCK_ENVIRONMENT), see data/shaders;
+// point and spot lights reach the shaders through ClusteredLighting
+struct EnvironmentBlock
+{
+	glm::vec4 ambient;
+	glm::vec4 sunDirection;    // towards the sun
+	glm::vec4 sunColor;
+	glm::vec4 fogColor;
+	glm::vec4 fogRange;        // start and end distance from the camera
+};
+
 class Environment : public Singleton<Environment>
 {
 	public:
-		void draw (Shader* shader);
+		// This frame's contents of the environment uniform block
+		void writeUniforms (EnvironmentBlock& block) const;
 
 		inline void setAmbientColor (glm::vec3 color) { m_ambient = color; }
-		inline void setSun (Light light) { m_sun = light; }
+		inline void setSun (DirectionalLight light) { m_sun = light; }
+		inline void setFog (glm::vec3 color, float start, float end) { m_fogColor = color; m_fogStart = start; m_fogEnd = end; }
+
+		// Point and spot lights in world space, any number of them
+		inline void addLight (Light light) { m_lights.push_back(light); }
+		inline void addSpotLight (SpotLight light) { m_spotLights.push_back(light); }
+		inline void clearLights () { m_lights.clear(); m_spotLights.clear(); }
+		inline const std::vector<Light>& getLights () const { return m_lights; }
+		inline const std::vector<SpotLight>& getSpotLights () const { return m_spotLights; }
 
 		friend class Singleton<Environment>;
 	private:
-		Light m_sun;
+		Environment ();
+
+		DirectionalLight m_sun;
 
 		// Ambient color
 		glm::vec3 m_ambient;
@@ -68,6 +94,7 @@ class Environment : public Singleton<Environment>
 
 		// All lights
 		std::vector<Light> m_lights;
+		std::vector<SpotLight> m_spotLights;
 };
 
 #endif // __ENVIRONMENT_H__
@@ -0,0 +1,162 @@
+/**
+ * @file    FrameScheduler.cpp
+ * @brief   Fixed-timestep simulation clock with frame pacing
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "FrameScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+typedef std::chrono::duration<double> Seconds;
+typedef std::chrono::duration<double, std::milli> Milliseconds;
+
+FrameScheduler::FrameScheduler(const Settings& settings) :
+	m_settings(settings), m_step(1.0 / settings.simulationRate), m_historyNext(0), m_historySize(0),
+	m_sleep{1e-3, 0.0, 0}
+{
+	reset();
+}
+
+void FrameScheduler::reset()
+{
+	m_accumulator = 0.0;
+	m_dropped = 0.0;
+	m_started = false;
+	m_current = { 0.0f, 0.0f, 0.0f, 0 };
+}
+
+int FrameScheduler::beginFrame()
+{
+	Clock::time_point now = Clock::now();
+	if (!m_started)
+	{
+		m_started = true;
+		m_frameStart = now;
+		m_current = { 0.0f, 0.0f, 0.0f, 0 };
+		return 0;
+	}
+
+	const double elapsed = Seconds(now - m_frameStart).count();
+	m_frameStart = now;
+
+	// Never owe more than maxStepsPerFrame, a long stall must not snowball into longer frames
+	const double limit = m_step * m_settings.maxStepsPerFrame;
+	m_accumulator += elapsed;
+	if (m_accumulator > limit)
+	{
+		m_dropped += m_accumulator - limit;
+		m_accumulator = limit;
+	}
+
+	int steps = static_cast<int>(m_accumulator / m_step);
+	m_accumulator -= steps * m_step;
+
+	m_current.frameMs = static_cast<float>(elapsed * 1e3);
+	m_current.steps = steps;
+	return steps;
+}
+
+void FrameScheduler::endFrame()
+{
+	Clock::time_point workEnd = Clock::now();
+	m_current.workMs = static_cast<float>(Milliseconds(workEnd - m_frameStart).count());
+	m_current.sleepMs = 0.0f;
+
+	if (m_settings.frameRateCap > 0.0)
+	{
+		Clock::time_point deadline = m_frameStart +
+			std::chrono::duration_cast<Clock::duration>(Seconds(1.0 / m_settings.frameRateCap));
+		sleepUntil(deadline);
+		m_current.sleepMs = static_cast<float>(Milliseconds(Clock::now() - workEnd).count());
+	}
+
+	m_history[m_historyNext] = m_current;
+	m_historyNext = (m_historyNext + 1) % HISTORY;
+	m_historySize = std::min(m_historySize + 1, HISTORY);
+}
+
+void FrameScheduler::sleepUntil(Clock::time_point deadline)
+{
+	// Sleep in 1 ms slices while even a pessimistic slice (mean + one deviation) fits
+	while (true)
+	{
+		const double remaining = Seconds(deadline - Clock::now()).count();
+		if (remaining <= m_sleep.upper())
+			break;
+
+		Clock::time_point start = Clock::now();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		m_sleep.add(Seconds(Clock::now() - start).count());
+	}
+
+	// The last fraction of a millisecond
+	while (Clock::now() < deadline)
+		std::this_thread::yield();
+}
+
+void FrameScheduler::setFrameRateCap(double framesPerSecond)
+{
+	m_settings.frameRateCap = std::max(framesPerSecond, 0.0);
+}
+
+const FrameScheduler::FrameTiming& FrameScheduler::getTiming(size_t framesAgo) const
+{
+	return m_history[(m_historyNext + HISTORY - 1 - std::min(framesAgo, HISTORY - 1)) % HISTORY];
+}
+
+FrameScheduler::FrameTiming FrameScheduler::getAverage() const
+{
+	FrameTiming average = { 0.0f, 0.0f, 0.0f, 0 };
+	if (m_historySize == 0)
+		return average;
+
+	double frame = 0.0, work = 0.0, sleep = 0.0;
+	long steps = 0;
+	for (size_t i = 0; i < m_historySize; i++)
+	{
+		const FrameTiming& timing = getTiming(i);
+		frame += timing.frameMs;
+		work += timing.workMs;
+		sleep += timing.sleepMs;
+		steps += timing.steps;
+	}
+
+	average.frameMs = static_cast<float>(frame / m_historySize);
+	average.workMs = static_cast<float>(work / m_historySize);
+	average.sleepMs = static_cast<float>(sleep / m_historySize);
+	average.steps = static_cast<int>(std::lround(static_cast<double>(steps) / m_historySize));
+	return average;
+}
+
+void FrameScheduler::SleepEstimate::add(double seconds)
+{
+	// A weight of 1/count gives the exact running mean and variance, its floor of
+	// 1/SLEEP_WINDOW turns them into exponentially weighted ones
+	count = std::min(count + 1, SLEEP_WINDOW);
+	const double weight = 1.0 / count;
+	const double delta = seconds - mean;
+	mean += weight * delta;
+	variance = (1.0 - weight) * (variance + weight * delta * delta);
+}
+
+double FrameScheduler::SleepEstimate::upper() const
+{
+	return mean + std::sqrt(variance);
+}
@@ -0,0 +1,113 @@
+/**
+ * @file    FrameScheduler.h
+ * @brief   Fixed-timestep simulation clock with frame pacing
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __FRAMESCHEDULER_H__
+#define __FRAMESCHEDULER_H__
+
+#include <array>
+#include <chrono>
+
+/**
+ * Splits real time into fixed simulation steps through an accumulator. The leftover
+ * fraction of a step is the interpolation factor for rendering between the previous
+ * and the current simulation state. With a frame rate cap, endFrame() sleeps in short
+ * slices while the measured oversleep allows it and spins only for the last bit.
+ */
+class FrameScheduler
+{
+	public:
+		typedef std::chrono::steady_clock Clock;
+
+		struct Settings
+		{
+			double simulationRate;  // fixed steps per second
+			int maxStepsPerFrame;   // time beyond this many steps is dropped, not caught up
+			double frameRateCap;    // frames per second, 0 for uncapped
+		};
+
+		struct FrameTiming
+		{
+			float frameMs;    // since the start of the previous frame
+			float workMs;     // before the pacing sleep
+			float sleepMs;
+			int steps;        // simulation steps run
+		};
+
+		// How long a 1 ms sleep really takes: the exact mean and variance of the first
+		// SLEEP_WINDOW samples, then exponentially weighted ones with a memory of about
+		// that many, so the estimate follows the OS scheduler and stays bounded
+		struct SleepEstimate
+		{
+			double mean;      // seconds
+			double variance;
+			size_t count;     // samples, up to SLEEP_WINDOW
+
+			void add(double seconds);
+			// Pessimistic slice length, mean plus one deviation
+			double upper() const;
+		};
+
+		static constexpr size_t HISTORY = 256;
+		static constexpr size_t SLEEP_WINDOW = 1000;
+
+		explicit FrameScheduler(const Settings& settings);
+
+		// Start the clock over, the next frame runs no steps
+		void reset();
+
+		// Returns the number of fixed steps to simulate this frame
+		int beginFrame();
+		// Sleeps until the frame cap allows the next frame and records the timing
+		void endFrame();
+
+		void setFrameRateCap(double framesPerSecond);
+		inline double getFrameRateCap() const { return m_settings.frameRateCap; }
+
+		// Fixed step length in seconds
+		inline double getStep() const { return m_step; }
+		// Fraction of a step simulated time is ahead of the last step, for interpolation
+		inline float getAlpha() const { return static_cast<float>(m_accumulator / m_step); }
+		// Simulated time dropped because a frame needed more than maxStepsPerFrame steps
+		inline double getDroppedSeconds() const { return m_dropped; }
+
+		// framesAgo 0 is the last finished frame
+		const FrameTiming& getTiming(size_t framesAgo) const;
+		inline size_t getHistorySize() const { return m_historySize; }
+		FrameTiming getAverage() const;
+		inline const SleepEstimate& getSleepEstimate() const { return m_sleep; }
+	private:
+		Settings m_settings;
+		double m_step;
+		double m_accumulator;
+		double m_dropped;
+		bool m_started;
+
+		Clock::time_point m_frameStart;
+		FrameTiming m_current;
+
+		std::array<FrameTiming, HISTORY> m_history;
+		size_t m_historyNext;
+		size_t m_historySize;
+
+		SleepEstimate m_sleep;
+
+		void sleepUntil(Clock::time_point deadline);
+};
+#endif // __FRAMESCHEDULER_H__
@@ -0,0 +1,206 @@
+/**
+ * @file    GLState.cpp
+ * @brief   Cache of bound GL objects and capabilities that drops redundant calls
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "GLState.h"
+
+#include <cstdio>
+
+// No GL object or enum has this value, so it never matches a real call
+static const GLuint UNKNOWN = 0xFFFFFFFFu;
+
+static const char* CALL_NAMES[GLState::CALL_KINDS] = {
+	"program", "vertex array", "buffer", "capability", "raster"
+};
+
+size_t GLState::Stats::totalIssued() const
+{
+	size_t total = 0;
+	for (size_t count : issued)
+		total += count;
+	return total;
+}
+
+size_t GLState::Stats::totalSkipped() const
+{
+	size_t total = 0;
+	for (size_t count : skipped)
+		total += count;
+	return total;
+}
+
+GLState::GLState()
+{
+	invalidate();
+	resetStats();
+}
+
+bool GLState::update(GLuint& cached, GLuint value, Call kind)
+{
+	if (cached == value)
+	{
+		m_stats.skipped[kind]++;
+		return false;
+	}
+
+	cached = value;
+	m_stats.issued[kind]++;
+	return true;
+}
+
+bool GLState::update(std::vector<Binding>& bindings, GLenum target, GLuint name, Call kind)
+{
+	for (Binding& binding : bindings)
+	{
+		if (binding.target == target)
+			return update(binding.name, name, kind);
+	}
+
+	bindings.push_back({ target, name });
+	m_stats.issued[kind]++;
+	return true;
+}
+
+void GLState::useProgram(GLuint program)
+{
+	if (update(m_program, program, PROGRAM))
+		glUseProgram(program);
+}
+
+void GLState::bindVertexArray(GLuint vertexArray)
+{
+	if (update(m_vertexArray, vertexArray, VERTEX_ARRAY))
+	{
+		glBindVertexArray(vertexArray);
+		for (Binding& binding : m_buffers)
+		{
+			if (binding.target == GL_ELEMENT_ARRAY_BUFFER)
+				binding.name = UNKNOWN;
+		}
+	}
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer)
+{
+	if (update(m_buffers, target, buffer, BUFFER))
+		glBindBuffer(target, buffer);
+}
+
+void GLState::bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+	glBindBufferRange(target, index, buffer, offset, size);
+	m_stats.issued[BUFFER]++;
+
+	for (Binding& binding : m_buffers)
+	{
+		if (binding.target == target)
+		{
+			binding.name = buffer;
+			return;
+		}
+	}
+	m_buffers.push_back({ target, buffer });
+}
+
+void GLState::enable(GLenum capability)
+{
+	if (update(m_capabilities, capability, 1, CAPABILITY))
+		glEnable(capability);
+}
+
+void GLState::disable(GLenum capability)
+{
+	if (update(m_capabilities, capability, 0, CAPABILITY))
+		glDisable(capability);
+}
+
+void GLState::cullFace(GLenum mode)
+{
+	if (update(m_cullFace, mode, RASTER))
+		glCullFace(mode);
+}
+
+void GLState::polygonMode(GLenum mode)
+{
+	if (update(m_polygonMode, mode, RASTER))
+		glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+void GLState::depthFunc(GLenum function)
+{
+	if (update(m_depthFunc, function, RASTER))
+		glDepthFunc(function);
+}
+
+void GLState::forgetProgram(GLuint program)
+{
+	if (m_program == program)
+		m_program = UNKNOWN;
+}
+
+void GLState::forgetVertexArray(GLuint vertexArray)
+{
+	if (m_vertexArray == vertexArray)
+		m_vertexArray = UNKNOWN;
+}
+
+void GLState::forgetBuffer(GLuint buffer)
+{
+	for (Binding& binding : m_buffers)
+	{
+		if (binding.name == buffer)
+			binding.name = UNKNOWN;
+	}
+}
+
+void GLState::invalidate()
+{
+	m_program = UNKNOWN;
+	m_vertexArray = UNKNOWN;
+	m_buffers.clear();
+	m_capabilities.clear();
+	m_cullFace = UNKNOWN;
+	m_polygonMode = UNKNOWN;
+	m_depthFunc = UNKNOWN;
+}
+
+void GLState::resetStats()
+{
+	for (size_t i = 0; i < CALL_KINDS; i++)
+	{
+		m_stats.issued[i] = 0;
+		m_stats.skipped[i] = 0;
+	}
+}
+
+std::string GLState::formatStats() const
+{
+	const size_t issued = m_stats.totalIssued(), skipped = m_stats.totalSkipped();
+	char line[128];
+	snprintf(line, sizeof(line), "GL state: %zu calls issued, %zu skipped (%.1f%%)",
+		issued, skipped, issued + skipped ? 100.0 * skipped / (issued + skipped) : 0.0);
+
+	std::string text = line;
+	for (size_t i = 0; i < CALL_KINDS; i++)
+	{
+		snprintf(line, sizeof(line), "; %s %zu/%zu", CALL_NAMES[i], m_stats.issued[i], m_stats.skipped[i]);
+		text += line;
+	}
+	return text;
+}
@@ -0,0 +1,109 @@
+/**
+ * @file    GLState.h
+ * @brief   Cache of bound GL objects and capabilities that drops redundant calls
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __GLSTATE_H__
+#define __GLSTATE_H__
+
+#include "util/Common.h"
+#include "util/Singleton.h"
+
+/**
+ * Mirrors the program, vertex array, buffer bindings and a few fixed-function states of
+ * the context, and only forwards calls that change something. All binding and state
+ * changes of the engine go through here; code that calls GL directly must invalidate()
+ * afterwards. GL thread only.
+ *
+ * The element array binding belongs to the vertex array, so it is forgotten whenever
+ * another vertex array gets bound.
+ */
+class GLState : public Singleton<GLState>
+{
+	public:
+		enum Call
+		{
+			PROGRAM,
+			VERTEX_ARRAY,
+			BUFFER,
+			CAPABILITY,
+			RASTER,     // cull face, polygon mode, depth function
+			CALL_KINDS
+		};
+
+		struct Stats
+		{
+			size_t issued[CALL_KINDS];
+			size_t skipped[CALL_KINDS];
+
+			size_t totalIssued() const;
+			size_t totalSkipped() const;
+		};
+
+		void useProgram(GLuint program);
+		void bindVertexArray(GLuint vertexArray);
+		void bindBuffer(GLenum target, GLuint buffer);
+		// Always issued, the ranges of streamed data move every frame; also the generic
+		// binding of target, like in GL
+		void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+		void enable(GLenum capability);
+		void disable(GLenum capability);
+		inline void setEnabled(GLenum capability, bool enabled) { enabled ? enable(capability) : disable(capability); }
+
+		void cullFace(GLenum mode);
+		void polygonMode(GLenum mode);
+		void depthFunc(GLenum function);
+
+		// Deleted objects are unbound by GL, keep the cache in sync
+		void forgetProgram(GLuint program);
+		void forgetVertexArray(GLuint vertexArray);
+		void forgetBuffer(GLuint buffer);
+
+		// Forget everything, the next call of each kind is always issued
+		void invalidate();
+
+		inline const Stats& getStats() const { return m_stats; }
+		void resetStats();
+		std::string formatStats() const;
+
+		friend class Singleton<GLState>;
+	private:
+		GLState();
+
+		struct Binding
+		{
+			GLenum target;
+			GLuint name;
+		};
+
+		GLuint m_program;
+		GLuint m_vertexArray;
+		std::vector<Binding> m_buffers;
+		std::vector<Binding> m_capabilities;  // name is 1 when enabled, 0 when disabled
+		GLenum m_cullFace;
+		GLenum m_polygonMode;
+		GLenum m_depthFunc;
+
+		Stats m_stats;
+
+		// Returns true when the cached value changed and the call must be issued
+		bool update(std::vector<Binding>& bindings, GLenum target, GLuint name, Call kind);
+		bool update(GLuint& cached, GLuint value, Call kind);
+};
+#endif // __GLSTATE_H__
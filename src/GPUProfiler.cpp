@@ -0,0 +1,136 @@
+/**
+ * @file    GPUProfiler.cpp
+ * @brief   GPU pass timings from GL_TIME_ELAPSED queries
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "GPUProfiler.h"
+
+#include <cstring>
+
+GPUProfiler::GPUProfiler() :
+	m_current(0), m_created(false), m_active(false), m_ignoredDepth(0)
+{
+	for (Frame& frame : m_frames)
+		frame.count = 0;
+}
+
+void GPUProfiler::begin(const char* name)
+{
+	Frame& frame = m_frames[m_current];
+	if (m_active || frame.count == MAX_PASSES)
+	{
+		m_ignoredDepth++;
+		return;
+	}
+
+	// Created lazily, the profiler may be touched before there is a context
+	if (!m_created)
+	{
+		for (Frame& pool : m_frames)
+			glGenQueries(MAX_PASSES, pool.queries);
+		m_created = true;
+	}
+
+	Pass& pass = frame.passes[frame.count];
+	pass.name = name;
+	pass.query = frame.queries[frame.count];
+	pass.cpuStart = Profiler::getInstance().now();
+	frame.count++;
+
+	glBeginQuery(GL_TIME_ELAPSED, pass.query);
+	m_active = true;
+}
+
+void GPUProfiler::end()
+{
+	if (m_ignoredDepth > 0)
+	{
+		m_ignoredDepth--;
+		return;
+	}
+
+	glEndQuery(GL_TIME_ELAPSED);
+	m_active = false;
+}
+
+void GPUProfiler::frame()
+{
+	m_current = (m_current + 1) % FRAMES_IN_FLIGHT;
+
+	// The oldest frame, about to be reused
+	collect(m_frames[m_current]);
+}
+
+void GPUProfiler::collect(Frame& frame)
+{
+	for (size_t i = 0; i < frame.count; i++)
+	{
+		const Pass& pass = frame.passes[i];
+
+		// Still not done after FRAMES_IN_FLIGHT frames, drop it rather than stall
+		GLint available = 0;
+		glGetQueryObjectiv(pass.query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			continue;
+
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(pass.query, GL_QUERY_RESULT, &elapsed);
+		Profiler::getInstance().recordGPU(pass.name, pass.cpuStart, elapsed);
+
+		bool found = false;
+		for (auto& latest : m_latest)
+		{
+			if (strcmp(latest.first, pass.name) == 0)
+			{
+				latest.second = elapsed * 1e-6;
+				found = true;
+				break;
+			}
+		}
+		if (!found)
+			m_latest.emplace_back(pass.name, elapsed * 1e-6);
+	}
+	frame.count = 0;
+}
+
+double GPUProfiler::getPassMs(const char* name) const
+{
+	for (const auto& latest : m_latest)
+	{
+		if (strcmp(latest.first, name) == 0)
+			return latest.second;
+	}
+	return 0.0;
+}
+
+void GPUProfiler::release()
+{
+	if (!m_created)
+		return;
+
+	if (m_active)
+		glEndQuery(GL_TIME_ELAPSED);
+
+	for (Frame& frame : m_frames)
+	{
+		glDeleteQueries(MAX_PASSES, frame.queries);
+		frame.count = 0;
+	}
+	m_created = false;
+	m_active = false;
+}
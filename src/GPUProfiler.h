@@ -0,0 +1,95 @@
+/**
+ * @file    GPUProfiler.h
+ * @brief   GPU pass timings from GL_TIME_ELAPSED queries
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __GPUPROFILER_H__
+#define __GPUPROFILER_H__
+
+#include "util/Common.h"
+#include "util/Singleton.h"
+#include "util/Profiler.h"
+
+/**
+ * Wraps render passes in GL_TIME_ELAPSED queries. Results are read FRAMES_IN_FLIGHT
+ * frames later so the CPU never waits on the GPU, and handed to the Profiler on its GPU
+ * track, placed at the CPU time the pass was issued. Elapsed-time queries can't nest, a
+ * pass begun inside another one is ignored. GL thread only.
+ */
+class GPUProfiler : public Singleton<GPUProfiler>
+{
+	public:
+		static const size_t FRAMES_IN_FLIGHT = 4;
+		static const size_t MAX_PASSES = 32;  // per frame
+
+		void begin(const char* name);
+		void end();
+
+		// Once per frame, after the frame was submitted
+		void frame();
+
+		// Last read back duration of a pass in milliseconds, 0 if unknown
+		double getPassMs(const char* name) const;
+
+		// Delete the queries while the context still exists
+		void release();
+
+		friend class Singleton<GPUProfiler>;
+	private:
+		GPUProfiler();
+
+		struct Pass
+		{
+			const char* name;
+			GLuint query;
+			uint64_t cpuStart;
+		};
+
+		struct Frame
+		{
+			GLuint queries[MAX_PASSES];
+			Pass passes[MAX_PASSES];
+			size_t count;
+		};
+
+		Frame m_frames[FRAMES_IN_FLIGHT];
+		size_t m_current;
+		bool m_created;
+		bool m_active;
+		int m_ignoredDepth;
+
+		// Latest result per pass name
+		std::vector<std::pair<const char*, double>> m_latest;
+
+		void collect(Frame& frame);
+};
+
+class GPUProfileScope
+{
+	public:
+		explicit GPUProfileScope(const char* name) { GPUProfiler::getInstance().begin(name); }
+		~GPUProfileScope() { GPUProfiler::getInstance().end(); }
+};
+
+#ifdef VOXSPATIUM_PROFILE
+#define PROFILE_GPU_SCOPE(name) GPUProfileScope PROFILE_CONCAT(gpuProfileScope, __LINE__)(name)
+#else
+#define PROFILE_GPU_SCOPE(name) do {} while (0)
+#endif
+
+#endif // __GPUPROFILER_H__
@@ -20,8 +20,77 @@
 */
 #include "Application.h"
 
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static void usage(const char* program)
+{
+	printf("Usage: %s [--fps-cap N] [--no-multidraw] [--save-dir DIR | --no-save] [--headless [--frames N] [--size WxH] [--warmup N] [--path FILE] [--report FILE] [--trace FILE]]\n", program);
+	printf("  --fps-cap   limit the frame rate instead of relying on vsync (default uncapped)\n");
+	printf("  --no-multidraw  one draw call per chunk instead of indirect multi-draw\n");
+	printf("  --save-dir  load and save terrain chunks there (default %s, none for headless runs)\n", Application::SAVE_DIRECTORY);
+	printf("  --no-save   generate every chunk and save none\n");
+	printf("  --headless  render offscreen along a scripted camera path and write a JSON timing report\n");
+	printf("  --frames    measured frames (default %d)\n", Application::HEADLESS_DEFAULTS.frames);
+	printf("  --size      offscreen resolution (default %dx%d)\n", Application::HEADLESS_DEFAULTS.width, Application::HEADLESS_DEFAULTS.height);
+	printf("  --warmup    frames at most spent waiting for streaming to settle (default %d)\n", Application::HEADLESS_DEFAULTS.maxWarmupFrames);
+	printf("  --path      camera path file, lines of \"time x y z yaw pitch\" (default built-in flight)\n");
+	printf("  --report    report file (default %s)\n", Application::HEADLESS_DEFAULTS.reportPath.c_str());
+	printf("  --trace     also write a Chrome trace of the profiling markers\n");
+}
+
 int main(int argc, char const *argv[])
 {
+	bool headless = false;
+	bool multiDraw = true;
+	double frameRateCap = 0.0;
+	const char* saveDirectory = nullptr;
+	Application::HeadlessSettings settings = Application::HEADLESS_DEFAULTS;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (strcmp(argv[i], "--headless") == 0)
+			headless = true;
+		else if (strcmp(argv[i], "--no-multidraw") == 0)
+			multiDraw = false;
+		else if (strcmp(argv[i], "--save-dir") == 0 && value)
+			saveDirectory = argv[++i];
+		else if (strcmp(argv[i], "--no-save") == 0)
+			saveDirectory = "";
+		else if (strcmp(argv[i], "--fps-cap") == 0 && value && (frameRateCap = atof(value)) >= 0.0)
+			i++;
+		else if (strcmp(argv[i], "--frames") == 0 && value && (settings.frames = atoi(value)) > 0)
+			i++;
+		else if (strcmp(argv[i], "--size") == 0 && value && sscanf(value, "%dx%d", &settings.width, &settings.height) == 2
+			&& settings.width > 0 && settings.height > 0)
+			i++;
+		else if (strcmp(argv[i], "--warmup") == 0 && value)
+			settings.maxWarmupFrames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--path") == 0 && value)
+			settings.cameraPath = argv[++i];
+		else if (strcmp(argv[i], "--report") == 0 && value)
+			settings.reportPath = argv[++i];
+		else if (strcmp(argv[i], "--trace") == 0 && value)
+			settings.tracePath = argv[++i];
+		else
+		{
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (headless)
+		Application::getInstance().setHeadless(settings);
+	Application::getInstance().setFrameRateCap(frameRateCap);
+	Application::getInstance().setMultiDrawIndirect(multiDraw);
+	// Headless runs generate everything unless told otherwise, chunks saved by an earlier
+	// run would have them measure different work
+	if (!saveDirectory)
+		saveDirectory = headless ? "" : Application::SAVE_DIRECTORY;
+	Application::getInstance().setSaveDirectory(saveDirectory);
+
 	Application::getInstance().initialize();
 	return 0;
 }
@@ -19,9 +19,23 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 #include "Shader.h"
+#include "ShaderCache.h"
+#include "GLState.h"
+#include "UniformBlocks.h"
 #include "util/Log.h"
+#include "util/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+// Start of a line replaced by another source file, see readFile()
+static const char* const INCLUDE_DIRECTIVE = "#include \"";
+// Deeper nesting is taken for an include cycle
+static const int MAX_INCLUDE_DEPTH = 8;
 
 struct Shader::Attribute {
+	GLint location;
 	GLint size;
 	GLboolean normalized;
 	GLsizei stride;
@@ -29,27 +43,68 @@ struct Shader::Attribute {
 	GLenum type;
 };
 
-/** Compile a shader from file */
-void Shader::compileShader(const std::string& filePath, GLuint& id)
+/** Read a whole shader file in one go, splicing in the files it includes */
+void Shader::readFile(const std::string& filePath, std::string& contents, int depth)
 {
-	// Load shader file
-	std::ifstream shaderFile(filePath);
+	std::ifstream shaderFile(filePath, std::ios::binary | std::ios::ate);
 	if(shaderFile.fail())
 	{
 		fatalError("Failed to open file @"+filePath);
+		return;
 	}
 
-	std::string fileContents = "";
-	std::string line;
+	contents.resize(static_cast<size_t>(shaderFile.tellg()));
+	shaderFile.seekg(0);
+	shaderFile.read(&contents[0], contents.size());
 
-	while(std::getline(shaderFile, line))
+	if (contents.find(INCLUDE_DIRECTIVE) == std::string::npos)
+		return;
+	if (depth >= MAX_INCLUDE_DEPTH)
 	{
-		fileContents += line + "\n";
+		fatalError("Shader includes nested too deep @" + filePath);
+		return;
 	}
 
-	shaderFile.close();
+	// #line directives around an included file keep compile errors at the right lines
+	const size_t slash = filePath.find_last_of('/');
+	const std::string directory = slash == std::string::npos ? "" : filePath.substr(0, slash + 1);
+	const size_t directiveLength = std::strlen(INCLUDE_DIRECTIVE);
+	std::string expanded;
+	int line = 1;
+	for (size_t start = 0; start < contents.size(); line++)
+	{
+		const size_t newline = contents.find('\n', start);
+		const size_t end = newline == std::string::npos ? contents.size() : newline + 1;
+		if (contents.compare(start, directiveLength, INCLUDE_DIRECTIVE) != 0)
+		{
+			expanded.append(contents, start, end - start);
+			start = end;
+			continue;
+		}
+
+		const size_t name = start + directiveLength;
+		const size_t quote = contents.find('"', name);
+		if (quote == std::string::npos || quote >= end)
+		{
+			fatalError("Malformed #include @" + filePath + ":" + std::to_string(line));
+			return;
+		}
+		std::string included;
+		readFile(directory + contents.substr(name, quote - name), included, depth + 1);
+		expanded += "#line 1\n";
+		expanded += included;
+		if (!included.empty() && included.back() != '\n')
+			expanded += '\n';
+		expanded += "#line " + std::to_string(line + 1) + "\n";
+		start = end;
+	}
+	contents.swap(expanded);
+}
 
-	const char* contentsPointer = fileContents.c_str();
+/** Compile a shader from source */
+void Shader::compileShader(const std::string& source, const std::string& filePath, GLuint& id)
+{
+	const char* contentsPointer = source.c_str();
 
 	// Create the shader with the contents of the file
 	glShaderSource(id, 1, &contentsPointer, nullptr);
@@ -76,57 +131,99 @@ void Shader::compileShader(const std::string& filePath, GLuint& id)
 
 /** Create new shader from vertex and fragment files */
 Shader& Shader::createShader(const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath)
+{
+	return createShader(vertexShaderFilePath, fragmentShaderFilePath, "");
+}
+
+/** Create new shader from vertex, fragment and (optional) geometry files, compilation happens in linkShaders() */
+Shader& Shader::createShader(const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath, const std::string& geometryShaderFilePath)
 {
 	Shader* shader = new Shader();
+	auto start = std::chrono::steady_clock::now();
 
+	shader->m_valid = false;
 	shader->m_programID = glCreateProgram();
-	shader->m_vertexShaderID = glCreateShader(GL_VERTEX_SHADER);
-	if(shader->m_vertexShaderID == 0)
+	shader->m_vertexShaderID = 0;
+	shader->m_fragmentShaderID = 0;
+	shader->m_geometryShaderID = 0;
+	shader->vao = shader->vbo = shader->ebo = 0;
+	shader->m_attributesDirty = false;
+
+	shader->m_name = vertexShaderFilePath + " + " + fragmentShaderFilePath;
+	shader->m_paths[0] = vertexShaderFilePath;
+	shader->m_paths[1] = fragmentShaderFilePath;
+	shader->m_paths[2] = geometryShaderFilePath;
+
+	Shader::readFile(vertexShaderFilePath, shader->m_sources[0]);
+	Shader::readFile(fragmentShaderFilePath, shader->m_sources[1]);
+	if (!geometryShaderFilePath.empty())
 	{
-		fatalError("Vertex shader failed to be created!");
+		shader->m_name += " + " + geometryShaderFilePath;
+		Shader::readFile(geometryShaderFilePath, shader->m_sources[2]);
 	}
 
-	shader->m_fragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
-	if(shader->m_fragmentShaderID == 0)
-	{
-		fatalError("Fragment shader failed to be created!");
-	}
-
-	Shader::compileShader(vertexShaderFilePath, shader->m_vertexShaderID);
-	Shader::compileShader(fragmentShaderFilePath, shader->m_fragmentShaderID);
-
+	shader->m_loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 	return *shader;
 }
 
-/** Create new shader from vertex, fragment and geometry files */
-Shader& Shader::createShader(const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath, const std::string& geometryShaderFilePath)
+/** List the active uniforms of the linked program and bind its uniform blocks */
+void Shader::reflectUniforms()
 {
-	Shader* shader = new Shader();
+	m_reflected.clear();
+	m_uniforms.clear();
 
-	shader->m_programID = glCreateProgram();
-	shader->m_vertexShaderID = glCreateShader(GL_VERTEX_SHADER);
-	if(shader->m_vertexShaderID == 0)
+	GLint count = 0, maxLength = 0;
+	glGetProgramiv(m_programID, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(m_programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+	std::vector<GLchar> name(std::max(maxLength, 1));
+	for (GLint i = 0; i < count; i++)
 	{
-		fatalError("Vertex shader failed to be created!");
+		UniformInfo info;
+		GLsizei length = 0;
+		glGetActiveUniform(m_programID, i, maxLength, &length, &info.size, &info.type, name.data());
+
+		// Uniform block members have no location
+		info.location = glGetUniformLocation(m_programID, name.data());
+		if (info.location < 0)
+			continue;
+
+		// Arrays are reported as "name[0]", make them reachable as "name" too
+		std::string uniform(name.data(), length);
+		m_reflected[uniform] = info;
+		m_uniforms[uniform] = info.location;
+		if (uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0)
+		{
+			uniform.resize(uniform.size() - 3);
+			m_reflected[uniform] = info;
+			m_uniforms[uniform] = info.location;
+		}
 	}
 
-	shader->m_fragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
-	if(shader->m_fragmentShaderID == 0)
+	// A loaded program binary starts from the default bindings again, so this runs on every load
+	for (int block = 0; block < UNIFORM_BLOCKS; block++)
 	{
-		fatalError("Fragment shader failed to be created!");
+		GLuint index = glGetUniformBlockIndex(m_programID, UniformBlocks::getName(static_cast<UniformBlock>(block)));
+		if (index != GL_INVALID_INDEX)
+			glUniformBlockBinding(m_programID, index, block);
 	}
+}
 
-	shader->m_geometryShaderID = glCreateShader(GL_GEOMETRY_SHADER);
-	if(shader->m_geometryShaderID == 0)
+const Shader::UniformInfo* Shader::findUniform(const std::string& name, bool (*accepts)(GLenum)) const
+{
+	auto it = m_reflected.find(name);
+	if (it == m_reflected.end())
 	{
-		fatalError("Geometry shader failed to be created!");
+		logWarn("Uniform " + name + " doesn't exist in program.");
+		return nullptr;
 	}
 
-	Shader::compileShader(vertexShaderFilePath, shader->m_vertexShaderID);
-	Shader::compileShader(fragmentShaderFilePath, shader->m_fragmentShaderID);
-	Shader::compileShader(geometryShaderFilePath, shader->m_geometryShaderID);
-
-	return *shader;
+	if (!accepts(it->second.type))
+	{
+		logWarn("Uniform " + name + " is not of the requested type.");
+		return nullptr;
+	}
+	return &it->second;
 }
 
 /** Get uniform location */
@@ -171,21 +268,58 @@ void Shader::setAttribute(const std::string& name,
 								 GLuint offset,
 								 GLenum type)
 {
-	GLuint loc = getAttribLocation(name);
-	glEnableVertexAttribArray(loc);
-	glVertexAttribPointer(loc, size, type, normalized, stride * sizeof(GLfloat),
-						(void*)(offset * sizeof(GLfloat)));
-
+	// Looked up once here, use() only replays the pointers when the layout changed
+	m_attributes[name].location = getAttribLocation(name);
 	m_attributes[name].size = size;
 	m_attributes[name].normalized = normalized;
 	m_attributes[name].stride = stride;
 	m_attributes[name].offset = offset;
 	m_attributes[name].type = type;
+	m_attributesDirty = true;
 }
 
-/** Link the shaders together */
+/** Compile the sources and link them, or load the linked program from the binary cache */
 void Shader::linkShaders()
 {
+	PROFILE_SCOPE("link shaders");
+	auto start = std::chrono::steady_clock::now();
+	ShaderCache& cache = ShaderCache::getInstance();
+	const uint64_t key = cache.key({ &m_sources[0], &m_sources[1], &m_sources[2] });
+
+	if (cache.load(m_programID, key))
+	{
+		m_valid = true;
+		reflectUniforms();
+		m_loadSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		cache.record(m_name, m_loadSeconds * 1e3, true);
+		return;
+	}
+
+	m_vertexShaderID = glCreateShader(GL_VERTEX_SHADER);
+	if(m_vertexShaderID == 0)
+	{
+		fatalError("Vertex shader failed to be created!");
+	}
+
+	m_fragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
+	if(m_fragmentShaderID == 0)
+	{
+		fatalError("Fragment shader failed to be created!");
+	}
+
+	Shader::compileShader(m_sources[0], m_paths[0], m_vertexShaderID);
+	Shader::compileShader(m_sources[1], m_paths[1], m_fragmentShaderID);
+
+	if (!m_sources[2].empty())
+	{
+		m_geometryShaderID = glCreateShader(GL_GEOMETRY_SHADER);
+		if(m_geometryShaderID == 0)
+		{
+			fatalError("Geometry shader failed to be created!");
+		}
+		Shader::compileShader(m_sources[2], m_paths[2], m_geometryShaderID);
+	}
+
 	// Attach our shaders to our program
 	glAttachShader(m_programID, m_vertexShaderID);
 	glAttachShader(m_programID, m_fragmentShaderID);
@@ -193,6 +327,10 @@ void Shader::linkShaders()
 		glAttachShader(m_programID, m_geometryShaderID);
 	}
 
+	// Ask the driver to keep a binary we can store
+	if (cache.isSupported())
+		glProgramParameteri(m_programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
 	// Link our program
 	glLinkProgram(m_programID);
 
@@ -220,6 +358,7 @@ void Shader::linkShaders()
 
 		std::printf("%s\n", &(infoLog[0]));
 		fatalError("Shader linking failed!");
+		return;
 	}
 
 	// Always detach shaders after a successful link.
@@ -232,18 +371,25 @@ void Shader::linkShaders()
 		glDetachShader(m_programID, m_geometryShaderID);
 		glDeleteShader(m_geometryShaderID);
 	}
+
+	m_valid = true;
+	reflectUniforms();
+	cache.store(m_programID, key);
+
+	m_loadSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	cache.record(m_name, m_loadSeconds * 1e3, false);
 }
 
 /** Bind the shader for usage */
 void Shader::start()
 {
-	glUseProgram(m_programID);
+	GLState::getInstance().useProgram(m_programID);
 }
 
 /** Unbind the shader */
 void Shader::stop()
 {
-	glUseProgram(0);
+	GLState::getInstance().useProgram(0);
 }
 
 void Shader::setUniform(const std::string& name, float x, float y, float z)
@@ -298,21 +444,27 @@ void Shader::setUniform(const std::string& name, int val)
 
 void Shader::use()
 {
+	GLState& state = GLState::getInstance();
+
 	// Bind the shader
 	start();
 
-	// Bind the buffers needed
-	glBindVertexArray(vao);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+	// The vertex array keeps the element buffer and the attribute pointers
+	state.bindVertexArray(vao);
+	if (!m_attributesDirty)
+		return;
+
+	state.bindBuffer(GL_ARRAY_BUFFER, vbo);
+	state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
 
-	// Enable all attributes
 	for (auto it(m_attributes.begin()); it != m_attributes.end(); ++it)
 	{
-		GLuint location = getAttribLocation(it->first);
-		glEnableVertexAttribArray(location);
+		if (it->second.location < 0)
+			continue;
+
+		glEnableVertexAttribArray(it->second.location);
 		glVertexAttribPointer(
-			location,
+			it->second.location,
 			it->second.size,
 			it->second.type,
 			it->second.normalized,
@@ -320,6 +472,9 @@ void Shader::use()
 			(void*)(it->second.offset * sizeof(GLfloat))
 		);
 	}
+
+	// Without a vertex array object the pointers are global state and get replayed every time
+	m_attributesDirty = vao == 0;
 }
 
 void Shader::setBuffers(GLint vao, GLint vbo, GLint ebo)
@@ -327,4 +482,5 @@ void Shader::setBuffers(GLint vao, GLint vbo, GLint ebo)
 	this->vao = vao;
 	this->vbo = vbo;
 	this->ebo = ebo;
+	m_attributesDirty = true;
 }
@@ -25,6 +25,9 @@
 #include <map>
 
 #include "util/Common.h"
+#include "UniformHandle.h"
+
+#include <unordered_map>
 
 class Shader
 {
@@ -36,6 +39,14 @@ public:
 
 	void setAttribute(const std::string& name, GLint size, GLboolean normalized, GLsizei stride, GLuint offset, GLenum type = GL_FLOAT);
 
+	// Typed handle to an active uniform, resolve once after linkShaders() and keep it
+	template<typename T>
+	UniformHandle<T> getUniform(const std::string& name) const
+	{
+		const UniformInfo* info = findUniform(name, UniformType<T>::accepts);
+		return info ? UniformHandle<T>(info->location) : UniformHandle<T>();
+	}
+
 	GLuint getUniformLocation(const std::string& uniformName);
 	inline GLuint operator[](const std::string& name) { return getUniformLocation(name); }
 	GLuint getAttribLocation(const std::string& attrbuteName);
@@ -54,7 +65,8 @@ public:
 
 	void setBuffers(GLint vao, GLint vbo, GLint ebo);
 
-	// Bind Attributes and start the shader program
+	// Start the shader program and bind its vertex array, attribute pointers are only
+	// (re)specified after setAttribute() or setBuffers()
 	void use();
 
 	// Start the shader program without binding attributes
@@ -62,6 +74,12 @@ public:
 	void stop();
 private:
 	struct Attribute;
+	struct UniformInfo
+	{
+		GLint location;
+		GLenum type;
+		GLint size;
+	};
 	bool m_valid;
 
 	GLuint m_programID;
@@ -70,11 +88,26 @@ private:
 	GLuint m_geometryShaderID;
 
 	std::map<std::string, GLuint> m_uniforms;
+	// Active uniforms of the linked program, reflected once at link time
+	std::unordered_map<std::string, UniformInfo> m_reflected;
 	std::map<std::string, Attribute> m_attributes;
 
 	GLint vao, vbo, ebo;
+	bool m_attributesDirty;
+
+	// Vertex, fragment and geometry sources (empty when unused), read at creation
+	std::string m_sources[3];
+	std::string m_paths[3];
+	std::string m_name;
+	double m_loadSeconds;
+
+	void reflectUniforms();
+	// nullptr (with a warning) if the uniform is not active or not of an accepted type
+	const UniformInfo* findUniform(const std::string& name, bool (*accepts)(GLenum)) const;
 
-	static void compileShader(const std::string& filePath, GLuint& id);
+	// Whole file, with every #include "name" line replaced by the file name next to it
+	static void readFile(const std::string& filePath, std::string& contents, int depth = 0);
+	static void compileShader(const std::string& source, const std::string& filePath, GLuint& id);
 };
 
 #endif // __SHADER_H__
@@ -0,0 +1,205 @@
+/**
+ * @file    ShaderCache.cpp
+ * @brief   On-disk cache of linked shader program binaries
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "ShaderCache.h"
+#include "util/Log.h"
+
+#include <cstdio>
+#include <filesystem>
+
+// File layout: magic, version, binary format, binary length, binary
+static const uint32_t CACHE_MAGIC = 0x42535856; // "VXSB"
+static const uint32_t CACHE_VERSION = 1;
+
+struct CacheHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t format;
+	uint32_t length;
+};
+
+static uint64_t fnv1a(uint64_t hash, const void* data, size_t size)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001B3ull;
+	}
+	return hash;
+}
+
+static std::string glString(GLenum name)
+{
+	const GLubyte* value = glGetString(name);
+	return value ? reinterpret_cast<const char*>(value) : "";
+}
+
+ShaderCache::ShaderCache() : m_directory("cache/shaders"), m_enabled(true), m_supported(-1)
+{
+
+}
+
+bool ShaderCache::isSupported()
+{
+	if (m_supported < 0)
+	{
+		GLint formats = 0;
+		if (GLEW_ARB_get_program_binary || GLEW_VERSION_4_1)
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		m_supported = formats > 0 ? 1 : 0;
+
+		m_driver = glString(GL_VENDOR) + "\n" + glString(GL_RENDERER) + "\n" + glString(GL_VERSION);
+	}
+	return m_enabled && m_supported == 1;
+}
+
+uint64_t ShaderCache::key(const std::vector<const std::string*>& sources)
+{
+	isSupported();
+
+	uint64_t hash = fnv1a(0xCBF29CE484222325ull, m_driver.data(), m_driver.size());
+	for (const std::string* source : sources)
+	{
+		// Length first, so moving text between stages changes the key
+		const uint64_t length = source->size();
+		hash = fnv1a(hash, &length, sizeof(length));
+		hash = fnv1a(hash, source->data(), source->size());
+	}
+	return hash;
+}
+
+std::string ShaderCache::pathOf(uint64_t key) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+	return m_directory + "/" + name;
+}
+
+bool ShaderCache::load(GLuint program, uint64_t key)
+{
+	if (!isSupported())
+		return false;
+
+	const std::string path = pathOf(key);
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	CacheHeader header;
+	std::vector<char> binary;
+	if (file.read(reinterpret_cast<char*>(&header), sizeof(header))
+		&& header.magic == CACHE_MAGIC && header.version == CACHE_VERSION)
+	{
+		binary.resize(header.length);
+		file.read(binary.data(), header.length);
+	}
+
+	if (binary.empty() || !file)
+	{
+		logWarn("Shader cache entry " + path + " is corrupt, rebuilding it.");
+		file.close();
+		std::remove(path.c_str());
+		return false;
+	}
+
+	glProgramBinary(program, header.format, binary.data(), header.length);
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (linked == GL_FALSE)
+	{
+		// Usually a driver change the version string did not reflect
+		logWarn("Driver rejected cached shader " + path + ", recompiling.");
+		file.close();
+		std::remove(path.c_str());
+		return false;
+	}
+	return true;
+}
+
+void ShaderCache::store(GLuint program, uint64_t key)
+{
+	if (!isSupported())
+		return;
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(program, length, &length, &format, binary.data());
+
+	std::error_code error;
+	std::filesystem::create_directories(m_directory, error);
+
+	// Write to a temporary file first, a crash must not leave a truncated entry behind
+	const std::string path = pathOf(key);
+	const std::string temporary = path + ".tmp";
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		CacheHeader header = { CACHE_MAGIC, CACHE_VERSION, format, static_cast<uint32_t>(length) };
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(binary.data(), length);
+		if (!file)
+		{
+			logWarn("Could not write shader cache entry " + path + ".");
+			file.close();
+			std::remove(temporary.c_str());
+			return;
+		}
+	}
+	std::rename(temporary.c_str(), path.c_str());
+}
+
+void ShaderCache::record(const std::string& name, double milliseconds, bool cached)
+{
+	m_entries.push_back({ name, milliseconds, cached });
+}
+
+void ShaderCache::report() const
+{
+	double cold = 0.0, warm = 0.0;
+	size_t hits = 0;
+	for (const Entry& entry : m_entries)
+	{
+		char line[256];
+		snprintf(line, sizeof(line), "  %-48s %8.2f ms  %s", entry.name.c_str(), entry.milliseconds,
+			entry.cached ? "warm (binary cache)" : "cold (compiled)");
+		logInfo(std::string(line));
+
+		if (entry.cached)
+		{
+			warm += entry.milliseconds;
+			hits++;
+		}
+		else
+			cold += entry.milliseconds;
+	}
+
+	char summary[256];
+	snprintf(summary, sizeof(summary), "Shaders: %zu loaded, %zu warm in %.2f ms, %zu cold in %.2f ms (binary cache %s)",
+		m_entries.size(), hits, warm, m_entries.size() - hits, cold,
+		m_supported == 1 ? (m_enabled ? "enabled" : "disabled") : "unsupported");
+	logInfo(std::string(summary));
+}
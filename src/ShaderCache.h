@@ -0,0 +1,75 @@
+/**
+ * @file    ShaderCache.h
+ * @brief   On-disk cache of linked shader program binaries
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __SHADERCACHE_H__
+#define __SHADERCACHE_H__
+
+#include "util/Common.h"
+#include "util/Singleton.h"
+
+/**
+ * Programs are stored under cache/shaders/ keyed by a hash of their sources and of the
+ * GL vendor, renderer and version strings, so a driver update or a shader edit misses
+ * the cache instead of loading a stale binary. Needs ARB_get_program_binary (core in 4.1)
+ * with at least one binary format, otherwise every lookup misses and Shader compiles
+ * from source as before. A binary the driver rejects is deleted and rebuilt.
+ *
+ * Mesa keeps its own disk cache of compiled shaders, set MESA_SHADER_CACHE_DISABLE=true
+ * to measure truly cold startups under llvmpipe.
+ */
+class ShaderCache : public Singleton<ShaderCache>
+{
+	public:
+		struct Entry
+		{
+			std::string name;
+			double milliseconds;
+			bool cached;
+		};
+
+		void setDirectory(const std::string& directory) { m_directory = directory; }
+		void setEnabled(bool enabled) { m_enabled = enabled; }
+		bool isSupported();
+
+		uint64_t key(const std::vector<const std::string*>& sources);
+
+		// Try to link program from a cached binary
+		bool load(GLuint program, uint64_t key);
+		// Save the binary of a freshly linked program
+		void store(GLuint program, uint64_t key);
+
+		// Shader load times since startup, for the startup report
+		void record(const std::string& name, double milliseconds, bool cached);
+		inline const std::vector<Entry>& getEntries() const { return m_entries; }
+		void report() const;
+
+		friend class Singleton<ShaderCache>;
+	private:
+		ShaderCache();
+
+		std::string m_directory;
+		std::string m_driver;
+		bool m_enabled;
+		int m_supported;   // -1 until queried
+		std::vector<Entry> m_entries;
+
+		std::string pathOf(uint64_t key) const;
+};
+#endif // __SHADERCACHE_H__
@@ -0,0 +1,182 @@
+/**
+ * @file    StreamBuffer.cpp
+ * @brief   Fenced streaming ring buffer for per-frame uploads
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "StreamBuffer.h"
+#include "GLState.h"
+#include "util/Profiler.h"
+
+#include <cstring>
+
+// Room for the chunk upload budget of a frame and its draw data
+static const size_t DEFAULT_REGION_BYTES = 8 * 1024 * 1024;
+
+// Between checks of a fence that has not signaled yet
+static const GLuint64 WAIT_SLICE_NS = 1000000;
+
+StreamBuffer::StreamBuffer() :
+	m_buffer(0), m_mapped(nullptr), m_persistent(false), m_regionBytes(DEFAULT_REGION_BYTES),
+	m_region(0), m_head(0), m_lastUsed(0), m_overflows(0), m_waits(0), m_waitNs(0)
+{
+	for (GLsync& fence : m_fences)
+		fence = 0;
+}
+
+void StreamBuffer::setRegionSize(size_t bytes)
+{
+	if (m_buffer == 0)
+		m_regionBytes = bytes;
+}
+
+void StreamBuffer::create()
+{
+	GLState& state = GLState::getInstance();
+	const size_t size = m_regionBytes * FRAMES_IN_FLIGHT;
+
+	glGenBuffers(1, &m_buffer);
+	state.bindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+
+	if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage)
+	{
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, flags);
+		m_mapped = static_cast<uint8_t*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags));
+		if (m_mapped != nullptr)
+		{
+			m_persistent = true;
+			return;
+		}
+
+		// Immutable storage can't be respecified, start over with a mutable buffer
+		state.forgetBuffer(m_buffer);
+		glDeleteBuffers(1, &m_buffer);
+		glGenBuffers(1, &m_buffer);
+		state.bindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+	}
+	glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+}
+
+GLuint StreamBuffer::getBuffer()
+{
+	if (m_buffer == 0)
+		create();
+	return m_buffer;
+}
+
+size_t StreamBuffer::write(const void* data, size_t bytes, size_t alignment)
+{
+	if (m_buffer == 0)
+		create();
+
+	// Aligned within the whole buffer, the regions need not start at a multiple of it
+	const size_t start = m_region * m_regionBytes;
+	const size_t offset = (start + m_head + alignment - 1) / alignment * alignment;
+	if (bytes > m_regionBytes || offset - start > m_regionBytes - bytes)
+	{
+		m_overflows++;
+		return INVALID;
+	}
+	m_head = offset - start + bytes;
+	if (m_persistent)
+	{
+		memcpy(m_mapped + offset, data, bytes);
+		return offset;
+	}
+
+	// The fence already vouches for the range, the driver need not check it again
+	GLState::getInstance().bindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+	void* mapped = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, bytes,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (mapped == nullptr)
+		return INVALID;
+	memcpy(mapped, data, bytes);
+	glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+	return offset;
+}
+
+void StreamBuffer::frame()
+{
+	if (m_buffer == 0)
+		return;
+
+	if (m_fences[m_region] != 0)
+		glDeleteSync(m_fences[m_region]);
+	m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_lastUsed = m_head;
+
+	m_region = (m_region + 1) % FRAMES_IN_FLIGHT;
+	m_head = 0;
+
+	GLsync fence = m_fences[m_region];
+	if (fence == 0)
+		return;
+
+	// Nearly always signaled already, FRAMES_IN_FLIGHT - 1 frames have passed since
+	GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	if (result == GL_TIMEOUT_EXPIRED)
+	{
+		PROFILE_SCOPE("streamWait");
+		const uint64_t start = Profiler::getInstance().now();
+		while (result == GL_TIMEOUT_EXPIRED)
+			result = glClientWaitSync(fence, 0, WAIT_SLICE_NS);
+		m_waits++;
+		m_waitNs += Profiler::getInstance().now() - start;
+	}
+	glDeleteSync(fence);
+	m_fences[m_region] = 0;
+}
+
+StreamBuffer::Stats StreamBuffer::getStats() const
+{
+	Stats stats = {};
+	stats.regionBytes = m_regionBytes;
+	stats.usedBytes = m_lastUsed;
+	stats.overflows = m_overflows;
+	stats.waits = m_waits;
+	stats.waitMs = m_waitNs * 1e-6;
+	stats.persistent = m_persistent;
+	return stats;
+}
+
+void StreamBuffer::release()
+{
+	if (m_buffer == 0)
+		return;
+
+	for (GLsync& fence : m_fences)
+	{
+		if (fence != 0)
+			glDeleteSync(fence);
+		fence = 0;
+	}
+
+	GLState& state = GLState::getInstance();
+	if (m_persistent)
+	{
+		state.bindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+	}
+	state.forgetBuffer(m_buffer);
+	glDeleteBuffers(1, &m_buffer);
+	m_buffer = 0;
+	m_mapped = nullptr;
+	m_persistent = false;
+	m_region = 0;
+	m_head = 0;
+}
@@ -0,0 +1,94 @@
+/**
+ * @file    StreamBuffer.h
+ * @brief   Fenced streaming ring buffer for per-frame uploads
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __STREAMBUFFER_H__
+#define __STREAMBUFFER_H__
+
+#include "util/Common.h"
+#include "util/Singleton.h"
+
+#include <cstdint>
+
+/**
+ * One buffer split into FRAMES_IN_FLIGHT regions, the frame writes into its own region
+ * while the GPU still reads the previous ones. Each region gets a fence when its frame
+ * is submitted, and is only written again once that fence has signaled, so the driver
+ * never has to synchronize implicitly. With GL 4.4 or ARB_buffer_storage the buffer is
+ * mapped once, persistent and coherent; otherwise every write maps its range
+ * unsynchronized. Data is consumed from the buffer by copies, vertex attributes or
+ * indirect draws issued in the same frame. GL thread only.
+ */
+class StreamBuffer : public Singleton<StreamBuffer>
+{
+	public:
+		static const size_t FRAMES_IN_FLIGHT = 3;
+		static const size_t INVALID = SIZE_MAX;
+
+		struct Stats
+		{
+			size_t regionBytes;
+			size_t usedBytes;     // last frame
+			size_t overflows;     // writes that did not fit, since the start
+			size_t waits;         // frames that had to wait for their region
+			double waitMs;        // in total
+			bool persistent;
+		};
+
+		// Before the first use, each of the FRAMES_IN_FLIGHT regions gets this size
+		void setRegionSize(size_t bytes);
+
+		// Copy bytes into this frame's region, at an offset that is a multiple of
+		// alignment (any size, e.g. that of an instanced attribute). Returns the offset
+		// in getBuffer(), or INVALID when the region has no room left.
+		size_t write(const void* data, size_t bytes, size_t alignment = 4);
+
+		// Created on first use
+		GLuint getBuffer();
+
+		// Once per frame, after the frame was submitted: fence its region and wait until
+		// the GPU is done with the next one
+		void frame();
+
+		inline bool isPersistent() const { return m_persistent; }
+		Stats getStats() const;
+
+		// Unmap and delete the buffer while the context still exists
+		void release();
+
+		friend class Singleton<StreamBuffer>;
+	private:
+		StreamBuffer();
+
+		GLuint m_buffer;
+		uint8_t* m_mapped;
+		bool m_persistent;
+		size_t m_regionBytes;
+		size_t m_region;
+		size_t m_head;
+		GLsync m_fences[FRAMES_IN_FLIGHT];
+
+		size_t m_lastUsed;
+		size_t m_overflows;
+		size_t m_waits;
+		uint64_t m_waitNs;
+
+		void create();
+};
+#endif // __STREAMBUFFER_H__
@@ -0,0 +1,76 @@
+/**
+ * @file    UniformBlocks.cpp
+ * @brief   Per-frame uniform blocks shared by all shader programs
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "UniformBlocks.h"
+#include "GLState.h"
+#include "StreamBuffer.h"
+
+static const char* BLOCK_NAMES[UNIFORM_BLOCKS] = {
+	"Camera",
+	"Environment",
+	"Clusters"
+};
+
+UniformBlocks::UniformBlocks() :
+	m_alignment(0)
+{
+	for (GLuint& buffer : m_fallback)
+		buffer = 0;
+}
+
+const char* UniformBlocks::getName(UniformBlock block)
+{
+	return BLOCK_NAMES[block];
+}
+
+void UniformBlocks::upload(UniformBlock block, const void* data, size_t bytes)
+{
+	GLState& state = GLState::getInstance();
+	StreamBuffer& stream = StreamBuffer::getInstance();
+	if (m_alignment == 0)
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &m_alignment);
+
+	const size_t offset = stream.write(data, bytes, static_cast<size_t>(m_alignment));
+	if (offset != StreamBuffer::INVALID)
+	{
+		state.bindBufferRange(GL_UNIFORM_BUFFER, block, stream.getBuffer(), offset, bytes);
+		return;
+	}
+
+	if (m_fallback[block] == 0)
+		glGenBuffers(1, &m_fallback[block]);
+	state.bindBuffer(GL_UNIFORM_BUFFER, m_fallback[block]);
+	glBufferData(GL_UNIFORM_BUFFER, bytes, data, GL_STREAM_DRAW);
+	state.bindBufferRange(GL_UNIFORM_BUFFER, block, m_fallback[block], 0, bytes);
+}
+
+void UniformBlocks::release()
+{
+	GLState& state = GLState::getInstance();
+	for (GLuint& buffer : m_fallback)
+	{
+		if (buffer == 0)
+			continue;
+		state.forgetBuffer(buffer);
+		glDeleteBuffers(1, &buffer);
+		buffer = 0;
+	}
+	m_alignment = 0;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file    UniformBlocks.h
+ * @brief   Per-frame uniform blocks shared by all shader programs
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __UNIFORMBLOCKS_H__
+#define __UNIFORMBLOCKS_H__
+
+#include "util/Common.h"
+#include "util/Singleton.h"
+
+// Binding points of the per-frame uniform blocks, the same in every program
+enum UniformBlock
+{
+	UNIFORM_BLOCK_CAMERA,        // uniform Camera, see CameraBlock
+	UNIFORM_BLOCK_ENVIRONMENT,   // uniform Environment, see EnvironmentBlock
+	UNIFORM_BLOCK_CLUSTERS,      // uniform Clusters, see ClustersBlock
+	UNIFORM_BLOCKS
+};
+
+/**
+ * Writes the std140 data of each block once per frame into the StreamBuffer and binds
+ * that range to the block's binding point. Shader assigns the binding points of the
+ * blocks a program declares at link time, so any number of programs read the same
+ * data without uploads of their own. GL thread only.
+ */
+class UniformBlocks : public Singleton<UniformBlocks>
+{
+	public:
+		// Name of the block in GLSL
+		static const char* getName(UniformBlock block);
+
+		void upload(UniformBlock block, const void* data, size_t bytes);
+		template<typename T>
+		inline void upload(UniformBlock block, const T& data) { upload(block, &data, sizeof(T)); }
+
+		// Delete the fallback buffers while the context still exists
+		void release();
+
+		friend class Singleton<UniformBlocks>;
+	private:
+		UniformBlocks();
+
+		// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, 0 until the first upload
+		GLint m_alignment;
+		// Orphaned instead, for a frame whose stream buffer region is full
+		GLuint m_fallback[UNIFORM_BLOCKS];
+};
+#endif // __UNIFORMBLOCKS_H__
@@ -0,0 +1,116 @@
+/**
+ * @file    UniformHandle.h
+ * @brief   Typed, pre-resolved shader uniform locations
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __UNIFORMHANDLE_H__
+#define __UNIFORMHANDLE_H__
+
+#include "util/Common.h"
+
+// GL type of a uniform of C++ type T and how to upload count values of it
+template<typename T> struct UniformType;
+
+template<> struct UniformType<float>
+{
+	static bool accepts(GLenum type) { return type == GL_FLOAT; }
+	static void upload(GLint location, GLsizei count, const float* v) { glUniform1fv(location, count, v); }
+};
+
+// Samplers and booleans are set as ints too
+template<> struct UniformType<int>
+{
+	static bool accepts(GLenum type)
+	{
+		return type == GL_INT || type == GL_BOOL || type == GL_SAMPLER_2D || type == GL_SAMPLER_3D
+			|| type == GL_SAMPLER_CUBE || type == GL_SAMPLER_2D_ARRAY || type == GL_SAMPLER_BUFFER
+			|| type == GL_INT_SAMPLER_BUFFER || type == GL_UNSIGNED_INT_SAMPLER_BUFFER;
+	}
+	static void upload(GLint location, GLsizei count, const int* v) { glUniform1iv(location, count, v); }
+};
+
+template<> struct UniformType<glm::vec2>
+{
+	static bool accepts(GLenum type) { return type == GL_FLOAT_VEC2; }
+	static void upload(GLint location, GLsizei count, const glm::vec2* v) { glUniform2fv(location, count, glm::value_ptr(*v)); }
+};
+
+template<> struct UniformType<glm::vec3>
+{
+	static bool accepts(GLenum type) { return type == GL_FLOAT_VEC3; }
+	static void upload(GLint location, GLsizei count, const glm::vec3* v) { glUniform3fv(location, count, glm::value_ptr(*v)); }
+};
+
+template<> struct UniformType<glm::vec4>
+{
+	static bool accepts(GLenum type) { return type == GL_FLOAT_VEC4; }
+	static void upload(GLint location, GLsizei count, const glm::vec4* v) { glUniform4fv(location, count, glm::value_ptr(*v)); }
+};
+
+template<> struct UniformType<glm::dvec3>
+{
+	static bool accepts(GLenum type) { return type == GL_DOUBLE_VEC3; }
+	static void upload(GLint location, GLsizei count, const glm::dvec3* v) { glUniform3dv(location, count, glm::value_ptr(*v)); }
+};
+
+template<> struct UniformType<glm::dvec4>
+{
+	static bool accepts(GLenum type) { return type == GL_DOUBLE_VEC4; }
+	static void upload(GLint location, GLsizei count, const glm::dvec4* v) { glUniform4dv(location, count, glm::value_ptr(*v)); }
+};
+
+template<> struct UniformType<glm::mat3>
+{
+	static bool accepts(GLenum type) { return type == GL_FLOAT_MAT3; }
+	static void upload(GLint location, GLsizei count, const glm::mat3* v) { glUniformMatrix3fv(location, count, GL_FALSE, glm::value_ptr(*v)); }
+};
+
+template<> struct UniformType<glm::mat4>
+{
+	static bool accepts(GLenum type) { return type == GL_FLOAT_MAT4; }
+	static void upload(GLint location, GLsizei count, const glm::mat4* v) { glUniformMatrix4fv(location, count, GL_FALSE, glm::value_ptr(*v)); }
+};
+
+template<> struct UniformType<glm::dmat4>
+{
+	static bool accepts(GLenum type) { return type == GL_DOUBLE_MAT4; }
+	static void upload(GLint location, GLsizei count, const glm::dmat4* v) { glUniformMatrix4dv(location, count, GL_FALSE, glm::value_ptr(*v)); }
+};
+
+/**
+ * Location of a uniform of type T, resolved once with Shader::getUniform<T>(). Setting it is
+ * a single glUniform call: no string, no map lookup. An invalid handle (unknown uniform
+ * or wrong type) has location -1, which GL silently ignores. Like setUniform(), set()
+ * applies to the program currently in use.
+ */
+template<typename T>
+class UniformHandle
+{
+	public:
+		UniformHandle() : m_location(-1) {}
+		explicit UniformHandle(GLint location) : m_location(location) {}
+
+		inline void set(const T& value) const { UniformType<T>::upload(m_location, 1, &value); }
+		inline void set(const T* values, GLsizei count) const { UniformType<T>::upload(m_location, count, values); }
+
+		inline bool isValid() const { return m_location >= 0; }
+		inline GLint getLocation() const { return m_location; }
+	private:
+		GLint m_location;
+};
+#endif // __UNIFORMHANDLE_H__
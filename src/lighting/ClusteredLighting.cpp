@@ -0,0 +1,156 @@
+/**
+ * @file    ClusteredLighting.cpp
+ * @brief   Clustered forward lighting of the Environment's lights
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "lighting/ClusteredLighting.h"
+#include "GLState.h"
+#include "UniformBlocks.h"
+#include "util/Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+// The light buffers are bound to these units in every lit program, nothing else uses them
+static const GLint FIRST_UNIT = 8;
+
+static const GLenum FORMATS[] = { GL_RGBA32F, GL_RG32UI, GL_R32UI };
+static const char* SAMPLERS[] = { "lightData", "clusterData", "lightIndices" };
+
+// Cone of a point light, every direction is inside of it
+static const float POINT_COS_INNER = -1.5f;
+static const float POINT_COS_OUTER = -2.0f;
+
+ClusteredLighting::ClusteredLighting(const Settings& settings) :
+	m_settings(settings), m_grid(settings.grid), m_stats()
+{
+	GLState& state = GLState::getInstance();
+	glGenBuffers(LIGHT_BUFFERS, m_buffers);
+	glGenTextures(LIGHT_BUFFERS, m_textures);
+	for (int i = 0; i < LIGHT_BUFFERS; i++)
+	{
+		upload(static_cast<LightBuffer>(i), nullptr, 0);
+		glBindTexture(GL_TEXTURE_BUFFER, m_textures[i]);
+		glTexBuffer(GL_TEXTURE_BUFFER, FORMATS[i], m_buffers[i]);
+	}
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	state.bindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+ClusteredLighting::~ClusteredLighting()
+{
+	GLState& state = GLState::getInstance();
+	for (GLuint buffer : m_buffers)
+		state.forgetBuffer(buffer);
+	glDeleteTextures(LIGHT_BUFFERS, m_textures);
+	glDeleteBuffers(LIGHT_BUFFERS, m_buffers);
+}
+
+void ClusteredLighting::setupProgram(Shader& shader)
+{
+	shader.start();
+	for (int i = 0; i < LIGHT_BUFFERS; i++)
+		shader.getUniform<int>(SAMPLERS[i]).set(FIRST_UNIT + i);
+}
+
+float ClusteredLighting::range(const Light& light) const
+{
+	// Distance where color / (constant + linear d + quadratic d^2) falls to minIntensity
+	const float brightest = std::max(light.color.x, std::max(light.color.y, light.color.z));
+	const float threshold = brightest / m_settings.minIntensity;
+	const glm::vec3& k = light.attenuation;
+	if (threshold <= k.x)
+		return 0.0f;
+
+	float distance = m_settings.maxRange;
+	if (k.z > 0.0f)
+		distance = (-k.y + std::sqrt(k.y * k.y + 4.0f * k.z * (threshold - k.x))) / (2.0f * k.z);
+	else if (k.y > 0.0f)
+		distance = (threshold - k.x) / k.y;
+	return std::min(distance, m_settings.maxRange);
+}
+
+void ClusteredLighting::upload(LightBuffer buffer, const void* data, size_t bytes)
+{
+	// Orphaned every frame, buffer textures of GL 3.3 can only view a whole buffer
+	static const uint32_t empty[4] = {};
+	GLState::getInstance().bindBuffer(GL_TEXTURE_BUFFER, m_buffers[buffer]);
+	if (bytes == 0)
+		glBufferData(GL_TEXTURE_BUFFER, sizeof(empty), empty, GL_STREAM_DRAW);
+	else
+		glBufferData(GL_TEXTURE_BUFFER, bytes, data, GL_STREAM_DRAW);
+}
+
+void ClusteredLighting::update(const Environment& environment, const Camera& camera, int width, int height)
+{
+	PROFILE_SCOPE("clustered lights");
+	const uint64_t start = Profiler::getInstance().now();
+
+	const glm::mat4 view = camera.getViewMatrix();
+	const glm::dvec3& origin = camera.getOrigin();
+	m_spheres.clear();
+	m_lights.clear();
+
+	// Positions relative to the render origin, spheres in view space
+	auto add = [&](const Light& light, const glm::vec3& direction, float cosInner, float cosOuter) {
+		const float reach = range(light);
+		if (reach <= 0.0f)
+			return;
+
+		const glm::vec3 position(glm::dvec3(light.position) - origin);
+		const glm::vec4 center = view * glm::vec4(position, 1.0f);
+		m_spheres.add(glm::vec3(center.x, center.y, center.z), reach);
+		m_lights.push_back(glm::vec4(position, reach));
+		m_lights.push_back(glm::vec4(light.color, cosInner));
+		m_lights.push_back(glm::vec4(direction, cosOuter));
+		m_lights.push_back(glm::vec4(light.attenuation, 0.0f));
+	};
+	for (const Light& light : environment.getLights())
+		add(light, glm::vec3(0.0f, 0.0f, -1.0f), POINT_COS_INNER, POINT_COS_OUTER);
+	for (const SpotLight& light : environment.getSpotLights())
+		add(light, glm::normalize(light.direction), light.cosInner, light.cosOuter);
+
+	const glm::mat4& projection = camera.getProjectionMatrix();
+	m_grid.assign(m_spheres, projection[0][0], projection[1][1]);
+
+	const std::vector<LightGrid::Cluster>& clusters = m_grid.getClusters();
+	const std::vector<uint32_t>& indices = m_grid.getIndices();
+	upload(LIGHT_BUFFER_DATA, m_lights.data(), m_lights.size() * sizeof(glm::vec4));
+	upload(LIGHT_BUFFER_CLUSTERS, clusters.data(), clusters.size() * sizeof(LightGrid::Cluster));
+	upload(LIGHT_BUFFER_INDICES, indices.data(), indices.size() * sizeof(uint32_t));
+
+	const LightGrid::Settings& grid = m_grid.getSettings();
+	ClustersBlock block;
+	block.scale = glm::vec4(static_cast<float>(grid.tilesX) / width, static_cast<float>(grid.tilesY) / height,
+		m_grid.getSliceScale(), m_grid.getSliceBias());
+	block.grid[0] = static_cast<GLint>(grid.tilesX);
+	block.grid[1] = static_cast<GLint>(grid.tilesY);
+	block.grid[2] = static_cast<GLint>(grid.slices);
+	block.grid[3] = static_cast<GLint>(m_spheres.size());
+	UniformBlocks::getInstance().upload(UNIFORM_BLOCK_CLUSTERS, block);
+
+	for (int i = 0; i < LIGHT_BUFFERS; i++)
+	{
+		glActiveTexture(GL_TEXTURE0 + FIRST_UNIT + i);
+		glBindTexture(GL_TEXTURE_BUFFER, m_textures[i]);
+	}
+	glActiveTexture(GL_TEXTURE0);
+
+	m_stats.grid = m_grid.getStats();
+	m_stats.assignMs = (Profiler::getInstance().now() - start) * 1e-6;
+}
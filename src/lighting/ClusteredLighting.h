@@ -0,0 +1,95 @@
+/**
+ * @file    ClusteredLighting.h
+ * @brief   Clustered forward lighting of the Environment's lights
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __CLUSTEREDLIGHTING_H__
+#define __CLUSTEREDLIGHTING_H__
+
+#include "util/Common.h"
+#include "lighting/LightGrid.h"
+#include "Camera.h"
+#include "Environment.h"
+#include "Shader.h"
+
+// std140 layout of uniform Clusters (UNIFORM_BLOCK_CLUSTERS), see data/shaders
+struct ClustersBlock
+{
+	glm::vec4 scale;           // tilesX / width, tilesY / height, slice scale, slice bias
+	GLint grid[4];             // tilesX, tilesY, slices, lights
+};
+
+/**
+ * Forward shading with any number of point and spot lights: every frame the lights
+ * of the Environment are assigned to the clusters of a LightGrid, and the lights,
+ * the offset and count of every cluster and the light index list are uploaded as
+ * buffer textures (GL 3.3 has no storage buffers). A fragment then only shades the
+ * lights of its own cluster. A light's range ends where its attenuated intensity
+ * drops below minIntensity; the shaders fade it out towards there. GL thread only.
+ */
+class ClusteredLighting
+{
+	public:
+		struct Settings
+		{
+			LightGrid::Settings grid;
+			float minIntensity;    // of the brightest color channel, where a light ends
+			float maxRange;        // for lights that barely attenuate
+		};
+
+		struct Stats
+		{
+			LightGrid::Stats grid; // last frame
+			double assignMs;
+		};
+
+		explicit ClusteredLighting(const Settings& settings);
+		~ClusteredLighting();
+
+		ClusteredLighting(const ClusteredLighting&) = delete;
+		ClusteredLighting& operator=(const ClusteredLighting&) = delete;
+
+		// Point the light samplers of a linked program at their texture units, once
+		static void setupProgram(Shader& shader);
+
+		// Cluster the lights for this frame's camera, upload them and bind the buffer
+		// textures and the Clusters uniform block
+		void update(const Environment& environment, const Camera& camera, int width, int height);
+
+		inline const Stats& getStats() const { return m_stats; }
+	private:
+		enum LightBuffer
+		{
+			LIGHT_BUFFER_DATA,     // RGBA32F, four texels per light
+			LIGHT_BUFFER_CLUSTERS, // RG32UI, offset and count per cluster
+			LIGHT_BUFFER_INDICES,  // R32UI
+			LIGHT_BUFFERS
+		};
+
+		Settings m_settings;
+		LightGrid m_grid;
+		SphereBatch m_spheres;
+		std::vector<glm::vec4> m_lights;
+		GLuint m_buffers[LIGHT_BUFFERS];
+		GLuint m_textures[LIGHT_BUFFERS];
+		Stats m_stats;
+
+		float range(const Light& light) const;
+		void upload(LightBuffer buffer, const void* data, size_t bytes);
+};
+#endif // __CLUSTEREDLIGHTING_H__
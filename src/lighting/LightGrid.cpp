@@ -0,0 +1,243 @@
+/**
+ * @file    LightGrid.cpp
+ * @brief   Clustered light assignment for forward shading
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "lighting/LightGrid.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// SSE2 is the baseline of x86-64, no runtime dispatch needed
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define LIGHTGRID_SSE2
+#endif
+
+// Spheres reaching behind the eye are projected from this depth on, which covers
+// the whole screen for any sphere that contains the eye
+static const float MIN_DEPTH = 1e-3f;
+
+// Fewer lights are not worth waking the workers for
+static const size_t PARALLEL_LIGHTS = 64;
+
+LightGrid::LightGrid(const Settings& settings) :
+	m_settings(settings), m_lights(0)
+{
+	m_settings.slices = std::max(m_settings.slices, 3u);
+
+	// Slices 1 .. slices - 2 split sliceNear .. sliceFar evenly in log(depth)
+	const uint32_t inner = m_settings.slices - 2;
+	m_sliceScale = inner / std::log(m_settings.sliceFar / m_settings.sliceNear);
+	m_sliceBias = 1.0f - std::log(m_settings.sliceNear) * m_sliceScale;
+
+	m_bounds.resize(m_settings.slices + 1);
+	m_bounds[0] = 0.0f;
+	for (uint32_t k = 1; k < m_settings.slices; k++)
+		m_bounds[k] = m_settings.sliceNear * std::pow(m_settings.sliceFar / m_settings.sliceNear, static_cast<float>(k - 1) / inner);
+	m_bounds[m_settings.slices] = FLT_MAX;
+
+	if (m_settings.threads != 1)
+		m_pool.reset(new ThreadPool(m_settings.threads));
+
+	m_slices.resize(m_settings.slices);
+	m_clusters.resize(static_cast<size_t>(m_settings.tilesX) * m_settings.tilesY * m_settings.slices);
+}
+
+uint32_t LightGrid::sliceOf(float depth) const
+{
+	const float slice = std::floor(std::log(std::max(depth, MIN_DEPTH)) * m_sliceScale + m_sliceBias);
+	return static_cast<uint32_t>(std::min(std::max(slice, 0.0f), static_cast<float>(m_settings.slices - 1)));
+}
+
+void LightGrid::assign(const SphereBatch& lights, float xScale, float yScale)
+{
+	m_lights = lights.size();
+	auto run = [&](size_t slice) { assignSlice(static_cast<uint32_t>(slice), lights, xScale, yScale); };
+	if (m_pool && m_lights >= PARALLEL_LIGHTS)
+		m_pool->parallelFor(m_settings.slices, run);
+	else
+	{
+		for (uint32_t slice = 0; slice < m_settings.slices; slice++)
+			run(slice);
+	}
+
+	// Each slice listed its clusters from 0, place them one after the other
+	const size_t tiles = static_cast<size_t>(m_settings.tilesX) * m_settings.tilesY;
+	size_t total = 0;
+	for (const Slice& slice : m_slices)
+		total += slice.indices.size();
+	m_indices.resize(total);
+
+	uint32_t base = 0;
+	for (uint32_t s = 0; s < m_settings.slices; s++)
+	{
+		const Slice& slice = m_slices[s];
+		for (size_t tile = 0; tile < tiles; tile++)
+			m_clusters[s * tiles + tile].offset += base;
+		std::copy(slice.indices.begin(), slice.indices.end(), m_indices.begin() + base);
+		base += static_cast<uint32_t>(slice.indices.size());
+	}
+}
+
+void LightGrid::assignSlice(uint32_t index, const SphereBatch& lights, float xScale, float yScale)
+{
+	Slice& slice = m_slices[index];
+	slice.lights.clear();
+	slice.rects.clear();
+
+	const float z0 = m_bounds[index], z1 = m_bounds[index + 1];
+	const float tilesX = static_cast<float>(m_settings.tilesX), tilesY = static_cast<float>(m_settings.tilesY);
+	const size_t size = lights.size();
+
+#if defined(LIGHTGRID_SSE2)
+	const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), minusOne = _mm_set1_ps(-1.0f), half = _mm_set1_ps(0.5f);
+	const __m128 near = _mm_set1_ps(z0), far = _mm_set1_ps(z1), minDepth = _mm_set1_ps(std::max(z0, MIN_DEPTH));
+	const __m128 scaleX = _mm_set1_ps(xScale), scaleY = _mm_set1_ps(yScale);
+	const __m128 tilesXv = _mm_set1_ps(tilesX), tilesYv = _mm_set1_ps(tilesY);
+	const __m128 lastX = _mm_set1_ps(tilesX - 1.0f), lastY = _mm_set1_ps(tilesY - 1.0f);
+
+	alignas(16) int32_t x0[4], x1[4], y0[4], y1[4];
+	for (size_t i = 0; i < size; i += 4)
+	{
+		const __m128 cx = _mm_loadu_ps(&lights.centerX[i]), cy = _mm_loadu_ps(&lights.centerY[i]);
+		const __m128 depth = _mm_sub_ps(zero, _mm_loadu_ps(&lights.centerZ[i])), r = _mm_loadu_ps(&lights.radius[i]);
+		const __m128 front = _mm_sub_ps(depth, r), back = _mm_add_ps(depth, r);
+
+		// Padding lanes are zero spheres at the eye, outside of every slice
+		int mask = _mm_movemask_ps(_mm_and_ps(_mm_cmplt_ps(front, far), _mm_cmpgt_ps(back, near)));
+		mask &= (1 << std::min<size_t>(4, size - i)) - 1;
+		if (mask == 0)
+			continue;
+
+		// Screen extent of the part of the bounding box inside the slice: x / depth is
+		// monotonic in both, so the extremes are at the corners
+		const __m128 nearInv = _mm_div_ps(one, _mm_max_ps(front, minDepth));
+		const __m128 farInv = _mm_div_ps(one, _mm_max_ps(_mm_min_ps(back, far), minDepth));
+		const __m128 left = _mm_mul_ps(_mm_sub_ps(cx, r), scaleX), right = _mm_mul_ps(_mm_add_ps(cx, r), scaleX);
+		const __m128 bottom = _mm_mul_ps(_mm_sub_ps(cy, r), scaleY), top = _mm_mul_ps(_mm_add_ps(cy, r), scaleY);
+		const __m128 minX = _mm_min_ps(_mm_mul_ps(left, nearInv), _mm_mul_ps(left, farInv));
+		const __m128 maxX = _mm_max_ps(_mm_mul_ps(right, nearInv), _mm_mul_ps(right, farInv));
+		const __m128 minY = _mm_min_ps(_mm_mul_ps(bottom, nearInv), _mm_mul_ps(bottom, farInv));
+		const __m128 maxY = _mm_max_ps(_mm_mul_ps(top, nearInv), _mm_mul_ps(top, farInv));
+
+		mask &= _mm_movemask_ps(_mm_and_ps(_mm_and_ps(_mm_cmple_ps(minX, one), _mm_cmpge_ps(maxX, minusOne)),
+			_mm_and_ps(_mm_cmple_ps(minY, one), _mm_cmpge_ps(maxY, minusOne))));
+		if (mask == 0)
+			continue;
+
+		// Clamped before the conversion, which then truncates non-negative values only
+		auto tile = [&](__m128 ndc, __m128 tiles, __m128 last) {
+			const __m128 t = _mm_mul_ps(_mm_mul_ps(_mm_add_ps(ndc, one), half), tiles);
+			return _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(t, zero), last));
+		};
+		_mm_store_si128(reinterpret_cast<__m128i*>(x0), tile(minX, tilesXv, lastX));
+		_mm_store_si128(reinterpret_cast<__m128i*>(x1), tile(maxX, tilesXv, lastX));
+		_mm_store_si128(reinterpret_cast<__m128i*>(y0), tile(minY, tilesYv, lastY));
+		_mm_store_si128(reinterpret_cast<__m128i*>(y1), tile(maxY, tilesYv, lastY));
+
+		for (int lane = 0; lane < 4; lane++)
+		{
+			if (!(mask & (1 << lane)))
+				continue;
+			slice.lights.push_back(static_cast<uint32_t>(i + lane));
+			slice.rects.insert(slice.rects.end(), { static_cast<uint32_t>(x0[lane]), static_cast<uint32_t>(x1[lane]),
+				static_cast<uint32_t>(y0[lane]), static_cast<uint32_t>(y1[lane]) });
+		}
+	}
+#else
+	auto tile = [](float ndc, float tiles) {
+		return static_cast<uint32_t>(std::min(std::max((ndc + 1.0f) * 0.5f * tiles, 0.0f), tiles - 1.0f));
+	};
+	for (size_t i = 0; i < size; i++)
+	{
+		const float depth = 0.0f - lights.centerZ[i], r = lights.radius[i];
+		const float front = depth - r, back = depth + r;
+		if (!(front < z1 && back > z0))
+			continue;
+
+		const float nearInv = 1.0f / std::max(front, std::max(z0, MIN_DEPTH));
+		const float farInv = 1.0f / std::max(std::min(back, z1), std::max(z0, MIN_DEPTH));
+		const float left = (lights.centerX[i] - r) * xScale, right = (lights.centerX[i] + r) * xScale;
+		const float bottom = (lights.centerY[i] - r) * yScale, top = (lights.centerY[i] + r) * yScale;
+		const float minX = std::min(left * nearInv, left * farInv), maxX = std::max(right * nearInv, right * farInv);
+		const float minY = std::min(bottom * nearInv, bottom * farInv), maxY = std::max(top * nearInv, top * farInv);
+		if (!(minX <= 1.0f && maxX >= -1.0f && minY <= 1.0f && maxY >= -1.0f))
+			continue;
+
+		slice.lights.push_back(static_cast<uint32_t>(i));
+		slice.rects.insert(slice.rects.end(), { tile(minX, tilesX), tile(maxX, tilesX), tile(minY, tilesY), tile(maxY, tilesY) });
+	}
+#endif
+
+	// Count, then fill, so the lights of each cluster end up next to each other
+	const uint32_t stride = m_settings.tilesX;
+	const size_t tiles = static_cast<size_t>(m_settings.tilesX) * m_settings.tilesY;
+	slice.cursors.assign(tiles, 0);
+	for (size_t l = 0; l < slice.lights.size(); l++)
+	{
+		const uint32_t* rect = &slice.rects[l * 4];
+		for (uint32_t y = rect[2]; y <= rect[3]; y++)
+			for (uint32_t x = rect[0]; x <= rect[1]; x++)
+				slice.cursors[x + y * stride]++;
+	}
+
+	Cluster* clusters = &m_clusters[index * tiles];
+	uint32_t offset = 0;
+	for (size_t tile = 0; tile < tiles; tile++)
+	{
+		clusters[tile].offset = offset;
+		clusters[tile].count = slice.cursors[tile];
+		slice.cursors[tile] = offset;
+		offset += clusters[tile].count;
+	}
+
+	slice.indices.resize(offset);
+	for (size_t l = 0; l < slice.lights.size(); l++)
+	{
+		const uint32_t* rect = &slice.rects[l * 4];
+		for (uint32_t y = rect[2]; y <= rect[3]; y++)
+			for (uint32_t x = rect[0]; x <= rect[1]; x++)
+				slice.indices[slice.cursors[x + y * stride]++] = slice.lights[l];
+	}
+}
+
+LightGrid::Stats LightGrid::getStats() const
+{
+	Stats stats = {};
+	stats.lights = m_lights;
+	stats.indices = m_indices.size();
+	for (const Cluster& cluster : m_clusters)
+	{
+		if (cluster.count == 0)
+			continue;
+		stats.occupied++;
+		stats.maxPerCluster = std::max(stats.maxPerCluster, cluster.count);
+	}
+	return stats;
+}
+
+const char* LightGrid::simdName()
+{
+#if defined(LIGHTGRID_SSE2)
+	return "SSE2";
+#else
+	return "scalar";
+#endif
+}
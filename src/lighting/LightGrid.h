@@ -0,0 +1,112 @@
+/**
+ * @file    LightGrid.h
+ * @brief   Clustered light assignment for forward shading
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __LIGHTGRID_H__
+#define __LIGHTGRID_H__
+
+#include "util/Frustum.h"
+#include "util/ThreadPool.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Cuts the view frustum into tilesX x tilesY screen tiles and a number of depth slices,
+ * and lists the lights of every cluster. Slice 0 reaches from the eye to sliceNear, the
+ * last slice from sliceFar to infinity and the ones between are spaced exponentially,
+ * so clusters stay roughly cube shaped. A light is added to every cluster its view
+ * space bounding box projects into, which is conservative. Slices are independent and
+ * run in parallel, four lights at a time with SSE2; the result is one index list with
+ * an offset and count per cluster, the layout the shaders read.
+ */
+class LightGrid
+{
+	public:
+		struct Settings
+		{
+			uint32_t tilesX, tilesY;  // screen tiles
+			uint32_t slices;          // depth slices, at least 3
+			float sliceNear;          // view depth where the first slice ends
+			float sliceFar;           // view depth where the last slice starts
+			size_t threads;           // 0 for one per hardware thread
+		};
+
+		// Lights of a cluster are indices[offset] .. indices[offset + count - 1]
+		struct Cluster
+		{
+			uint32_t offset;
+			uint32_t count;
+		};
+
+		struct Stats
+		{
+			size_t lights;            // last assign()
+			size_t indices;
+			size_t occupied;          // clusters with at least one light
+			uint32_t maxPerCluster;
+		};
+
+		explicit LightGrid(const Settings& settings);
+
+		// Light spheres in view space, the camera looking down -z; xScale and yScale are
+		// elements [0][0] and [1][1] of the (perspective) projection matrix
+		void assign(const SphereBatch& lights, float xScale, float yScale);
+
+		inline size_t getClusterCount() const { return m_clusters.size(); }
+		inline uint32_t clusterIndex(uint32_t x, uint32_t y, uint32_t slice) const
+		{
+			return x + m_settings.tilesX * (y + m_settings.tilesY * slice);
+		}
+		inline const std::vector<Cluster>& getClusters() const { return m_clusters; }
+		inline const std::vector<uint32_t>& getIndices() const { return m_indices; }
+
+		// The slice of a view depth is floor(log(depth) * scale + bias), clamped to the grid
+		inline float getSliceScale() const { return m_sliceScale; }
+		inline float getSliceBias() const { return m_sliceBias; }
+		uint32_t sliceOf(float depth) const;
+
+		inline const Settings& getSettings() const { return m_settings; }
+		Stats getStats() const;
+
+		// Instruction set the assignment was built for
+		static const char* simdName();
+	private:
+		// Scratch of one slice, kept between frames
+		struct Slice
+		{
+			std::vector<uint32_t> lights;   // overlapping lights, in order
+			std::vector<uint32_t> rects;    // first and last tile x, then y, per light
+			std::vector<uint32_t> cursors;  // per tile
+			std::vector<uint32_t> indices;
+		};
+
+		Settings m_settings;
+		float m_sliceScale, m_sliceBias;
+		std::vector<float> m_bounds;        // slice k covers m_bounds[k] .. m_bounds[k + 1]
+		std::unique_ptr<ThreadPool> m_pool;
+		std::vector<Slice> m_slices;
+		std::vector<Cluster> m_clusters;
+		std::vector<uint32_t> m_indices;
+		size_t m_lights;
+
+		void assignSlice(uint32_t slice, const SphereBatch& lights, float xScale, float yScale);
+};
+#endif // __LIGHTGRID_H__
@@ -0,0 +1,92 @@
+/**
+ * @file    CharacterController.cpp
+ * @brief   Walking body with gravity and step-up on the voxel grid
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "physics/CharacterController.h"
+
+#include <algorithm>
+
+CharacterController::CharacterController(const Settings& settings, const glm::dvec3& feet) :
+	m_settings(settings),
+	m_position(feet),
+	m_velocity(0.0),
+	m_onGround(false)
+{
+
+}
+
+void CharacterController::setPosition(const glm::dvec3& feet)
+{
+	m_position = feet;
+	m_velocity = glm::dvec3(0.0);
+	m_onGround = false;
+}
+
+VoxelCollider::Box CharacterController::getBox() const
+{
+	const glm::dvec3 half(m_settings.halfWidth, 0.0, m_settings.halfWidth);
+	return { m_position - half, m_position + half + glm::dvec3(0.0, m_settings.height, 0.0) };
+}
+
+void CharacterController::step(VoxelCollider& collider, const glm::dvec3& wishVelocity, bool jump, double dt)
+{
+	m_velocity.x = wishVelocity.x;
+	m_velocity.z = wishVelocity.z;
+	if (jump && m_onGround)
+		m_velocity.y = m_settings.jumpSpeed;
+	else
+		m_velocity.y = std::max(m_velocity.y - m_settings.gravity * dt, -m_settings.maxFallSpeed);
+
+	const glm::dvec3 motion = m_velocity * dt;
+	const VoxelCollider::Box start = getBox();
+	VoxelCollider::Box box = start;
+	bool blocked[3];
+	glm::dvec3 applied = collider.move(box, motion, blocked);
+
+	// Walked into something while standing: try again from stepHeight higher, then
+	// back down, and keep whichever got further
+	if (m_onGround && m_settings.stepHeight > 0.0 && (blocked[0] || blocked[2]))
+	{
+		VoxelCollider::Box raised = start;
+		const double up = collider.sweep(raised, 1, m_settings.stepHeight);
+		raised.min.y += up;
+		raised.max.y += up;
+
+		bool raisedBlocked[3];
+		const glm::dvec3 across = collider.move(raised, glm::dvec3(motion.x, 0.0, motion.z), raisedBlocked);
+		const double down = collider.sweep(raised, 1, std::min(motion.y, 0.0) - up);
+		raised.min.y += down;
+		raised.max.y += down;
+
+		if (across.x * across.x + across.z * across.z > applied.x * applied.x + applied.z * applied.z)
+		{
+			box = raised;
+			applied = glm::dvec3(across.x, up + down, across.z);
+			blocked[0] = raisedBlocked[0];
+			blocked[1] = down != std::min(motion.y, 0.0) - up;
+			blocked[2] = raisedBlocked[2];
+		}
+	}
+
+	m_position += applied;
+	m_onGround = blocked[1] && motion.y <= 0.0;
+	for (int axis = 0; axis < 3; axis++)
+		if (blocked[axis])
+			m_velocity[axis] = 0.0;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file    CharacterController.h
+ * @brief   Walking body with gravity and step-up on the voxel grid
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __CHARACTERCONTROLLER_H__
+#define __CHARACTERCONTROLLER_H__
+
+#include "physics/VoxelCollider.h"
+
+/**
+ * Walking body: a box standing on its feet position, pulled down by gravity, moved
+ * through a VoxelCollider each fixed step. Horizontal velocity follows the requested
+ * one directly. A body on the ground that walks into a ledge no higher than stepHeight
+ * climbs it, by retrying the move raised by stepHeight and keeping it when it gets
+ * further. Only plain double arithmetic, so the same steps give the same positions.
+ */
+class CharacterController
+{
+	public:
+		struct Settings
+		{
+			double halfWidth;     // of the square footprint
+			double height;
+			double eyeHeight;     // of the camera above the feet
+			double stepHeight;    // ledges climbed without jumping
+			double gravity;       // units/s^2
+			double jumpSpeed;     // units/s upwards
+			double maxFallSpeed;  // units/s
+		};
+
+		CharacterController(const Settings& settings, const glm::dvec3& feet);
+
+		// One fixed step of dt seconds; wishVelocity is horizontal, its y is ignored
+		void step(VoxelCollider& collider, const glm::dvec3& wishVelocity, bool jump, double dt);
+
+		// Place the feet directly, keeping no velocity
+		void setPosition(const glm::dvec3& feet);
+
+		inline const glm::dvec3& getPosition() const { return m_position; }
+		inline glm::dvec3 getEyePosition() const { return m_position + glm::dvec3(0.0, m_settings.eyeHeight, 0.0); }
+		inline const glm::dvec3& getVelocity() const { return m_velocity; }
+		inline bool isOnGround() const { return m_onGround; }
+		VoxelCollider::Box getBox() const;
+	private:
+		Settings m_settings;
+		glm::dvec3 m_position;
+		glm::dvec3 m_velocity;
+		bool m_onGround;
+};
+#endif // __CHARACTERCONTROLLER_H__
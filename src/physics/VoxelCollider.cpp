@@ -0,0 +1,100 @@
+/**
+ * @file    VoxelCollider.cpp
+ * @brief   Swept box collision against the voxel grid
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "physics/VoxelCollider.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Faces closer than this to a voxel boundary count as touching it, not entering it
+static const double EPSILON = 1e-7;
+
+VoxelCollider::VoxelCollider(const ChunkStore& store) :
+	m_store(store),
+	m_tested(0)
+{
+
+}
+
+double VoxelCollider::sweep(const Box& box, int axis, double distance)
+{
+	if (distance == 0.0)
+		return 0.0;
+
+	// Cross section of the box on the two other axes, in voxels
+	const int u = (axis + 1) % 3, v = (axis + 2) % 3;
+	const int u0 = static_cast<int>(std::floor(box.min[u] + EPSILON)), u1 = static_cast<int>(std::floor(box.max[u] - EPSILON));
+	const int v0 = static_cast<int>(std::floor(box.min[v] + EPSILON)), v1 = static_cast<int>(std::floor(box.max[v] - EPSILON));
+
+	// Layers the leading face enters, nearest first
+	const bool positive = distance > 0.0;
+	const double face = positive ? box.max[axis] : box.min[axis];
+	const int first = positive ? static_cast<int>(std::floor(face - EPSILON)) + 1 : static_cast<int>(std::floor(face + EPSILON)) - 1;
+	const int last = positive ? static_cast<int>(std::floor(face + distance - EPSILON)) : static_cast<int>(std::floor(face + distance + EPSILON));
+	const int step = positive ? 1 : -1;
+
+	glm::ivec3 voxel;
+	for (int layer = first; positive ? layer <= last : layer >= last; layer += step)
+	{
+		voxel[axis] = layer;
+		for (int a = u0; a <= u1; a++)
+			for (int b = v0; b <= v1; b++)
+			{
+				voxel[u] = a;
+				voxel[v] = b;
+				m_tested++;
+				if (m_store.getVoxel(voxel.x, voxel.y, voxel.z) != VOXEL_AIR)
+				{
+					// Stop at the layer's near face, never backwards
+					const double allowed = positive ? layer - face : layer + 1 - face;
+					return positive ? std::max(allowed, 0.0) : std::min(allowed, 0.0);
+				}
+			}
+	}
+	return distance;
+}
+
+glm::dvec3 VoxelCollider::move(Box& box, const glm::dvec3& motion, bool blocked[3])
+{
+	static const int ORDER[3] = { 1, 0, 2 };
+
+	glm::dvec3 applied(0.0);
+	for (int axis : ORDER)
+	{
+		applied[axis] = sweep(box, axis, motion[axis]);
+		blocked[axis] = applied[axis] != motion[axis];
+		box.min[axis] += applied[axis];
+		box.max[axis] += applied[axis];
+	}
+	return applied;
+}
+
+bool VoxelCollider::overlaps(const Box& box) const
+{
+	const int x0 = static_cast<int>(std::floor(box.min.x + EPSILON)), x1 = static_cast<int>(std::floor(box.max.x - EPSILON));
+	const int y0 = static_cast<int>(std::floor(box.min.y + EPSILON)), y1 = static_cast<int>(std::floor(box.max.y - EPSILON));
+	const int z0 = static_cast<int>(std::floor(box.min.z + EPSILON)), z1 = static_cast<int>(std::floor(box.max.z - EPSILON));
+	for (int z = z0; z <= z1; z++)
+		for (int y = y0; y <= y1; y++)
+			for (int x = x0; x <= x1; x++)
+				if (m_store.getVoxel(x, y, z) != VOXEL_AIR)
+					return true;
+	return false;
+}
@@ -0,0 +1,58 @@
+/**
+ * @file    VoxelCollider.h
+ * @brief   Swept box collision against the voxel grid
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __VOXELCOLLIDER_H__
+#define __VOXELCOLLIDER_H__
+
+#include "util/Math3D.h"
+#include "voxel/ChunkStore.h"
+
+/**
+ * Swept axis-aligned boxes against the voxel grid. A move is resolved one axis at a
+ * time, and each axis only tests the layers of voxels the leading face of the box
+ * sweeps into, nearest first, stopping at the first solid one; a box sliding along a
+ * wall keeps the motion along the other axes. Boxes are assumed not to overlap solid
+ * voxels to begin with. Not thread-safe, like the ChunkStore it reads.
+ */
+class VoxelCollider
+{
+	public:
+		struct Box
+		{
+			glm::dvec3 min, max;
+		};
+
+		explicit VoxelCollider(const ChunkStore& store);
+
+		// Part of distance (signed) the box can travel along axis before touching a solid voxel
+		double sweep(const Box& box, int axis, double distance);
+		// Move the box by motion, y first, then x and z. Returns the motion applied,
+		// blocked[axis] tells whether that axis was cut short.
+		glm::dvec3 move(Box& box, const glm::dvec3& motion, bool blocked[3]);
+		// Any solid voxel inside the box
+		bool overlaps(const Box& box) const;
+
+		// Voxels looked at since construction
+		inline size_t getVoxelsTested() const { return m_tested; }
+	private:
+		const ChunkStore& m_store;
+		size_t m_tested;
+};
+#endif // __VOXELCOLLIDER_H__
@@ -0,0 +1,91 @@
+/**
+ * @file    PlanetMeshBuffer.cpp
+ * @brief   GPU vertex buffer of a planet patch
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "planet/PlanetMeshBuffer.h"
+#include "GLState.h"
+
+PlanetMeshBuffer::PlanetMeshBuffer() :
+	m_vao(0), m_vbo(0), m_indexCount(0), m_bytes(0)
+{
+
+}
+
+PlanetMeshBuffer::~PlanetMeshBuffer()
+{
+	release();
+}
+
+void PlanetMeshBuffer::upload(const PlanetPatchMesh& mesh)
+{
+	GLState& state = GLState::getInstance();
+	if (m_vao == 0)
+	{
+		glGenVertexArrays(1, &m_vao);
+		glGenBuffers(1, &m_vbo);
+
+		state.bindVertexArray(m_vao);
+		state.bindBuffer(GL_ARRAY_BUFFER, m_vbo);
+
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(PlanetVertex), (void*)offsetof(PlanetVertex, position));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(PlanetVertex), (void*)offsetof(PlanetVertex, normal));
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(PlanetVertex), (void*)offsetof(PlanetVertex, elevation));
+	}
+	else
+		state.bindBuffer(GL_ARRAY_BUFFER, m_vbo);
+
+	glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(PlanetVertex), mesh.vertices.data(), GL_STATIC_DRAW);
+	m_bytes = mesh.vertices.size() * sizeof(PlanetVertex);
+}
+
+void PlanetMeshBuffer::setIndices(GLuint indexBuffer, GLsizei indexCount)
+{
+	GLState& state = GLState::getInstance();
+	state.bindVertexArray(m_vao);
+	state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	m_indexCount = indexCount;
+}
+
+void PlanetMeshBuffer::draw() const
+{
+	if (m_indexCount == 0)
+		return;
+
+	GLState::getInstance().bindVertexArray(m_vao);
+	glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_SHORT, 0);
+}
+
+void PlanetMeshBuffer::release()
+{
+	if (m_vao == 0)
+		return;
+
+	GLState& state = GLState::getInstance();
+	state.forgetBuffer(m_vbo);
+	state.forgetVertexArray(m_vao);
+
+	glDeleteBuffers(1, &m_vbo);
+	glDeleteVertexArrays(1, &m_vao);
+	m_vao = m_vbo = 0;
+	m_indexCount = 0;
+	m_bytes = 0;
+}
@@ -0,0 +1,54 @@
+/**
+ * @file    PlanetMeshBuffer.h
+ * @brief   GPU vertex buffer of a planet patch
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __PLANETMESHBUFFER_H__
+#define __PLANETMESHBUFFER_H__
+
+#include "util/Common.h"
+#include "planet/PlanetPatch.h"
+
+/**
+ * Owns the VAO and vertex buffer of one planet patch, with PlanetVertex bound at
+ * locations 0 (position), 1 (normal) and 2 (elevation), see data/shaders/planet.vert.
+ * Index buffers are shared between patches with the same edge stitching.
+ */
+class PlanetMeshBuffer
+{
+	public:
+		PlanetMeshBuffer();
+		~PlanetMeshBuffer();
+
+		PlanetMeshBuffer(const PlanetMeshBuffer&) = delete;
+		PlanetMeshBuffer& operator=(const PlanetMeshBuffer&) = delete;
+
+		// Replace the vertices, the GL objects are created on first use
+		void upload(const PlanetPatchMesh& mesh);
+		// Attach a shared GL_UNSIGNED_SHORT index buffer
+		void setIndices(GLuint indexBuffer, GLsizei indexCount);
+		void draw() const;
+		void release();
+
+		inline size_t getByteSize() const { return m_bytes; }
+	private:
+		GLuint m_vao, m_vbo;
+		GLsizei m_indexCount;
+		size_t m_bytes;
+};
+#endif // __PLANETMESHBUFFER_H__
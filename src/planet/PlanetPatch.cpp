@@ -0,0 +1,226 @@
+/**
+ * @file    PlanetPatch.cpp
+ * @brief   Cube-sphere geometry and height-mapped planet patch meshes
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "planet/PlanetPatch.h"
+
+#include <algorithm>
+#include <cmath>
+
+static const glm::dvec3 FACE_NORMALS[CUBE_FACES] = {
+	glm::dvec3( 1.0,  0.0,  0.0), glm::dvec3(-1.0,  0.0,  0.0),
+	glm::dvec3( 0.0,  1.0,  0.0), glm::dvec3( 0.0, -1.0,  0.0),
+	glm::dvec3( 0.0,  0.0,  1.0), glm::dvec3( 0.0,  0.0, -1.0)
+};
+
+static const glm::dvec3 FACE_U[CUBE_FACES] = {
+	glm::dvec3( 0.0,  0.0, -1.0), glm::dvec3( 0.0,  0.0,  1.0),
+	glm::dvec3( 1.0,  0.0,  0.0), glm::dvec3( 1.0,  0.0,  0.0),
+	glm::dvec3( 1.0,  0.0,  0.0), glm::dvec3(-1.0,  0.0,  0.0)
+};
+
+static const glm::dvec3 FACE_V[CUBE_FACES] = {
+	glm::dvec3( 0.0,  1.0,  0.0), glm::dvec3( 0.0,  1.0,  0.0),
+	glm::dvec3( 0.0,  0.0, -1.0), glm::dvec3( 0.0,  0.0,  1.0),
+	glm::dvec3( 0.0,  1.0,  0.0), glm::dvec3( 0.0,  1.0,  0.0)
+};
+
+// Lattice of the deepest level, all patch vertices are points of it
+static const int64_t LATTICE = static_cast<int64_t>(PlanetPatch::CELLS) << PlanetPatch::MAX_LEVEL;
+
+// Samples around the patch grid, with a one vertex border for the normals
+static const int BORDERED = PlanetPatch::GRID + 2;
+
+const glm::dvec3& CubeSphere::faceNormal(CubeFace face)
+{
+	return FACE_NORMALS[face];
+}
+
+const glm::dvec3& CubeSphere::faceU(CubeFace face)
+{
+	return FACE_U[face];
+}
+
+const glm::dvec3& CubeSphere::faceV(CubeFace face)
+{
+	return FACE_V[face];
+}
+
+glm::dvec3 CubeSphere::cubePoint(CubeFace face, double u, double v)
+{
+	// Every component is one of +-1, +-u, +-v or 0, nothing gets rounded
+	return FACE_NORMALS[face] + FACE_U[face] * u + FACE_V[face] * v;
+}
+
+CubeFace CubeSphere::project(const glm::dvec3& point, double& u, double& v)
+{
+	const glm::dvec3 a = glm::abs(point);
+	CubeFace face;
+	if (a.x >= a.y && a.x >= a.z)
+		face = point.x >= 0.0 ? FACE_POSITIVE_X : FACE_NEGATIVE_X;
+	else if (a.y >= a.z)
+		face = point.y >= 0.0 ? FACE_POSITIVE_Y : FACE_NEGATIVE_Y;
+	else
+		face = point.z >= 0.0 ? FACE_POSITIVE_Z : FACE_NEGATIVE_Z;
+
+	const double depth = glm::dot(point, FACE_NORMALS[face]);
+	u = glm::dot(point, FACE_U[face]) / depth;
+	v = glm::dot(point, FACE_V[face]) / depth;
+	return face;
+}
+
+glm::dvec3 CubeSphere::spherify(const glm::dvec3& cube)
+{
+	// Each component only depends on the point, not on the face it was computed from
+	const glm::dvec3 s = cube * cube;
+	return glm::dvec3(
+		cube.x * std::sqrt(1.0 - s.y * 0.5 - s.z * 0.5 + s.y * s.z / 3.0),
+		cube.y * std::sqrt(1.0 - s.z * 0.5 - s.x * 0.5 + s.z * s.x / 3.0),
+		cube.z * std::sqrt(1.0 - s.x * 0.5 - s.y * 0.5 + s.x * s.y / 3.0));
+}
+
+PlanetPatch::PlanetPatch(const Settings& settings) :
+	m_settings(settings),
+	m_height(settings.frequency, 1.0f, 2.0f, 0.5f)
+{
+	m_height.setSeed(settings.seed);
+}
+
+glm::dvec3 PlanetPatch::surfacePoint(const glm::dvec3& direction, float& elevation) const
+{
+	const glm::dvec3 sample = direction * m_settings.radius;
+	elevation = m_height.fractal(m_settings.octaves,
+		static_cast<float>(sample.x), static_cast<float>(sample.y), static_cast<float>(sample.z));
+	return direction * (m_settings.radius + static_cast<double>(m_settings.heightScale * elevation));
+}
+
+void PlanetPatch::generate(const PatchTile& tile, PlanetPatchMesh& mesh) const
+{
+	const size_t samples = BORDERED * BORDERED;
+	std::vector<glm::dvec3> points(samples);
+	std::vector<float> x(samples), y(samples), z(samples), elevations(samples);
+
+	// Lattice steps between two vertices of this level, the lattice coordinates are
+	// exact in double and so is the division by the power of two LATTICE
+	const int64_t spacing = int64_t(1) << (MAX_LEVEL - tile.level);
+	const int64_t baseU = static_cast<int64_t>(tile.x) * CELLS, baseV = static_cast<int64_t>(tile.y) * CELLS;
+	for (int j = 0; j < BORDERED; j++)
+		for (int i = 0; i < BORDERED; i++)
+		{
+			const double u = static_cast<double>(2 * (baseU + i - 1) * spacing - LATTICE) / LATTICE;
+			const double v = static_cast<double>(2 * (baseV + j - 1) * spacing - LATTICE) / LATTICE;
+
+			// The border spills over onto the neighbouring face, bring it back onto the cube
+			glm::dvec3 cube = CubeSphere::cubePoint(tile.face, u, v);
+			const glm::dvec3 a = glm::abs(cube);
+			cube /= std::max(a.x, std::max(a.y, a.z));
+
+			const glm::dvec3 direction = CubeSphere::spherify(cube);
+			const glm::dvec3 sample = direction * m_settings.radius;
+			points[i + j * BORDERED] = direction;
+			x[i + j * BORDERED] = static_cast<float>(sample.x);
+			y[i + j * BORDERED] = static_cast<float>(sample.y);
+			z[i + j * BORDERED] = static_cast<float>(sample.z);
+		}
+
+	// Same values as surfacePoint(), through the batch kernels
+	m_height.fractal(m_settings.octaves, x.data(), y.data(), z.data(), elevations.data(), samples);
+	for (size_t n = 0; n < samples; n++)
+		points[n] *= m_settings.radius + static_cast<double>(m_settings.heightScale * elevations[n]);
+
+	auto point = [&](int i, int j) -> const glm::dvec3& { return points[(i + 1) + (j + 1) * BORDERED]; };
+
+	mesh.center = point(CELLS / 2, CELLS / 2);
+	mesh.vertices.resize(GRID * GRID);
+
+	double radius = 0.0, coarsening = 0.0;
+	for (int j = 0; j < GRID; j++)
+		for (int i = 0; i < GRID; i++)
+		{
+			const glm::dvec3& p = point(i, j);
+			const glm::dvec3 normal = glm::normalize(glm::cross(point(i + 1, j) - point(i - 1, j), point(i, j + 1) - point(i, j - 1)));
+
+			PlanetVertex& vertex = mesh.vertices[i + j * GRID];
+			vertex.position = glm::vec3(p - mesh.center);
+			vertex.normal = glm::vec3(normal);
+			vertex.elevation = elevations[(i + 1) + (j + 1) * BORDERED];
+			radius = std::max(radius, glm::length(p - mesh.center));
+
+			// How far the vertices the parent does not have are from its triangles
+			if ((i & 1) == 0 && (j & 1) == 0)
+				continue;
+			glm::dvec3 predicted;
+			if ((j & 1) == 0)
+				predicted = (point(i - 1, j) + point(i + 1, j)) * 0.5;
+			else if ((i & 1) == 0)
+				predicted = (point(i, j - 1) + point(i, j + 1)) * 0.5;
+			else
+				predicted = (point(i + 1, j - 1) + point(i - 1, j + 1)) * 0.5;
+			coarsening = std::max(coarsening, glm::length(p - predicted));
+		}
+
+	// With the octaves halving in amplitude as they double in frequency, the error of
+	// this level is about half of what dropping to the parent's spacing would cost
+	mesh.radius = static_cast<float>(radius);
+	mesh.error = static_cast<float>(coarsening * 0.5);
+}
+
+void PlanetPatch::buildIndices(const int steps[PATCH_EDGES], std::vector<uint16_t>& indices)
+{
+	auto vertex = [&](int i, int j) -> uint16_t {
+		if (i == 0)
+			j -= j % steps[EDGE_U_MIN];
+		else if (i == CELLS)
+			j -= j % steps[EDGE_U_MAX];
+		if (j == 0)
+			i -= i % steps[EDGE_V_MIN];
+		else if (j == CELLS)
+			i -= i % steps[EDGE_V_MAX];
+		return static_cast<uint16_t>(i + j * GRID);
+	};
+
+	auto triangle = [&](uint16_t a, uint16_t b, uint16_t c) {
+		// Collapsed edge vertices leave degenerate triangles behind
+		if (a == b || b == c || a == c)
+			return;
+		indices.push_back(a);
+		indices.push_back(b);
+		indices.push_back(c);
+	};
+
+	indices.clear();
+	indices.reserve(CELLS * CELLS * 6);
+	for (int j = 0; j < CELLS; j++)
+		for (int i = 0; i < CELLS; i++)
+		{
+			const uint16_t a = vertex(i, j), b = vertex(i + 1, j);
+			const uint16_t c = vertex(i, j + 1), d = vertex(i + 1, j + 1);
+
+			// The far corner's diagonal would end at both collapsed edges and leave a
+			// sliver through a, use the other one there
+			if (i == CELLS - 1 && j == CELLS - 1)
+			{
+				triangle(a, b, d);
+				triangle(a, d, c);
+				continue;
+			}
+			triangle(a, b, c);
+			triangle(b, d, c);
+		}
+}
@@ -0,0 +1,141 @@
+/**
+ * @file    PlanetPatch.h
+ * @brief   Cube-sphere geometry and height-mapped planet patch meshes
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __PLANETPATCH_H__
+#define __PLANETPATCH_H__
+
+#include "util/Math3D.h"
+#include "util/SimplexNoise.h"
+
+#include <cstdint>
+#include <vector>
+
+enum CubeFace
+{
+	FACE_POSITIVE_X,
+	FACE_NEGATIVE_X,
+	FACE_POSITIVE_Y,
+	FACE_NEGATIVE_Y,
+	FACE_POSITIVE_Z,
+	FACE_NEGATIVE_Z,
+	CUBE_FACES
+};
+
+// Patch edges, along the face coordinates u and v
+enum PatchEdge
+{
+	EDGE_U_MIN,
+	EDGE_U_MAX,
+	EDGE_V_MIN,
+	EDGE_V_MAX,
+	PATCH_EDGES
+};
+
+/**
+ * Every face of the unit cube is parametrized by u, v in [-1, 1], with cross(U, V)
+ * pointing out of the cube so grid triangles wind counter-clockwise from outside.
+ */
+class CubeSphere
+{
+	public:
+		// Point on the unit cube; exact for dyadic u and v, so a point on a cube edge
+		// comes out bit-identical from both faces that share it
+		static glm::dvec3 cubePoint(CubeFace face, double u, double v);
+		// Face a point near the cube surface belongs to, and its face coordinates
+		static CubeFace project(const glm::dvec3& point, double& u, double& v);
+		// Unit cube point to unit sphere, with less area distortion than normalizing
+		static glm::dvec3 spherify(const glm::dvec3& cube);
+
+		static const glm::dvec3& faceNormal(CubeFace face);
+		static const glm::dvec3& faceU(CubeFace face);
+		static const glm::dvec3& faceV(CubeFace face);
+};
+
+// Tile x, y of a face at a quadtree level, 2^level tiles along each side
+struct PatchTile
+{
+	CubeFace face;
+	int level;
+	uint32_t x, y;
+
+	// Face coordinates of the lower corner, and the side length
+	inline double size() const { return 2.0 / static_cast<double>(1u << level); }
+	inline double u0() const { return -1.0 + x * size(); }
+	inline double v0() const { return -1.0 + y * size(); }
+};
+
+struct PlanetVertex
+{
+	glm::vec3 position;  // relative to PlanetPatchMesh::center
+	glm::vec3 normal;
+	float elevation;     // noise value, -1 to 1
+};
+
+struct PlanetPatchMesh
+{
+	std::vector<PlanetVertex> vertices;  // PlanetPatch::GRID^2, v-major
+	glm::dvec3 center;                   // planet-relative
+	float radius;                        // bounding sphere around center
+	float error;                         // estimated geometric error, world units
+};
+
+/**
+ * Generates patch meshes of a planet whose surface is radius + heightScale * fBm over
+ * the sphere. Vertices come from one global lattice of the cube faces, so patches
+ * share the exact positions of their common lattice points at every level, and
+ * stitched index lists (see buildIndices) remove the T-junctions towards coarser
+ * neighbours. All methods are const and safe to call from several threads at once.
+ */
+class PlanetPatch
+{
+	public:
+		static const int CELLS = 32;
+		static const int GRID = CELLS + 1;
+		// Deepest level the global lattice can address exactly
+		static constexpr int MAX_LEVEL = 20;
+
+		struct Settings
+		{
+			uint32_t seed;
+			double radius;       // of the sea level sphere
+			float heightScale;   // surface goes radius +- heightScale
+			float frequency;     // of the height fBm, per world unit on the sphere
+			size_t octaves;
+		};
+
+		explicit PlanetPatch(const Settings& settings);
+
+		void generate(const PatchTile& tile, PlanetPatchMesh& mesh) const;
+
+		// Triangles of a patch whose neighbour across edge e is coarser: edge vertices
+		// between every steps[e]-th one are collapsed onto the previous kept one, which
+		// leaves the edge made of the neighbour's segments. Steps are powers of two up
+		// to CELLS, 1 for a neighbour of the same level or finer.
+		static void buildIndices(const int steps[PATCH_EDGES], std::vector<uint16_t>& indices);
+
+		// Planet-relative surface point above a unit sphere direction, and its noise value
+		glm::dvec3 surfacePoint(const glm::dvec3& direction, float& elevation) const;
+
+		inline const Settings& getSettings() const { return m_settings; }
+	private:
+		Settings m_settings;
+		SimplexNoise m_height;
+};
+#endif // __PLANETPATCH_H__
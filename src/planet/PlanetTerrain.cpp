@@ -0,0 +1,281 @@
+/**
+ * @file    PlanetTerrain.cpp
+ * @brief   Cube-sphere quadtree level of detail for planet terrain
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "planet/PlanetTerrain.h"
+#include "GLState.h"
+#include "util/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+typedef std::chrono::steady_clock Clock;
+typedef std::chrono::duration<double, std::milli> Milliseconds;
+
+// Children are merged back once the parent's error is this far below the threshold,
+// so a patch near the threshold does not split and merge every other frame
+static const double MERGE_RATIO = 0.5;
+
+// Closest the camera counts as being to a patch it is inside of
+static const double MIN_DISTANCE = 1.0;
+
+// Edge steps in a stitch key, as 3 bit shifts of one, up to CELLS
+static const int STITCH_BITS = 3;
+static const int MAX_STITCH_SHIFT = 5;
+static_assert((1 << MAX_STITCH_SHIFT) == PlanetPatch::CELLS, "stitch shifts must reach CELLS");
+
+// Nothing attached yet
+static const uint32_t NO_STITCH = 0xFFFFFFFF;
+
+bool PlanetTerrain::Node::isRefined() const
+{
+	if (!children[0])
+		return false;
+	for (const std::unique_ptr<Node>& child : children)
+		if (!child->generated)
+			return false;
+	return true;
+}
+
+PlanetTerrain::PlanetTerrain(const glm::dvec3& center, const Settings& settings) :
+	m_center(center), m_settings(settings), m_generator(settings.surface), m_stats()
+{
+	m_settings.maxLevel = std::min(m_settings.maxLevel, PlanetPatch::MAX_LEVEL);
+	for (int face = 0; face < CUBE_FACES; face++)
+		m_roots[face] = createNode({ static_cast<CubeFace>(face), 0, 0, 0 });
+}
+
+PlanetTerrain::~PlanetTerrain()
+{
+	for (std::unique_ptr<Node>& root : m_roots)
+		root.reset();
+
+	GLState& state = GLState::getInstance();
+	for (auto& entry : m_indexBuffers)
+	{
+		state.forgetBuffer(entry.second.buffer);
+		glDeleteBuffers(1, &entry.second.buffer);
+	}
+}
+
+std::unique_ptr<PlanetTerrain::Node> PlanetTerrain::createNode(const PatchTile& tile) const
+{
+	std::unique_ptr<Node> node(new Node());
+	node->tile = tile;
+
+	// Bounds from the sphere until the patch is generated, only used for ordering
+	const double half = tile.size() * 0.5;
+	const glm::dvec3 middle = CubeSphere::spherify(CubeSphere::cubePoint(tile.face, tile.u0() + half, tile.v0() + half));
+	const glm::dvec3 corner = CubeSphere::spherify(CubeSphere::cubePoint(tile.face, tile.u0(), tile.v0()));
+	node->center = m_center + middle * m_settings.surface.radius;
+	node->radius = glm::length(corner - middle) * m_settings.surface.radius + m_settings.surface.heightScale;
+	node->error = 0.0f;
+	node->distance = 0.0;
+	node->priority = 0.0;
+	node->generated = false;
+	node->stitch = NO_STITCH;
+	return node;
+}
+
+void PlanetTerrain::visit(Node* node, const glm::dvec3& cameraPosition, double projectionScale)
+{
+	m_stats.nodes++;
+	node->distance = glm::length(cameraPosition - node->center);
+	if (!node->generated)
+	{
+		m_pending.push_back(node);
+		return;
+	}
+
+	// Geometric error in pixels, at the nearest point of the bounding sphere
+	const double screenError = node->error * projectionScale / std::max(node->distance - node->radius, MIN_DISTANCE);
+
+	if (!node->children[0])
+	{
+		if (screenError <= m_settings.maxScreenError || node->tile.level >= m_settings.maxLevel)
+			return;
+
+		const PatchTile& tile = node->tile;
+		for (int i = 0; i < 4; i++)
+			node->children[i] = createNode({ tile.face, tile.level + 1, tile.x * 2 + (i & 1), tile.y * 2 + (i >> 1) });
+	}
+	else if (screenError < m_settings.maxScreenError * MERGE_RATIO)
+	{
+		for (std::unique_ptr<Node>& child : node->children)
+			child.reset();
+		return;
+	}
+
+	for (std::unique_ptr<Node>& child : node->children)
+		visit(child.get(), cameraPosition, projectionScale);
+}
+
+void PlanetTerrain::generate(Node* node)
+{
+	m_generator.generate(node->tile, m_mesh);
+	node->center = m_center + m_mesh.center;
+	node->radius = m_mesh.radius;
+	node->error = m_mesh.error;
+	node->buffer.upload(m_mesh);
+	node->generated = true;
+}
+
+void PlanetTerrain::update(const glm::dvec3& cameraPosition, float fov, int viewportHeight)
+{
+	PROFILE_SCOPE("planet update");
+	// Pixels covered by one world unit at distance one
+	const double projectionScale = viewportHeight / (2.0 * std::tan(glm::radians(static_cast<double>(fov)) * 0.5));
+
+	m_stats.nodes = 0;
+	m_pending.clear();
+	for (std::unique_ptr<Node>& root : m_roots)
+		visit(root.get(), cameraPosition, projectionScale);
+
+	// Largest on screen first: coarse patches before their descendants, near before far
+	for (Node* node : m_pending)
+		node->priority = node->radius / std::max(node->distance - node->radius, MIN_DISTANCE);
+	std::sort(m_pending.begin(), m_pending.end(), [](const Node* a, const Node* b) {
+		return a->priority > b->priority;
+	});
+
+	const Clock::time_point start = Clock::now();
+	m_stats.generated = 0;
+	for (Node* node : m_pending)
+	{
+		if (m_stats.generated >= m_settings.maxPatchesPerFrame)
+			break;
+		if (m_stats.generated > 0 && Milliseconds(Clock::now() - start).count() >= m_settings.generationBudgetMs)
+			break;
+
+		PROFILE_SCOPE("generate patch");
+		generate(node);
+		m_stats.generated++;
+	}
+	m_stats.generationMs = Milliseconds(Clock::now() - start).count();
+	m_stats.pending = m_pending.size() - m_stats.generated;
+}
+
+void PlanetTerrain::collect(Node* node)
+{
+	if (!node->generated)
+		return;
+
+	if (node->isRefined())
+	{
+		for (std::unique_ptr<Node>& child : node->children)
+			collect(child.get());
+		return;
+	}
+	m_drawables.push_back(node);
+}
+
+int PlanetTerrain::drawnLevel(CubeFace face, double u, double v) const
+{
+	const Node* node = m_roots[face].get();
+	while (node->isRefined())
+	{
+		const PatchTile& tile = node->tile;
+		const double half = tile.size() * 0.5;
+		const int child = (u >= tile.u0() + half ? 1 : 0) + (v >= tile.v0() + half ? 2 : 0);
+		node = node->children[child].get();
+	}
+	return node->tile.level;
+}
+
+uint32_t PlanetTerrain::stitchKey(const Node* node) const
+{
+	// Probe the middle of where a neighbour of the same level would be; a coarser
+	// neighbour covers the whole edge, a finer one stitches itself to this patch
+	const PatchTile& tile = node->tile;
+	const double size = tile.size();
+	const double middleU = tile.u0() + size * 0.5, middleV = tile.v0() + size * 0.5;
+	const double probes[PATCH_EDGES][2] = {
+		{ tile.u0() - size * 0.5, middleV },
+		{ tile.u0() + size * 1.5, middleV },
+		{ middleU, tile.v0() - size * 0.5 },
+		{ middleU, tile.v0() + size * 1.5 }
+	};
+
+	uint32_t key = 0;
+	for (int edge = 0; edge < PATCH_EDGES; edge++)
+	{
+		// Off the face the probe lands on the neighbouring face
+		double u, v;
+		const CubeFace face = CubeSphere::project(CubeSphere::cubePoint(tile.face, probes[edge][0], probes[edge][1]), u, v);
+		const int coarser = std::min(std::max(tile.level - drawnLevel(face, u, v), 0), MAX_STITCH_SHIFT);
+		key |= static_cast<uint32_t>(coarser) << (edge * STITCH_BITS);
+	}
+	return key;
+}
+
+const PlanetTerrain::IndexBuffer& PlanetTerrain::indexBuffer(uint32_t key)
+{
+	auto found = m_indexBuffers.find(key);
+	if (found != m_indexBuffers.end())
+		return found->second;
+
+	int steps[PATCH_EDGES];
+	for (int edge = 0; edge < PATCH_EDGES; edge++)
+		steps[edge] = 1 << ((key >> (edge * STITCH_BITS)) & ((1 << STITCH_BITS) - 1));
+
+	std::vector<uint16_t> indices;
+	PlanetPatch::buildIndices(steps, indices);
+
+	// Through the copy target, binding an element array would change the bound vertex array
+	IndexBuffer& index = m_indexBuffers[key];
+	glGenBuffers(1, &index.buffer);
+	GLState::getInstance().bindBuffer(GL_COPY_WRITE_BUFFER, index.buffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+	index.count = static_cast<GLsizei>(indices.size());
+	return index;
+}
+
+void PlanetTerrain::render(const UniformHandle<glm::mat4>& modelMatrix, const Frustum& frustum, const glm::dvec3& origin)
+{
+	PROFILE_SCOPE("planet render");
+	m_drawables.clear();
+	for (std::unique_ptr<Node>& root : m_roots)
+		collect(root.get());
+
+	m_bounds.clear();
+	for (const Node* node : m_drawables)
+		m_bounds.add(glm::vec3(node->center - origin), static_cast<float>(node->radius));
+	m_visible.resize(m_drawables.size());
+
+	m_stats.drawn = frustum.cull(m_bounds, m_visible.data());
+	m_stats.culled = m_drawables.size() - m_stats.drawn;
+	for (size_t i = 0; i < m_stats.drawn; i++)
+	{
+		Node* node = m_drawables[m_visible[i]];
+
+		// Neighbours change level without this patch changing, look again every frame
+		const uint32_t key = stitchKey(node);
+		if (key != node->stitch)
+		{
+			const IndexBuffer& index = indexBuffer(key);
+			node->buffer.setIndices(index.buffer, index.count);
+			node->stitch = key;
+		}
+
+		// Subtracted in double precision, only the small difference is a float
+		modelMatrix.set(glm::translate(glm::mat4(1.0f), glm::vec3(node->center - origin)));
+		node->buffer.draw();
+	}
+}
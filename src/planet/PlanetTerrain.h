@@ -0,0 +1,125 @@
+/**
+ * @file    PlanetTerrain.h
+ * @brief   Cube-sphere quadtree level of detail for planet terrain
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __PLANETTERRAIN_H__
+#define __PLANETTERRAIN_H__
+
+#include "util/Common.h"
+#include "planet/PlanetMeshBuffer.h"
+#include "UniformHandle.h"
+#include "util/Frustum.h"
+
+#include <memory>
+#include <unordered_map>
+
+/**
+ * A planet as six quadtrees of PlanetPatch tiles, one per cube face. Every frame a
+ * patch is split when its geometric error, projected to the screen, exceeds the
+ * threshold, and its children are merged back once it is well below. Patches are
+ * generated on the main thread under a time budget, coarse and near ones first; a
+ * parent stays on screen until all four of its children exist, so nothing pops out
+ * while the camera dives in from orbit.
+ *
+ * Seams: neighbours share their lattice points exactly, and each drawn patch uses the
+ * index list stitched to the level of the patches drawn across its edges.
+ */
+class PlanetTerrain
+{
+	public:
+		struct Settings
+		{
+			PlanetPatch::Settings surface;
+			int maxLevel;               // quadtree depth, at most PlanetPatch::MAX_LEVEL
+			float maxScreenError;       // pixels, patches projecting a larger error are split
+			double generationBudgetMs;  // patch generation time per frame, one patch always fits
+			size_t maxPatchesPerFrame;
+		};
+
+		struct Stats
+		{
+			size_t nodes;       // in all quadtrees
+			size_t pending;     // waiting for generation
+			size_t generated;   // last frame
+			double generationMs;
+			size_t drawn;
+			size_t culled;
+		};
+
+		PlanetTerrain(const glm::dvec3& center, const Settings& settings);
+		~PlanetTerrain();
+
+		// Call once per frame on the GL thread; fov in degrees, viewport height in pixels
+		void update(const glm::dvec3& cameraPosition, float fov, int viewportHeight);
+		// Draw the patches inside the frustum with the planet shader in use. The frustum
+		// and modelMatrix, set per patch, are relative to the camera's floating origin.
+		void render(const UniformHandle<glm::mat4>& modelMatrix, const Frustum& frustum, const glm::dvec3& origin);
+
+		inline const glm::dvec3& getCenter() const { return m_center; }
+		inline const Stats& getStats() const { return m_stats; }
+	private:
+		struct Node
+		{
+			PatchTile tile;
+			std::unique_ptr<Node> children[4];
+			glm::dvec3 center;    // world space, estimated until generated
+			double radius;
+			float error;
+			double distance;      // to the camera at the last update
+			double priority;      // of generation, the higher the sooner
+			bool generated;
+			uint32_t stitch;      // key of the attached index buffer
+			PlanetMeshBuffer buffer;
+
+			// The children are drawn in place of this node
+			bool isRefined() const;
+		};
+
+		struct IndexBuffer
+		{
+			GLuint buffer;
+			GLsizei count;
+		};
+
+		glm::dvec3 m_center;
+		Settings m_settings;
+		PlanetPatch m_generator;
+		PlanetPatchMesh m_mesh;
+		std::unique_ptr<Node> m_roots[CUBE_FACES];
+
+		// Stitched index lists by key, created when first needed
+		std::unordered_map<uint32_t, IndexBuffer> m_indexBuffers;
+
+		std::vector<Node*> m_pending;
+		std::vector<Node*> m_drawables;
+		SphereBatch m_bounds;
+		std::vector<uint32_t> m_visible;
+		Stats m_stats;
+
+		std::unique_ptr<Node> createNode(const PatchTile& tile) const;
+		void visit(Node* node, const glm::dvec3& cameraPosition, double projectionScale);
+		void generate(Node* node);
+		void collect(Node* node);
+
+		// Level of the patch drawn at face coordinates u, v
+		int drawnLevel(CubeFace face, double u, double v) const;
+		uint32_t stitchKey(const Node* node) const;
+		const IndexBuffer& indexBuffer(uint32_t key);
+};
+#endif // __PLANETTERRAIN_H__
@@ -0,0 +1,66 @@
+/**
+ * @file    NoiseFieldGenerator.cpp
+ * @brief   Multithreaded fBm heightmap and density volume generation
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "terrain/NoiseFieldGenerator.h"
+
+#include <algorithm>
+
+NoiseFieldGenerator::NoiseFieldGenerator(const SimplexNoise& noise, size_t octaves, size_t tileSize) :
+	m_noise(noise), m_octaves(octaves), m_tileSize(std::max<size_t>(tileSize, 1))
+{
+
+}
+
+void NoiseFieldGenerator::generate(ThreadPool& pool, float* out, size_t sizeX, size_t sizeY,
+	float x, float y, float step) const
+{
+	const size_t tilesX = (sizeX + m_tileSize - 1) / m_tileSize;
+	const size_t tilesY = (sizeY + m_tileSize - 1) / m_tileSize;
+
+	pool.parallelFor(tilesX * tilesY, [&](size_t tile)
+	{
+		const size_t i = (tile % tilesX) * m_tileSize;
+		const size_t j = (tile / tilesX) * m_tileSize;
+
+		m_noise.fractalGrid(m_octaves, out + i + j * sizeX,
+			std::min(m_tileSize, sizeX - i), std::min(m_tileSize, sizeY - j),
+			x + i * step, y + j * step, step, sizeX);
+	});
+}
+
+void NoiseFieldGenerator::generate(ThreadPool& pool, float* out, size_t sizeX, size_t sizeY, size_t sizeZ,
+	float x, float y, float z, float step) const
+{
+	const size_t tilesX = (sizeX + m_tileSize - 1) / m_tileSize;
+	const size_t tilesY = (sizeY + m_tileSize - 1) / m_tileSize;
+	const size_t tilesZ = (sizeZ + m_tileSize - 1) / m_tileSize;
+	const size_t slice = sizeX * sizeY;
+
+	pool.parallelFor(tilesX * tilesY * tilesZ, [&](size_t tile)
+	{
+		const size_t i = (tile % tilesX) * m_tileSize;
+		const size_t j = ((tile / tilesX) % tilesY) * m_tileSize;
+		const size_t k = (tile / (tilesX * tilesY)) * m_tileSize;
+
+		m_noise.fractalGrid(m_octaves, out + i + j * sizeX + k * slice,
+			std::min(m_tileSize, sizeX - i), std::min(m_tileSize, sizeY - j), std::min(m_tileSize, sizeZ - k),
+			x + i * step, y + j * step, z + k * step, step, sizeX, slice);
+	});
+}
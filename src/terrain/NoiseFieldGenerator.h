@@ -0,0 +1,52 @@
+/**
+ * @file    NoiseFieldGenerator.h
+ * @brief   Multithreaded fBm heightmap and density volume generation
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __NOISEFIELDGENERATOR_H__
+#define __NOISEFIELDGENERATOR_H__
+
+#include "util/SimplexNoise.h"
+#include "util/ThreadPool.h"
+
+/**
+ * Splits a region into fixed-size tiles and fills them with SimplexNoise::fractalGrid
+ * on a ThreadPool. The tiling only depends on the region and the tile size, so the
+ * output is the same whatever the thread count or the order tiles run in.
+ */
+class NoiseFieldGenerator
+{
+	public:
+		NoiseFieldGenerator(const SimplexNoise& noise, size_t octaves, size_t tileSize = 32);
+
+		// Heightmap: out[i + j*sizeX] = fBm at (x + i*step, y + j*step)
+		void generate(ThreadPool& pool, float* out, size_t sizeX, size_t sizeY,
+			float x, float y, float step) const;
+
+		// Density volume: out[i + j*sizeX + k*sizeX*sizeY] = fBm at (x + i*step, y + j*step, z + k*step)
+		void generate(ThreadPool& pool, float* out, size_t sizeX, size_t sizeY, size_t sizeZ,
+			float x, float y, float z, float step) const;
+
+		inline size_t getTileSize() const { return m_tileSize; }
+		inline size_t getOctaves() const { return m_octaves; }
+	private:
+		SimplexNoise m_noise;
+		size_t m_octaves;
+		size_t m_tileSize;
+};
+#endif // __NOISEFIELDGENERATOR_H__
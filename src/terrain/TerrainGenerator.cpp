@@ -0,0 +1,144 @@
+/**
+ * @file    TerrainGenerator.cpp
+ * @brief   Voxel terrain of a chunk from fBm height and cave noise
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "terrain/TerrainGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+static const int SIZE = VoxelChunk::SIZE;
+static const int PADDED = ChunkMesher::PADDED;
+
+static const TerrainGenerator::Settings DEFAULT_SETTINGS = {
+	1337,     // seed
+	0.0f,     // baseHeight
+	48.0f,    // heightRange
+	0.004f,   // frequency
+	6,        // octaves
+	0.03f,    // caveFrequency
+	0.55f     // caveThreshold
+};
+
+TerrainGenerator::TerrainGenerator() : TerrainGenerator(DEFAULT_SETTINGS)
+{
+
+}
+
+TerrainGenerator::TerrainGenerator(const Settings& settings) :
+	m_settings(settings),
+	m_height(settings.frequency, 1.0f, 2.0f, 0.5f),
+	m_caves(settings.caveFrequency, 1.0f, 2.0f, 0.5f)
+{
+	m_height.setSeed(settings.seed);
+	m_caves.setSeed(settings.seed ^ 0x5bd1e995u);
+}
+
+bool TerrainGenerator::isAboveSurface(const ChunkCoord& coord) const
+{
+	return coord.y * SIZE - 1 >= m_settings.baseHeight + m_settings.heightRange;
+}
+
+void TerrainGenerator::generatePadded(const ChunkCoord& coord, Voxel* padded) const
+{
+	generate(coord, padded, false);
+}
+
+void TerrainGenerator::generateBorder(const ChunkCoord& coord, Voxel* padded) const
+{
+	generate(coord, padded, true);
+}
+
+void TerrainGenerator::generate(const ChunkCoord& coord, Voxel* padded, bool borderOnly) const
+{
+	const int x0 = coord.x * SIZE - 1, y0 = coord.y * SIZE - 1, z0 = coord.z * SIZE - 1;
+
+	if (isAboveSurface(coord))
+	{
+		std::fill(padded, padded + ChunkMesher::PADDED_VOLUME, VOXEL_AIR);
+		return;
+	}
+
+	// Surface height of every padded column, heights[x + z*PADDED]
+	std::vector<float> heights(PADDED * PADDED);
+	m_height.fractalGrid(m_settings.octaves, heights.data(), PADDED, PADDED,
+		static_cast<float>(x0), static_cast<float>(z0), 1.0f, PADDED);
+
+	int top = y0 - 1;
+	for (float& height : heights)
+	{
+		height = std::floor(m_settings.baseHeight + m_settings.heightRange * height);
+		top = std::max(top, static_cast<int>(height));
+	}
+
+	// Cave density only where there can be stone
+	std::vector<float> density;
+	const bool caves = m_settings.caveThreshold <= 1.0f && top - 3 > y0;
+	auto caveSlab = [&](int x, int y, int z, int sizeX, int sizeY, int sizeZ) {
+		m_caves.fractalGrid(2, density.data() + x + y * PADDED + z * PADDED * PADDED, sizeX, sizeY, sizeZ,
+			static_cast<float>(x0 + x), static_cast<float>(y0 + y), static_cast<float>(z0 + z), 1.0f, PADDED, PADDED * PADDED);
+	};
+	if (caves)
+	{
+		density.resize(ChunkMesher::PADDED_VOLUME);
+		if (!borderOnly)
+			caveSlab(0, 0, 0, PADDED, PADDED, PADDED);
+		else
+		{
+			// The six faces of the border, each voxel once; grid points are integers,
+			// so the values match those of the whole grid bit for bit
+			caveSlab(0, 0, 0, PADDED, PADDED, 1);
+			caveSlab(0, 0, PADDED - 1, PADDED, PADDED, 1);
+			caveSlab(0, 0, 1, PADDED, 1, PADDED - 2);
+			caveSlab(0, PADDED - 1, 1, PADDED, 1, PADDED - 2);
+			caveSlab(0, 1, 1, 1, PADDED - 2, PADDED - 2);
+			caveSlab(PADDED - 1, 1, 1, 1, PADDED - 2, PADDED - 2);
+		}
+	}
+
+	for (int z = 0; z < PADDED; z++)
+		for (int y = 0; y < PADDED; y++)
+		{
+			const int wy = y0 + y;
+			Voxel* row = padded + y * PADDED + z * PADDED * PADDED;
+			// Inside rows of the border only have their two ends on it
+			const bool shell = !borderOnly || z == 0 || z == PADDED - 1 || y == 0 || y == PADDED - 1;
+			for (int x = 0; x < PADDED; x += shell ? 1 : PADDED - 1)
+			{
+				const int height = static_cast<int>(heights[x + z * PADDED]);
+				Voxel voxel = VOXEL_AIR;
+				if (wy < height)
+					voxel = wy == height - 1 ? VOXEL_GRASS : wy > height - 4 ? VOXEL_DIRT : VOXEL_STONE;
+				if (voxel == VOXEL_STONE && caves && density[x + y * PADDED + z * PADDED * PADDED] > m_settings.caveThreshold)
+					voxel = VOXEL_AIR;
+				row[x] = voxel;
+			}
+		}
+}
+
+void TerrainGenerator::extract(const Voxel* padded, VoxelChunk& chunk)
+{
+	std::vector<Voxel> voxels(VoxelChunk::VOLUME);
+	for (int z = 0; z < SIZE; z++)
+		for (int y = 0; y < SIZE; y++)
+			for (int x = 0; x < SIZE; x++)
+				voxels[VoxelChunk::index(x, y, z)] = padded[ChunkMesher::paddedIndex(x, y, z)];
+	chunk.load(voxels.data());
+}
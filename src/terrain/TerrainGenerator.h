@@ -0,0 +1,77 @@
+/**
+ * @file    TerrainGenerator.h
+ * @brief   Voxel terrain of a chunk from fBm height and cave noise
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __TERRAINGENERATOR_H__
+#define __TERRAINGENERATOR_H__
+
+#include "util/SimplexNoise.h"
+#include "voxel/ChunkMesher.h"
+
+const Voxel VOXEL_STONE = 1;
+const Voxel VOXEL_DIRT = 2;
+const Voxel VOXEL_GRASS = 3;
+
+/**
+ * Every voxel is a pure function of its world position, so a chunk can be generated
+ * together with its mesher border without its neighbours existing. All methods are
+ * const and safe to call from several threads at once.
+ */
+class TerrainGenerator
+{
+	public:
+		// Bumped whenever generation or its default settings change, saved chunks of an
+		// older version are not loaded next to newly generated ones
+		static constexpr uint32_t VERSION = 1;
+
+		struct Settings
+		{
+			uint32_t seed;
+			float baseHeight;     // world y of the mean surface
+			float heightRange;    // surface goes baseHeight +- heightRange
+			float frequency;      // of the height fBm
+			size_t octaves;
+			float caveFrequency;  // of the cave density fBm
+			float caveThreshold;  // density above which stone is carved out, > 1 disables caves
+		};
+
+		TerrainGenerator();
+		explicit TerrainGenerator(const Settings& settings);
+
+		// Fill a ChunkMesher::PADDED_VOLUME snapshot of chunk coord, border included
+		void generatePadded(const ChunkCoord& coord, Voxel* padded) const;
+		// Only the one voxel border of the snapshot, for a chunk whose inside was loaded
+		// rather than generated; the inside is filled afterwards, it may be overwritten
+		void generateBorder(const ChunkCoord& coord, Voxel* padded) const;
+
+		// Copy the inside of a padded snapshot into a chunk
+		static void extract(const Voxel* padded, VoxelChunk& chunk);
+
+		// Chunks entirely above the highest surface are air and need no generation
+		bool isAboveSurface(const ChunkCoord& coord) const;
+
+		inline const Settings& getSettings() const { return m_settings; }
+	private:
+		Settings m_settings;
+		SimplexNoise m_height;
+		SimplexNoise m_caves;
+
+		void generate(const ChunkCoord& coord, Voxel* padded, bool borderOnly) const;
+};
+#endif // __TERRAINGENERATOR_H__
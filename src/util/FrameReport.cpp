@@ -0,0 +1,184 @@
+/**
+ * @file    FrameReport.cpp
+ * @brief   Per-frame stage timings and their JSON summary
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "util/FrameReport.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+FrameReport::FrameReport(const std::vector<std::string>& stages, const std::vector<std::string>& counters) :
+	m_stages(stages), m_stageMs(stages.size()), m_counters(counters), m_counterValues(counters.size())
+{
+
+}
+
+void FrameReport::reserve(size_t frames)
+{
+	m_frames.reserve(frames);
+	for (std::vector<double>& samples : m_stageMs)
+		samples.reserve(frames);
+	for (std::vector<double>& samples : m_counterValues)
+		samples.reserve(frames);
+}
+
+void FrameReport::addFrame(const double* stageMs, double frameMs, const double* counters)
+{
+	for (size_t i = 0; i < m_stages.size(); i++)
+		m_stageMs[i].push_back(stageMs[i]);
+	for (size_t i = 0; counters && i < m_counters.size(); i++)
+		m_counterValues[i].push_back(counters[i]);
+	m_frames.push_back(frameMs);
+}
+
+void FrameReport::setInfo(const std::string& key, const std::string& value)
+{
+	m_info.emplace_back(key, quote(value));
+}
+
+void FrameReport::setInfo(const std::string& key, double value)
+{
+	char number[32];
+	snprintf(number, sizeof(number), "%.9g", std::isfinite(value) ? value : 0.0);
+	m_info.emplace_back(key, number);
+}
+
+FrameReport::Summary FrameReport::getFrameSummary() const
+{
+	return summarize(m_frames);
+}
+
+FrameReport::Summary FrameReport::getStageSummary(size_t stage) const
+{
+	return summarize(m_stageMs[stage]);
+}
+
+FrameReport::Summary FrameReport::getCounterSummary(size_t counter) const
+{
+	return summarize(m_counterValues[counter]);
+}
+
+FrameReport::Summary FrameReport::summarize(std::vector<double> samples)
+{
+	Summary summary = { 0, 0, 0, 0, 0, 0, 0 };
+	if (samples.empty())
+		return summary;
+
+	std::sort(samples.begin(), samples.end());
+	auto rank = [&samples](double percentile) {
+		size_t index = static_cast<size_t>(std::ceil(percentile / 100.0 * samples.size()));
+		return samples[std::min(std::max<size_t>(index, 1), samples.size()) - 1];
+	};
+
+	double total = 0.0;
+	for (double sample : samples)
+		total += sample;
+
+	summary.min = samples.front();
+	summary.mean = total / samples.size();
+	summary.p50 = rank(50.0);
+	summary.p90 = rank(90.0);
+	summary.p95 = rank(95.0);
+	summary.p99 = rank(99.0);
+	summary.max = samples.back();
+	return summary;
+}
+
+static void writeSummary(std::ofstream& out, const FrameReport::Summary& s)
+{
+	char line[256];
+	snprintf(line, sizeof(line),
+		"{ \"min\": %.4f, \"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f }",
+		s.min, s.mean, s.p50, s.p90, s.p95, s.p99, s.max);
+	out << line;
+}
+
+bool FrameReport::write(const std::string& path) const
+{
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	if (!out)
+		return false;
+
+	out << "{\n\t\"info\": {";
+	for (size_t i = 0; i < m_info.size(); i++)
+		out << (i ? ",\n\t\t" : "\n\t\t") << quote(m_info[i].first) << ": " << m_info[i].second;
+	out << "\n\t},\n";
+
+	const Summary frame = getFrameSummary();
+	out << "\t\"frames\": " << m_frames.size() << ",\n";
+	out << "\t\"fps\": " << (frame.mean > 0.0 ? 1000.0 / frame.mean : 0.0) << ",\n";
+	out << "\t\"frameMs\": ";
+	writeSummary(out, frame);
+	out << ",\n\t\"stagesMs\": {";
+	for (size_t i = 0; i < m_stages.size(); i++)
+	{
+		out << (i ? ",\n\t\t" : "\n\t\t") << quote(m_stages[i]) << ": ";
+		writeSummary(out, getStageSummary(i));
+	}
+	out << "\n\t},\n";
+	if (!m_counters.empty())
+	{
+		out << "\t\"counters\": {";
+		for (size_t i = 0; i < m_counters.size(); i++)
+		{
+			out << (i ? ",\n\t\t" : "\n\t\t") << quote(m_counters[i]) << ": ";
+			writeSummary(out, getCounterSummary(i));
+		}
+		out << "\n\t},\n";
+	}
+
+	// Raw frame times, for plotting or diffing two runs frame by frame
+	out << "\t\"frameTimesMs\": [";
+	char number[32];
+	for (size_t i = 0; i < m_frames.size(); i++)
+	{
+		snprintf(number, sizeof(number), "%s%.4f", i ? ", " : "", m_frames[i]);
+		out << number;
+	}
+	out << "]\n}\n";
+
+	return out.good();
+}
+
+std::string FrameReport::quote(const std::string& text)
+{
+	std::string quoted = "\"";
+	for (char c : text)
+	{
+		switch (c)
+		{
+			case '"':  quoted += "\\\""; break;
+			case '\\': quoted += "\\\\"; break;
+			case '\n': quoted += "\\n"; break;
+			case '\t': quoted += "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20)
+				{
+					char escaped[8];
+					snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+					quoted += escaped;
+				}
+				else
+					quoted += c;
+		}
+	}
+	return quoted + "\"";
+}
@@ -0,0 +1,78 @@
+/**
+ * @file    FrameReport.h
+ * @brief   Per-frame stage timings and their JSON summary
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __FRAMEREPORT_H__
+#define __FRAMEREPORT_H__
+
+#include <string>
+#include <vector>
+#include <utility>
+
+/**
+ * Collects the CPU time of each named frame stage and the whole frame, in milliseconds,
+ * plus optional per-frame counters (draw calls, ...), and writes them out as a JSON
+ * document with percentiles, for comparing perf runs.
+ */
+class FrameReport
+{
+	public:
+		struct Summary
+		{
+			double min;
+			double mean;
+			double p50;
+			double p90;
+			double p95;
+			double p99;
+			double max;
+		};
+
+		explicit FrameReport(const std::vector<std::string>& stages, const std::vector<std::string>& counters = {});
+
+		void reserve(size_t frames);
+		// stageMs holds one value per stage and counters one per counter, in the order
+		// given to the constructor
+		void addFrame(const double* stageMs, double frameMs, const double* counters = nullptr);
+		inline size_t getFrameCount() const { return m_frames.size(); }
+
+		// Extra top-level "info" entries: run settings, renderer, counters
+		void setInfo(const std::string& key, const std::string& value);
+		void setInfo(const std::string& key, double value);
+
+		Summary getFrameSummary() const;
+		Summary getStageSummary(size_t stage) const;
+		Summary getCounterSummary(size_t counter) const;
+
+		bool write(const std::string& path) const;
+
+		// Nearest-rank percentiles, all zero for no samples
+		static Summary summarize(std::vector<double> samples);
+	private:
+		std::vector<std::string> m_stages;
+		std::vector<std::vector<double>> m_stageMs;
+		std::vector<std::string> m_counters;
+		std::vector<std::vector<double>> m_counterValues;
+		std::vector<double> m_frames;
+		// Values already encoded as JSON
+		std::vector<std::pair<std::string, std::string>> m_info;
+
+		static std::string quote(const std::string& text);
+};
+#endif // __FRAMEREPORT_H__
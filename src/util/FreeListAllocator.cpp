@@ -0,0 +1,109 @@
+/**
+ * @file    FreeListAllocator.cpp
+ * @brief   Best-fit range allocator for sub-allocating large buffers
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "util/FreeListAllocator.h"
+
+double FreeListAllocator::Stats::fragmentation() const
+{
+	const size_t available = capacity - used;
+	return available == 0 ? 0.0 : 1.0 - static_cast<double>(largestFree) / available;
+}
+
+FreeListAllocator::FreeListAllocator(size_t capacity)
+{
+	reset(capacity);
+}
+
+void FreeListAllocator::reset(size_t capacity)
+{
+	m_capacity = capacity;
+	m_used = 0;
+	m_byOffset.clear();
+	m_bySize.clear();
+	if (capacity > 0)
+		insert(0, capacity);
+}
+
+void FreeListAllocator::insert(size_t offset, size_t size)
+{
+	m_byOffset.emplace(offset, size);
+	m_bySize.emplace(size, offset);
+}
+
+void FreeListAllocator::erase(std::map<size_t, size_t>::iterator range)
+{
+	m_bySize.erase(std::make_pair(range->second, range->first));
+	m_byOffset.erase(range);
+}
+
+size_t FreeListAllocator::allocate(size_t size)
+{
+	if (size == 0)
+		return INVALID;
+
+	auto fit = m_bySize.lower_bound(std::make_pair(size, size_t(0)));
+	if (fit == m_bySize.end())
+		return INVALID;
+
+	const size_t offset = fit->second, available = fit->first;
+	erase(m_byOffset.find(offset));
+	if (available > size)
+		insert(offset + size, available - size);
+
+	m_used += size;
+	return offset;
+}
+
+void FreeListAllocator::release(size_t offset, size_t size)
+{
+	if (size == 0)
+		return;
+
+	m_used -= size;
+
+	// Merge with the free ranges right after and right before
+	auto next = m_byOffset.lower_bound(offset);
+	if (next != m_byOffset.end() && next->first == offset + size)
+	{
+		size += next->second;
+		erase(next++);
+	}
+	if (next != m_byOffset.begin())
+	{
+		auto previous = std::prev(next);
+		if (previous->first + previous->second == offset)
+		{
+			offset = previous->first;
+			size += previous->second;
+			erase(previous);
+		}
+	}
+	insert(offset, size);
+}
+
+FreeListAllocator::Stats FreeListAllocator::getStats() const
+{
+	Stats stats;
+	stats.capacity = m_capacity;
+	stats.used = m_used;
+	stats.freeRanges = m_byOffset.size();
+	stats.largestFree = m_bySize.empty() ? 0 : m_bySize.rbegin()->first;
+	return stats;
+}
@@ -0,0 +1,74 @@
+/**
+ * @file    FreeListAllocator.h
+ * @brief   Best-fit range allocator for sub-allocating large buffers
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __FREELISTALLOCATOR_H__
+#define __FREELISTALLOCATOR_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <utility>
+
+/**
+ * Hands out ranges of a fixed capacity, counted in whatever unit the caller uses
+ * (vertices, indices, bytes). Free ranges are indexed by offset, to merge a released
+ * range with its neighbours, and by size, to take the smallest one that fits so small
+ * meshes fill small holes and large ranges stay whole. Not thread safe.
+ */
+class FreeListAllocator
+{
+	public:
+		static const size_t INVALID = SIZE_MAX;
+
+		struct Stats
+		{
+			size_t capacity;
+			size_t used;
+			size_t freeRanges;
+			size_t largestFree;
+
+			// Share of the free space outside the largest free range, 0 when it is all one range
+			double fragmentation() const;
+		};
+
+		explicit FreeListAllocator(size_t capacity = 0);
+
+		// Forget every allocation
+		void reset(size_t capacity);
+
+		// Offset of size free units, INVALID when no free range is large enough
+		size_t allocate(size_t size);
+		// Give back a range exactly as it was allocated
+		void release(size_t offset, size_t size);
+
+		inline size_t getCapacity() const { return m_capacity; }
+		inline size_t getUsed() const { return m_used; }
+		Stats getStats() const;
+	private:
+		size_t m_capacity;
+		size_t m_used;
+		std::map<size_t, size_t> m_byOffset;              // offset -> size
+		std::set<std::pair<size_t, size_t>> m_bySize;     // (size, offset)
+
+		void insert(size_t offset, size_t size);
+		void erase(std::map<size_t, size_t>::iterator range);
+};
+#endif // __FREELISTALLOCATOR_H__
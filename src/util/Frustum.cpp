@@ -0,0 +1,326 @@
+/**
+ * @file    Frustum.cpp
+ * @brief   View frustum planes and batched bounding volume culling
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "util/Frustum.h"
+
+#include <algorithm>
+#include <cmath>
+
+// SSE2 and NEON are the baseline of x86-64 and AArch64, no runtime dispatch needed
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define FRUSTUM_SSE2
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define FRUSTUM_NEON
+#endif
+
+BoxBatch::BoxBatch() : m_size(0)
+{
+
+}
+
+void BoxBatch::clear()
+{
+	m_size = 0;
+}
+
+void BoxBatch::reserve(size_t count)
+{
+	count = (count + LANES - 1) / LANES * LANES;
+	for (std::vector<float>* array : { &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ })
+		array->reserve(count);
+}
+
+uint32_t BoxBatch::add(const glm::vec3& min, const glm::vec3& max)
+{
+	if (m_size == centerX.size())
+	{
+		for (std::vector<float>* array : { &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ })
+			array->resize(m_size + LANES, 0.0f);
+	}
+
+	const glm::vec3 center = (min + max) * 0.5f, extent = (max - min) * 0.5f;
+	centerX[m_size] = center.x;
+	centerY[m_size] = center.y;
+	centerZ[m_size] = center.z;
+	extentX[m_size] = extent.x;
+	extentY[m_size] = extent.y;
+	extentZ[m_size] = extent.z;
+	return static_cast<uint32_t>(m_size++);
+}
+
+SphereBatch::SphereBatch() : m_size(0)
+{
+
+}
+
+void SphereBatch::clear()
+{
+	m_size = 0;
+}
+
+void SphereBatch::reserve(size_t count)
+{
+	count = (count + LANES - 1) / LANES * LANES;
+	for (std::vector<float>* array : { &centerX, &centerY, &centerZ, &radius })
+		array->reserve(count);
+}
+
+uint32_t SphereBatch::add(const glm::vec3& center, float r)
+{
+	if (m_size == centerX.size())
+	{
+		for (std::vector<float>* array : { &centerX, &centerY, &centerZ, &radius })
+			array->resize(m_size + LANES, 0.0f);
+	}
+
+	centerX[m_size] = center.x;
+	centerY[m_size] = center.y;
+	centerZ[m_size] = center.z;
+	radius[m_size] = r;
+	return static_cast<uint32_t>(m_size++);
+}
+
+Frustum::Frustum()
+{
+	// Everything passes until a matrix is extracted
+	for (glm::vec4& plane : m_planes)
+		plane = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+Frustum::Frustum(const glm::mat4& viewProjection, ClipDepth depth)
+{
+	extract(viewProjection, depth);
+}
+
+void Frustum::extract(const glm::mat4& m, ClipDepth depth)
+{
+	// Rows of the column-major matrix
+	const glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+	const glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+	const glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+	const glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+	m_planes[PLANE_LEFT] = row3 + row0;
+	m_planes[PLANE_RIGHT] = row3 - row0;
+	m_planes[PLANE_BOTTOM] = row3 + row1;
+	m_planes[PLANE_TOP] = row3 - row1;
+	m_planes[PLANE_NEAR] = depth == CLIP_ZERO_TO_ONE ? row2 : row3 + row2;
+	m_planes[PLANE_FAR] = row3 - row2;
+
+	for (glm::vec4& plane : m_planes)
+	{
+		const float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+
+		// An infinite far plane degenerates to no normal at all, let everything pass it
+		if (length < 1e-6f)
+			plane = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		else
+			plane = plane / length;
+	}
+}
+
+// Signed distance of the box's farthest corner along the plane normal; the batched
+// paths evaluate the same expression in the same order
+static inline float boxDistance(const glm::vec4& p, float cx, float cy, float cz, float ex, float ey, float ez)
+{
+	return p.x * cx + p.y * cy + p.z * cz + p.w + std::fabs(p.x) * ex + std::fabs(p.y) * ey + std::fabs(p.z) * ez;
+}
+
+bool Frustum::testBox(const glm::vec3& min, const glm::vec3& max) const
+{
+	const glm::vec3 center = (min + max) * 0.5f, extent = (max - min) * 0.5f;
+	for (const glm::vec4& plane : m_planes)
+	{
+		if (boxDistance(plane, center.x, center.y, center.z, extent.x, extent.y, extent.z) < 0.0f)
+			return false;
+	}
+	return true;
+}
+
+bool Frustum::testSphere(const glm::vec3& center, float radius) const
+{
+	for (const glm::vec4& p : m_planes)
+	{
+		if (p.x * center.x + p.y * center.y + p.z * center.z + p.w + radius < 0.0f)
+			return false;
+	}
+	return true;
+}
+
+// Append base + lane for every set bit of a 4-lane mask. Full groups store every lane
+// and only advance over the visible ones, which avoids a branch per box; the last
+// group may be partial and must not write past the end.
+static inline size_t compact(uint32_t* visible, size_t count, uint32_t base, unsigned mask, size_t lanes)
+{
+	if (lanes == 4)
+	{
+		visible[count] = base;
+		count += mask & 1;
+		visible[count] = base + 1;
+		count += (mask >> 1) & 1;
+		visible[count] = base + 2;
+		count += (mask >> 2) & 1;
+		if (mask & 8)
+			visible[count++] = base + 3;
+		return count;
+	}
+
+	for (size_t lane = 0; lane < lanes; lane++)
+	{
+		if (mask & (1u << lane))
+			visible[count++] = static_cast<uint32_t>(base + lane);
+	}
+	return count;
+}
+
+size_t Frustum::cull(const BoxBatch& boxes, uint32_t* visible) const
+{
+	const size_t size = boxes.size();
+	size_t count = 0;
+
+#if defined(FRUSTUM_SSE2)
+	__m128 nx[PLANES], ny[PLANES], nz[PLANES], nw[PLANES], ax[PLANES], ay[PLANES], az[PLANES];
+	for (int p = 0; p < PLANES; p++)
+	{
+		nx[p] = _mm_set1_ps(m_planes[p].x);
+		ny[p] = _mm_set1_ps(m_planes[p].y);
+		nz[p] = _mm_set1_ps(m_planes[p].z);
+		nw[p] = _mm_set1_ps(m_planes[p].w);
+		ax[p] = _mm_set1_ps(std::fabs(m_planes[p].x));
+		ay[p] = _mm_set1_ps(std::fabs(m_planes[p].y));
+		az[p] = _mm_set1_ps(std::fabs(m_planes[p].z));
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+	for (size_t i = 0; i < size; i += 4)
+	{
+		const __m128 cx = _mm_loadu_ps(&boxes.centerX[i]), cy = _mm_loadu_ps(&boxes.centerY[i]), cz = _mm_loadu_ps(&boxes.centerZ[i]);
+		const __m128 ex = _mm_loadu_ps(&boxes.extentX[i]), ey = _mm_loadu_ps(&boxes.extentY[i]), ez = _mm_loadu_ps(&boxes.extentZ[i]);
+
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (int p = 0; p < PLANES; p++)
+		{
+			__m128 d = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[p], cx), _mm_mul_ps(ny[p], cy)), _mm_mul_ps(nz[p], cz)), nw[p]);
+			d = _mm_add_ps(_mm_add_ps(_mm_add_ps(d, _mm_mul_ps(ax[p], ex)), _mm_mul_ps(ay[p], ey)), _mm_mul_ps(az[p], ez));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(d, zero));
+		}
+
+		count = compact(visible, count, static_cast<uint32_t>(i), _mm_movemask_ps(inside), std::min<size_t>(4, size - i));
+	}
+#elif defined(FRUSTUM_NEON)
+	const uint32x4_t laneBits = { 1, 2, 4, 8 };
+	for (size_t i = 0; i < size; i += 4)
+	{
+		const float32x4_t cx = vld1q_f32(&boxes.centerX[i]), cy = vld1q_f32(&boxes.centerY[i]), cz = vld1q_f32(&boxes.centerZ[i]);
+		const float32x4_t ex = vld1q_f32(&boxes.extentX[i]), ey = vld1q_f32(&boxes.extentY[i]), ez = vld1q_f32(&boxes.extentZ[i]);
+
+		uint32x4_t inside = vdupq_n_u32(0xFFFFFFFFu);
+		for (int p = 0; p < PLANES; p++)
+		{
+			const glm::vec4& plane = m_planes[p];
+			// Separate multiply and add, not vmlaq, to match the scalar rounding
+			float32x4_t d = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(cx, plane.x), vmulq_n_f32(cy, plane.y)), vmulq_n_f32(cz, plane.z)), vdupq_n_f32(plane.w));
+			d = vaddq_f32(vaddq_f32(vaddq_f32(d, vmulq_n_f32(ex, std::fabs(plane.x))), vmulq_n_f32(ey, std::fabs(plane.y))), vmulq_n_f32(ez, std::fabs(plane.z)));
+			inside = vandq_u32(inside, vcgeq_f32(d, vdupq_n_f32(0.0f)));
+		}
+
+		const unsigned mask = vaddvq_u32(vandq_u32(inside, laneBits));
+		count = compact(visible, count, static_cast<uint32_t>(i), mask, std::min<size_t>(4, size - i));
+	}
+#else
+	for (size_t i = 0; i < size; i++)
+	{
+		bool inside = true;
+		for (int p = 0; p < PLANES && inside; p++)
+			inside = boxDistance(m_planes[p], boxes.centerX[i], boxes.centerY[i], boxes.centerZ[i],
+				boxes.extentX[i], boxes.extentY[i], boxes.extentZ[i]) >= 0.0f;
+		if (inside)
+			visible[count++] = static_cast<uint32_t>(i);
+	}
+#endif
+
+	return count;
+}
+
+size_t Frustum::cull(const SphereBatch& spheres, uint32_t* visible) const
+{
+	const size_t size = spheres.size();
+	size_t count = 0;
+
+#if defined(FRUSTUM_SSE2)
+	const __m128 zero = _mm_setzero_ps();
+	for (size_t i = 0; i < size; i += 4)
+	{
+		const __m128 cx = _mm_loadu_ps(&spheres.centerX[i]), cy = _mm_loadu_ps(&spheres.centerY[i]);
+		const __m128 cz = _mm_loadu_ps(&spheres.centerZ[i]), r = _mm_loadu_ps(&spheres.radius[i]);
+
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (int p = 0; p < PLANES; p++)
+		{
+			const glm::vec4& plane = m_planes[p];
+			__m128 d = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), cx), _mm_mul_ps(_mm_set1_ps(plane.y), cy));
+			d = _mm_add_ps(_mm_add_ps(_mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(plane.z), cz)), _mm_set1_ps(plane.w)), r);
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(d, zero));
+		}
+
+		count = compact(visible, count, static_cast<uint32_t>(i), _mm_movemask_ps(inside), std::min<size_t>(4, size - i));
+	}
+#elif defined(FRUSTUM_NEON)
+	const uint32x4_t laneBits = { 1, 2, 4, 8 };
+	for (size_t i = 0; i < size; i += 4)
+	{
+		const float32x4_t cx = vld1q_f32(&spheres.centerX[i]), cy = vld1q_f32(&spheres.centerY[i]);
+		const float32x4_t cz = vld1q_f32(&spheres.centerZ[i]), r = vld1q_f32(&spheres.radius[i]);
+
+		uint32x4_t inside = vdupq_n_u32(0xFFFFFFFFu);
+		for (int p = 0; p < PLANES; p++)
+		{
+			const glm::vec4& plane = m_planes[p];
+			float32x4_t d = vaddq_f32(vmulq_n_f32(cx, plane.x), vmulq_n_f32(cy, plane.y));
+			d = vaddq_f32(vaddq_f32(vaddq_f32(d, vmulq_n_f32(cz, plane.z)), vdupq_n_f32(plane.w)), r);
+			inside = vandq_u32(inside, vcgeq_f32(d, vdupq_n_f32(0.0f)));
+		}
+
+		const unsigned mask = vaddvq_u32(vandq_u32(inside, laneBits));
+		count = compact(visible, count, static_cast<uint32_t>(i), mask, std::min<size_t>(4, size - i));
+	}
+#else
+	for (size_t i = 0; i < size; i++)
+	{
+		if (testSphere(glm::vec3(spheres.centerX[i], spheres.centerY[i], spheres.centerZ[i]), spheres.radius[i]))
+			visible[count++] = static_cast<uint32_t>(i);
+	}
+#endif
+
+	return count;
+}
+
+const char* Frustum::simdName()
+{
+#if defined(FRUSTUM_SSE2)
+	return "SSE2";
+#elif defined(FRUSTUM_NEON)
+	return "NEON";
+#else
+	return "scalar";
+#endif
+}
@@ -0,0 +1,118 @@
+/**
+ * @file    Frustum.h
+ * @brief   View frustum planes and batched bounding volume culling
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __FRUSTUM_H__
+#define __FRUSTUM_H__
+
+#include "util/Math3D.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Axis-aligned boxes as structure-of-arrays (centers and half extents), the layout the
+ * batched culling reads four boxes at a time. Arrays are padded to a multiple of LANES.
+ */
+class BoxBatch
+{
+	public:
+		static const size_t LANES = 4;
+
+		BoxBatch();
+
+		void clear();
+		void reserve(size_t count);
+		// Returns the index the box has in a visible list
+		uint32_t add(const glm::vec3& min, const glm::vec3& max);
+
+		inline size_t size() const { return m_size; }
+
+		std::vector<float> centerX, centerY, centerZ;
+		std::vector<float> extentX, extentY, extentZ;
+	private:
+		size_t m_size;
+};
+
+// Bounding spheres as structure-of-arrays, padded like BoxBatch
+class SphereBatch
+{
+	public:
+		static const size_t LANES = 4;
+
+		SphereBatch();
+
+		void clear();
+		void reserve(size_t count);
+		uint32_t add(const glm::vec3& center, float radius);
+
+		inline size_t size() const { return m_size; }
+
+		std::vector<float> centerX, centerY, centerZ, radius;
+	private:
+		size_t m_size;
+};
+
+/**
+ * The six clip planes of a view-projection matrix (Gribb/Hartmann), normalized, pointing
+ * inwards. A volume is culled only when it lies fully behind one plane, so a few volumes
+ * near the frustum corners pass although they are outside; that is conservative.
+ */
+class Frustum
+{
+	public:
+		enum Plane
+		{
+			PLANE_LEFT,
+			PLANE_RIGHT,
+			PLANE_BOTTOM,
+			PLANE_TOP,
+			PLANE_NEAR,
+			PLANE_FAR,
+			PLANES
+		};
+
+		// Depth range of clip space; with reverse-Z (zero to one) the near and far planes
+		// trade places, culling is the same
+		enum ClipDepth
+		{
+			CLIP_NEGATIVE_ONE_TO_ONE,  // OpenGL default
+			CLIP_ZERO_TO_ONE           // glClipControl(..., GL_ZERO_TO_ONE)
+		};
+
+		Frustum();
+		explicit Frustum(const glm::mat4& viewProjection, ClipDepth depth = CLIP_NEGATIVE_ONE_TO_ONE);
+
+		void extract(const glm::mat4& viewProjection, ClipDepth depth = CLIP_NEGATIVE_ONE_TO_ONE);
+		inline const glm::vec4& getPlane(Plane plane) const { return m_planes[plane]; }
+
+		bool testBox(const glm::vec3& min, const glm::vec3& max) const;
+		bool testSphere(const glm::vec3& center, float radius) const;
+
+		// Write the indices of the visible volumes to visible, which must hold size()
+		// entries, and return how many there are. Order is kept.
+		size_t cull(const BoxBatch& boxes, uint32_t* visible) const;
+		size_t cull(const SphereBatch& spheres, uint32_t* visible) const;
+
+		// Instruction set the batched paths were built for
+		static const char* simdName();
+	private:
+		glm::vec4 m_planes[PLANES];
+};
+#endif // __FRUSTUM_H__
@@ -0,0 +1,86 @@
+/**
+ * @file    MPSCQueue.h
+ * @brief   Lock-free multi-producer single-consumer queue
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __MPSCQUEUE_H__
+#define __MPSCQUEUE_H__
+
+#include <atomic>
+#include <utility>
+
+/**
+ * Linked queue after Dmitry Vyukov's intrusive MPSC design: push() is a single atomic
+ * exchange and never blocks, pop() must only be called from one thread. The consumer
+ * always holds a dummy node, the value of a node is read when it becomes the dummy.
+ * A pop() racing with a push() that has not finished linking may report the queue
+ * empty; the value shows up on a later pop().
+ */
+template<typename T>
+class MPSCQueue
+{
+	public:
+		MPSCQueue() : m_head(new Node()), m_tail(m_head.load()) {}
+		~MPSCQueue()
+		{
+			T value;
+			while (pop(value));
+			delete m_tail;
+		}
+
+		MPSCQueue(const MPSCQueue&) = delete;
+		MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+		// Any thread
+		void push(T value)
+		{
+			Node* node = new Node();
+			node->value = std::move(value);
+			Node* previous = m_head.exchange(node, std::memory_order_acq_rel);
+			previous->next.store(node, std::memory_order_release);
+		}
+
+		// Consumer thread only
+		bool pop(T& value)
+		{
+			Node* tail = m_tail;
+			Node* next = tail->next.load(std::memory_order_acquire);
+			if (!next)
+				return false;
+
+			value = std::move(next->value);
+			m_tail = next;
+			delete tail;
+			return true;
+		}
+
+		// Consumer thread only, same caveat as pop()
+		inline bool empty() const { return m_tail->next.load(std::memory_order_acquire) == nullptr; }
+	private:
+		struct Node
+		{
+			std::atomic<Node*> next;
+			T value;
+
+			Node() : next(nullptr), value() {}
+		};
+
+		std::atomic<Node*> m_head;
+		Node* m_tail;
+};
+#endif // __MPSCQUEUE_H__
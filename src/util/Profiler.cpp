@@ -0,0 +1,199 @@
+/**
+ * @file    Profiler.cpp
+ * @brief   Scoped CPU profiling markers and Chrome trace export
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "util/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+static const uint32_t GPU_TRACK = 0;
+
+static thread_local void* t_buffer = nullptr;
+
+static uint64_t steadyNanoseconds()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Profiler::ThreadBuffer::ThreadBuffer() :
+	id(0), depth(0), head(0), slots(new Slot[RING_SIZE])
+{
+	for (size_t i = 0; i < RING_SIZE; i++)
+		slots[i].sequence.store(0, std::memory_order_relaxed);
+}
+
+Profiler::Profiler() :
+	m_origin(steadyNanoseconds())
+{
+	m_gpu.name = "GPU";
+	m_gpu.id = GPU_TRACK;
+}
+
+uint64_t Profiler::now() const
+{
+	return steadyNanoseconds() - m_origin;
+}
+
+Profiler::ThreadBuffer& Profiler::local()
+{
+	if (t_buffer)
+		return *static_cast<ThreadBuffer*>(t_buffer);
+
+	// First scope on this thread, the list keeps the buffer alive past the thread's exit
+	std::shared_ptr<ThreadBuffer> buffer = std::make_shared<ThreadBuffer>();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	buffer->id = static_cast<uint32_t>(m_threads.size() + 1);
+	buffer->name = "thread " + std::to_string(buffer->id);
+	m_threads.push_back(buffer);
+	t_buffer = buffer.get();
+	return *buffer;
+}
+
+void Profiler::setThreadName(const std::string& name)
+{
+	ThreadBuffer& buffer = local();
+	std::lock_guard<std::mutex> lock(m_mutex);
+	buffer.name = name;
+}
+
+uint32_t Profiler::enter()
+{
+	return local().depth++;
+}
+
+void Profiler::leave(const char* name, uint64_t start, uint32_t depth)
+{
+	ThreadBuffer& buffer = local();
+	buffer.depth = depth;
+	push(buffer, { name, start, now(), depth });
+}
+
+void Profiler::recordGPU(const char* name, uint64_t start, uint64_t duration)
+{
+	push(m_gpu, { name, start, start + duration, 0 });
+}
+
+void Profiler::push(ThreadBuffer& buffer, const Event& event)
+{
+	const uint64_t head = buffer.head.load(std::memory_order_relaxed);
+	Slot& slot = buffer.slots[head % RING_SIZE];
+
+	slot.sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.name.store(event.name, std::memory_order_relaxed);
+	slot.start.store(event.start, std::memory_order_relaxed);
+	slot.end.store(event.end, std::memory_order_relaxed);
+	slot.depth.store(event.depth, std::memory_order_relaxed);
+	slot.sequence.store(head + 1, std::memory_order_release);
+
+	buffer.head.store(head + 1, std::memory_order_release);
+}
+
+bool Profiler::read(const ThreadBuffer& buffer, uint64_t index, Event& event)
+{
+	const Slot& slot = buffer.slots[index % RING_SIZE];
+	if (slot.sequence.load(std::memory_order_acquire) != index + 1)
+		return false;
+
+	event.name = slot.name.load(std::memory_order_relaxed);
+	event.start = slot.start.load(std::memory_order_relaxed);
+	event.end = slot.end.load(std::memory_order_relaxed);
+	event.depth = slot.depth.load(std::memory_order_relaxed);
+
+	// Still the same event after the copy, or it got overwritten under us
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return slot.sequence.load(std::memory_order_relaxed) == index + 1;
+}
+
+static void writeName(FILE* file, const std::string& name)
+{
+	fputc('"', file);
+	for (char c : name)
+	{
+		if (c == '"' || c == '\\')
+			fputc('\\', file);
+		if (static_cast<unsigned char>(c) >= 0x20)
+			fputc(c, file);
+	}
+	fputc('"', file);
+}
+
+bool Profiler::exportChromeTrace(const std::string& path)
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file)
+		return false;
+
+	std::vector<ThreadBuffer*> buffers;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		buffers.push_back(&m_gpu);
+		for (const std::shared_ptr<ThreadBuffer>& buffer : m_threads)
+			buffers.push_back(buffer.get());
+	}
+
+	fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+	bool first = true;
+	std::vector<Event> events;
+	for (ThreadBuffer* buffer : buffers)
+	{
+		const uint64_t head = buffer->head.load(std::memory_order_acquire);
+		const uint64_t count = std::min<uint64_t>(head, RING_SIZE);
+		if (count == 0)
+			continue;
+
+		events.clear();
+		Event event;
+		for (uint64_t i = head - count; i < head; i++)
+		{
+			if (read(*buffer, i, event))
+				events.push_back(event);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+				first ? "" : ",\n", buffer->id);
+			writeName(file, buffer->name);
+			fputs("}}", file);
+			first = false;
+		}
+
+		// Scopes are pushed when they close, parents after their children; trace viewers
+		// want them by start time
+		std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+			return a.start != b.start ? a.start < b.start : a.depth < b.depth;
+		});
+
+		for (const Event& event : events)
+		{
+			fputs(",\n{\"name\":", file);
+			writeName(file, event.name);
+			fprintf(file, ",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				buffer->id == GPU_TRACK ? "gpu" : "cpu", buffer->id, event.start * 1e-3, (event.end - event.start) * 1e-3);
+		}
+	}
+	fputs("\n]}\n", file);
+
+	return fclose(file) == 0;
+}
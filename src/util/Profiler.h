@@ -0,0 +1,132 @@
+/**
+ * @file    Profiler.h
+ * @brief   Scoped CPU profiling markers and Chrome trace export
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include "util/Singleton.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Collects timed, nested scopes. Every thread records into its own ring buffer without
+ * locks; the last RING_SIZE scopes of each thread are kept. GPU passes (see GPUProfiler)
+ * are recorded on a separate track. exportChromeTrace() writes everything still in the
+ * rings as Chrome trace-event JSON (chrome://tracing, Perfetto).
+ *
+ * The PROFILE_SCOPE markers only exist in builds with VOXSPATIUM_PROFILE defined.
+ */
+class Profiler : public Singleton<Profiler>
+{
+	public:
+		struct Event
+		{
+			const char* name;  // string literal, never copied
+			uint64_t start;    // nanoseconds since the profiler started
+			uint64_t end;
+			uint32_t depth;
+		};
+
+		static constexpr size_t RING_SIZE = 1 << 14;
+
+#ifdef VOXSPATIUM_PROFILE
+		static const bool COMPILED_IN = true;
+#else
+		static const bool COMPILED_IN = false;
+#endif
+
+		// Nanoseconds since the profiler started
+		uint64_t now() const;
+
+		// Shown as the track name in the trace
+		void setThreadName(const std::string& name);
+
+		// Called by ProfileScope, the owning thread only
+		uint32_t enter();
+		void leave(const char* name, uint64_t start, uint32_t depth);
+
+		// GPU pass that started on the CPU timeline at start and took duration ns on the GPU
+		void recordGPU(const char* name, uint64_t start, uint64_t duration);
+
+		bool exportChromeTrace(const std::string& path);
+
+		friend class Singleton<Profiler>;
+	private:
+		Profiler();
+
+		// Ring entry guarded by a sequence number, so the exporter can tell a slot the
+		// owning thread overwrote while it was being copied
+		struct Slot
+		{
+			std::atomic<uint64_t> sequence;  // index + 1 when complete, 0 while written
+			std::atomic<const char*> name;
+			std::atomic<uint64_t> start;
+			std::atomic<uint64_t> end;
+			std::atomic<uint32_t> depth;
+		};
+
+		struct ThreadBuffer
+		{
+			std::string name;
+			uint32_t id;
+			uint32_t depth;
+			// Written by the owning thread only, read by the exporter
+			std::atomic<uint64_t> head;
+			std::unique_ptr<Slot[]> slots;
+
+			ThreadBuffer();
+		};
+
+		uint64_t m_origin;
+		std::mutex m_mutex;  // guards the buffer list, not the buffers
+		std::vector<std::shared_ptr<ThreadBuffer>> m_threads;
+		ThreadBuffer m_gpu;
+
+		ThreadBuffer& local();
+		static void push(ThreadBuffer& buffer, const Event& event);
+		static bool read(const ThreadBuffer& buffer, uint64_t index, Event& event);
+};
+
+class ProfileScope
+{
+	public:
+		explicit ProfileScope(const char* name) :
+			m_name(name), m_depth(Profiler::getInstance().enter()), m_start(Profiler::getInstance().now()) {}
+		~ProfileScope() { Profiler::getInstance().leave(m_name, m_start, m_depth); }
+	private:
+		const char* m_name;
+		uint32_t m_depth;
+		uint64_t m_start;
+};
+
+#ifdef VOXSPATIUM_PROFILE
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) do {} while (0)
+#endif
+
+#endif // __PROFILER_H__
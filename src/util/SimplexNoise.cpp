@@ -25,8 +25,10 @@
  */
 
 #include "SimplexNoise.h"
+#include "SimplexNoiseSIMD.h"
 
 #include <cstdint>  // int32_t/uint8_t
+#include <algorithm>  // std::min
 
 /**
  * Computes the largest integer value not greater than the float one
@@ -68,7 +70,7 @@ static inline int32_t fastfloor(float fp) {
  * A vector-valued noise over 3D accesses it 96 times, and a
  * float-valued 4D noise 64 times. We want this to fit in the cache!
  */
-static const uint8_t perm[256] = {
+static constexpr uint8_t perm[256] = {
     151, 160, 137, 91, 90, 15,
     131, 13, 201, 95, 96, 53, 194, 233, 7, 225, 140, 36, 103, 30, 69, 142, 8, 99, 37, 240, 21, 10, 23,
     190, 6, 148, 247, 120, 234, 75, 0, 26, 197, 62, 94, 252, 219, 203, 117, 35, 11, 32, 57, 177, 33,
@@ -85,21 +87,82 @@ static const uint8_t perm[256] = {
 };
 
 /**
- * Helper function to hash an integer using the above permutation table
+ * Helper functor to hash lattice coordinates using a permutation table
  *
- *  This inline function costs around 1ns, and is called N+1 times for a noise of N dimension.
+ *  One lookup costs around 1ns, and there are N lookups for a noise of N dimension.
  *
- *  Using a real hash function would be better to improve the "repeatability of 256" of the above permutation table,
- * but fast integer Hash functions uses more time and have bad random properties.
+ *  This gives the "repeatability of 256" of the permutation table. IntegerHash below
+ * trades a few multiplies for a period of 2^32 cells.
  *
- * @param[in] i Integer value to hash
+ *  Works the same on the 8-bit table and on its widened 32-bit copy.
+ *
+ * @param[in] i, j, k   Integer lattice coordinates to hash
  *
  * @return 8-bits hashed value
  */
-static inline uint8_t hash(int32_t i) {
-    return perm[static_cast<uint8_t>(i)];
+template<typename T>
+struct PermutationHash {
+    const T* table;
+
+    inline int32_t operator()(int32_t i) const {
+        return table[static_cast<uint8_t>(i)];
+    }
+    inline int32_t operator()(int32_t i, int32_t j) const {
+        return (*this)(i + (*this)(j));
+    }
+    inline int32_t operator()(int32_t i, int32_t j, int32_t k) const {
+        return (*this)(i + (*this)(j + (*this)(k)));
+    }
+};
+
+/**
+ * Helper functor to hash lattice coordinates by integer mixing (HashMode::Integer)
+ *
+ *  Each coordinate is multiplied by a large odd constant and combined with the seed,
+ * then finalized with xorshift-multiply rounds. The pattern only repeats every 2^32
+ * cells on each axis, which is what planet-scale coordinates need.
+ *
+ *  Must stay in sync with IntegerLanes in SimplexNoiseKernels.h.
+ *
+ * @param[in] i, j, k   Integer lattice coordinates to hash
+ *
+ * @return 8-bits hashed value (the best mixed top bits)
+ */
+struct IntegerHash {
+    uint32_t seed;
+
+    inline int32_t operator()(int32_t i, int32_t j = 0, int32_t k = 0) const {
+        uint32_t h = seed ^ (static_cast<uint32_t>(i) * 0x8DA6B343u)
+                          ^ (static_cast<uint32_t>(j) * 0xD8163841u)
+                          ^ (static_cast<uint32_t>(k) * 0xCB1AB31Fu);
+        h ^= h >> 15;
+        h *= 0x2C1B3C6Du;
+        h ^= h >> 12;
+        return static_cast<int32_t>(h >> 24);
+    }
+};
+
+/**
+ * Permutation table widened to 32-bit entries, for the batch kernels
+ *
+ * The SIMD kernels look up 4 or 8 hashes at once; a 32-bit gather (AVX2)
+ * needs 32-bit entries, and the other kernels avoid a zero-extension per lane.
+ * At 1KB it still sits comfortably in L1 next to perm[].
+ */
+struct WidePermutation {
+    int32_t v[256];
+};
+
+static constexpr WidePermutation widen(const uint8_t (&table)[256]) {
+    WidePermutation wide = {};
+    for (size_t i = 0; i < 256; i++) {
+        wide.v[i] = table[i];
+    }
+    return wide;
 }
 
+static constexpr WidePermutation perm32 = widen(perm);
+
 /* NOTE Gradient table to test if lookup-table are more efficient than calculs
 static const float gradients1D[16] = {
         -8.f, -7.f, -6.f, -5.f, -4.f, -3.f, -2.f, -1.f,
@@ -168,11 +231,13 @@ static float grad(int32_t hash, float x, float y, float z) {
  *
  *  Takes around 74ns on an AMD APU.
  *
- * @param[in] x float coordinate
+ * @param[in] hash  lattice hash
+ * @param[in] x     float coordinate
  *
  * @return Noise value in the range[-1; 1], value of 0 on all integer coordinates.
  */
-float SimplexNoise::noise(float x) {
+template<class Hash>
+static float noise1D(const Hash& hash, float x) {
     float n0, n1;   // Noise contributions from the two "corners"
 
     // No need to skew the input space in 1D
@@ -206,12 +271,14 @@ float SimplexNoise::noise(float x) {
  *
  *  Takes around 150ns on an AMD APU.
  *
- * @param[in] x float coordinate
- * @param[in] y float coordinate
+ * @param[in] hash  lattice hash
+ * @param[in] x     float coordinate
+ * @param[in] y     float coordinate
  *
  * @return Noise value in the range[-1; 1], value of 0 on all integer coordinates.
  */
-float SimplexNoise::noise(float x, float y) {
+template<class Hash>
+static float noise2D(const Hash& hash, float x, float y) {
     float n0, n1, n2;   // Noise contributions from the three corners
 
     // Skewing/Unskewing factors for 2D
@@ -253,9 +320,9 @@ float SimplexNoise::noise(float x, float y) {
     const float y2 = y0 - 1.0f + 2.0f * G2;
 
     // Work out the hashed gradient indices of the three simplex corners
-    const int gi0 = hash(i + hash(j));
-    const int gi1 = hash(i + i1 + hash(j + j1));
-    const int gi2 = hash(i + 1 + hash(j + 1));
+    const int gi0 = hash(i, j);
+    const int gi1 = hash(i + i1, j + j1);
+    const int gi2 = hash(i + 1, j + 1);
 
     // Calculate the contribution from the first corner
     float t0 = 0.5f - x0*x0 - y0*y0;
@@ -293,13 +360,15 @@ float SimplexNoise::noise(float x, float y) {
 /**
  * 3D Perlin simplex noise
  *
- * @param[in] x float coordinate
- * @param[in] y float coordinate
- * @param[in] z float coordinate
+ * @param[in] hash  lattice hash
+ * @param[in] x     float coordinate
+ * @param[in] y     float coordinate
+ * @param[in] z     float coordinate
  *
  * @return Noise value in the range[-1; 1], value of 0 on all integer coordinates.
  */
-float SimplexNoise::noise(float x, float y, float z) {
+template<class Hash>
+static float noise3D(const Hash& hash, float x, float y, float z) {
     float n0, n1, n2, n3; // Noise contributions from the four corners
 
     // Skewing/Unskewing factors for 3D
@@ -356,10 +425,10 @@ float SimplexNoise::noise(float x, float y, float z) {
     float z3 = z0 - 1.0f + 3.0f * G3;
 
     // Work out the hashed gradient indices of the four simplex corners
-    int gi0 = hash(i + hash(j + hash(k)));
-    int gi1 = hash(i + i1 + hash(j + j1 + hash(k + k1)));
-    int gi2 = hash(i + i2 + hash(j + j2 + hash(k + k2)));
-    int gi3 = hash(i + 1 + hash(j + 1 + hash(k + 1)));
+    int gi0 = hash(i, j, k);
+    int gi1 = hash(i + i1, j + j1, k + k1);
+    int gi2 = hash(i + i2, j + j2, k + k2);
+    int gi3 = hash(i + 1, j + 1, k + 1);
 
     // Calculate the contribution from the four corners
     float t0 = 0.6f - x0*x0 - y0*y0 - z0*z0;
@@ -396,6 +465,337 @@ float SimplexNoise::noise(float x, float y, float z) {
 }
 
 
+/**
+ * Helper functions to compute the gradient vectors used by grad() (2D)
+ *
+ *  grad(hash, x, y) is the dot product of this vector with (x,y).
+ *
+ * @param[in]  hash  hash value
+ * @param[out] gx    x component of the gradient
+ * @param[out] gy    y component of the gradient
+ */
+static inline void gradVector(int32_t hash, float& gx, float& gy) {
+    const int32_t h = hash & 0x3F;
+    const float su = (h & 1) ? -1.0f : 1.0f;
+    const float sv = (h & 2) ? -2.0f : 2.0f;
+    gx = h < 4 ? su : sv;
+    gy = h < 4 ? sv : su;
+}
+
+/**
+ * Helper functions to compute the gradient vectors used by grad() (3D)
+ *
+ *  grad(hash, x, y, z) is the dot product of this vector with (x,y,z).
+ *
+ * @param[in]  hash  hash value
+ * @param[out] gx    x component of the gradient
+ * @param[out] gy    y component of the gradient
+ * @param[out] gz    z component of the gradient
+ */
+static inline void gradVector(int32_t hash, float& gx, float& gy, float& gz) {
+    const int h = hash & 15;
+    const float su = (h & 1) ? -1.0f : 1.0f;
+    const float sv = (h & 2) ? -1.0f : 1.0f;
+    const bool vx = h >= 4 && (h == 12 || h == 14); // v is x
+    const bool vz = h >= 4 && !(h == 12 || h == 14); // v is z
+    gx = h < 8 ? su : (vx ? sv : 0.0f);
+    gy = h < 8 ? (h < 4 ? sv : 0.0f) : su;
+    gz = vz ? sv : 0.0f;
+}
+
+/**
+ * 2D Perlin simplex noise with its analytic gradient
+ *
+ *  Each corner contributes n = t^4 * (g.r) with t = 0.5 - r.r, so its derivative is
+ * t^4 * g - 8 * t^3 * (g.r) * r. The value is computed exactly like noise2D().
+ *
+ * @param[in]  hash  lattice hash
+ * @param[in]  x     float coordinate
+ * @param[in]  y     float coordinate
+ * @param[out] dx    derivative of the noise along x
+ * @param[out] dy    derivative of the noise along y
+ *
+ * @return Noise value in the range[-1; 1], identical to noise2D().
+ */
+template<class Hash>
+static float noise2DDerivative(const Hash& hash, float x, float y, float& dx, float& dy) {
+    static const float F2 = 0.366025403f;
+    static const float G2 = 0.211324865f;
+
+    const float s = (x + y) * F2;
+    const float xs = x + s;
+    const float ys = y + s;
+    const int32_t i = fastfloor(xs);
+    const int32_t j = fastfloor(ys);
+
+    const float t = static_cast<float>(i + j) * G2;
+    const float X0 = i - t;
+    const float Y0 = j - t;
+    const float x0 = x - X0;
+    const float y0 = y - Y0;
+
+    int32_t i1, j1;
+    if (x0 > y0) {
+        i1 = 1;
+        j1 = 0;
+    } else {
+        i1 = 0;
+        j1 = 1;
+    }
+
+    const float xc[3] = { x0, x0 - i1 + G2, x0 - 1.0f + 2.0f * G2 };
+    const float yc[3] = { y0, y0 - j1 + G2, y0 - 1.0f + 2.0f * G2 };
+    const int gi[3] = { hash(i, j), hash(i + i1, j + j1), hash(i + 1, j + 1) };
+
+    float n[3], ddx[3], ddy[3];
+    for (int c = 0; c < 3; c++) {
+        const float tc = 0.5f - xc[c]*xc[c] - yc[c]*yc[c];
+        if (tc < 0.0f) {
+            n[c] = ddx[c] = ddy[c] = 0.0f;
+        } else {
+            float gx, gy;
+            gradVector(gi[c], gx, gy);
+            const float t2 = tc * tc;
+            const float t4 = t2 * t2;
+            const float gdot = grad(gi[c], xc[c], yc[c]);
+            const float temp = t2 * tc * gdot;
+            n[c] = t4 * gdot;
+            ddx[c] = t4 * gx - 8.0f * temp * xc[c];
+            ddy[c] = t4 * gy - 8.0f * temp * yc[c];
+        }
+    }
+
+    dx = 45.23065f * (ddx[0] + ddx[1] + ddx[2]);
+    dy = 45.23065f * (ddy[0] + ddy[1] + ddy[2]);
+    return 45.23065f * (n[0] + n[1] + n[2]);
+}
+
+/**
+ * 3D Perlin simplex noise with its analytic gradient
+ *
+ *  Each corner contributes n = t^4 * (g.r) with t = 0.6 - r.r, so its derivative is
+ * t^4 * g - 8 * t^3 * (g.r) * r. The value is computed exactly like noise3D().
+ *
+ * @param[in]  hash  lattice hash
+ * @param[in]  x     float coordinate
+ * @param[in]  y     float coordinate
+ * @param[in]  z     float coordinate
+ * @param[out] dx    derivative of the noise along x
+ * @param[out] dy    derivative of the noise along y
+ * @param[out] dz    derivative of the noise along z
+ *
+ * @return Noise value in the range[-1; 1], identical to noise3D().
+ */
+template<class Hash>
+static float noise3DDerivative(const Hash& hash, float x, float y, float z, float& dx, float& dy, float& dz) {
+    static const float F3 = 1.0f / 3.0f;
+    static const float G3 = 1.0f / 6.0f;
+
+    float s = (x + y + z) * F3;
+    int i = fastfloor(x + s);
+    int j = fastfloor(y + s);
+    int k = fastfloor(z + s);
+    float t = (i + j + k) * G3;
+    float X0 = i - t;
+    float Y0 = j - t;
+    float Z0 = k - t;
+    float x0 = x - X0;
+    float y0 = y - Y0;
+    float z0 = z - Z0;
+
+    int i1, j1, k1;
+    int i2, j2, k2;
+    if (x0 >= y0) {
+        if (y0 >= z0) {
+            i1 = 1; j1 = 0; k1 = 0; i2 = 1; j2 = 1; k2 = 0;
+        } else if (x0 >= z0) {
+            i1 = 1; j1 = 0; k1 = 0; i2 = 1; j2 = 0; k2 = 1;
+        } else {
+            i1 = 0; j1 = 0; k1 = 1; i2 = 1; j2 = 0; k2 = 1;
+        }
+    } else {
+        if (y0 < z0) {
+            i1 = 0; j1 = 0; k1 = 1; i2 = 0; j2 = 1; k2 = 1;
+        } else if (x0 < z0) {
+            i1 = 0; j1 = 1; k1 = 0; i2 = 0; j2 = 1; k2 = 1;
+        } else {
+            i1 = 0; j1 = 1; k1 = 0; i2 = 1; j2 = 1; k2 = 0;
+        }
+    }
+
+    const float xc[4] = { x0, x0 - i1 + G3, x0 - i2 + 2.0f * G3, x0 - 1.0f + 3.0f * G3 };
+    const float yc[4] = { y0, y0 - j1 + G3, y0 - j2 + 2.0f * G3, y0 - 1.0f + 3.0f * G3 };
+    const float zc[4] = { z0, z0 - k1 + G3, z0 - k2 + 2.0f * G3, z0 - 1.0f + 3.0f * G3 };
+    const int gi[4] = {
+        hash(i, j, k),
+        hash(i + i1, j + j1, k + k1),
+        hash(i + i2, j + j2, k + k2),
+        hash(i + 1, j + 1, k + 1)
+    };
+
+    float n[4], ddx[4], ddy[4], ddz[4];
+    for (int c = 0; c < 4; c++) {
+        const float tc = 0.6f - xc[c]*xc[c] - yc[c]*yc[c] - zc[c]*zc[c];
+        if (tc < 0) {
+            n[c] = ddx[c] = ddy[c] = ddz[c] = 0.0f;
+        } else {
+            float gx, gy, gz;
+            gradVector(gi[c], gx, gy, gz);
+            const float t2 = tc * tc;
+            const float t4 = t2 * t2;
+            const float gdot = grad(gi[c], xc[c], yc[c], zc[c]);
+            const float temp = t2 * tc * gdot;
+            n[c] = t4 * gdot;
+            ddx[c] = t4 * gx - 8.0f * temp * xc[c];
+            ddy[c] = t4 * gy - 8.0f * temp * yc[c];
+            ddz[c] = t4 * gz - 8.0f * temp * zc[c];
+        }
+    }
+
+    dx = 32.0f * (ddx[0] + ddx[1] + ddx[2] + ddx[3]);
+    dy = 32.0f * (ddy[0] + ddy[1] + ddy[2] + ddy[3]);
+    dz = 32.0f * (ddz[0] + ddz[1] + ddz[2] + ddz[3]);
+    return 32.0f * (n[0] + n[1] + n[2] + n[3]);
+}
+
+/**
+ * 1D Perlin simplex noise, using Ken Perlin's reference permutation table
+ *
+ * @param[in] x float coordinate
+ *
+ * @return Noise value in the range[-1; 1], value of 0 on all integer coordinates.
+ */
+float SimplexNoise::noise(float x) {
+    return noise1D(PermutationHash<uint8_t>{perm}, x);
+}
+
+/**
+ * 2D Perlin simplex noise, using Ken Perlin's reference permutation table
+ *
+ * @param[in] x float coordinate
+ * @param[in] y float coordinate
+ *
+ * @return Noise value in the range[-1; 1], value of 0 on all integer coordinates.
+ */
+float SimplexNoise::noise(float x, float y) {
+    return noise2D(PermutationHash<uint8_t>{perm}, x, y);
+}
+
+/**
+ * 3D Perlin simplex noise, using Ken Perlin's reference permutation table
+ *
+ * @param[in] x float coordinate
+ * @param[in] y float coordinate
+ * @param[in] z float coordinate
+ *
+ * @return Noise value in the range[-1; 1], value of 0 on all integer coordinates.
+ */
+float SimplexNoise::noise(float x, float y, float z) {
+    return noise3D(PermutationHash<uint8_t>{perm}, x, y, z);
+}
+
+/**
+ * Constructor of to initialize a fractal noise summation, see SimplexNoise.h
+ *
+ * Starts with Ken Perlin's reference permutation table, so that an unseeded
+ * instance produces exactly the same values as the static noise functions.
+ */
+SimplexNoise::SimplexNoise(float frequency, float amplitude, float lacunarity, float persistence) :
+    mFrequency(frequency),
+    mAmplitude(amplitude),
+    mLacunarity(lacunarity),
+    mPersistence(persistence),
+    mHashMode(HashMode::Permutation) {
+    setSeed(0);
+}
+
+/**
+ * Reseed the instance
+ *
+ * The permutation table is reshuffled (Fisher-Yates driven by splitmix64), and the
+ * seed is mixed into the integer hash. The result only depends on the seed, so
+ * worlds are reproducible on every platform. Seed 0 keeps Ken Perlin's reference
+ * table, which unseeded instances start with.
+ *
+ * @param[in] seed  world seed
+ */
+void SimplexNoise::setSeed(uint32_t seed) {
+    mSeed = seed;
+
+    if (seed == 0) {
+        for (size_t i = 0; i < 256; i++) {
+            mPerm[i] = perm[i];
+            mPerm32[i] = perm[i];
+        }
+        return;
+    }
+
+    uint64_t state = seed;
+    for (size_t i = 0; i < 256; i++) {
+        mPerm[i] = static_cast<uint8_t>(i);
+    }
+    for (size_t i = 255; i > 0; i--) {
+        state += 0x9E3779B97F4A7C15ull;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        z ^= z >> 31;
+
+        const size_t j = static_cast<size_t>(z % (i + 1));
+        const uint8_t swap = mPerm[i];
+        mPerm[i] = mPerm[j];
+        mPerm[j] = swap;
+    }
+    for (size_t i = 0; i < 256; i++) {
+        mPerm32[i] = mPerm[i];
+    }
+}
+
+/**
+ * 1D Perlin simplex noise, using the instance seed and hash mode
+ *
+ * @param[in] x float coordinate
+ *
+ * @return Noise value in the range[-1; 1], value of 0 on all integer coordinates.
+ */
+float SimplexNoise::sample(float x) const {
+    if (mHashMode == HashMode::Integer) {
+        return noise1D(IntegerHash{mSeed}, x);
+    }
+    return noise1D(PermutationHash<uint8_t>{mPerm}, x);
+}
+
+/**
+ * 2D Perlin simplex noise, using the instance seed and hash mode
+ *
+ * @param[in] x float coordinate
+ * @param[in] y float coordinate
+ *
+ * @return Noise value in the range[-1; 1], value of 0 on all integer coordinates.
+ */
+float SimplexNoise::sample(float x, float y) const {
+    if (mHashMode == HashMode::Integer) {
+        return noise2D(IntegerHash{mSeed}, x, y);
+    }
+    return noise2D(PermutationHash<uint8_t>{mPerm}, x, y);
+}
+
+/**
+ * 3D Perlin simplex noise, using the instance seed and hash mode
+ *
+ * @param[in] x float coordinate
+ * @param[in] y float coordinate
+ * @param[in] z float coordinate
+ *
+ * @return Noise value in the range[-1; 1], value of 0 on all integer coordinates.
+ */
+float SimplexNoise::sample(float x, float y, float z) const {
+    if (mHashMode == HashMode::Integer) {
+        return noise3D(IntegerHash{mSeed}, x, y, z);
+    }
+    return noise3D(PermutationHash<uint8_t>{mPerm}, x, y, z);
+}
+
 /**
  * Fractal/Fractional Brownian Motion (fBm) summation of 1D Perlin Simplex noise
  *
@@ -411,7 +811,7 @@ float SimplexNoise::fractal(size_t octaves, float x) const {
     float amplitude = mAmplitude;
 
     for (size_t i = 0; i < octaves; i++) {
-        output += (amplitude * noise(x * frequency));
+        output += (amplitude * sample(x * frequency));
         denom += amplitude;
 
         frequency *= mLacunarity;
@@ -437,7 +837,7 @@ float SimplexNoise::fractal(size_t octaves, float x, float y) const {
     float amplitude = mAmplitude;
 
     for (size_t i = 0; i < octaves; i++) {
-        output += (amplitude * noise(x * frequency, y * frequency));
+        output += (amplitude * sample(x * frequency, y * frequency));
         denom += amplitude;
 
         frequency *= mLacunarity;
@@ -464,7 +864,7 @@ float SimplexNoise::fractal(size_t octaves, float x, float y, float z) const {
     float amplitude = mAmplitude;
 
     for (size_t i = 0; i < octaves; i++) {
-        output += (amplitude * noise(x * frequency, y * frequency, z * frequency));
+        output += (amplitude * sample(x * frequency, y * frequency, z * frequency));
         denom += amplitude;
 
         frequency *= mLacunarity;
@@ -473,3 +873,820 @@ float SimplexNoise::fractal(size_t octaves, float x, float y, float z) const {
 
     return (output / denom);
 }
+
+/**
+ * 2D Perlin simplex noise with its analytic gradient, using Ken Perlin's reference permutation table
+ *
+ *  Costs about as much as 1.5 noise() calls, instead of the 4 extra calls of central differences.
+ *
+ * @param[in] x float coordinate
+ * @param[in] y float coordinate
+ *
+ * @return Noise value (identical to noise(x, y)) and its partial derivatives.
+ */
+SimplexNoise::Derivative2 SimplexNoise::noiseWithDerivative(float x, float y) {
+    Derivative2 result;
+    result.value = noise2DDerivative(PermutationHash<uint8_t>{perm}, x, y, result.dx, result.dy);
+    return result;
+}
+
+/**
+ * 3D Perlin simplex noise with its analytic gradient, using Ken Perlin's reference permutation table
+ *
+ *  Costs about as much as 1.5 noise() calls, instead of the 6 extra calls of central differences.
+ *
+ * @param[in] x float coordinate
+ * @param[in] y float coordinate
+ * @param[in] z float coordinate
+ *
+ * @return Noise value (identical to noise(x, y, z)) and its partial derivatives.
+ */
+SimplexNoise::Derivative3 SimplexNoise::noiseWithDerivative(float x, float y, float z) {
+    Derivative3 result;
+    result.value = noise3DDerivative(PermutationHash<uint8_t>{perm}, x, y, z, result.dx, result.dy, result.dz);
+    return result;
+}
+
+/**
+ * 2D Perlin simplex noise with its analytic gradient, using the instance seed and hash mode
+ */
+SimplexNoise::Derivative2 SimplexNoise::sampleWithDerivative(float x, float y) const {
+    Derivative2 result;
+    if (mHashMode == HashMode::Integer) {
+        result.value = noise2DDerivative(IntegerHash{mSeed}, x, y, result.dx, result.dy);
+    } else {
+        result.value = noise2DDerivative(PermutationHash<uint8_t>{mPerm}, x, y, result.dx, result.dy);
+    }
+    return result;
+}
+
+/**
+ * 3D Perlin simplex noise with its analytic gradient, using the instance seed and hash mode
+ */
+SimplexNoise::Derivative3 SimplexNoise::sampleWithDerivative(float x, float y, float z) const {
+    Derivative3 result;
+    if (mHashMode == HashMode::Integer) {
+        result.value = noise3DDerivative(IntegerHash{mSeed}, x, y, z, result.dx, result.dy, result.dz);
+    } else {
+        result.value = noise3DDerivative(PermutationHash<uint8_t>{mPerm}, x, y, z, result.dx, result.dy, result.dz);
+    }
+    return result;
+}
+
+/**
+ * Fractal/Fractional Brownian Motion (fBm) summation of 2D noise, with its analytic gradient
+ *
+ * @param[in] octaves   number of fraction of noise to sum
+ * @param[in] x         x float coordinate
+ * @param[in] y         y float coordinate
+ *
+ * @return Noise value (identical to fractal(octaves, x, y)) and its partial derivatives.
+ */
+SimplexNoise::Derivative2 SimplexNoise::fractalWithDerivative(size_t octaves, float x, float y) const {
+    Derivative2 output = { 0.f, 0.f, 0.f };
+    float denom  = 0.f;
+    float frequency = mFrequency;
+    float amplitude = mAmplitude;
+
+    for (size_t i = 0; i < octaves; i++) {
+        const Derivative2 n = sampleWithDerivative(x * frequency, y * frequency);
+        output.value += (amplitude * n.value);
+        // Chain rule: the octave is sampled at (x,y) * frequency
+        output.dx += (amplitude * frequency) * n.dx;
+        output.dy += (amplitude * frequency) * n.dy;
+        denom += amplitude;
+
+        frequency *= mLacunarity;
+        amplitude *= mPersistence;
+    }
+
+    output.value = (output.value / denom);
+    output.dx = (output.dx / denom);
+    output.dy = (output.dy / denom);
+    return output;
+}
+
+/**
+ * Fractal/Fractional Brownian Motion (fBm) summation of 3D noise, with its analytic gradient
+ *
+ * @param[in] octaves   number of fraction of noise to sum
+ * @param[in] x         x float coordinate
+ * @param[in] y         y float coordinate
+ * @param[in] z         z float coordinate
+ *
+ * @return Noise value (identical to fractal(octaves, x, y, z)) and its partial derivatives.
+ */
+SimplexNoise::Derivative3 SimplexNoise::fractalWithDerivative(size_t octaves, float x, float y, float z) const {
+    Derivative3 output = { 0.f, 0.f, 0.f, 0.f };
+    float denom  = 0.f;
+    float frequency = mFrequency;
+    float amplitude = mAmplitude;
+
+    for (size_t i = 0; i < octaves; i++) {
+        const Derivative3 n = sampleWithDerivative(x * frequency, y * frequency, z * frequency);
+        output.value += (amplitude * n.value);
+        // Chain rule: the octave is sampled at (x,y,z) * frequency
+        output.dx += (amplitude * frequency) * n.dx;
+        output.dy += (amplitude * frequency) * n.dy;
+        output.dz += (amplitude * frequency) * n.dz;
+        denom += amplitude;
+
+        frequency *= mLacunarity;
+        amplitude *= mPersistence;
+    }
+
+    output.value = (output.value / denom);
+    output.dx = (output.dx / denom);
+    output.dy = (output.dy / denom);
+    output.dz = (output.dz / denom);
+    return output;
+}
+
+/**
+ * Derivative-damped fBm of 2D noise ("swiss" style terrain)
+ *
+ *  Each octave is attenuated by 1 / (1 + damping * |sum of previous gradients|^2), so detail
+ * is kept in flat areas and eroded away on steep slopes.
+ *
+ * @param[in] octaves   number of fraction of noise to sum
+ * @param[in] x         x float coordinate
+ * @param[in] y         y float coordinate
+ * @param[in] damping   strength of the slope attenuation (0 gives plain fBm)
+ *
+ * @return Noise value in the range[-1; 1]
+ */
+float SimplexNoise::fractalDamped(size_t octaves, float x, float y, float damping) const {
+    float output = 0.f;
+    float denom  = 0.f;
+    float frequency = mFrequency;
+    float amplitude = mAmplitude;
+    float sdx = 0.f, sdy = 0.f;
+
+    for (size_t i = 0; i < octaves; i++) {
+        const Derivative2 n = sampleWithDerivative(x * frequency, y * frequency);
+        sdx += n.dx;
+        sdy += n.dy;
+        output += (amplitude * n.value) / (1.0f + damping * (sdx * sdx + sdy * sdy));
+        denom += amplitude;
+
+        frequency *= mLacunarity;
+        amplitude *= mPersistence;
+    }
+
+    return (output / denom);
+}
+
+/**
+ * Derivative-damped fBm of 3D noise ("swiss" style terrain), see fractalDamped(size_t, float, float, float)
+ *
+ * @param[in] octaves   number of fraction of noise to sum
+ * @param[in] x         x float coordinate
+ * @param[in] y         y float coordinate
+ * @param[in] z         z float coordinate
+ * @param[in] damping   strength of the slope attenuation (0 gives plain fBm)
+ *
+ * @return Noise value in the range[-1; 1]
+ */
+float SimplexNoise::fractalDamped(size_t octaves, float x, float y, float z, float damping) const {
+    float output = 0.f;
+    float denom  = 0.f;
+    float frequency = mFrequency;
+    float amplitude = mAmplitude;
+    float sdx = 0.f, sdy = 0.f, sdz = 0.f;
+
+    for (size_t i = 0; i < octaves; i++) {
+        const Derivative3 n = sampleWithDerivative(x * frequency, y * frequency, z * frequency);
+        sdx += n.dx;
+        sdy += n.dy;
+        sdz += n.dz;
+        output += (amplitude * n.value) / (1.0f + damping * (sdx * sdx + sdy * sdy + sdz * sdz));
+        denom += amplitude;
+
+        frequency *= mLacunarity;
+        amplitude *= mPersistence;
+    }
+
+    return (output / denom);
+}
+
+using SimplexNoiseSIMD::LatticeHash;
+
+/// Lattice hash of the static functions: Ken Perlin's reference table
+static const LatticeHash kDefaultHash = { perm32.v, 0, false };
+
+/**
+ * Scalar batch kernels, used when no SIMD kernel is available.
+ * They run the single point code, so they are bit-identical by definition.
+ */
+static void noise2Scalar(const LatticeHash& hash, const float* x, const float* y, float* out, size_t count) {
+    for (size_t n = 0; n < count; n++) {
+        out[n] = hash.integer ? noise2D(IntegerHash{hash.seed}, x[n], y[n])
+                              : noise2D(PermutationHash<int32_t>{hash.perm}, x[n], y[n]);
+    }
+}
+
+static void noise3Scalar(const LatticeHash& hash, const float* x, const float* y, const float* z, float* out, size_t count) {
+    for (size_t n = 0; n < count; n++) {
+        out[n] = hash.integer ? noise3D(IntegerHash{hash.seed}, x[n], y[n], z[n])
+                              : noise3D(PermutationHash<int32_t>{hash.perm}, x[n], y[n], z[n]);
+    }
+}
+
+static void noise2DerivativeScalar(const LatticeHash& hash, const float* x, const float* y,
+                                   float* out, float* dx, float* dy, size_t count) {
+    for (size_t n = 0; n < count; n++) {
+        out[n] = hash.integer ? noise2DDerivative(IntegerHash{hash.seed}, x[n], y[n], dx[n], dy[n])
+                              : noise2DDerivative(PermutationHash<int32_t>{hash.perm}, x[n], y[n], dx[n], dy[n]);
+    }
+}
+
+static void noise3DerivativeScalar(const LatticeHash& hash, const float* x, const float* y, const float* z,
+                                   float* out, float* dx, float* dy, float* dz, size_t count) {
+    for (size_t n = 0; n < count; n++) {
+        out[n] = hash.integer ? noise3DDerivative(IntegerHash{hash.seed}, x[n], y[n], z[n], dx[n], dy[n], dz[n])
+                              : noise3DDerivative(PermutationHash<int32_t>{hash.perm}, x[n], y[n], z[n], dx[n], dy[n], dz[n]);
+    }
+}
+
+/**
+ * Kernels of the currently selected batch backend
+ */
+struct BatchKernels {
+    SimplexNoise::Backend backend;
+    void (*noise2)(const LatticeHash& hash, const float* x, const float* y, float* out, size_t count);
+    void (*noise3)(const LatticeHash& hash, const float* x, const float* y, const float* z, float* out, size_t count);
+    void (*noise2Derivative)(const LatticeHash& hash, const float* x, const float* y,
+                             float* out, float* dx, float* dy, size_t count);
+    void (*noise3Derivative)(const LatticeHash& hash, const float* x, const float* y, const float* z,
+                             float* out, float* dx, float* dy, float* dz, size_t count);
+};
+
+static BatchKernels kernelsFor(SimplexNoise::Backend backend) {
+    switch (backend) {
+#if defined(__x86_64__)
+    case SimplexNoise::Backend::SSE2:
+        return { backend, SimplexNoiseSIMD::noise2SSE2, SimplexNoiseSIMD::noise3SSE2,
+                 SimplexNoiseSIMD::noise2DerivativeSSE2, SimplexNoiseSIMD::noise3DerivativeSSE2 };
+    case SimplexNoise::Backend::AVX2:
+        return { backend, SimplexNoiseSIMD::noise2AVX2, SimplexNoiseSIMD::noise3AVX2,
+                 SimplexNoiseSIMD::noise2DerivativeAVX2, SimplexNoiseSIMD::noise3DerivativeAVX2 };
+#endif
+#if defined(__aarch64__)
+    case SimplexNoise::Backend::NEON:
+        return { backend, SimplexNoiseSIMD::noise2NEON, SimplexNoiseSIMD::noise3NEON,
+                 SimplexNoiseSIMD::noise2DerivativeNEON, SimplexNoiseSIMD::noise3DerivativeNEON };
+#endif
+    default:
+        return { SimplexNoise::Backend::Scalar, noise2Scalar, noise3Scalar,
+                 noise2DerivativeScalar, noise3DerivativeScalar };
+    }
+}
+
+/**
+ * Widest backend supported by the running CPU
+ */
+static SimplexNoise::Backend bestBackend() {
+    if (SimplexNoise::isBackendSupported(SimplexNoise::Backend::AVX2)) {
+        return SimplexNoise::Backend::AVX2;
+    }
+    if (SimplexNoise::isBackendSupported(SimplexNoise::Backend::SSE2)) {
+        return SimplexNoise::Backend::SSE2;
+    }
+    if (SimplexNoise::isBackendSupported(SimplexNoise::Backend::NEON)) {
+        return SimplexNoise::Backend::NEON;
+    }
+    return SimplexNoise::Backend::Scalar;
+}
+
+static BatchKernels& activeKernels() {
+    static BatchKernels kernels = kernelsFor(bestBackend());
+    return kernels;
+}
+
+/// Number of samples evaluated per kernel call by the grid functions (coordinates live on the stack)
+static const size_t kGridBatch = 64;
+
+/**
+ * Check whether a batch backend can run on this build and CPU
+ *
+ * @param[in] backend   instruction set to check
+ *
+ * @return true if setBackend(backend) would succeed
+ */
+bool SimplexNoise::isBackendSupported(Backend backend) {
+    switch (backend) {
+    case Backend::Scalar:
+        return true;
+#if defined(__x86_64__)
+    case Backend::SSE2:
+        return true;
+    case Backend::AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+#if defined(__aarch64__)
+    case Backend::NEON:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+/**
+ * Select the instruction set used by the batch functions
+ *
+ * The widest supported backend is picked automatically; this is only needed to
+ * compare backends (benchmarks) or to rule one out. Not thread-safe: call it
+ * before any batch function runs concurrently.
+ *
+ * @param[in] backend   instruction set to use
+ *
+ * @return false (and no change) if the backend is not supported
+ */
+bool SimplexNoise::setBackend(Backend backend) {
+    if (!isBackendSupported(backend)) {
+        return false;
+    }
+    activeKernels() = kernelsFor(backend);
+    return true;
+}
+
+SimplexNoise::Backend SimplexNoise::getBackend() {
+    return activeKernels().backend;
+}
+
+const char* SimplexNoise::backendName(Backend backend) {
+    switch (backend) {
+    case Backend::SSE2: return "SSE2";
+    case Backend::AVX2: return "AVX2";
+    case Backend::NEON: return "NEON";
+    default:            return "Scalar";
+    }
+}
+
+/**
+ * Fill a 2D grid, see noiseGrid()
+ */
+static void noiseGrid2(const LatticeHash& hash, float* out, size_t sizeX, size_t sizeY,
+                       float x, float y, float step, size_t strideY) {
+    const BatchKernels& kernels = activeKernels();
+    float px[kGridBatch], py[kGridBatch];
+
+    for (size_t j = 0; j < sizeY; j++) {
+        const float cy = y + static_cast<float>(j) * step;
+        for (size_t i = 0; i < sizeX; i += kGridBatch) {
+            const size_t count = std::min(kGridBatch, sizeX - i);
+            for (size_t l = 0; l < count; l++) {
+                px[l] = x + static_cast<float>(i + l) * step;
+                py[l] = cy;
+            }
+            kernels.noise2(hash, px, py, out + j * strideY + i, count);
+        }
+    }
+}
+
+/**
+ * Fill a 3D grid, see noiseGrid()
+ */
+static void noiseGrid3(const LatticeHash& hash, float* out, size_t sizeX, size_t sizeY, size_t sizeZ,
+                       float x, float y, float z, float step, size_t strideY, size_t strideZ) {
+    const BatchKernels& kernels = activeKernels();
+    float px[kGridBatch], py[kGridBatch], pz[kGridBatch];
+
+    for (size_t k = 0; k < sizeZ; k++) {
+        const float cz = z + static_cast<float>(k) * step;
+        for (size_t j = 0; j < sizeY; j++) {
+            const float cy = y + static_cast<float>(j) * step;
+            for (size_t i = 0; i < sizeX; i += kGridBatch) {
+                const size_t count = std::min(kGridBatch, sizeX - i);
+                for (size_t l = 0; l < count; l++) {
+                    px[l] = x + static_cast<float>(i + l) * step;
+                    py[l] = cy;
+                    pz[l] = cz;
+                }
+                kernels.noise3(hash, px, py, pz, out + j * strideY + k * strideZ + i, count);
+            }
+        }
+    }
+}
+
+/**
+ * Batched 2D Perlin simplex noise over structure-of-arrays coordinates
+ *
+ * @param[in]  x      count x coordinates
+ * @param[in]  y      count y coordinates
+ * @param[out] out    count noise values, bit-identical to noise(x[n], y[n])
+ * @param[in]  count  number of samples
+ */
+void SimplexNoise::noise(const float* x, const float* y, float* out, size_t count) {
+    activeKernels().noise2(kDefaultHash, x, y, out, count);
+}
+
+/**
+ * Batched 3D Perlin simplex noise over structure-of-arrays coordinates
+ *
+ * @param[in]  x      count x coordinates
+ * @param[in]  y      count y coordinates
+ * @param[in]  z      count z coordinates
+ * @param[out] out    count noise values, bit-identical to noise(x[n], y[n], z[n])
+ * @param[in]  count  number of samples
+ */
+void SimplexNoise::noise(const float* x, const float* y, const float* z, float* out, size_t count) {
+    activeKernels().noise3(kDefaultHash, x, y, z, out, count);
+}
+
+/**
+ * Batched 2D noise using the instance seed and hash mode, bit-identical to sample(x[n], y[n])
+ */
+void SimplexNoise::sample(const float* x, const float* y, float* out, size_t count) const {
+    activeKernels().noise2(LatticeHash{mPerm32, mSeed, mHashMode == HashMode::Integer}, x, y, out, count);
+}
+
+/**
+ * Batched 3D noise using the instance seed and hash mode, bit-identical to sample(x[n], y[n], z[n])
+ */
+void SimplexNoise::sample(const float* x, const float* y, const float* z, float* out, size_t count) const {
+    activeKernels().noise3(LatticeHash{mPerm32, mSeed, mHashMode == HashMode::Integer}, x, y, z, out, count);
+}
+
+/**
+ * Batched fBm of 3D noise over structure-of-arrays coordinates
+ *
+ * @param[in]  octaves  number of fraction of noise to sum
+ * @param[in]  x        count x coordinates
+ * @param[in]  y        count y coordinates
+ * @param[in]  z        count z coordinates
+ * @param[out] out      count values, bit-identical to fractal(octaves, x[n], y[n], z[n])
+ * @param[in]  count    number of samples
+ */
+void SimplexNoise::fractal(size_t octaves, const float* x, const float* y, const float* z, float* out, size_t count) const {
+    const BatchKernels& kernels = activeKernels();
+    const LatticeHash hash = { mPerm32, mSeed, mHashMode == HashMode::Integer };
+    float sx[kGridBatch], sy[kGridBatch], sz[kGridBatch];
+    float value[kGridBatch], output[kGridBatch];
+
+    for (size_t i = 0; i < count; i += kGridBatch) {
+        const size_t batch = std::min(kGridBatch, count - i);
+        for (size_t l = 0; l < batch; l++) {
+            output[l] = 0.f;
+        }
+
+        float denom     = 0.f;
+        float frequency = mFrequency;
+        float amplitude = mAmplitude;
+
+        for (size_t o = 0; o < octaves; o++) {
+            for (size_t l = 0; l < batch; l++) {
+                sx[l] = x[i + l] * frequency;
+                sy[l] = y[i + l] * frequency;
+                sz[l] = z[i + l] * frequency;
+            }
+            kernels.noise3(hash, sx, sy, sz, value, batch);
+            for (size_t l = 0; l < batch; l++) {
+                output[l] += (amplitude * value[l]);
+            }
+            denom += amplitude;
+
+            frequency *= mLacunarity;
+            amplitude *= mPersistence;
+        }
+
+        for (size_t l = 0; l < batch; l++) {
+            out[i + l] = (output[l] / denom);
+        }
+    }
+}
+
+/**
+ * 2D Perlin simplex noise over a regular grid
+ *
+ * Sample (i,j) is noise(x + i*step, y + j*step) and is stored at out[i + j*strideY].
+ *
+ * @param[out] out      output buffer, rows of sizeX contiguous floats
+ * @param[in]  sizeX    number of samples along x
+ * @param[in]  sizeY    number of samples along y
+ * @param[in]  x        x coordinate of the first sample
+ * @param[in]  y        y coordinate of the first sample
+ * @param[in]  step     distance between two neighbouring samples
+ * @param[in]  strideY  distance in floats between two rows of out
+ */
+void SimplexNoise::noiseGrid(float* out, size_t sizeX, size_t sizeY, float x, float y, float step, size_t strideY) {
+    noiseGrid2(kDefaultHash, out, sizeX, sizeY, x, y, step, strideY);
+}
+
+/**
+ * 3D Perlin simplex noise over a regular grid
+ *
+ * Sample (i,j,k) is noise(x + i*step, y + j*step, z + k*step)
+ * and is stored at out[i + j*strideY + k*strideZ].
+ *
+ * @param[out] out      output buffer, rows of sizeX contiguous floats
+ * @param[in]  sizeX    number of samples along x
+ * @param[in]  sizeY    number of samples along y
+ * @param[in]  sizeZ    number of samples along z
+ * @param[in]  x        x coordinate of the first sample
+ * @param[in]  y        y coordinate of the first sample
+ * @param[in]  z        z coordinate of the first sample
+ * @param[in]  step     distance between two neighbouring samples
+ * @param[in]  strideY  distance in floats between two rows of out
+ * @param[in]  strideZ  distance in floats between two slices of out
+ */
+void SimplexNoise::noiseGrid(float* out, size_t sizeX, size_t sizeY, size_t sizeZ,
+                             float x, float y, float z, float step, size_t strideY, size_t strideZ) {
+    noiseGrid3(kDefaultHash, out, sizeX, sizeY, sizeZ, x, y, z, step, strideY, strideZ);
+}
+
+/**
+ * 2D noise over a regular grid using the instance seed and hash mode, see noiseGrid()
+ */
+void SimplexNoise::sampleGrid(float* out, size_t sizeX, size_t sizeY, float x, float y, float step, size_t strideY) const {
+    noiseGrid2(LatticeHash{mPerm32, mSeed, mHashMode == HashMode::Integer}, out, sizeX, sizeY, x, y, step, strideY);
+}
+
+/**
+ * 3D noise over a regular grid using the instance seed and hash mode, see noiseGrid()
+ */
+void SimplexNoise::sampleGrid(float* out, size_t sizeX, size_t sizeY, size_t sizeZ,
+                              float x, float y, float z, float step, size_t strideY, size_t strideZ) const {
+    noiseGrid3(LatticeHash{mPerm32, mSeed, mHashMode == HashMode::Integer},
+               out, sizeX, sizeY, sizeZ, x, y, z, step, strideY, strideZ);
+}
+
+/**
+ * Fractal/Fractional Brownian Motion (fBm) summation of 2D noise over a regular grid
+ *
+ * Sample (i,j) is fractal(octaves, x + i*step, y + j*step) and is stored at out[i + j*strideY].
+ * Octaves are summed a batch of samples at a time, in the same order as fractal(),
+ * with the instance seed and hash mode.
+ *
+ * @param[in]  octaves  number of fraction of noise to sum
+ * @param[out] out      output buffer, rows of sizeX contiguous floats
+ * @param[in]  sizeX    number of samples along x
+ * @param[in]  sizeY    number of samples along y
+ * @param[in]  x        x coordinate of the first sample
+ * @param[in]  y        y coordinate of the first sample
+ * @param[in]  step     distance between two neighbouring samples
+ * @param[in]  strideY  distance in floats between two rows of out
+ */
+void SimplexNoise::fractalGrid(size_t octaves, float* out, size_t sizeX, size_t sizeY,
+                               float x, float y, float step, size_t strideY) const {
+    const BatchKernels& kernels = activeKernels();
+    const LatticeHash hash = { mPerm32, mSeed, mHashMode == HashMode::Integer };
+    float px[kGridBatch], py[kGridBatch];
+    float sx[kGridBatch], sy[kGridBatch];
+    float value[kGridBatch], output[kGridBatch];
+
+    for (size_t j = 0; j < sizeY; j++) {
+        const float cy = y + static_cast<float>(j) * step;
+        for (size_t i = 0; i < sizeX; i += kGridBatch) {
+            const size_t count = std::min(kGridBatch, sizeX - i);
+            for (size_t l = 0; l < count; l++) {
+                px[l] = x + static_cast<float>(i + l) * step;
+                py[l] = cy;
+                output[l] = 0.f;
+            }
+
+            float denom     = 0.f;
+            float frequency = mFrequency;
+            float amplitude = mAmplitude;
+
+            for (size_t o = 0; o < octaves; o++) {
+                for (size_t l = 0; l < count; l++) {
+                    sx[l] = px[l] * frequency;
+                    sy[l] = py[l] * frequency;
+                }
+                kernels.noise2(hash, sx, sy, value, count);
+                for (size_t l = 0; l < count; l++) {
+                    output[l] += (amplitude * value[l]);
+                }
+                denom += amplitude;
+
+                frequency *= mLacunarity;
+                amplitude *= mPersistence;
+            }
+
+            float* row = out + j * strideY + i;
+            for (size_t l = 0; l < count; l++) {
+                row[l] = (output[l] / denom);
+            }
+        }
+    }
+}
+
+/**
+ * Fractal/Fractional Brownian Motion (fBm) summation of 3D noise over a regular grid
+ *
+ * Sample (i,j,k) is fractal(octaves, x + i*step, y + j*step, z + k*step)
+ * and is stored at out[i + j*strideY + k*strideZ].
+ * Octaves are summed a batch of samples at a time, in the same order as fractal(),
+ * with the instance seed and hash mode.
+ *
+ * @param[in]  octaves  number of fraction of noise to sum
+ * @param[out] out      output buffer, rows of sizeX contiguous floats
+ * @param[in]  sizeX    number of samples along x
+ * @param[in]  sizeY    number of samples along y
+ * @param[in]  sizeZ    number of samples along z
+ * @param[in]  x        x coordinate of the first sample
+ * @param[in]  y        y coordinate of the first sample
+ * @param[in]  z        z coordinate of the first sample
+ * @param[in]  step     distance between two neighbouring samples
+ * @param[in]  strideY  distance in floats between two rows of out
+ * @param[in]  strideZ  distance in floats between two slices of out
+ */
+void SimplexNoise::fractalGrid(size_t octaves, float* out, size_t sizeX, size_t sizeY, size_t sizeZ,
+                               float x, float y, float z, float step, size_t strideY, size_t strideZ) const {
+    const BatchKernels& kernels = activeKernels();
+    const LatticeHash hash = { mPerm32, mSeed, mHashMode == HashMode::Integer };
+    float px[kGridBatch], py[kGridBatch], pz[kGridBatch];
+    float sx[kGridBatch], sy[kGridBatch], sz[kGridBatch];
+    float value[kGridBatch], output[kGridBatch];
+
+    for (size_t k = 0; k < sizeZ; k++) {
+        const float cz = z + static_cast<float>(k) * step;
+        for (size_t j = 0; j < sizeY; j++) {
+            const float cy = y + static_cast<float>(j) * step;
+            for (size_t i = 0; i < sizeX; i += kGridBatch) {
+                const size_t count = std::min(kGridBatch, sizeX - i);
+                for (size_t l = 0; l < count; l++) {
+                    px[l] = x + static_cast<float>(i + l) * step;
+                    py[l] = cy;
+                    pz[l] = cz;
+                    output[l] = 0.f;
+                }
+
+                float denom     = 0.f;
+                float frequency = mFrequency;
+                float amplitude = mAmplitude;
+
+                for (size_t o = 0; o < octaves; o++) {
+                    for (size_t l = 0; l < count; l++) {
+                        sx[l] = px[l] * frequency;
+                        sy[l] = py[l] * frequency;
+                        sz[l] = pz[l] * frequency;
+                    }
+                    kernels.noise3(hash, sx, sy, sz, value, count);
+                    for (size_t l = 0; l < count; l++) {
+                        output[l] += (amplitude * value[l]);
+                    }
+                    denom += amplitude;
+
+                    frequency *= mLacunarity;
+                    amplitude *= mPersistence;
+                }
+
+                float* row = out + j * strideY + k * strideZ + i;
+                for (size_t l = 0; l < count; l++) {
+                    row[l] = (output[l] / denom);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * fBm of 2D noise with its analytic gradient over a regular grid
+ *
+ * Sample (i,j) is fractalWithDerivative(octaves, x + i*step, y + j*step); its value is stored
+ * at out[i + j*strideY] and its derivatives at the same index of dx and dy.
+ *
+ * @param[in]  octaves  number of fraction of noise to sum
+ * @param[out] out      output values, rows of sizeX contiguous floats
+ * @param[out] dx       output derivatives along x, same layout as out
+ * @param[out] dy       output derivatives along y, same layout as out
+ * @param[in]  sizeX    number of samples along x
+ * @param[in]  sizeY    number of samples along y
+ * @param[in]  x        x coordinate of the first sample
+ * @param[in]  y        y coordinate of the first sample
+ * @param[in]  step     distance between two neighbouring samples
+ * @param[in]  strideY  distance in floats between two rows of the outputs
+ */
+void SimplexNoise::fractalGridWithDerivative(size_t octaves, float* out, float* dx, float* dy,
+                                             size_t sizeX, size_t sizeY,
+                                             float x, float y, float step, size_t strideY) const {
+    const BatchKernels& kernels = activeKernels();
+    const LatticeHash hash = { mPerm32, mSeed, mHashMode == HashMode::Integer };
+    float px[kGridBatch], py[kGridBatch];
+    float sx[kGridBatch], sy[kGridBatch];
+    float value[kGridBatch], vdx[kGridBatch], vdy[kGridBatch];
+    float output[kGridBatch], odx[kGridBatch], ody[kGridBatch];
+
+    for (size_t j = 0; j < sizeY; j++) {
+        const float cy = y + static_cast<float>(j) * step;
+        for (size_t i = 0; i < sizeX; i += kGridBatch) {
+            const size_t count = std::min(kGridBatch, sizeX - i);
+            for (size_t l = 0; l < count; l++) {
+                px[l] = x + static_cast<float>(i + l) * step;
+                py[l] = cy;
+                output[l] = odx[l] = ody[l] = 0.f;
+            }
+
+            float denom     = 0.f;
+            float frequency = mFrequency;
+            float amplitude = mAmplitude;
+
+            for (size_t o = 0; o < octaves; o++) {
+                for (size_t l = 0; l < count; l++) {
+                    sx[l] = px[l] * frequency;
+                    sy[l] = py[l] * frequency;
+                }
+                kernels.noise2Derivative(hash, sx, sy, value, vdx, vdy, count);
+                for (size_t l = 0; l < count; l++) {
+                    output[l] += (amplitude * value[l]);
+                    odx[l] += (amplitude * frequency) * vdx[l];
+                    ody[l] += (amplitude * frequency) * vdy[l];
+                }
+                denom += amplitude;
+
+                frequency *= mLacunarity;
+                amplitude *= mPersistence;
+            }
+
+            const size_t offset = j * strideY + i;
+            for (size_t l = 0; l < count; l++) {
+                out[offset + l] = (output[l] / denom);
+                dx[offset + l] = (odx[l] / denom);
+                dy[offset + l] = (ody[l] / denom);
+            }
+        }
+    }
+}
+
+/**
+ * fBm of 3D noise with its analytic gradient over a regular grid
+ *
+ * Sample (i,j,k) is fractalWithDerivative(octaves, x + i*step, y + j*step, z + k*step); its value
+ * is stored at out[i + j*strideY + k*strideZ] and its derivatives at the same index of dx, dy and dz.
+ *
+ * @param[in]  octaves  number of fraction of noise to sum
+ * @param[out] out      output values, rows of sizeX contiguous floats
+ * @param[out] dx       output derivatives along x, same layout as out
+ * @param[out] dy       output derivatives along y, same layout as out
+ * @param[out] dz       output derivatives along z, same layout as out
+ * @param[in]  sizeX    number of samples along x
+ * @param[in]  sizeY    number of samples along y
+ * @param[in]  sizeZ    number of samples along z
+ * @param[in]  x        x coordinate of the first sample
+ * @param[in]  y        y coordinate of the first sample
+ * @param[in]  z        z coordinate of the first sample
+ * @param[in]  step     distance between two neighbouring samples
+ * @param[in]  strideY  distance in floats between two rows of the outputs
+ * @param[in]  strideZ  distance in floats between two slices of the outputs
+ */
+void SimplexNoise::fractalGridWithDerivative(size_t octaves, float* out, float* dx, float* dy, float* dz,
+                                             size_t sizeX, size_t sizeY, size_t sizeZ,
+                                             float x, float y, float z, float step,
+                                             size_t strideY, size_t strideZ) const {
+    const BatchKernels& kernels = activeKernels();
+    const LatticeHash hash = { mPerm32, mSeed, mHashMode == HashMode::Integer };
+    float px[kGridBatch], py[kGridBatch], pz[kGridBatch];
+    float sx[kGridBatch], sy[kGridBatch], sz[kGridBatch];
+    float value[kGridBatch], vdx[kGridBatch], vdy[kGridBatch], vdz[kGridBatch];
+    float output[kGridBatch], odx[kGridBatch], ody[kGridBatch], odz[kGridBatch];
+
+    for (size_t k = 0; k < sizeZ; k++) {
+        const float cz = z + static_cast<float>(k) * step;
+        for (size_t j = 0; j < sizeY; j++) {
+            const float cy = y + static_cast<float>(j) * step;
+            for (size_t i = 0; i < sizeX; i += kGridBatch) {
+                const size_t count = std::min(kGridBatch, sizeX - i);
+                for (size_t l = 0; l < count; l++) {
+                    px[l] = x + static_cast<float>(i + l) * step;
+                    py[l] = cy;
+                    pz[l] = cz;
+                    output[l] = odx[l] = ody[l] = odz[l] = 0.f;
+                }
+
+                float denom     = 0.f;
+                float frequency = mFrequency;
+                float amplitude = mAmplitude;
+
+                for (size_t o = 0; o < octaves; o++) {
+                    for (size_t l = 0; l < count; l++) {
+                        sx[l] = px[l] * frequency;
+                        sy[l] = py[l] * frequency;
+                        sz[l] = pz[l] * frequency;
+                    }
+                    kernels.noise3Derivative(hash, sx, sy, sz, value, vdx, vdy, vdz, count);
+                    for (size_t l = 0; l < count; l++) {
+                        output[l] += (amplitude * value[l]);
+                        odx[l] += (amplitude * frequency) * vdx[l];
+                        ody[l] += (amplitude * frequency) * vdy[l];
+                        odz[l] += (amplitude * frequency) * vdz[l];
+                    }
+                    denom += amplitude;
+
+                    frequency *= mLacunarity;
+                    amplitude *= mPersistence;
+                }
+
+                const size_t offset = j * strideY + k * strideZ + i;
+                for (size_t l = 0; l < count; l++) {
+                    out[offset + l] = (output[l] / denom);
+                    dx[offset + l] = (odx[l] / denom);
+                    dy[offset + l] = (ody[l] / denom);
+                    dz[offset + l] = (odz[l] / denom);
+                }
+            }
+        }
+    }
+}
@@ -10,12 +10,45 @@
 #pragma once
 
 #include <cstddef>  // size_t
+#include <cstdint>  // int32_t/uint8_t/uint32_t
 
 /**
  * @brief A Perlin Simplex Noise C++ Implementation (1D, 2D, 3D, 4D).
  */
 class SimplexNoise {
 public:
+    /// Instruction sets available to the batch functions (widest supported one is used by default)
+    enum class Backend {
+        Scalar, ///< Calls the single point functions, always available
+        SSE2,   ///< 4 lanes, x86-64
+        AVX2,   ///< 8 lanes, x86-64 with a runtime CPU check
+        NEON    ///< 4 lanes, AArch64
+    };
+
+    /// How lattice coordinates are hashed into gradients
+    enum class HashMode {
+        Permutation, ///< 256 entry permutation table: fastest, repeats every 256 units
+        Integer      ///< Integer mixing hash: period of 2^32 units, for planet-scale coordinates
+    };
+
+    /// Noise value with its analytic gradient
+    struct Derivative2 {
+        float value;
+        float dx;
+        float dy;
+    };
+    struct Derivative3 {
+        float value;
+        float dx;
+        float dy;
+        float dz;
+    };
+
+    static bool isBackendSupported(Backend backend);
+    static bool setBackend(Backend backend);
+    static Backend getBackend();
+    static const char* backendName(Backend backend);
+
     // 1D Perlin simplex noise
     static float noise(float x);
     // 2D Perlin simplex noise
@@ -23,11 +56,61 @@ public:
     // 3D Perlin simplex noise
     static float noise(float x, float y, float z);
 
+    // 2D/3D Perlin simplex noise and its analytic gradient from a single evaluation
+    static Derivative2 noiseWithDerivative(float x, float y);
+    static Derivative3 noiseWithDerivative(float x, float y, float z);
+
+    // Perlin simplex noise using the instance seed and hash mode
+    float sample(float x) const;
+    float sample(float x, float y) const;
+    float sample(float x, float y, float z) const;
+
     // Fractal/Fractional Brownian Motion (fBm) noise summation
     float fractal(size_t octaves, float x) const;
     float fractal(size_t octaves, float x, float y) const;
     float fractal(size_t octaves, float x, float y, float z) const;
 
+    // Instance noise and fBm with their analytic gradient
+    Derivative2 sampleWithDerivative(float x, float y) const;
+    Derivative3 sampleWithDerivative(float x, float y, float z) const;
+    Derivative2 fractalWithDerivative(size_t octaves, float x, float y) const;
+    Derivative3 fractalWithDerivative(size_t octaves, float x, float y, float z) const;
+
+    // Derivative-damped ("swiss") fBm: octaves fade out where the accumulated slope is steep
+    float fractalDamped(size_t octaves, float x, float y, float damping = 1.0f) const;
+    float fractalDamped(size_t octaves, float x, float y, float z, float damping = 1.0f) const;
+
+    // Batched 2D/3D noise over structure-of-arrays coordinates (bit-identical to the functions above)
+    static void noise(const float* x, const float* y, float* out, size_t count);
+    static void noise(const float* x, const float* y, const float* z, float* out, size_t count);
+
+    // Batched sample() over structure-of-arrays coordinates
+    void sample(const float* x, const float* y, float* out, size_t count) const;
+    void sample(const float* x, const float* y, const float* z, float* out, size_t count) const;
+
+    // Batched fractal() over structure-of-arrays coordinates
+    void fractal(size_t octaves, const float* x, const float* y, const float* z, float* out, size_t count) const;
+
+    // Batched 2D/3D noise and fBm over a regular grid, written to a strided buffer
+    static void noiseGrid(float* out, size_t sizeX, size_t sizeY,
+                          float x, float y, float step, size_t strideY);
+    static void noiseGrid(float* out, size_t sizeX, size_t sizeY, size_t sizeZ,
+                          float x, float y, float z, float step, size_t strideY, size_t strideZ);
+    void sampleGrid(float* out, size_t sizeX, size_t sizeY,
+                    float x, float y, float step, size_t strideY) const;
+    void sampleGrid(float* out, size_t sizeX, size_t sizeY, size_t sizeZ,
+                    float x, float y, float z, float step, size_t strideY, size_t strideZ) const;
+    void fractalGrid(size_t octaves, float* out, size_t sizeX, size_t sizeY,
+                     float x, float y, float step, size_t strideY) const;
+    void fractalGrid(size_t octaves, float* out, size_t sizeX, size_t sizeY, size_t sizeZ,
+                     float x, float y, float z, float step, size_t strideY, size_t strideZ) const;
+    void fractalGridWithDerivative(size_t octaves, float* out, float* dx, float* dy,
+                                   size_t sizeX, size_t sizeY,
+                                   float x, float y, float step, size_t strideY) const;
+    void fractalGridWithDerivative(size_t octaves, float* out, float* dx, float* dy, float* dz,
+                                   size_t sizeX, size_t sizeY, size_t sizeZ,
+                                   float x, float y, float z, float step, size_t strideY, size_t strideZ) const;
+
     /**
      * Constructor of to initialize a fractal noise summation
      *
@@ -39,12 +122,15 @@ public:
     explicit SimplexNoise(float frequency = 1.0f,
                           float amplitude = 1.0f,
                           float lacunarity = 2.0f,
-                          float persistence = 0.5f) :
-        mFrequency(frequency),
-        mAmplitude(amplitude),
-        mLacunarity(lacunarity),
-        mPersistence(persistence) {
-    }
+                          float persistence = 0.5f);
+
+    // Seed the instance: reshuffles its permutation table and seeds the integer hash.
+    // Seed 0 is the default, Ken Perlin's table, so setSeed(getSeed()) changes nothing.
+    void setSeed(uint32_t seed);
+    uint32_t getSeed() const { return mSeed; }
+
+    void setHashMode(HashMode mode) { mHashMode = mode; }
+    HashMode getHashMode() const { return mHashMode; }
 
 private:
     // Parameters of Fractional Brownian Motion (fBm) : sum of N "octaves" of noise
@@ -52,4 +138,9 @@ private:
     float mAmplitude;   ///< Amplitude ("height") of the first octave of noise (default to 1.0)
     float mLacunarity;  ///< Lacunarity specifies the frequency multiplier between successive octaves (default to 2.0).
     float mPersistence; ///< Persistence is the loss of amplitude between successive octaves (usually 1/lacunarity)
+
+    HashMode mHashMode; ///< Permutation table (default) or integer hash
+    uint32_t mSeed;     ///< Seed of the permutation table and the integer hash (0 and Ken Perlin's table by default)
+    uint8_t mPerm[256]; ///< Per-instance permutation table, used by the scalar functions
+    int32_t mPerm32[256]; ///< Same table widened to 32-bit entries, used by the batch kernels
 };
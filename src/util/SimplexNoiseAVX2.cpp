@@ -0,0 +1,113 @@
+/**
+ * @file    SimplexNoiseAVX2.cpp
+ * @brief   AVX2 batch kernels for SimplexNoise (8 lanes).
+ *
+ * This file is compiled with -mavx2 (see CMakeLists.txt). Its kernels must
+ * only be reached through SimplexNoise.cpp, which checks that the CPU
+ * supports AVX2 first. FMA is deliberately not enabled: fused multiply-adds
+ * would round differently from the scalar code.
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "SimplexNoiseSIMD.h"
+
+#if defined(__x86_64__)
+
+#if !defined(__AVX2__)
+#error "SimplexNoiseAVX2.cpp must be compiled with -mavx2"
+#endif
+
+#include <immintrin.h>
+
+#include "SimplexNoiseKernels.h"
+
+namespace {
+
+/**
+ * AVX2 lanes: the permutation lookups use a 32-bit gather.
+ */
+struct AVX2Lanes {
+    typedef __m256  F;
+    typedef __m256i I;
+    typedef __m256  M;
+    static constexpr size_t width = 8;
+
+    static inline F load(const float* p) { return _mm256_loadu_ps(p); }
+    static inline void store(float* p, F v) { _mm256_storeu_ps(p, v); }
+    static inline F set(float v) { return _mm256_set1_ps(v); }
+    static inline I seti(int32_t v) { return _mm256_set1_epi32(v); }
+
+    static inline F add(F a, F b) { return _mm256_add_ps(a, b); }
+    static inline F sub(F a, F b) { return _mm256_sub_ps(a, b); }
+    static inline F mul(F a, F b) { return _mm256_mul_ps(a, b); }
+    static inline F neg(F a) { return _mm256_xor_ps(a, _mm256_set1_ps(-0.0f)); }
+
+    static inline M cmplt(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static inline M cmpgt(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static inline M cmpge(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    static inline M cmplti(I a, I b) { return _mm256_castsi256_ps(_mm256_cmpgt_epi32(b, a)); }
+    static inline M cmpeqi(I a, I b) { return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)); }
+
+    static inline M mand(M a, M b) { return _mm256_and_ps(a, b); }
+    static inline M mor(M a, M b) { return _mm256_or_ps(a, b); }
+    static inline M mnot(M a) { return _mm256_xor_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(-1))); }
+    static inline F select(M m, F a, F b) { return _mm256_blendv_ps(b, a, m); }
+    static inline I bit(M m) { return _mm256_and_si256(_mm256_castps_si256(m), _mm256_set1_epi32(1)); }
+
+    static inline I addi(I a, I b) { return _mm256_add_epi32(a, b); }
+    static inline I andi(I a, I b) { return _mm256_and_si256(a, b); }
+    static inline I xori(I a, I b) { return _mm256_xor_si256(a, b); }
+    static inline I muli(I a, I b) { return _mm256_mullo_epi32(a, b); }
+    template<int N> static inline I srli(I a) { return _mm256_srli_epi32(a, N); }
+    static inline F toFloat(I a) { return _mm256_cvtepi32_ps(a); }
+
+    // Truncate, then step down where the truncation rounded up (negative inputs)
+    static inline I fastfloor(F x) {
+        const I i = _mm256_cvttps_epi32(x);
+        return _mm256_add_epi32(i, _mm256_castps_si256(_mm256_cmp_ps(x, _mm256_cvtepi32_ps(i), _CMP_LT_OQ)));
+    }
+
+    static inline I lookup(const int32_t* table, I idx) {
+        return _mm256_i32gather_epi32(reinterpret_cast<const int*>(table), idx, 4);
+    }
+};
+
+} // namespace
+
+void SimplexNoiseSIMD::noise2AVX2(const LatticeHash& hash, const float* x, const float* y, float* out, size_t count) {
+    if (hash.integer) {
+        noiseBatch2<AVX2Lanes>(IntegerLanes<AVX2Lanes>{static_cast<int32_t>(hash.seed)}, x, y, out, count);
+    } else {
+        noiseBatch2<AVX2Lanes>(PermutationLanes<AVX2Lanes>{hash.perm}, x, y, out, count);
+    }
+}
+
+void SimplexNoiseSIMD::noise3AVX2(const LatticeHash& hash, const float* x, const float* y, const float* z, float* out, size_t count) {
+    if (hash.integer) {
+        noiseBatch3<AVX2Lanes>(IntegerLanes<AVX2Lanes>{static_cast<int32_t>(hash.seed)}, x, y, z, out, count);
+    } else {
+        noiseBatch3<AVX2Lanes>(PermutationLanes<AVX2Lanes>{hash.perm}, x, y, z, out, count);
+    }
+}
+
+void SimplexNoiseSIMD::noise2DerivativeAVX2(const LatticeHash& hash, const float* x, const float* y,
+                                            float* out, float* dx, float* dy, size_t count) {
+    if (hash.integer) {
+        noiseBatch2Derivative<AVX2Lanes>(IntegerLanes<AVX2Lanes>{static_cast<int32_t>(hash.seed)}, x, y, out, dx, dy, count);
+    } else {
+        noiseBatch2Derivative<AVX2Lanes>(PermutationLanes<AVX2Lanes>{hash.perm}, x, y, out, dx, dy, count);
+    }
+}
+
+void SimplexNoiseSIMD::noise3DerivativeAVX2(const LatticeHash& hash, const float* x, const float* y, const float* z,
+                                            float* out, float* dx, float* dy, float* dz, size_t count) {
+    if (hash.integer) {
+        noiseBatch3Derivative<AVX2Lanes>(IntegerLanes<AVX2Lanes>{static_cast<int32_t>(hash.seed)}, x, y, z, out, dx, dy, dz, count);
+    } else {
+        noiseBatch3Derivative<AVX2Lanes>(PermutationLanes<AVX2Lanes>{hash.perm}, x, y, z, out, dx, dy, dz, count);
+    }
+}
+
+#endif // __x86_64__
@@ -0,0 +1,452 @@
+/**
+ * @file    SimplexNoiseKernels.h
+ * @brief   Lane-generic batch kernels for SimplexNoise (internal header).
+ *
+ * The kernels below are written once against a small "lanes" interface
+ * (float vector F, integer vector I, comparison mask M) and a lattice hash
+ * policy, and instantiated by each instruction set translation unit
+ * (SSE2, AVX2, NEON).
+ *
+ * Every operation mirrors the scalar SimplexNoise::noise() code step by step,
+ * in the same order and with the same float rounding, so that a lane produces
+ * exactly the same bits as the scalar function for the same input.
+ * Do not reorder or "simplify" the arithmetic here without doing the same in
+ * SimplexNoise.cpp.
+ *
+ * This header must only be included from the SimplexNoise*.cpp kernel files,
+ * and must not pull in any library template: those translation units can be
+ * built with extra instruction set flags, and an out-of-line template instance
+ * compiled with them could be picked by the linker for the whole program.
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include <cstddef>  // size_t
+#include <cstdint>  // int32_t
+
+namespace {
+
+/**
+ * Hash a vector of integers through the permutation table
+ */
+template<class V>
+inline typename V::I permute(const int32_t* perm, typename V::I i) {
+    return V::lookup(perm, V::andi(i, V::seti(255)));
+}
+
+/**
+ * Lattice hash through the widened permutation table, see PermutationHash
+ */
+template<class V>
+struct PermutationLanes {
+    typedef typename V::I I;
+    const int32_t* perm;
+
+    inline I operator()(I i, I j) const {
+        return permute<V>(perm, V::addi(i, permute<V>(perm, j)));
+    }
+    inline I operator()(I i, I j, I k) const {
+        return permute<V>(perm, V::addi(i, permute<V>(perm, V::addi(j, permute<V>(perm, k)))));
+    }
+};
+
+/**
+ * Lattice hash by integer mixing, see IntegerHash
+ */
+template<class V>
+struct IntegerLanes {
+    typedef typename V::I I;
+    int32_t seed;
+
+    inline I operator()(I i, I j) const {
+        return (*this)(i, j, V::seti(0));
+    }
+    inline I operator()(I i, I j, I k) const {
+        I h = V::xori(V::xori(V::xori(V::seti(seed),
+            V::muli(i, V::seti(static_cast<int32_t>(0x8DA6B343u)))),
+            V::muli(j, V::seti(static_cast<int32_t>(0xD8163841u)))),
+            V::muli(k, V::seti(static_cast<int32_t>(0xCB1AB31Fu))));
+        h = V::xori(h, V::template srli<15>(h));
+        h = V::muli(h, V::seti(static_cast<int32_t>(0x2C1B3C6Du)));
+        h = V::xori(h, V::template srli<12>(h));
+        return V::template srli<24>(h);
+    }
+};
+
+/**
+ * Gradients-dot-residual vectors (2D), see grad(int32_t, float, float)
+ */
+template<class V>
+inline typename V::F grad2(typename V::I hash, typename V::F x, typename V::F y) {
+    const typename V::I h = V::andi(hash, V::seti(0x3F));
+    const typename V::M lo = V::cmplti(h, V::seti(4));
+    const typename V::F u = V::select(lo, x, y);
+    const typename V::F v = V::mul(V::set(2.0f), V::select(lo, y, x));
+    const typename V::M s1 = V::cmpeqi(V::andi(h, V::seti(1)), V::seti(1));
+    const typename V::M s2 = V::cmpeqi(V::andi(h, V::seti(2)), V::seti(2));
+    return V::add(V::select(s1, V::neg(u), u), V::select(s2, V::neg(v), v));
+}
+
+/**
+ * Gradients-dot-residual vectors (3D), see grad(int32_t, float, float, float)
+ */
+template<class V>
+inline typename V::F grad3(typename V::I hash, typename V::F x, typename V::F y, typename V::F z) {
+    const typename V::I h = V::andi(hash, V::seti(15));
+    const typename V::M h12or14 = V::mor(V::cmpeqi(h, V::seti(12)), V::cmpeqi(h, V::seti(14)));
+    const typename V::F u = V::select(V::cmplti(h, V::seti(8)), x, y);
+    const typename V::F v = V::select(V::cmplti(h, V::seti(4)), y, V::select(h12or14, x, z));
+    const typename V::M s1 = V::cmpeqi(V::andi(h, V::seti(1)), V::seti(1));
+    const typename V::M s2 = V::cmpeqi(V::andi(h, V::seti(2)), V::seti(2));
+    return V::add(V::select(s1, V::neg(u), u), V::select(s2, V::neg(v), v));
+}
+
+/**
+ * Gradient vector used by grad2() (its dot product with (x,y)), see gradVector(int32_t, float&, float&)
+ */
+template<class V>
+inline void gradVector2(typename V::I hash, typename V::F& gx, typename V::F& gy) {
+    const typename V::I h = V::andi(hash, V::seti(0x3F));
+    const typename V::M lo = V::cmplti(h, V::seti(4));
+    const typename V::F su = V::select(V::cmpeqi(V::andi(h, V::seti(1)), V::seti(1)), V::set(-1.0f), V::set(1.0f));
+    const typename V::F sv = V::select(V::cmpeqi(V::andi(h, V::seti(2)), V::seti(2)), V::set(-2.0f), V::set(2.0f));
+    gx = V::select(lo, su, sv);
+    gy = V::select(lo, sv, su);
+}
+
+/**
+ * Gradient vector used by grad3() (its dot product with (x,y,z)), see gradVector(int32_t, float&, float&, float&)
+ */
+template<class V>
+inline void gradVector3(typename V::I hash, typename V::F& gx, typename V::F& gy, typename V::F& gz) {
+    const typename V::I h = V::andi(hash, V::seti(15));
+    const typename V::M lo8 = V::cmplti(h, V::seti(8));
+    const typename V::M lo4 = V::cmplti(h, V::seti(4));
+    const typename V::M h12or14 = V::mor(V::cmpeqi(h, V::seti(12)), V::cmpeqi(h, V::seti(14)));
+    const typename V::F su = V::select(V::cmpeqi(V::andi(h, V::seti(1)), V::seti(1)), V::set(-1.0f), V::set(1.0f));
+    const typename V::F sv = V::select(V::cmpeqi(V::andi(h, V::seti(2)), V::seti(2)), V::set(-1.0f), V::set(1.0f));
+    const typename V::F zero = V::set(0.0f);
+    gx = V::select(lo8, su, V::select(V::mand(V::mnot(lo4), h12or14), sv, zero));
+    gy = V::select(lo8, V::select(lo4, sv, zero), su);
+    gz = V::select(V::mand(V::mnot(lo4), V::mnot(h12or14)), sv, zero);
+}
+
+/**
+ * Contribution of one simplex corner, given its falloff term t
+ */
+template<class V>
+inline typename V::F corner(typename V::F t, typename V::F g) {
+    const typename V::F t2 = V::mul(t, t);
+    const typename V::F n = V::mul(V::mul(t2, t2), g);
+    return V::select(V::cmplt(t, V::set(0.0f)), V::set(0.0f), n);
+}
+
+/**
+ * Contribution of one simplex corner and its derivative along one axis:
+ * t^4 * g - 8 * t^3 * (g.r) * r, zero outside of the corner's radius
+ */
+template<class V>
+inline typename V::F cornerDerivative(typename V::F t, typename V::F gdot, typename V::F g, typename V::F r) {
+    const typename V::F t2 = V::mul(t, t);
+    const typename V::F temp = V::mul(V::mul(t2, t), gdot);
+    const typename V::F d = V::sub(V::mul(V::mul(t2, t2), g), V::mul(V::mul(V::set(8.0f), temp), r));
+    return V::select(V::cmplt(t, V::set(0.0f)), V::set(0.0f), d);
+}
+
+/**
+ * The three corners of the 2D simplex containing (x,y): offsets, falloff terms and hashes,
+ * see SimplexNoise::noise(float, float)
+ */
+template<class V>
+struct Simplex2 {
+    typedef typename V::F F;
+    typedef typename V::I I;
+
+    F x[3], y[3], t[3];
+    I h[3];
+
+    template<class H>
+    inline Simplex2(const H& hash, F px, F py) {
+        const float F2 = 0.366025403f;
+        const float G2 = 0.211324865f;
+
+        // Skew the input space to determine which simplex cell we're in
+        const F s = V::mul(V::add(px, py), V::set(F2));
+        const I i = V::fastfloor(V::add(px, s));
+        const I j = V::fastfloor(V::add(py, s));
+
+        // Unskew the cell origin back to (x,y) space
+        const F u = V::mul(V::toFloat(V::addi(i, j)), V::set(G2));
+        x[0] = V::sub(px, V::sub(V::toFloat(i), u));
+        y[0] = V::sub(py, V::sub(V::toFloat(j), u));
+
+        // Lower (XY order) or upper (YX order) triangle
+        const typename V::M lower = V::cmpgt(x[0], y[0]);
+        const I i1 = V::bit(lower);
+        const I j1 = V::bit(V::mnot(lower));
+
+        x[1] = V::add(V::sub(x[0], V::toFloat(i1)), V::set(G2));
+        y[1] = V::add(V::sub(y[0], V::toFloat(j1)), V::set(G2));
+        x[2] = V::add(V::sub(x[0], V::set(1.0f)), V::set(2.0f * G2));
+        y[2] = V::add(V::sub(y[0], V::set(1.0f)), V::set(2.0f * G2));
+
+        // Hashed gradient indices of the three simplex corners
+        const I one = V::seti(1);
+        h[0] = hash(i, j);
+        h[1] = hash(V::addi(i, i1), V::addi(j, j1));
+        h[2] = hash(V::addi(i, one), V::addi(j, one));
+
+        for (int c = 0; c < 3; c++) {
+            t[c] = V::sub(V::sub(V::set(0.5f), V::mul(x[c], x[c])), V::mul(y[c], y[c]));
+        }
+    }
+};
+
+/**
+ * The four corners of the 3D simplex containing (x,y,z): offsets, falloff terms and hashes,
+ * see SimplexNoise::noise(float, float, float)
+ */
+template<class V>
+struct Simplex3 {
+    typedef typename V::F F;
+    typedef typename V::I I;
+    typedef typename V::M M;
+
+    F x[4], y[4], z[4], t[4];
+    I h[4];
+
+    template<class H>
+    inline Simplex3(const H& hash, F px, F py, F pz) {
+        const float F3 = 1.0f / 3.0f;
+        const float G3 = 1.0f / 6.0f;
+
+        // Skew the input space to determine which simplex cell we're in
+        const F s = V::mul(V::add(V::add(px, py), pz), V::set(F3));
+        const I i = V::fastfloor(V::add(px, s));
+        const I j = V::fastfloor(V::add(py, s));
+        const I k = V::fastfloor(V::add(pz, s));
+        const F u = V::mul(V::toFloat(V::addi(V::addi(i, j), k)), V::set(G3));
+        x[0] = V::sub(px, V::sub(V::toFloat(i), u));
+        y[0] = V::sub(py, V::sub(V::toFloat(j), u));
+        z[0] = V::sub(pz, V::sub(V::toFloat(k), u));
+
+        // Branch-free version of the rank ordering in the scalar code
+        const M xy = V::cmpge(x[0], y[0]);
+        const M yz = V::cmpge(y[0], z[0]);
+        const M xz = V::cmpge(x[0], z[0]);
+        const I i1 = V::bit(V::mand(xy, xz));
+        const I j1 = V::bit(V::mand(V::mnot(xy), yz));
+        const I k1 = V::bit(V::mnot(V::mor(xz, yz)));
+        const I i2 = V::bit(V::mor(xy, xz));
+        const I j2 = V::bit(V::mor(V::mnot(xy), yz));
+        const I k2 = V::bit(V::mnot(V::mand(xz, yz)));
+
+        x[1] = V::add(V::sub(x[0], V::toFloat(i1)), V::set(G3));
+        y[1] = V::add(V::sub(y[0], V::toFloat(j1)), V::set(G3));
+        z[1] = V::add(V::sub(z[0], V::toFloat(k1)), V::set(G3));
+        x[2] = V::add(V::sub(x[0], V::toFloat(i2)), V::set(2.0f * G3));
+        y[2] = V::add(V::sub(y[0], V::toFloat(j2)), V::set(2.0f * G3));
+        z[2] = V::add(V::sub(z[0], V::toFloat(k2)), V::set(2.0f * G3));
+        x[3] = V::add(V::sub(x[0], V::set(1.0f)), V::set(3.0f * G3));
+        y[3] = V::add(V::sub(y[0], V::set(1.0f)), V::set(3.0f * G3));
+        z[3] = V::add(V::sub(z[0], V::set(1.0f)), V::set(3.0f * G3));
+
+        // Hashed gradient indices of the four simplex corners
+        const I one = V::seti(1);
+        h[0] = hash(i, j, k);
+        h[1] = hash(V::addi(i, i1), V::addi(j, j1), V::addi(k, k1));
+        h[2] = hash(V::addi(i, i2), V::addi(j, j2), V::addi(k, k2));
+        h[3] = hash(V::addi(i, one), V::addi(j, one), V::addi(k, one));
+
+        for (int c = 0; c < 4; c++) {
+            t[c] = V::sub(V::sub(V::sub(V::set(0.6f), V::mul(x[c], x[c])), V::mul(y[c], y[c])), V::mul(z[c], z[c]));
+        }
+    }
+};
+
+/**
+ * 2D Perlin simplex noise on V::width lanes, see SimplexNoise::noise(float, float)
+ */
+template<class V, class H>
+inline typename V::F noise2(const H& hash, typename V::F x, typename V::F y) {
+    const Simplex2<V> s(hash, x, y);
+    typename V::F n[3];
+    for (int c = 0; c < 3; c++) {
+        n[c] = corner<V>(s.t[c], grad2<V>(s.h[c], s.x[c], s.y[c]));
+    }
+    return V::mul(V::set(45.23065f), V::add(V::add(n[0], n[1]), n[2]));
+}
+
+/**
+ * 3D Perlin simplex noise on V::width lanes, see SimplexNoise::noise(float, float, float)
+ */
+template<class V, class H>
+inline typename V::F noise3(const H& hash, typename V::F x, typename V::F y, typename V::F z) {
+    const Simplex3<V> s(hash, x, y, z);
+    typename V::F n[4];
+    for (int c = 0; c < 4; c++) {
+        n[c] = corner<V>(s.t[c], grad3<V>(s.h[c], s.x[c], s.y[c], s.z[c]));
+    }
+    return V::mul(V::set(32.0f), V::add(V::add(V::add(n[0], n[1]), n[2]), n[3]));
+}
+
+/**
+ * 2D Perlin simplex noise and its analytic gradient on V::width lanes, see noise2DDerivative()
+ */
+template<class V, class H>
+inline typename V::F noise2Derivative(const H& hash, typename V::F x, typename V::F y,
+                                      typename V::F& dx, typename V::F& dy) {
+    const Simplex2<V> s(hash, x, y);
+    typename V::F n[3], ddx[3], ddy[3];
+    for (int c = 0; c < 3; c++) {
+        typename V::F gx, gy;
+        gradVector2<V>(s.h[c], gx, gy);
+        const typename V::F gdot = grad2<V>(s.h[c], s.x[c], s.y[c]);
+        n[c] = corner<V>(s.t[c], gdot);
+        ddx[c] = cornerDerivative<V>(s.t[c], gdot, gx, s.x[c]);
+        ddy[c] = cornerDerivative<V>(s.t[c], gdot, gy, s.y[c]);
+    }
+    const typename V::F scale = V::set(45.23065f);
+    dx = V::mul(scale, V::add(V::add(ddx[0], ddx[1]), ddx[2]));
+    dy = V::mul(scale, V::add(V::add(ddy[0], ddy[1]), ddy[2]));
+    return V::mul(scale, V::add(V::add(n[0], n[1]), n[2]));
+}
+
+/**
+ * 3D Perlin simplex noise and its analytic gradient on V::width lanes, see noise3DDerivative()
+ */
+template<class V, class H>
+inline typename V::F noise3Derivative(const H& hash, typename V::F x, typename V::F y, typename V::F z,
+                                      typename V::F& dx, typename V::F& dy, typename V::F& dz) {
+    const Simplex3<V> s(hash, x, y, z);
+    typename V::F n[4], ddx[4], ddy[4], ddz[4];
+    for (int c = 0; c < 4; c++) {
+        typename V::F gx, gy, gz;
+        gradVector3<V>(s.h[c], gx, gy, gz);
+        const typename V::F gdot = grad3<V>(s.h[c], s.x[c], s.y[c], s.z[c]);
+        n[c] = corner<V>(s.t[c], gdot);
+        ddx[c] = cornerDerivative<V>(s.t[c], gdot, gx, s.x[c]);
+        ddy[c] = cornerDerivative<V>(s.t[c], gdot, gy, s.y[c]);
+        ddz[c] = cornerDerivative<V>(s.t[c], gdot, gz, s.z[c]);
+    }
+    const typename V::F scale = V::set(32.0f);
+    dx = V::mul(scale, V::add(V::add(V::add(ddx[0], ddx[1]), ddx[2]), ddx[3]));
+    dy = V::mul(scale, V::add(V::add(V::add(ddy[0], ddy[1]), ddy[2]), ddy[3]));
+    dz = V::mul(scale, V::add(V::add(V::add(ddz[0], ddz[1]), ddz[2]), ddz[3]));
+    return V::mul(scale, V::add(V::add(V::add(n[0], n[1]), n[2]), n[3]));
+}
+
+/**
+ * Evaluate 2D noise over structure-of-arrays coordinates, padding the tail
+ */
+template<class V, class H>
+inline void noiseBatch2(const H& hash, const float* x, const float* y, float* out, size_t count) {
+    size_t n = 0;
+    for (; n + V::width <= count; n += V::width) {
+        V::store(out + n, noise2<V>(hash, V::load(x + n), V::load(y + n)));
+    }
+    if (n < count) {
+        float bx[V::width] = {0.0f}, by[V::width] = {0.0f}, bo[V::width];
+        for (size_t l = 0; n + l < count; l++) {
+            bx[l] = x[n + l];
+            by[l] = y[n + l];
+        }
+        V::store(bo, noise2<V>(hash, V::load(bx), V::load(by)));
+        for (size_t l = 0; n + l < count; l++) {
+            out[n + l] = bo[l];
+        }
+    }
+}
+
+/**
+ * Evaluate 3D noise over structure-of-arrays coordinates, padding the tail
+ */
+template<class V, class H>
+inline void noiseBatch3(const H& hash, const float* x, const float* y, const float* z, float* out, size_t count) {
+    size_t n = 0;
+    for (; n + V::width <= count; n += V::width) {
+        V::store(out + n, noise3<V>(hash, V::load(x + n), V::load(y + n), V::load(z + n)));
+    }
+    if (n < count) {
+        float bx[V::width] = {0.0f}, by[V::width] = {0.0f}, bz[V::width] = {0.0f}, bo[V::width];
+        for (size_t l = 0; n + l < count; l++) {
+            bx[l] = x[n + l];
+            by[l] = y[n + l];
+            bz[l] = z[n + l];
+        }
+        V::store(bo, noise3<V>(hash, V::load(bx), V::load(by), V::load(bz)));
+        for (size_t l = 0; n + l < count; l++) {
+            out[n + l] = bo[l];
+        }
+    }
+}
+
+/**
+ * Evaluate 2D noise and its gradient over structure-of-arrays coordinates, padding the tail
+ */
+template<class V, class H>
+inline void noiseBatch2Derivative(const H& hash, const float* x, const float* y,
+                                  float* out, float* dx, float* dy, size_t count) {
+    typename V::F gx, gy;
+    size_t n = 0;
+    for (; n + V::width <= count; n += V::width) {
+        V::store(out + n, noise2Derivative<V>(hash, V::load(x + n), V::load(y + n), gx, gy));
+        V::store(dx + n, gx);
+        V::store(dy + n, gy);
+    }
+    if (n < count) {
+        float bx[V::width] = {0.0f}, by[V::width] = {0.0f};
+        float bo[V::width], bdx[V::width], bdy[V::width];
+        for (size_t l = 0; n + l < count; l++) {
+            bx[l] = x[n + l];
+            by[l] = y[n + l];
+        }
+        V::store(bo, noise2Derivative<V>(hash, V::load(bx), V::load(by), gx, gy));
+        V::store(bdx, gx);
+        V::store(bdy, gy);
+        for (size_t l = 0; n + l < count; l++) {
+            out[n + l] = bo[l];
+            dx[n + l] = bdx[l];
+            dy[n + l] = bdy[l];
+        }
+    }
+}
+
+/**
+ * Evaluate 3D noise and its gradient over structure-of-arrays coordinates, padding the tail
+ */
+template<class V, class H>
+inline void noiseBatch3Derivative(const H& hash, const float* x, const float* y, const float* z,
+                                  float* out, float* dx, float* dy, float* dz, size_t count) {
+    typename V::F gx, gy, gz;
+    size_t n = 0;
+    for (; n + V::width <= count; n += V::width) {
+        V::store(out + n, noise3Derivative<V>(hash, V::load(x + n), V::load(y + n), V::load(z + n), gx, gy, gz));
+        V::store(dx + n, gx);
+        V::store(dy + n, gy);
+        V::store(dz + n, gz);
+    }
+    if (n < count) {
+        float bx[V::width] = {0.0f}, by[V::width] = {0.0f}, bz[V::width] = {0.0f};
+        float bo[V::width], bdx[V::width], bdy[V::width], bdz[V::width];
+        for (size_t l = 0; n + l < count; l++) {
+            bx[l] = x[n + l];
+            by[l] = y[n + l];
+            bz[l] = z[n + l];
+        }
+        V::store(bo, noise3Derivative<V>(hash, V::load(bx), V::load(by), V::load(bz), gx, gy, gz));
+        V::store(bdx, gx);
+        V::store(bdy, gy);
+        V::store(bdz, gz);
+        for (size_t l = 0; n + l < count; l++) {
+            out[n + l] = bo[l];
+            dx[n + l] = bdx[l];
+            dy[n + l] = bdy[l];
+            dz[n + l] = bdz[l];
+        }
+    }
+}
+
+} // namespace
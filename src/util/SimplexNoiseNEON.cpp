@@ -0,0 +1,110 @@
+/**
+ * @file    SimplexNoiseNEON.cpp
+ * @brief   NEON batch kernels for SimplexNoise (4 lanes).
+ *
+ * Only built for AArch64, where NEON float arithmetic is IEEE compliant;
+ * 32-bit ARM NEON flushes denormals and would not match the scalar code.
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "SimplexNoiseSIMD.h"
+
+#if defined(__aarch64__)
+
+#include <arm_neon.h>
+
+#include "SimplexNoiseKernels.h"
+
+namespace {
+
+/**
+ * NEON lanes: comparisons produce unsigned masks, lookups go through memory.
+ */
+struct NEONLanes {
+    typedef float32x4_t F;
+    typedef int32x4_t   I;
+    typedef uint32x4_t  M;
+    static constexpr size_t width = 4;
+
+    static inline F load(const float* p) { return vld1q_f32(p); }
+    static inline void store(float* p, F v) { vst1q_f32(p, v); }
+    static inline F set(float v) { return vdupq_n_f32(v); }
+    static inline I seti(int32_t v) { return vdupq_n_s32(v); }
+
+    static inline F add(F a, F b) { return vaddq_f32(a, b); }
+    static inline F sub(F a, F b) { return vsubq_f32(a, b); }
+    static inline F mul(F a, F b) { return vmulq_f32(a, b); }
+    static inline F neg(F a) { return vnegq_f32(a); }
+
+    static inline M cmplt(F a, F b) { return vcltq_f32(a, b); }
+    static inline M cmpgt(F a, F b) { return vcgtq_f32(a, b); }
+    static inline M cmpge(F a, F b) { return vcgeq_f32(a, b); }
+    static inline M cmplti(I a, I b) { return vcltq_s32(a, b); }
+    static inline M cmpeqi(I a, I b) { return vceqq_s32(a, b); }
+
+    static inline M mand(M a, M b) { return vandq_u32(a, b); }
+    static inline M mor(M a, M b) { return vorrq_u32(a, b); }
+    static inline M mnot(M a) { return vmvnq_u32(a); }
+    static inline F select(M m, F a, F b) { return vbslq_f32(m, a, b); }
+    static inline I bit(M m) { return vreinterpretq_s32_u32(vandq_u32(m, vdupq_n_u32(1))); }
+
+    static inline I addi(I a, I b) { return vaddq_s32(a, b); }
+    static inline I andi(I a, I b) { return vandq_s32(a, b); }
+    static inline I xori(I a, I b) { return veorq_s32(a, b); }
+    static inline I muli(I a, I b) { return vmulq_s32(a, b); }
+    template<int N> static inline I srli(I a) { return vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(a), N)); }
+    static inline F toFloat(I a) { return vcvtq_f32_s32(a); }
+
+    // Truncate, then step down where the truncation rounded up (negative inputs)
+    static inline I fastfloor(F x) {
+        const I i = vcvtq_s32_f32(x);
+        return vaddq_s32(i, vreinterpretq_s32_u32(vcltq_f32(x, vcvtq_f32_s32(i))));
+    }
+
+    static inline I lookup(const int32_t* table, I idx) {
+        int32_t v[4];
+        vst1q_s32(v, idx);
+        const int32_t r[4] = { table[v[0]], table[v[1]], table[v[2]], table[v[3]] };
+        return vld1q_s32(r);
+    }
+};
+
+} // namespace
+
+void SimplexNoiseSIMD::noise2NEON(const LatticeHash& hash, const float* x, const float* y, float* out, size_t count) {
+    if (hash.integer) {
+        noiseBatch2<NEONLanes>(IntegerLanes<NEONLanes>{static_cast<int32_t>(hash.seed)}, x, y, out, count);
+    } else {
+        noiseBatch2<NEONLanes>(PermutationLanes<NEONLanes>{hash.perm}, x, y, out, count);
+    }
+}
+
+void SimplexNoiseSIMD::noise3NEON(const LatticeHash& hash, const float* x, const float* y, const float* z, float* out, size_t count) {
+    if (hash.integer) {
+        noiseBatch3<NEONLanes>(IntegerLanes<NEONLanes>{static_cast<int32_t>(hash.seed)}, x, y, z, out, count);
+    } else {
+        noiseBatch3<NEONLanes>(PermutationLanes<NEONLanes>{hash.perm}, x, y, z, out, count);
+    }
+}
+
+void SimplexNoiseSIMD::noise2DerivativeNEON(const LatticeHash& hash, const float* x, const float* y,
+                                            float* out, float* dx, float* dy, size_t count) {
+    if (hash.integer) {
+        noiseBatch2Derivative<NEONLanes>(IntegerLanes<NEONLanes>{static_cast<int32_t>(hash.seed)}, x, y, out, dx, dy, count);
+    } else {
+        noiseBatch2Derivative<NEONLanes>(PermutationLanes<NEONLanes>{hash.perm}, x, y, out, dx, dy, count);
+    }
+}
+
+void SimplexNoiseSIMD::noise3DerivativeNEON(const LatticeHash& hash, const float* x, const float* y, const float* z,
+                                            float* out, float* dx, float* dy, float* dz, size_t count) {
+    if (hash.integer) {
+        noiseBatch3Derivative<NEONLanes>(IntegerLanes<NEONLanes>{static_cast<int32_t>(hash.seed)}, x, y, z, out, dx, dy, dz, count);
+    } else {
+        noiseBatch3Derivative<NEONLanes>(PermutationLanes<NEONLanes>{hash.perm}, x, y, z, out, dx, dy, dz, count);
+    }
+}
+
+#endif // __aarch64__
@@ -0,0 +1,55 @@
+/**
+ * @file    SimplexNoiseSIMD.h
+ * @brief   Instruction set specific batch kernels for SimplexNoise (internal header).
+ *
+ * Each kernel evaluates noise over structure-of-arrays coordinates with the
+ * given lattice hash, and is bit-identical to the scalar noise.
+ * The kernels only exist for the instruction sets the target can run;
+ * SimplexNoise.cpp picks the widest one supported at runtime.
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include <cstddef>  // size_t
+#include <cstdint>  // int32_t
+
+namespace SimplexNoiseSIMD {
+
+/// Lattice hash used by a batch, mirrors SimplexNoise::HashMode
+struct LatticeHash {
+    const int32_t* perm;    ///< widened permutation table (HashMode::Permutation)
+    uint32_t seed;          ///< seed of the integer hash (HashMode::Integer)
+    bool integer;           ///< use the integer hash instead of the table
+};
+
+#if defined(__x86_64__)
+// 4 lanes, baseline on x86-64 (SimplexNoiseSSE2.cpp)
+void noise2SSE2(const LatticeHash& hash, const float* x, const float* y, float* out, size_t count);
+void noise3SSE2(const LatticeHash& hash, const float* x, const float* y, const float* z, float* out, size_t count);
+void noise2DerivativeSSE2(const LatticeHash& hash, const float* x, const float* y,
+                        float* out, float* dx, float* dy, size_t count);
+void noise3DerivativeSSE2(const LatticeHash& hash, const float* x, const float* y, const float* z,
+                        float* out, float* dx, float* dy, float* dz, size_t count);
+
+// 8 lanes, built with -mavx2 and only called after a runtime CPU check (SimplexNoiseAVX2.cpp)
+void noise2AVX2(const LatticeHash& hash, const float* x, const float* y, float* out, size_t count);
+void noise3AVX2(const LatticeHash& hash, const float* x, const float* y, const float* z, float* out, size_t count);
+void noise2DerivativeAVX2(const LatticeHash& hash, const float* x, const float* y,
+                        float* out, float* dx, float* dy, size_t count);
+void noise3DerivativeAVX2(const LatticeHash& hash, const float* x, const float* y, const float* z,
+                        float* out, float* dx, float* dy, float* dz, size_t count);
+#endif
+
+#if defined(__aarch64__)
+// 4 lanes, baseline on AArch64 (SimplexNoiseNEON.cpp)
+void noise2NEON(const LatticeHash& hash, const float* x, const float* y, float* out, size_t count);
+void noise3NEON(const LatticeHash& hash, const float* x, const float* y, const float* z, float* out, size_t count);
+void noise2DerivativeNEON(const LatticeHash& hash, const float* x, const float* y,
+                        float* out, float* dx, float* dy, size_t count);
+void noise3DerivativeNEON(const LatticeHash& hash, const float* x, const float* y, const float* z,
+                        float* out, float* dx, float* dy, float* dz, size_t count);
+#endif
+
+} // namespace SimplexNoiseSIMD
@@ -0,0 +1,115 @@
+/**
+ * @file    SimplexNoiseSSE2.cpp
+ * @brief   SSE2 batch kernels for SimplexNoise (4 lanes).
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "SimplexNoiseSIMD.h"
+
+#if defined(__x86_64__)
+
+#include <emmintrin.h>
+
+#include "SimplexNoiseKernels.h"
+
+namespace {
+
+/**
+ * SSE2 lanes: masks are kept as float vectors, integer compares are cast back.
+ * SSE2 has neither blendv nor gather, so selects are and/andnot/or and the
+ * permutation lookups go through memory.
+ */
+struct SSE2Lanes {
+    typedef __m128  F;
+    typedef __m128i I;
+    typedef __m128  M;
+    static constexpr size_t width = 4;
+
+    static inline F load(const float* p) { return _mm_loadu_ps(p); }
+    static inline void store(float* p, F v) { _mm_storeu_ps(p, v); }
+    static inline F set(float v) { return _mm_set1_ps(v); }
+    static inline I seti(int32_t v) { return _mm_set1_epi32(v); }
+
+    static inline F add(F a, F b) { return _mm_add_ps(a, b); }
+    static inline F sub(F a, F b) { return _mm_sub_ps(a, b); }
+    static inline F mul(F a, F b) { return _mm_mul_ps(a, b); }
+    static inline F neg(F a) { return _mm_xor_ps(a, _mm_set1_ps(-0.0f)); }
+
+    static inline M cmplt(F a, F b) { return _mm_cmplt_ps(a, b); }
+    static inline M cmpgt(F a, F b) { return _mm_cmpgt_ps(a, b); }
+    static inline M cmpge(F a, F b) { return _mm_cmpge_ps(a, b); }
+    static inline M cmplti(I a, I b) { return _mm_castsi128_ps(_mm_cmplt_epi32(a, b)); }
+    static inline M cmpeqi(I a, I b) { return _mm_castsi128_ps(_mm_cmpeq_epi32(a, b)); }
+
+    static inline M mand(M a, M b) { return _mm_and_ps(a, b); }
+    static inline M mor(M a, M b) { return _mm_or_ps(a, b); }
+    static inline M mnot(M a) { return _mm_xor_ps(a, _mm_castsi128_ps(_mm_set1_epi32(-1))); }
+    static inline F select(M m, F a, F b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+    static inline I bit(M m) { return _mm_and_si128(_mm_castps_si128(m), _mm_set1_epi32(1)); }
+
+    static inline I addi(I a, I b) { return _mm_add_epi32(a, b); }
+    static inline I andi(I a, I b) { return _mm_and_si128(a, b); }
+    static inline I xori(I a, I b) { return _mm_xor_si128(a, b); }
+    template<int N> static inline I srli(I a) { return _mm_srli_epi32(a, N); }
+
+    // SSE2 has no 32-bit mullo: multiply even and odd lanes separately and interleave the low halves
+    static inline I muli(I a, I b) {
+        const I even = _mm_mul_epu32(a, b);
+        const I odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+        return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                  _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+    }
+    static inline F toFloat(I a) { return _mm_cvtepi32_ps(a); }
+
+    // Truncate, then step down where the truncation rounded up (negative inputs)
+    static inline I fastfloor(F x) {
+        const I i = _mm_cvttps_epi32(x);
+        return _mm_add_epi32(i, _mm_castps_si128(_mm_cmplt_ps(x, _mm_cvtepi32_ps(i))));
+    }
+
+    static inline I lookup(const int32_t* table, I idx) {
+        alignas(16) int32_t v[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(v), idx);
+        return _mm_setr_epi32(table[v[0]], table[v[1]], table[v[2]], table[v[3]]);
+    }
+};
+
+} // namespace
+
+void SimplexNoiseSIMD::noise2SSE2(const LatticeHash& hash, const float* x, const float* y, float* out, size_t count) {
+    if (hash.integer) {
+        noiseBatch2<SSE2Lanes>(IntegerLanes<SSE2Lanes>{static_cast<int32_t>(hash.seed)}, x, y, out, count);
+    } else {
+        noiseBatch2<SSE2Lanes>(PermutationLanes<SSE2Lanes>{hash.perm}, x, y, out, count);
+    }
+}
+
+void SimplexNoiseSIMD::noise3SSE2(const LatticeHash& hash, const float* x, const float* y, const float* z, float* out, size_t count) {
+    if (hash.integer) {
+        noiseBatch3<SSE2Lanes>(IntegerLanes<SSE2Lanes>{static_cast<int32_t>(hash.seed)}, x, y, z, out, count);
+    } else {
+        noiseBatch3<SSE2Lanes>(PermutationLanes<SSE2Lanes>{hash.perm}, x, y, z, out, count);
+    }
+}
+
+void SimplexNoiseSIMD::noise2DerivativeSSE2(const LatticeHash& hash, const float* x, const float* y,
+                                            float* out, float* dx, float* dy, size_t count) {
+    if (hash.integer) {
+        noiseBatch2Derivative<SSE2Lanes>(IntegerLanes<SSE2Lanes>{static_cast<int32_t>(hash.seed)}, x, y, out, dx, dy, count);
+    } else {
+        noiseBatch2Derivative<SSE2Lanes>(PermutationLanes<SSE2Lanes>{hash.perm}, x, y, out, dx, dy, count);
+    }
+}
+
+void SimplexNoiseSIMD::noise3DerivativeSSE2(const LatticeHash& hash, const float* x, const float* y, const float* z,
+                                            float* out, float* dx, float* dy, float* dz, size_t count) {
+    if (hash.integer) {
+        noiseBatch3Derivative<SSE2Lanes>(IntegerLanes<SSE2Lanes>{static_cast<int32_t>(hash.seed)}, x, y, z, out, dx, dy, dz, count);
+    } else {
+        noiseBatch3Derivative<SSE2Lanes>(PermutationLanes<SSE2Lanes>{hash.perm}, x, y, z, out, dx, dy, dz, count);
+    }
+}
+
+#endif // __x86_64__
@@ -0,0 +1,162 @@
+/**
+ * @file    ThreadPool.cpp
+ * @brief   Work-stealing thread pool for data-parallel loops
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "util/ThreadPool.h"
+
+#include <algorithm>
+
+// One parallelFor() call; lives on the caller's stack until all of its tasks ran
+struct ThreadPool::Batch {
+	const std::function<void(size_t)>* fn;
+	std::atomic<size_t> remaining;
+	std::mutex mutex;
+	std::condition_variable done;
+};
+
+ThreadPool::ThreadPool(size_t threads) : m_queued(0), m_steals(0), m_stop(false)
+{
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+
+	for (size_t i = 1; i < threads; i++)
+		m_workers.emplace_back(new Worker());
+
+	for (size_t i = 0; i < m_workers.size(); i++)
+		m_workers[i]->thread = std::thread(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+
+	for (auto& worker : m_workers)
+		worker->thread.join();
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& fn)
+{
+	if (count == 0)
+		return;
+
+	// Nothing to spread the work over
+	if (m_workers.empty())
+	{
+		for (size_t i = 0; i < count; i++)
+			fn(i);
+		return;
+	}
+
+	Batch batch;
+	batch.fn = &fn;
+	batch.remaining = count;
+
+	// Deal contiguous ranges to the workers, so neighbouring items start on the same thread.
+	// Imbalance is fixed up by stealing.
+	const size_t workers = m_workers.size();
+	for (size_t w = 0; w < workers; w++)
+	{
+		size_t begin = count * w / workers;
+		size_t end = count * (w + 1) / workers;
+
+		std::lock_guard<std::mutex> lock(m_workers[w]->mutex);
+		for (size_t i = end; i > begin; i--)
+			m_workers[w]->tasks.push_back(Task { &batch, i - 1 });
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_queued += count;
+	}
+	m_wake.notify_all();
+
+	// Help out until the batch has been fully handed out, then wait for the stragglers
+	Task task;
+	while (batch.remaining.load() > 0 && steal(workers, task))
+		execute(task);
+
+	std::unique_lock<std::mutex> lock(batch.mutex);
+	batch.done.wait(lock, [&batch]() { return batch.remaining.load() == 0; });
+}
+
+bool ThreadPool::pop(size_t worker, Task& task)
+{
+	Worker& w = *m_workers[worker];
+	std::lock_guard<std::mutex> lock(w.mutex);
+	if (w.tasks.empty())
+		return false;
+
+	task = w.tasks.back();
+	w.tasks.pop_back();
+	m_queued--;
+	return true;
+}
+
+bool ThreadPool::steal(size_t thief, Task& task)
+{
+	const size_t workers = m_workers.size();
+	for (size_t n = 1; n <= workers; n++)
+	{
+		Worker& victim = *m_workers[(thief + n) % workers];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (victim.tasks.empty())
+			continue;
+
+		task = victim.tasks.front();
+		victim.tasks.pop_front();
+		m_queued--;
+		m_steals++;
+		return true;
+	}
+
+	return false;
+}
+
+void ThreadPool::execute(const Task& task)
+{
+	Batch& batch = *task.batch;
+	(*batch.fn)(task.index);
+
+	// Decrement under the lock: the waiting thread destroys the batch as soon as it sees zero
+	std::lock_guard<std::mutex> lock(batch.mutex);
+	if (--batch.remaining == 0)
+		batch.done.notify_all();
+}
+
+void ThreadPool::workerLoop(size_t index)
+{
+	Task task;
+	while (true)
+	{
+		if (pop(index, task) || steal(index, task))
+		{
+			execute(task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_wake.wait(lock, [this]() { return m_stop || m_queued.load() > 0; });
+		if (m_stop)
+			return;
+	}
+}
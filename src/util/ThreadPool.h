@@ -0,0 +1,78 @@
+/**
+ * @file    ThreadPool.h
+ * @brief   Work-stealing thread pool for data-parallel loops
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __THREADPOOL_H__
+#define __THREADPOOL_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+	public:
+		// threads counts the calling thread, 0 means one per hardware thread
+		explicit ThreadPool(size_t threads = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		// Run fn(0) .. fn(count - 1) on the pool and return once all of them finished.
+		// The calling thread takes part in the work.
+		void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+		inline size_t getThreadCount() const { return m_workers.size() + 1; }
+		inline size_t getStealCount() const { return m_steals.load(); }
+	private:
+		struct Batch;
+		struct Task
+		{
+			Batch* batch;
+			size_t index;
+		};
+
+		// Owner pops from the back (most recently dealt, cache-warm), thieves take from the front
+		struct Worker
+		{
+			std::mutex mutex;
+			std::deque<Task> tasks;
+			std::thread thread;
+		};
+
+		std::vector<std::unique_ptr<Worker>> m_workers;
+
+		std::mutex m_sleepMutex;
+		std::condition_variable m_wake;
+		std::atomic<long> m_queued;
+		std::atomic<size_t> m_steals;
+		bool m_stop;
+
+		bool pop(size_t worker, Task& task);
+		bool steal(size_t thief, Task& task);
+		void execute(const Task& task);
+		void workerLoop(size_t index);
+};
+#endif // __THREADPOOL_H__
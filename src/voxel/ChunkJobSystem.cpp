@@ -0,0 +1,236 @@
+/**
+ * @file    ChunkJobSystem.cpp
+ * @brief   Background generation and meshing of chunks
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "voxel/ChunkJobSystem.h"
+#include "util/Profiler.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+ChunkJobSystem::ChunkJobSystem(const TerrainGenerator& generator, size_t threads, ChunkStreamer* streamer) :
+	m_generator(generator), m_streamer(streamer), m_focus{0.0f, 0.0f, 0.0f}, m_reorder(false), m_stop(false),
+	m_running(0), m_completed(0), m_cancelled(0)
+{
+	if (threads == 0)
+	{
+		const size_t hardware = std::thread::hardware_concurrency();
+		threads = hardware > 1 ? hardware - 1 : 1;
+	}
+
+	for (size_t i = 0; i < threads; i++)
+		m_threads.emplace_back(&ChunkJobSystem::workerLoop, this);
+}
+
+ChunkJobSystem::~ChunkJobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+
+	for (std::thread& thread : m_threads)
+		thread.join();
+}
+
+float ChunkJobSystem::distanceTo(const ChunkCoord& coord) const
+{
+	const float half = VoxelChunk::SIZE * 0.5f;
+	const float dx = coord.x * VoxelChunk::SIZE + half - m_focus[0];
+	const float dy = coord.y * VoxelChunk::SIZE + half - m_focus[1];
+	const float dz = coord.z * VoxelChunk::SIZE + half - m_focus[2];
+	return dx * dx + dy * dy + dz * dz;
+}
+
+void ChunkJobSystem::setFocus(float x, float y, float z)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_focus[0] = x;
+	m_focus[1] = y;
+	m_focus[2] = z;
+	m_reorder = true;
+}
+
+bool ChunkJobSystem::request(const ChunkCoord& coord)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_live.count(coord))
+			return false;
+
+		std::shared_ptr<Job> job = std::make_shared<Job>(coord);
+		job->distance = distanceTo(coord);
+		m_live[coord] = job;
+		m_pending.push_back(job);
+		std::push_heap(m_pending.begin(), m_pending.end(), farther);
+	}
+	m_wake.notify_one();
+	return true;
+}
+
+void ChunkJobSystem::cancel(const ChunkCoord& coord)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = m_live.find(coord);
+	if (it == m_live.end())
+		return;
+
+	it->second->cancelled = true;
+	m_live.erase(it);
+	m_cancelled++;
+}
+
+size_t ChunkJobSystem::cancelOutside(const ChunkCoord& center, int radius, int verticalRadius)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	size_t count = 0;
+	for (auto it = m_live.begin(); it != m_live.end();)
+	{
+		const ChunkCoord& coord = it->first;
+		if (std::abs(coord.x - center.x) > radius || std::abs(coord.y - center.y) > verticalRadius || std::abs(coord.z - center.z) > radius)
+		{
+			it->second->cancelled = true;
+			it = m_live.erase(it);
+			count++;
+		}
+		else
+			++it;
+	}
+	m_cancelled += count;
+	return count;
+}
+
+bool ChunkJobSystem::isRequested(const ChunkCoord& coord) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_live.count(coord) != 0;
+}
+
+bool ChunkJobSystem::popCompleted(Result& result)
+{
+	std::shared_ptr<Job> job;
+	while (m_done.pop(job))
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto it = m_live.find(job->coord);
+			if (it != m_live.end() && it->second == job)
+				m_live.erase(it);
+			if (job->cancelled)
+				continue;
+			m_completed++;
+		}
+
+		result = std::move(*job->result);
+		return true;
+	}
+	return false;
+}
+
+ChunkJobSystem::Stats ChunkJobSystem::getStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return { m_pending.size(), m_running, m_completed, m_cancelled };
+}
+
+void ChunkJobSystem::workerLoop()
+{
+	std::vector<Voxel> padded(ChunkMesher::PADDED_VOLUME);
+	std::vector<Voxel> voxels(VoxelChunk::VOLUME);
+	ChunkMesher mesher;
+	Profiler::getInstance().setThreadName("chunk worker");
+
+	while (true)
+	{
+		std::shared_ptr<Job> job;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [this]() { return m_stop || !m_pending.empty(); });
+			if (m_stop)
+				return;
+
+			// The focus moved: drop cancelled jobs and rebuild the heap with the new distances
+			if (m_reorder)
+			{
+				m_pending.erase(std::remove_if(m_pending.begin(), m_pending.end(),
+					[](const std::shared_ptr<Job>& pending) { return pending->cancelled.load(); }), m_pending.end());
+				for (std::shared_ptr<Job>& pending : m_pending)
+					pending->distance = distanceTo(pending->coord);
+				std::make_heap(m_pending.begin(), m_pending.end(), farther);
+				m_reorder = false;
+				if (m_pending.empty())
+					continue;
+			}
+
+			std::pop_heap(m_pending.begin(), m_pending.end(), farther);
+			job = std::move(m_pending.back());
+			m_pending.pop_back();
+			if (job->cancelled)
+				continue;
+			m_running++;
+		}
+
+		job->result.reset(new Result());
+		job->result->coord = job->coord;
+		job->result->chunk.reset(new VoxelChunk());
+		VoxelChunk& chunk = *job->result->chunk;
+
+		// Saved chunks only need the border generated, the inside is decoded from the payload
+		bool loaded = false;
+		if (m_streamer)
+		{
+			ChunkStreamer::Payload payload = m_streamer->fetch(job->coord);
+			PROFILE_SCOPE("load");
+			if (payload && RegionFile::decode(payload->data(), payload->size(), voxels.data()))
+			{
+				m_generator.generateBorder(job->coord, padded.data());
+				for (int z = 0; z < VoxelChunk::SIZE; z++)
+					for (int y = 0; y < VoxelChunk::SIZE; y++)
+						std::copy_n(&voxels[VoxelChunk::index(0, y, z)], VoxelChunk::SIZE, &padded[ChunkMesher::paddedIndex(0, y, z)]);
+				chunk.load(voxels.data());
+				loaded = true;
+			}
+		}
+		if (!loaded)
+		{
+			{
+				PROFILE_SCOPE("generate");
+				m_generator.generatePadded(job->coord, padded.data());
+				TerrainGenerator::extract(padded.data(), chunk);
+			}
+			// Even for a cancelled job, the camera may well come back
+			if (m_streamer)
+				m_streamer->save(job->coord, chunk);
+		}
+		if (!job->cancelled)
+		{
+			PROFILE_SCOPE("mesh");
+			mesher.mesh(padded.data(), job->result->mesh);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_running--;
+		}
+
+		if (!job->cancelled)
+			m_done.push(std::move(job));
+	}
+}
@@ -0,0 +1,119 @@
+/**
+ * @file    ChunkJobSystem.h
+ * @brief   Background generation and meshing of chunks
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __CHUNKJOBSYSTEM_H__
+#define __CHUNKJOBSYSTEM_H__
+
+#include "terrain/TerrainGenerator.h"
+#include "util/MPSCQueue.h"
+#include "voxel/ChunkStreamer.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Worker threads take the pending chunk closest to the focus point (the camera), load it
+ * through the ChunkStreamer when it was saved or generate it otherwise, and mesh it with
+ * its border from the generator; generated chunks are handed back to the streamer to
+ * save. Results go through a lock-free queue that the main thread drains with
+ * popCompleted() at its own pace. Cancelled jobs are skipped if they have not started,
+ * abandoned between generation and meshing otherwise, and their results are dropped by
+ * popCompleted().
+ */
+class ChunkJobSystem
+{
+	public:
+		struct Result
+		{
+			ChunkCoord coord;
+			std::unique_ptr<VoxelChunk> chunk;
+			ChunkMesh mesh;
+		};
+
+		struct Stats
+		{
+			size_t pending;
+			size_t running;
+			size_t completed;
+			size_t cancelled;
+		};
+
+		// threads 0 means one per hardware thread but one, left to the main thread; without
+		// a streamer every chunk is generated. The streamer must outlive the job system.
+		explicit ChunkJobSystem(const TerrainGenerator& generator, size_t threads = 0, ChunkStreamer* streamer = nullptr);
+		~ChunkJobSystem();
+
+		ChunkJobSystem(const ChunkJobSystem&) = delete;
+		ChunkJobSystem& operator=(const ChunkJobSystem&) = delete;
+
+		// Pending jobs are reordered by distance to this point, in world units
+		void setFocus(float x, float y, float z);
+
+		// Returns false if the chunk already has a live job
+		bool request(const ChunkCoord& coord);
+		void cancel(const ChunkCoord& coord);
+		// Cancel every job further than radius chunks from center along x or z, or verticalRadius along y
+		size_t cancelOutside(const ChunkCoord& center, int radius, int verticalRadius);
+		bool isRequested(const ChunkCoord& coord) const;
+
+		// Main thread only
+		bool popCompleted(Result& result);
+
+		inline size_t getThreadCount() const { return m_threads.size(); }
+		Stats getStats() const;
+	private:
+		struct Job
+		{
+			ChunkCoord coord;
+			float distance;
+			std::atomic<bool> cancelled;
+			std::unique_ptr<Result> result;
+
+			Job(const ChunkCoord& c) : coord(c), distance(0.0f), cancelled(false) {}
+		};
+
+		TerrainGenerator m_generator;
+		ChunkStreamer* m_streamer;
+		std::vector<std::thread> m_threads;
+
+		mutable std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::vector<std::shared_ptr<Job>> m_pending;   // min-heap on distance
+		std::unordered_map<ChunkCoord, std::shared_ptr<Job>, ChunkCoordHash> m_live;
+		float m_focus[3];
+		bool m_reorder;
+		bool m_stop;
+		size_t m_running;
+		size_t m_completed;
+		size_t m_cancelled;
+
+		MPSCQueue<std::shared_ptr<Job>> m_done;
+
+		// Heap order: the closest job on top
+		static bool farther(const std::shared_ptr<Job>& a, const std::shared_ptr<Job>& b) { return a->distance > b->distance; }
+
+		float distanceTo(const ChunkCoord& coord) const;
+		void workerLoop();
+};
+#endif // __CHUNKJOBSYSTEM_H__
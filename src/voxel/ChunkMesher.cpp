@@ -0,0 +1,194 @@
+/**
+ * @file    ChunkMesher.cpp
+ * @brief   Greedy meshing of voxel chunks into packed vertex buffers
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "voxel/ChunkMesher.h"
+
+static const int SIZE = VoxelChunk::SIZE;
+static const int STRIDE[3] = { 1, ChunkMesher::PADDED, ChunkMesher::PADDED * ChunkMesher::PADDED };
+
+void ChunkMesh::clear()
+{
+	vertices.clear();
+	indices.clear();
+	faces = 0;
+}
+
+uint64_t ChunkMesh::checksum() const
+{
+	uint64_t hash = 0xCBF29CE484222325ull;
+	auto mix = [&hash](uint32_t value)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			hash ^= (value >> (i * 8)) & 0xFF;
+			hash *= 0x100000001B3ull;
+		}
+	};
+
+	for (const ChunkVertex& vertex : vertices)
+	{
+		mix(vertex.position);
+		mix(vertex.material);
+	}
+	for (uint32_t index : indices)
+		mix(index);
+	return hash;
+}
+
+void ChunkMesher::gather(const ChunkStore& store, const ChunkCoord& coord, Voxel* padded)
+{
+	for (int cz = -1; cz <= 1; cz++)
+		for (int cy = -1; cy <= 1; cy++)
+			for (int cx = -1; cx <= 1; cx++)
+			{
+				const VoxelChunk* chunk = store.getChunk({ coord.x + cx, coord.y + cy, coord.z + cz });
+
+				// Range of padded coordinates covered by this neighbour
+				const int minX = cx < 0 ? -1 : cx == 0 ? 0 : SIZE, maxX = cx < 0 ? -1 : cx == 0 ? SIZE - 1 : SIZE;
+				const int minY = cy < 0 ? -1 : cy == 0 ? 0 : SIZE, maxY = cy < 0 ? -1 : cy == 0 ? SIZE - 1 : SIZE;
+				const int minZ = cz < 0 ? -1 : cz == 0 ? 0 : SIZE, maxZ = cz < 0 ? -1 : cz == 0 ? SIZE - 1 : SIZE;
+
+				for (int z = minZ; z <= maxZ; z++)
+					for (int y = minY; y <= maxY; y++)
+						for (int x = minX; x <= maxX; x++)
+							padded[paddedIndex(x, y, z)] = chunk ?
+								chunk->get(x & (SIZE - 1), y & (SIZE - 1), z & (SIZE - 1)) : VOXEL_AIR;
+			}
+}
+
+// Occlusion of a face corner from its two edge neighbours and the diagonal one
+static inline uint32_t vertexAO(bool side1, bool side2, bool corner)
+{
+	if (side1 && side2)
+		return 0;
+	return 3 - (side1 + side2 + corner);
+}
+
+void ChunkMesher::mesh(const Voxel* padded, ChunkMesh& out)
+{
+	out.clear();
+	m_mask.assign(SIZE * SIZE, 0);
+
+	for (int face = 0; face < 6; face++)
+	{
+		const int axis = face / 2;
+		const bool positive = (face & 1) == 0;
+		const int u = (axis + 1) % 3, v = (axis + 2) % 3;
+		const int normal = positive ? STRIDE[axis] : -STRIDE[axis];
+		const int su = STRIDE[u], sv = STRIDE[v];
+
+		for (int slice = 0; slice < SIZE; slice++)
+		{
+			// Visible faces of this slice, keyed by material and corner occlusion
+			for (int j = 0; j < SIZE; j++)
+				for (int i = 0; i < SIZE; i++)
+				{
+					int p[3];
+					p[axis] = slice;
+					p[u] = i;
+					p[v] = j;
+
+					const size_t index = paddedIndex(p[0], p[1], p[2]);
+					const Voxel voxel = padded[index];
+					uint32_t key = 0;
+					if (voxel != VOXEL_AIR && padded[index + normal] == VOXEL_AIR)
+					{
+						const Voxel* q = padded + index + normal;
+						const bool mu = q[-su] != VOXEL_AIR, pu = q[su] != VOXEL_AIR;
+						const bool mv = q[-sv] != VOXEL_AIR, pv = q[sv] != VOXEL_AIR;
+
+						// Corners in quad order (-u,-v), (+u,-v), (+u,+v), (-u,+v)
+						key = voxel
+							| vertexAO(mu, mv, q[-su - sv] != VOXEL_AIR) << 16
+							| vertexAO(pu, mv, q[su - sv] != VOXEL_AIR) << 18
+							| vertexAO(pu, pv, q[su + sv] != VOXEL_AIR) << 20
+							| vertexAO(mu, pv, q[-su + sv] != VOXEL_AIR) << 22;
+						out.faces++;
+					}
+					m_mask[i + j * SIZE] = key;
+				}
+
+			// Grow each face into the widest, then tallest, rectangle of identical keys
+			for (int j = 0; j < SIZE; j++)
+				for (int i = 0; i < SIZE;)
+				{
+					const uint32_t key = m_mask[i + j * SIZE];
+					if (key == 0)
+					{
+						i++;
+						continue;
+					}
+
+					int width = 1;
+					while (i + width < SIZE && m_mask[i + width + j * SIZE] == key)
+						width++;
+
+					int height = 1;
+					for (; j + height < SIZE; height++)
+					{
+						bool row = true;
+						for (int k = 0; k < width && row; k++)
+							row = m_mask[i + k + (j + height) * SIZE] == key;
+						if (!row)
+							break;
+					}
+
+					for (int h = 0; h < height; h++)
+						for (int k = 0; k < width; k++)
+							m_mask[i + k + (j + h) * SIZE] = 0;
+
+					// u x v == axis, so (0,0) (1,0) (1,1) (0,1) winds counter-clockwise seen from +axis
+					const int cornerU[4] = { i, i + width, i + width, i };
+					const int cornerV[4] = { j, j, j + height, j + height };
+					const int order[4] = { 0, positive ? 1 : 3, 2, positive ? 3 : 1 };
+					const Voxel voxel = static_cast<Voxel>(key & 0xFFFF);
+					const uint32_t base = static_cast<uint32_t>(out.vertices.size());
+					uint32_t ao[4];
+
+					for (int n = 0; n < 4; n++)
+					{
+						const int c = order[n];
+						int position[3];
+						position[axis] = slice + (positive ? 1 : 0);
+						position[u] = cornerU[c];
+						position[v] = cornerV[c];
+						ao[n] = (key >> (16 + 2 * c)) & 3;
+						out.vertices.push_back(ChunkVertex::pack(position[0], position[1], position[2], face, ao[n], voxel));
+					}
+
+					// Split along the brighter diagonal so occlusion interpolates symmetrically
+					if (ao[0] + ao[2] >= ao[1] + ao[3])
+					{
+						const uint32_t quad[6] = { 0, 1, 2, 0, 2, 3 };
+						for (uint32_t n : quad)
+							out.indices.push_back(base + n);
+					}
+					else
+					{
+						const uint32_t quad[6] = { 0, 1, 3, 1, 2, 3 };
+						for (uint32_t n : quad)
+							out.indices.push_back(base + n);
+					}
+
+					i += width;
+				}
+		}
+	}
+}
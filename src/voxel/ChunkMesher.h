@@ -0,0 +1,90 @@
+/**
+ * @file    ChunkMesher.h
+ * @brief   Greedy meshing of voxel chunks into packed vertex buffers
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __CHUNKMESHER_H__
+#define __CHUNKMESHER_H__
+
+#include "voxel/ChunkStore.h"
+
+#include <vector>
+
+/**
+ * 8 byte vertex, read in the shader with integer attributes:
+ *  position: x | y << 6 | z << 12 (0..SIZE each, chunk local) | face << 18 | ao << 21
+ *  material: voxel material id
+ * face is 0..5 for +X, -X, +Y, -Y, +Z, -Z and ao is 0 (fully occluded) to 3 (open).
+ */
+struct ChunkVertex
+{
+	uint32_t position;
+	uint32_t material;
+
+	inline static ChunkVertex pack(int x, int y, int z, int face, int ao, Voxel voxel)
+	{
+		return { static_cast<uint32_t>(x | (y << 6) | (z << 12) | (face << 18) | (ao << 21)), voxel };
+	}
+
+	inline int x() const { return position & 63; }
+	inline int y() const { return (position >> 6) & 63; }
+	inline int z() const { return (position >> 12) & 63; }
+	inline int face() const { return (position >> 18) & 7; }
+	inline int ao() const { return (position >> 21) & 3; }
+};
+
+struct ChunkMesh
+{
+	std::vector<ChunkVertex> vertices;
+	std::vector<uint32_t> indices;
+	size_t faces;   // visible unit faces, before greedy merging
+
+	inline size_t getTriangleCount() const { return indices.size() / 3; }
+	inline bool empty() const { return indices.empty(); }
+	void clear();
+
+	// FNV-1a over vertices and indices, to compare meshes across runs and platforms
+	uint64_t checksum() const;
+};
+
+/**
+ * Meshing reads a snapshot of the chunk with a one voxel border taken from its 26
+ * neighbours, so faces against solid neighbours are culled and ambient occlusion is
+ * continuous across chunk edges. Taking the snapshot touches the ChunkStore and has to
+ * happen on the thread owning it; mesh() only reads the snapshot and can run anywhere.
+ *
+ * Faces are merged greedily per slice when they share material and corner occlusion,
+ * the output only depends on the voxels so it is identical from run to run.
+ */
+class ChunkMesher
+{
+	public:
+		static const int PADDED = VoxelChunk::SIZE + 2;
+		static const size_t PADDED_VOLUME = PADDED * PADDED * PADDED;
+
+		// Voxel (x, y, z) of the chunk, -1..SIZE on each axis, in a padded snapshot
+		inline static size_t paddedIndex(int x, int y, int z) { return (x + 1) + (y + 1) * PADDED + (z + 1) * PADDED * PADDED; }
+
+		// Fill padded (PADDED_VOLUME voxels) with chunk coord and its border
+		static void gather(const ChunkStore& store, const ChunkCoord& coord, Voxel* padded);
+
+		void mesh(const Voxel* padded, ChunkMesh& out);
+	private:
+		std::vector<uint32_t> m_mask;
+};
+#endif // __CHUNKMESHER_H__
@@ -0,0 +1,293 @@
+/**
+ * @file    ChunkRenderer.cpp
+ * @brief   Chunk meshes in shared buffers, drawn with indirect multi-draw
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "voxel/ChunkRenderer.h"
+#include "GLState.h"
+#include "StreamBuffer.h"
+
+#include <algorithm>
+
+// Instanced attribute holding the chunk corner
+static const GLuint OFFSET_ATTRIBUTE = 2;
+
+ChunkRenderer::ChunkRenderer(const Settings& settings) :
+	m_settings(settings),
+	m_multiDraw(settings.multiDrawIndirect && (GLEW_VERSION_4_3 || (GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance))),
+	m_lastDrawCalls(0), m_lastChunks(0)
+{
+
+}
+
+ChunkRenderer::~ChunkRenderer()
+{
+	GLState& state = GLState::getInstance();
+	for (const std::unique_ptr<Page>& page : m_pages)
+	{
+		state.forgetBuffer(page->vertexBuffer);
+		state.forgetBuffer(page->indexBuffer);
+		state.forgetVertexArray(page->vao);
+		glDeleteBuffers(1, &page->vertexBuffer);
+		glDeleteBuffers(1, &page->indexBuffer);
+		glDeleteVertexArrays(1, &page->vao);
+	}
+}
+
+ChunkRenderer::Page& ChunkRenderer::createPage(size_t vertices, size_t indices)
+{
+	GLState& state = GLState::getInstance();
+	std::unique_ptr<Page> page(new Page());
+	page->vertices.reset(vertices);
+	page->indices.reset(indices);
+
+	glGenVertexArrays(1, &page->vao);
+	glGenBuffers(1, &page->vertexBuffer);
+	glGenBuffers(1, &page->indexBuffer);
+
+	state.bindVertexArray(page->vao);
+	state.bindBuffer(GL_ARRAY_BUFFER, page->vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, vertices * sizeof(ChunkVertex), nullptr, GL_STATIC_DRAW);
+	state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, page->indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices * sizeof(uint32_t), nullptr, GL_STATIC_DRAW);
+
+	glEnableVertexAttribArray(0);
+	glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, sizeof(ChunkVertex), (void*)offsetof(ChunkVertex, position));
+	glEnableVertexAttribArray(1);
+	glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(ChunkVertex), (void*)offsetof(ChunkVertex, material));
+
+	// Per draw through baseInstance, which also carries the frame's offset into the
+	// stream buffer; the fallback leaves the array disabled and sets the constant
+	// attribute value before every draw instead
+	if (m_multiDraw)
+	{
+		state.bindBuffer(GL_ARRAY_BUFFER, StreamBuffer::getInstance().getBuffer());
+		glEnableVertexAttribArray(OFFSET_ATTRIBUTE);
+		glVertexAttribPointer(OFFSET_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+		glVertexAttribDivisor(OFFSET_ATTRIBUTE, 1);
+	}
+
+	m_pages.push_back(std::move(page));
+	return *m_pages.back();
+}
+
+ChunkRenderer::Allocation ChunkRenderer::upload(const ChunkMesh& mesh)
+{
+	Allocation allocation = {};
+	if (mesh.empty())
+		return allocation;
+
+	const size_t vertices = mesh.vertices.size(), indices = mesh.indices.size();
+	size_t firstVertex = FreeListAllocator::INVALID, firstIndex = FreeListAllocator::INVALID;
+	size_t page = 0;
+	for (; page < m_pages.size(); page++)
+	{
+		firstVertex = m_pages[page]->vertices.allocate(vertices);
+		if (firstVertex == FreeListAllocator::INVALID)
+			continue;
+		firstIndex = m_pages[page]->indices.allocate(indices);
+		if (firstIndex != FreeListAllocator::INVALID)
+			break;
+		m_pages[page]->vertices.release(firstVertex, vertices);
+	}
+
+	if (page == m_pages.size())
+	{
+		Page& created = createPage(std::max(vertices, m_settings.pageVertices), std::max(indices, m_settings.pageIndices));
+		firstVertex = created.vertices.allocate(vertices);
+		firstIndex = created.indices.allocate(indices);
+	}
+
+	// Through the copy targets, binding an element array would change the bound vertex array
+	GLState& state = GLState::getInstance();
+	StreamBuffer& stream = StreamBuffer::getInstance();
+	const size_t vertexBytes = vertices * sizeof(ChunkVertex), indexBytes = indices * sizeof(uint32_t);
+	const size_t vertexSource = stream.write(mesh.vertices.data(), vertexBytes);
+	const size_t indexSource = vertexSource == StreamBuffer::INVALID ? StreamBuffer::INVALID : stream.write(mesh.indices.data(), indexBytes);
+	if (indexSource != StreamBuffer::INVALID)
+	{
+		// Ordered after the draws that may still read the range's old mesh, without
+		// the CPU waiting for them
+		state.bindBuffer(GL_COPY_READ_BUFFER, stream.getBuffer());
+		state.bindBuffer(GL_COPY_WRITE_BUFFER, m_pages[page]->vertexBuffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, vertexSource, firstVertex * sizeof(ChunkVertex), vertexBytes);
+		state.bindBuffer(GL_COPY_WRITE_BUFFER, m_pages[page]->indexBuffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, indexSource, firstIndex * sizeof(uint32_t), indexBytes);
+	}
+	else
+	{
+		// This frame's region is full
+		state.bindBuffer(GL_COPY_WRITE_BUFFER, m_pages[page]->vertexBuffer);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, firstVertex * sizeof(ChunkVertex), vertexBytes, mesh.vertices.data());
+		state.bindBuffer(GL_COPY_WRITE_BUFFER, m_pages[page]->indexBuffer);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, firstIndex * sizeof(uint32_t), indexBytes, mesh.indices.data());
+	}
+
+	allocation.page = static_cast<uint32_t>(page);
+	allocation.firstVertex = static_cast<uint32_t>(firstVertex);
+	allocation.vertexCount = static_cast<uint32_t>(vertices);
+	allocation.firstIndex = static_cast<uint32_t>(firstIndex);
+	allocation.indexCount = static_cast<uint32_t>(indices);
+	return allocation;
+}
+
+void ChunkRenderer::release(Allocation& allocation)
+{
+	if (allocation.empty())
+		return;
+
+	Page& page = *m_pages[allocation.page];
+	page.vertices.release(allocation.firstVertex, allocation.vertexCount);
+	page.indices.release(allocation.firstIndex, allocation.indexCount);
+	allocation = {};
+}
+
+void ChunkRenderer::begin()
+{
+	for (const std::unique_ptr<Page>& page : m_pages)
+	{
+		page->commands.clear();
+		page->offsets.clear();
+	}
+}
+
+void ChunkRenderer::add(const Allocation& allocation, const glm::vec3& offset)
+{
+	if (allocation.empty())
+		return;
+
+	Page& page = *m_pages[allocation.page];
+	page.commands.push_back({ allocation.indexCount, 1, allocation.firstIndex, static_cast<GLint>(allocation.firstVertex), 0 });
+	page.offsets.push_back(offset);
+}
+
+void ChunkRenderer::submit()
+{
+	m_lastDrawCalls = 0;
+	m_lastChunks = 0;
+
+	if (!m_multiDraw || !submitIndirect())
+		submitDirect();
+}
+
+void ChunkRenderer::submitDirect()
+{
+	GLState& state = GLState::getInstance();
+	for (const std::unique_ptr<Page>& page : m_pages)
+	{
+		if (page->commands.empty())
+			continue;
+
+		// Only when the stream buffer had no room for the instance data
+		state.bindVertexArray(page->vao);
+		if (m_multiDraw)
+			glDisableVertexAttribArray(OFFSET_ATTRIBUTE);
+
+		for (size_t i = 0; i < page->commands.size(); i++)
+		{
+			const DrawElementsIndirectCommand& command = page->commands[i];
+			const glm::vec3& offset = page->offsets[i];
+			glVertexAttrib3f(OFFSET_ATTRIBUTE, offset.x, offset.y, offset.z);
+			glDrawElementsBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_INT,
+				(void*)(command.firstIndex * sizeof(uint32_t)), command.baseVertex);
+		}
+
+		if (m_multiDraw)
+			glEnableVertexAttribArray(OFFSET_ATTRIBUTE);
+		m_lastDrawCalls += page->commands.size();
+		m_lastChunks += page->commands.size();
+	}
+}
+
+bool ChunkRenderer::submitIndirect()
+{
+	// One command and instance array for the frame, each page draws its own stretch
+	m_commands.clear();
+	m_offsets.clear();
+	for (const std::unique_ptr<Page>& page : m_pages)
+	{
+		for (DrawElementsIndirectCommand command : page->commands)
+		{
+			command.baseInstance = static_cast<GLuint>(m_commands.size());
+			m_commands.push_back(command);
+		}
+		m_offsets.insert(m_offsets.end(), page->offsets.begin(), page->offsets.end());
+	}
+	if (m_commands.empty())
+		return true;
+
+	// The instanced attribute starts at the beginning of the stream buffer, so the
+	// offsets are found baseInstance elements into it
+	StreamBuffer& stream = StreamBuffer::getInstance();
+	const size_t instances = stream.write(m_offsets.data(), m_offsets.size() * sizeof(glm::vec3), sizeof(glm::vec3));
+	if (instances == StreamBuffer::INVALID)
+		return false;
+	const GLuint baseInstance = static_cast<GLuint>(instances / sizeof(glm::vec3));
+	for (DrawElementsIndirectCommand& command : m_commands)
+		command.baseInstance += baseInstance;
+	const size_t commands = stream.write(m_commands.data(), m_commands.size() * sizeof(DrawElementsIndirectCommand));
+	if (commands == StreamBuffer::INVALID)
+		return false;
+
+	GLState& state = GLState::getInstance();
+	state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, stream.getBuffer());
+
+	size_t first = 0;
+	for (const std::unique_ptr<Page>& page : m_pages)
+	{
+		if (page->commands.empty())
+			continue;
+
+		state.bindVertexArray(page->vao);
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+			(void*)(commands + first * sizeof(DrawElementsIndirectCommand)), static_cast<GLsizei>(page->commands.size()), 0);
+		first += page->commands.size();
+		m_lastDrawCalls++;
+	}
+	m_lastChunks = m_commands.size();
+	return true;
+}
+
+ChunkRenderer::Stats ChunkRenderer::getStats() const
+{
+	Stats stats = {};
+	stats.drawCalls = m_lastDrawCalls;
+	stats.chunks = m_lastChunks;
+	stats.pages = m_pages.size();
+
+	// All free space against the single largest range, a mesh cannot span two pages either
+	FreeListAllocator::Stats vertices = {}, indices = {};
+	for (const std::unique_ptr<Page>& page : m_pages)
+	{
+		const FreeListAllocator::Stats v = page->vertices.getStats(), i = page->indices.getStats();
+		vertices.capacity += v.capacity;
+		vertices.used += v.used;
+		vertices.freeRanges += v.freeRanges;
+		vertices.largestFree = std::max(vertices.largestFree, v.largestFree);
+		indices.capacity += i.capacity;
+		indices.used += i.used;
+		indices.freeRanges += i.freeRanges;
+		indices.largestFree = std::max(indices.largestFree, i.largestFree);
+	}
+
+	stats.capacityBytes = vertices.capacity * sizeof(ChunkVertex) + indices.capacity * sizeof(uint32_t);
+	stats.usedBytes = vertices.used * sizeof(ChunkVertex) + indices.used * sizeof(uint32_t);
+	stats.freeRanges = vertices.freeRanges + indices.freeRanges;
+	stats.fragmentation = std::max(vertices.fragmentation(), indices.fragmentation());
+	return stats;
+}
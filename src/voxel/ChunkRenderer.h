@@ -0,0 +1,122 @@
+/**
+ * @file    ChunkRenderer.h
+ * @brief   Chunk meshes in shared buffers, drawn with indirect multi-draw
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __CHUNKRENDERER_H__
+#define __CHUNKRENDERER_H__
+
+#include "util/Common.h"
+#include "util/FreeListAllocator.h"
+#include "voxel/ChunkMesher.h"
+
+#include <memory>
+
+// Layout glMultiDrawElementsIndirect reads from GL_DRAW_INDIRECT_BUFFER
+struct DrawElementsIndirectCommand
+{
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;
+};
+
+/**
+ * Sub-allocates every chunk mesh from a few large pages, each one vertex buffer and one
+ * index buffer behind one VAO, with a FreeListAllocator per buffer. The visible set of
+ * a frame becomes one DrawElementsIndirectCommand per chunk and one
+ * glMultiDrawElementsIndirect per page; the chunk position is an instanced attribute
+ * (location 2, see data/shaders/chunk.vert) picked by baseInstance. Without indirect
+ * multi-draw and base instance (GL 4.3), every chunk is a glDrawElementsBaseVertex
+ * with the position as a constant attribute. Meshes and the per-frame draw data go
+ * through the StreamBuffer, meshes are then copied into their page on the GPU.
+ * GL thread only.
+ */
+class ChunkRenderer
+{
+	public:
+		struct Settings
+		{
+			size_t pageVertices;      // per page, a mesh larger than this gets a page of its own
+			size_t pageIndices;
+			bool multiDrawIndirect;   // when the context supports it
+		};
+
+		// Where a mesh lives, empty for a chunk without faces
+		struct Allocation
+		{
+			uint32_t page;
+			uint32_t firstVertex, vertexCount;
+			uint32_t firstIndex, indexCount;
+
+			inline bool empty() const { return indexCount == 0; }
+		};
+
+		struct Stats
+		{
+			size_t drawCalls;         // last frame
+			size_t chunks;            // drawn last frame
+			size_t pages;
+			size_t capacityBytes;
+			size_t usedBytes;
+			size_t freeRanges;
+			double fragmentation;     // worst of the vertex and index buffers, see FreeListAllocator::Stats
+		};
+
+		explicit ChunkRenderer(const Settings& settings);
+		~ChunkRenderer();
+
+		ChunkRenderer(const ChunkRenderer&) = delete;
+		ChunkRenderer& operator=(const ChunkRenderer&) = delete;
+
+		Allocation upload(const ChunkMesh& mesh);
+		void release(Allocation& allocation);
+
+		// Collect the visible chunks of a frame, offset is the chunk corner relative to the
+		// camera's floating origin, then draw them with the chunk shader in use
+		void begin();
+		void add(const Allocation& allocation, const glm::vec3& offset);
+		void submit();
+
+		inline bool isMultiDrawIndirect() const { return m_multiDraw; }
+		Stats getStats() const;
+	private:
+		struct Page
+		{
+			GLuint vao, vertexBuffer, indexBuffer;
+			FreeListAllocator vertices, indices;
+			std::vector<DrawElementsIndirectCommand> commands;
+			std::vector<glm::vec3> offsets;
+		};
+
+		Settings m_settings;
+		bool m_multiDraw;
+		std::vector<std::unique_ptr<Page>> m_pages;
+
+		// Per frame, all pages back to back
+		std::vector<DrawElementsIndirectCommand> m_commands;
+		std::vector<glm::vec3> m_offsets;
+		size_t m_lastDrawCalls;
+		size_t m_lastChunks;
+
+		Page& createPage(size_t vertices, size_t indices);
+		bool submitIndirect();
+		void submitDirect();
+};
+#endif // __CHUNKRENDERER_H__
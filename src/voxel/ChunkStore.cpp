@@ -0,0 +1,136 @@
+/**
+ * @file    ChunkStore.cpp
+ * @brief   Sparse world of voxel chunks indexed by chunk coordinate
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "voxel/ChunkStore.h"
+
+static const int LOCAL_MASK = VoxelChunk::SIZE - 1;
+
+ChunkStore::ChunkStore() :
+	m_lastCoord{INT32_MAX, INT32_MAX, INT32_MAX}, m_lastChunk(nullptr)
+{
+
+}
+
+VoxelChunk* ChunkStore::getChunk(const ChunkCoord& coord) const
+{
+	if (coord == m_lastCoord)
+		return m_lastChunk;
+
+	auto it = m_chunks.find(coord);
+	m_lastCoord = coord;
+	m_lastChunk = it == m_chunks.end() ? nullptr : it->second.get();
+	return m_lastChunk;
+}
+
+VoxelChunk& ChunkStore::getOrCreateChunk(const ChunkCoord& coord)
+{
+	if (coord == m_lastCoord && m_lastChunk)
+		return *m_lastChunk;
+
+	std::unique_ptr<VoxelChunk>& chunk = m_chunks[coord];
+	if (!chunk)
+		chunk.reset(new VoxelChunk());
+
+	m_lastCoord = coord;
+	m_lastChunk = chunk.get();
+	return *chunk;
+}
+
+VoxelChunk& ChunkStore::insertChunk(const ChunkCoord& coord, std::unique_ptr<VoxelChunk> chunk)
+{
+	std::unique_ptr<VoxelChunk>& slot = m_chunks[coord];
+	slot = std::move(chunk);
+
+	m_lastCoord = coord;
+	m_lastChunk = slot.get();
+	return *slot;
+}
+
+void ChunkStore::removeChunk(const ChunkCoord& coord)
+{
+	if (coord == m_lastCoord)
+		resetLast();
+	m_chunks.erase(coord);
+}
+
+void ChunkStore::clear()
+{
+	resetLast();
+	m_chunks.clear();
+}
+
+Voxel ChunkStore::getVoxel(int x, int y, int z) const
+{
+	const VoxelChunk* chunk = getChunk(chunkOf(x, y, z));
+	if (!chunk)
+		return VOXEL_AIR;
+	return chunk->get(x & LOCAL_MASK, y & LOCAL_MASK, z & LOCAL_MASK);
+}
+
+void ChunkStore::setVoxel(int x, int y, int z, Voxel voxel)
+{
+	const ChunkCoord coord = chunkOf(x, y, z);
+	VoxelChunk* chunk = getChunk(coord);
+	if (!chunk)
+	{
+		if (voxel == VOXEL_AIR)
+			return;
+		chunk = &getOrCreateChunk(coord);
+	}
+	chunk->set(x & LOCAL_MASK, y & LOCAL_MASK, z & LOCAL_MASK, voxel);
+}
+
+void ChunkStore::compact()
+{
+	resetLast();
+
+	for (auto it = m_chunks.begin(); it != m_chunks.end();)
+	{
+		it->second->compact();
+		if (it->second->isUniform() && it->second->getUniformValue() == VOXEL_AIR)
+			it = m_chunks.erase(it);
+		else
+			++it;
+	}
+}
+
+ChunkStore::MemoryStats ChunkStore::getMemoryStats() const
+{
+	MemoryStats stats = {};
+	for (const auto& entry : m_chunks)
+	{
+		const VoxelChunk& chunk = *entry.second;
+		if (chunk.isUniform())
+			stats.uniformChunks++;
+		else if (chunk.isDirect())
+			stats.directChunks++;
+		else
+			stats.palettedChunks++;
+		stats.bytes += chunk.getMemoryUsage();
+	}
+
+	// Approximate node size of the map: key, owning pointer and the next-node pointer
+	stats.chunks = m_chunks.size();
+	stats.bytes += stats.chunks * (sizeof(ChunkCoord) + sizeof(std::unique_ptr<VoxelChunk>) + sizeof(void*));
+	stats.bytes += m_chunks.bucket_count() * sizeof(void*);
+	stats.denseBytes = stats.chunks * VoxelChunk::VOLUME * sizeof(Voxel);
+	stats.bytesPerChunk = stats.chunks ? static_cast<double>(stats.bytes) / stats.chunks : 0.0;
+	return stats;
+}
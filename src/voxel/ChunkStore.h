@@ -0,0 +1,106 @@
+/**
+ * @file    ChunkStore.h
+ * @brief   Sparse world of voxel chunks indexed by chunk coordinate
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __CHUNKSTORE_H__
+#define __CHUNKSTORE_H__
+
+#include "voxel/VoxelChunk.h"
+
+#include <memory>
+#include <unordered_map>
+
+struct ChunkCoord
+{
+	int32_t x, y, z;
+
+	inline bool operator==(const ChunkCoord& other) const { return x == other.x && y == other.y && z == other.z; }
+	inline bool operator!=(const ChunkCoord& other) const { return !(*this == other); }
+};
+
+struct ChunkCoordHash
+{
+	inline size_t operator()(const ChunkCoord& c) const
+	{
+		uint64_t h = static_cast<uint32_t>(c.x) * 0x9E3779B97F4A7C15ull;
+		h ^= static_cast<uint32_t>(c.y) * 0xC2B2AE3D27D4EB4Full;
+		h ^= static_cast<uint32_t>(c.z) * 0x165667B19E3779F9ull;
+		return static_cast<size_t>(h ^ (h >> 29));
+	}
+};
+
+/**
+ * Chunks live in a hash map keyed by chunk coordinate; a missing chunk reads as air.
+ * World voxel (x, y, z) belongs to chunk (x >> SIZE_BITS, ...), so negative coordinates
+ * round towards -infinity. Not thread-safe: the last looked-up chunk is cached, which makes
+ * sequential access skip the hash lookup.
+ */
+class ChunkStore
+{
+	public:
+		struct MemoryStats
+		{
+			size_t chunks;
+			size_t uniformChunks;
+			size_t palettedChunks;
+			size_t directChunks;
+			size_t bytes;          // chunk storage plus hash map nodes and buckets
+			size_t denseBytes;     // the same chunks stored as plain Voxel arrays
+			double bytesPerChunk;
+		};
+
+		ChunkStore();
+
+		inline static ChunkCoord chunkOf(int x, int y, int z)
+		{
+			return { x >> VoxelChunk::SIZE_BITS, y >> VoxelChunk::SIZE_BITS, z >> VoxelChunk::SIZE_BITS };
+		}
+
+		Voxel getVoxel(int x, int y, int z) const;
+		// Creates the chunk if needed, setting air in a missing chunk is a no-op
+		void setVoxel(int x, int y, int z, Voxel voxel);
+
+		VoxelChunk* getChunk(const ChunkCoord& coord) const;
+		VoxelChunk& getOrCreateChunk(const ChunkCoord& coord);
+		// Take ownership of a chunk built elsewhere, replacing any chunk at coord
+		VoxelChunk& insertChunk(const ChunkCoord& coord, std::unique_ptr<VoxelChunk> chunk);
+		void removeChunk(const ChunkCoord& coord);
+		void clear();
+
+		// Run compact() on every chunk and drop the ones left uniform air
+		void compact();
+
+		inline size_t getChunkCount() const { return m_chunks.size(); }
+		inline const std::unordered_map<ChunkCoord, std::unique_ptr<VoxelChunk>, ChunkCoordHash>& getChunks() const { return m_chunks; }
+
+		MemoryStats getMemoryStats() const;
+	private:
+		std::unordered_map<ChunkCoord, std::unique_ptr<VoxelChunk>, ChunkCoordHash> m_chunks;
+
+		mutable ChunkCoord m_lastCoord;
+		mutable VoxelChunk* m_lastChunk;
+
+		// Forget the last looked up chunk, coordinate and pointer together
+		inline void resetLast()
+		{
+			m_lastCoord = { INT32_MAX, INT32_MAX, INT32_MAX };
+			m_lastChunk = nullptr;
+		}
+};
+#endif // __CHUNKSTORE_H__
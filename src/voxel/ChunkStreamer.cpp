@@ -0,0 +1,343 @@
+/**
+ * @file    ChunkStreamer.cpp
+ * @brief   Saved chunks streamed around the camera by an I/O thread
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "voxel/ChunkStreamer.h"
+#include "util/Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+// Hash map and list nodes of an entry, counted against the budget besides its payload
+static const size_t ENTRY_OVERHEAD = 96;
+
+// Seconds over which the velocity estimate follows the camera
+static const float VELOCITY_SMOOTHING = 0.25f;
+// Faster than this is a teleport, not movement worth prefetching for
+static const float MAX_SPEED = 512.0f;
+
+ChunkStreamer::ChunkStreamer(const Settings& settings, const RegionFile::Generator& generator) :
+	m_settings(settings), m_regions(settings.directory, generator), m_residentBytes(0), m_reorder(false), m_stop(false),
+	m_position(0.0, 0.0, 0.0), m_velocity(0.0f, 0.0f, 0.0f), m_hasPosition(false),
+	m_center{0, 0, 0}, m_ahead{0, 0, 0}, m_focus{0.0f, 0.0f, 0.0f},
+	m_fetches(0), m_hits(0), m_stalls(0), m_absent(0), m_evictions(0),
+	m_readCount(0), m_bytesRead(0), m_writeCount(0), m_bytesWritten(0), m_latencyMs(0.0), m_maxLatencyMs(0.0)
+{
+	m_thread = std::thread(&ChunkStreamer::ioLoop, this);
+}
+
+ChunkStreamer::~ChunkStreamer()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	m_resolved.notify_all();
+	m_thread.join();
+}
+
+static inline size_t bytesOf(const ChunkStreamer::Payload& payload)
+{
+	return ENTRY_OVERHEAD + (payload ? payload->size() : 0);
+}
+
+float ChunkStreamer::distanceTo(const ChunkCoord& coord) const
+{
+	const float half = VoxelChunk::SIZE * 0.5f;
+	const float dx = coord.x * VoxelChunk::SIZE + half - m_focus[0];
+	const float dy = coord.y * VoxelChunk::SIZE + half - m_focus[1];
+	const float dz = coord.z * VoxelChunk::SIZE + half - m_focus[2];
+	return dx * dx + dy * dy + dz * dz;
+}
+
+bool ChunkStreamer::inRing(const ChunkCoord& coord, const ChunkCoord& center) const
+{
+	return std::abs(coord.x - center.x) <= m_settings.ringRadius
+		&& std::abs(coord.z - center.z) <= m_settings.ringRadius
+		&& std::abs(coord.y - center.y) <= m_settings.ringVerticalRadius;
+}
+
+void ChunkStreamer::update(const glm::dvec3& position)
+{
+	const Clock::time_point now = Clock::now();
+	if (m_hasPosition)
+	{
+		const float seconds = std::chrono::duration<float>(now - m_time).count();
+		if (seconds > 0.0f)
+		{
+			glm::vec3 velocity = glm::vec3((position - m_position) / static_cast<double>(seconds));
+			if (glm::length(velocity) > MAX_SPEED)
+				velocity = glm::vec3(0.0f);
+			m_velocity += (velocity - m_velocity) * (1.0f - std::exp(-seconds / VELOCITY_SMOOTHING));
+		}
+	}
+	m_position = position;
+	m_time = now;
+
+	const glm::dvec3 ahead = position + glm::dvec3(m_velocity * m_settings.prefetchSeconds);
+	const ChunkCoord centerChunk = ChunkStore::chunkOf(
+		static_cast<int>(std::floor(position.x)), static_cast<int>(std::floor(position.y)), static_cast<int>(std::floor(position.z)));
+	const ChunkCoord aheadChunk = ChunkStore::chunkOf(
+		static_cast<int>(std::floor(ahead.x)), static_cast<int>(std::floor(ahead.y)), static_cast<int>(std::floor(ahead.z)));
+	if (m_hasPosition && centerChunk == m_center && aheadChunk == m_ahead)
+		return;
+	m_hasPosition = true;
+
+	PROFILE_SCOPE("stream rings");
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_center = centerChunk;
+		m_ahead = aheadChunk;
+		m_focus[0] = static_cast<float>(position.x);
+		m_focus[1] = static_cast<float>(position.y);
+		m_focus[2] = static_cast<float>(position.z);
+		m_reorder = true;
+
+		requestRing(m_center);
+		if (m_ahead != m_center)
+			requestRing(m_ahead);
+		evict();
+	}
+	m_wake.notify_one();
+}
+
+void ChunkStreamer::requestRing(const ChunkCoord& center)
+{
+	const Clock::time_point now = Clock::now();
+	const int r = m_settings.ringRadius, h = m_settings.ringVerticalRadius;
+	for (int z = center.z - r; z <= center.z + r; z++)
+		for (int y = center.y - h; y <= center.y + h; y++)
+			for (int x = center.x - r; x <= center.x + r; x++)
+			{
+				const ChunkCoord coord = { x, y, z };
+				auto it = m_entries.find(coord);
+				if (it != m_entries.end())
+				{
+					touch(it->second);
+					continue;
+				}
+
+				m_lru.push_front(coord);
+				m_entries[coord] = { ENTRY_QUEUED, nullptr, m_lru.begin(), now, 0 };
+				m_residentBytes += ENTRY_OVERHEAD;
+				m_reads.push_back({ coord, distanceTo(coord) });
+				std::push_heap(m_reads.begin(), m_reads.end(), farther);
+			}
+}
+
+void ChunkStreamer::touch(Entry& entry)
+{
+	m_lru.splice(m_lru.begin(), m_lru, entry.lru);
+}
+
+void ChunkStreamer::resolve(Entry& entry, EntryState state, Payload payload)
+{
+	m_residentBytes -= bytesOf(entry.payload);
+	entry.state = state;
+	entry.payload = std::move(payload);
+	m_residentBytes += bytesOf(entry.payload);
+}
+
+void ChunkStreamer::evict()
+{
+	// Oldest first; queued entries have a reader coming, ring entries are about to be needed
+	for (auto it = m_lru.end(); it != m_lru.begin() && m_residentBytes > m_settings.memoryBudgetBytes;)
+	{
+		--it;
+		auto entry = m_entries.find(*it);
+		if (entry->second.state == ENTRY_QUEUED || entry->second.waiters > 0 || inRing(*it, m_center) || inRing(*it, m_ahead))
+			continue;
+
+		m_residentBytes -= bytesOf(entry->second.payload);
+		m_entries.erase(entry);
+		it = m_lru.erase(it);
+		m_evictions++;
+	}
+}
+
+ChunkStreamer::Payload ChunkStreamer::fetch(const ChunkCoord& coord)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_fetches++;
+
+	auto it = m_entries.find(coord);
+	if (it == m_entries.end())
+	{
+		// Outside of the rings, or evicted in the meantime
+		m_lru.push_front(coord);
+		it = m_entries.emplace(coord, Entry{ ENTRY_QUEUED, nullptr, m_lru.begin(), Clock::now(), 0 }).first;
+		m_residentBytes += ENTRY_OVERHEAD;
+	}
+
+	Entry& entry = it->second;
+	touch(entry);
+	if (entry.state == ENTRY_QUEUED)
+	{
+		// Ahead of every prefetch, the I/O thread skips the entry's other read
+		m_reads.push_back({ coord, -1.0f });
+		std::push_heap(m_reads.begin(), m_reads.end(), farther);
+		m_wake.notify_one();
+
+		// Entries are never erased while they have waiters
+		entry.waiters++;
+		m_resolved.wait(lock, [&]() { return m_stop || entry.state != ENTRY_QUEUED; });
+		entry.waiters--;
+		if (entry.state == ENTRY_QUEUED)
+			return nullptr;
+		m_stalls += entry.state == ENTRY_RESIDENT ? 1 : 0;
+	}
+	else
+		m_hits += entry.state == ENTRY_RESIDENT ? 1 : 0;
+
+	m_absent += entry.state == ENTRY_ABSENT ? 1 : 0;
+	return entry.payload;
+}
+
+void ChunkStreamer::save(const ChunkCoord& coord, const VoxelChunk& chunk)
+{
+	if (!m_settings.saveGenerated)
+		return;
+
+	std::shared_ptr<std::vector<uint8_t>> payload = std::make_shared<std::vector<uint8_t>>();
+	RegionFile::encode(chunk, *payload);
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_entries.find(coord);
+		if (it == m_entries.end())
+		{
+			m_lru.push_front(coord);
+			it = m_entries.emplace(coord, Entry{ ENTRY_QUEUED, nullptr, m_lru.begin(), Clock::now(), 0 }).first;
+			m_residentBytes += ENTRY_OVERHEAD;
+		}
+		resolve(it->second, ENTRY_RESIDENT, payload);
+		m_writes.push_back({ coord, payload });
+		evict();
+	}
+	m_wake.notify_one();
+	m_resolved.notify_all();
+}
+
+ChunkStreamer::Stats ChunkStreamer::getStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	Stats stats = {};
+	stats.fetches = m_fetches;
+	stats.hits = m_hits;
+	stats.stalls = m_stalls;
+	stats.absent = m_absent;
+	stats.resident = m_entries.size();
+	stats.residentBytes = m_residentBytes;
+	stats.evictions = m_evictions;
+	stats.pendingReads = m_reads.size();
+	stats.reads = m_readCount;
+	stats.bytesRead = m_bytesRead;
+	stats.writes = m_writeCount;
+	stats.bytesWritten = m_bytesWritten;
+	stats.averageLatencyMs = m_readCount > 0 ? m_latencyMs / m_readCount : 0.0;
+	stats.maxLatencyMs = m_maxLatencyMs;
+	return stats;
+}
+
+void ChunkStreamer::ioLoop()
+{
+	Profiler::getInstance().setThreadName("chunk io");
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		m_wake.wait(lock, [this]() { return m_stop || !m_reads.empty() || !m_writes.empty(); });
+
+		// Writes first, and all of them before stopping so nothing generated is lost
+		if (!m_writes.empty())
+		{
+			std::vector<Write> writes;
+			writes.swap(m_writes);
+			lock.unlock();
+
+			size_t count = 0, bytes = 0;
+			{
+				PROFILE_SCOPE("chunk writes");
+				for (const Write& write : writes)
+				{
+					if (!m_regions.write(write.coord, write.payload->data(), write.payload->size()))
+						continue;
+					count++;
+					bytes += write.payload->size();
+				}
+			}
+
+			lock.lock();
+			m_writeCount += count;
+			m_bytesWritten += bytes;
+			continue;
+		}
+		if (m_stop)
+			return;
+
+		// The camera moved: drop reads that got resolved otherwise and sort the rest again
+		if (m_reorder)
+		{
+			m_reads.erase(std::remove_if(m_reads.begin(), m_reads.end(), [this](const Read& read) {
+				auto it = m_entries.find(read.coord);
+				return it == m_entries.end() || it->second.state != ENTRY_QUEUED;
+			}), m_reads.end());
+			for (Read& read : m_reads)
+				if (read.distance >= 0.0f)
+					read.distance = distanceTo(read.coord);
+			std::make_heap(m_reads.begin(), m_reads.end(), farther);
+			m_reorder = false;
+			if (m_reads.empty())
+				continue;
+		}
+
+		std::pop_heap(m_reads.begin(), m_reads.end(), farther);
+		const ChunkCoord coord = m_reads.back().coord;
+		m_reads.pop_back();
+		auto it = m_entries.find(coord);
+		if (it == m_entries.end() || it->second.state != ENTRY_QUEUED)
+			continue;
+		lock.unlock();
+
+		// Copied out of the mapping, which the next write may replace
+		Payload payload;
+		{
+			PROFILE_SCOPE("chunk read");
+			const uint8_t* data;
+			size_t bytes;
+			if (m_regions.read(coord, data, bytes))
+				payload = std::make_shared<const std::vector<uint8_t>>(data, data + bytes);
+		}
+
+		lock.lock();
+		it = m_entries.find(coord);
+		if (it == m_entries.end() || it->second.state != ENTRY_QUEUED)
+			continue;
+
+		const double latency = std::chrono::duration<double, std::milli>(Clock::now() - it->second.requested).count();
+		m_latencyMs += latency;
+		m_maxLatencyMs = std::max(m_maxLatencyMs, latency);
+		m_readCount++;
+		m_bytesRead += payload ? payload->size() : 0;
+		const EntryState state = payload ? ENTRY_RESIDENT : ENTRY_ABSENT;
+		resolve(it->second, state, std::move(payload));
+		evict();
+		m_resolved.notify_all();
+	}
+}
@@ -0,0 +1,170 @@
+/**
+ * @file    ChunkStreamer.h
+ * @brief   Saved chunks streamed around the camera by an I/O thread
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __CHUNKSTREAMER_H__
+#define __CHUNKSTREAMER_H__
+
+#include "util/Math3D.h"
+#include "voxel/RegionStore.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/**
+ * Keeps the encoded payloads of the saved chunks in a ring around the camera resident,
+ * and those of a second ring ahead of it along its velocity, so the ChunkJobSystem
+ * workers find them in memory by the time they get to the chunks. One I/O thread owns
+ * the RegionStore: it reads the requested payloads, closest to the camera first, and
+ * writes the payloads of newly generated chunks so later runs load them instead.
+ *
+ * Payloads stay encoded while resident, the workers decode them (see fetch()). Past the
+ * memory budget the least recently used payloads are evicted, except those inside
+ * either ring. Chunks that were never saved are remembered as absent, so the workers
+ * generate them without waiting for a read.
+ */
+class ChunkStreamer
+{
+	public:
+		typedef std::shared_ptr<const std::vector<uint8_t>> Payload;
+
+		struct Settings
+		{
+			std::string directory;     // region files
+			int ringRadius;            // chunks kept resident around the camera, horizontally
+			int ringVerticalRadius;    // and vertically
+			float prefetchSeconds;     // the second ring is where the camera will be by then
+			size_t memoryBudgetBytes;  // resident payloads, absent chunks included
+			bool saveGenerated;        // write generated chunks so later runs load them
+		};
+
+		struct Stats
+		{
+			size_t fetches;            // payload lookups by the workers
+			size_t hits;               // resident by the time of the lookup
+			size_t stalls;             // the worker waited for the read
+			size_t absent;             // never saved, generated instead
+			size_t resident;           // entries, absent chunks included
+			size_t residentBytes;
+			size_t evictions;
+			size_t pendingReads;
+			size_t reads;
+			size_t bytesRead;
+			size_t writes;
+			size_t bytesWritten;
+			double averageLatencyMs;   // from a read's request to its payload being resident
+			double maxLatencyMs;
+
+			// Lookups of saved chunks that did not have to wait
+			inline double hitRate() const { return hits + stalls > 0 ? static_cast<double>(hits) / (hits + stalls) : 0.0; }
+		};
+
+		// Region files of another generator are neither read nor written
+		ChunkStreamer(const Settings& settings, const RegionFile::Generator& generator);
+		~ChunkStreamer();
+
+		ChunkStreamer(const ChunkStreamer&) = delete;
+		ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+
+		// Main thread, once per frame: follow the camera and estimate its velocity
+		void update(const glm::dvec3& position);
+
+		// Any thread: the payload of a saved chunk, null if it was never saved. Waits for
+		// the I/O thread when the payload is not resident yet, moving it to the front.
+		Payload fetch(const ChunkCoord& coord);
+		// Any thread: encode a generated chunk and queue it for writing
+		void save(const ChunkCoord& coord, const VoxelChunk& chunk);
+
+		inline const Settings& getSettings() const { return m_settings; }
+		inline glm::vec3 getVelocity() const { return m_velocity; }
+		Stats getStats() const;
+	private:
+		typedef std::chrono::steady_clock Clock;
+
+		enum EntryState
+		{
+			ENTRY_QUEUED,
+			ENTRY_RESIDENT,
+			ENTRY_ABSENT
+		};
+
+		struct Entry
+		{
+			EntryState state;
+			Payload payload;
+			std::list<ChunkCoord>::iterator lru;
+			Clock::time_point requested;
+			int waiters;           // workers in fetch(), which keep the entry from being evicted
+		};
+
+		struct Read
+		{
+			ChunkCoord coord;
+			float distance;        // squared, to the camera; negative for a waiting worker
+		};
+
+		struct Write
+		{
+			ChunkCoord coord;
+			Payload payload;
+		};
+
+		Settings m_settings;
+		RegionStore m_regions;     // I/O thread only
+		std::thread m_thread;
+
+		mutable std::mutex m_mutex;
+		std::condition_variable m_wake;      // the I/O thread
+		std::condition_variable m_resolved;  // workers waiting in fetch()
+		std::unordered_map<ChunkCoord, Entry, ChunkCoordHash> m_entries;
+		std::list<ChunkCoord> m_lru;         // most recently used first
+		std::vector<Read> m_reads;           // min-heap on distance
+		std::vector<Write> m_writes;
+		size_t m_residentBytes;
+		bool m_reorder;
+		bool m_stop;
+
+		// Camera, main thread only but for m_focus
+		glm::dvec3 m_position;
+		Clock::time_point m_time;
+		glm::vec3 m_velocity;
+		bool m_hasPosition;
+		ChunkCoord m_center, m_ahead;
+		float m_focus[3];
+
+		size_t m_fetches, m_hits, m_stalls, m_absent, m_evictions;
+		size_t m_readCount, m_bytesRead, m_writeCount, m_bytesWritten;
+		double m_latencyMs, m_maxLatencyMs;
+
+		// Heap order: the closest read on top
+		static bool farther(const Read& a, const Read& b) { return a.distance > b.distance; }
+
+		float distanceTo(const ChunkCoord& coord) const;
+		bool inRing(const ChunkCoord& coord, const ChunkCoord& center) const;
+		void requestRing(const ChunkCoord& center);
+		void touch(Entry& entry);
+		void resolve(Entry& entry, EntryState state, Payload payload);
+		void evict();
+		void ioLoop();
+};
+#endif // __CHUNKSTREAMER_H__
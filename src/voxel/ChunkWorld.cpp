@@ -0,0 +1,161 @@
+/**
+ * @file    ChunkWorld.cpp
+ * @brief   Streams terrain chunks around the camera and renders them
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "voxel/ChunkWorld.h"
+#include "util/Profiler.h"
+
+#include <cstdlib>
+
+// Loaded chunks are kept this many chunks past the view radius, so moving back and
+// forth across a chunk border does not unload and regenerate them
+static const int UNLOAD_MARGIN = 1;
+
+ChunkWorld::ChunkWorld(const TerrainGenerator& generator, const Settings& settings) :
+	m_settings(settings),
+	m_streamer(settings.streamer.directory.empty() ? nullptr :
+		new ChunkStreamer(settings.streamer, { generator.getSettings().seed, TerrainGenerator::VERSION })),
+	m_jobs(generator, settings.threads, m_streamer.get()), m_renderer(settings.renderer), m_boundsOrigin(0.0, 0.0, 0.0),
+	m_drawablesDirty(false), m_lastDrawn(0),
+	m_center{0, 0, 0}, m_hasCenter(false), m_lastUploads(0), m_lastUploadBytes(0)
+{
+
+}
+
+ChunkWorld::~ChunkWorld()
+{
+
+}
+
+bool ChunkWorld::inRange(const ChunkCoord& coord, int margin) const
+{
+	return std::abs(coord.x - m_center.x) <= m_settings.viewRadius + margin
+		&& std::abs(coord.z - m_center.z) <= m_settings.viewRadius + margin
+		&& std::abs(coord.y - m_center.y) <= m_settings.verticalRadius + margin;
+}
+
+void ChunkWorld::recenter(const ChunkCoord& center, const glm::dvec3& cameraPosition)
+{
+	PROFILE_SCOPE("recenter");
+	m_center = center;
+	m_hasCenter = true;
+	m_jobs.setFocus(static_cast<float>(cameraPosition.x), static_cast<float>(cameraPosition.y), static_cast<float>(cameraPosition.z));
+
+	// Stale jobs and chunks
+	for (auto it = m_loaded.begin(); it != m_loaded.end();)
+	{
+		if (!inRange(it->first, UNLOAD_MARGIN))
+		{
+			m_renderer.release(it->second);
+			m_store.removeChunk(it->first);
+			it = m_loaded.erase(it);
+			m_drawablesDirty = true;
+		}
+		else
+			++it;
+	}
+	m_jobs.cancelOutside(center, m_settings.viewRadius + UNLOAD_MARGIN, m_settings.verticalRadius + UNLOAD_MARGIN);
+
+	const int r = m_settings.viewRadius, h = m_settings.verticalRadius;
+	for (int z = center.z - r; z <= center.z + r; z++)
+		for (int y = center.y - h; y <= center.y + h; y++)
+			for (int x = center.x - r; x <= center.x + r; x++)
+			{
+				const ChunkCoord coord = { x, y, z };
+				if (!m_loaded.count(coord))
+					m_jobs.request(coord);
+			}
+}
+
+void ChunkWorld::update(const glm::dvec3& cameraPosition)
+{
+	PROFILE_SCOPE("world update");
+	const glm::ivec3 voxel = glm::ivec3(glm::floor(cameraPosition));
+	const ChunkCoord center = ChunkStore::chunkOf(voxel.x, voxel.y, voxel.z);
+	// Rings first, so their reads are queued before the workers ask for the chunks
+	if (m_streamer)
+		m_streamer->update(cameraPosition);
+	if (!m_hasCenter || center != m_center)
+		recenter(center, cameraPosition);
+
+	m_lastUploads = 0;
+	m_lastUploadBytes = 0;
+
+	ChunkJobSystem::Result result;
+	while (m_lastUploads < m_settings.maxUploadsPerFrame
+		&& m_lastUploadBytes < m_settings.uploadBudgetBytes
+		&& m_jobs.popCompleted(result))
+	{
+		// Finished after the camera moved away
+		if (!inRange(result.coord, UNLOAD_MARGIN))
+			continue;
+
+		if (!result.chunk->isUniform() || result.chunk->getUniformValue() != VOXEL_AIR)
+			m_store.insertChunk(result.coord, std::move(result.chunk));
+
+		ChunkRenderer::Allocation& allocation = m_loaded[result.coord];
+		m_drawablesDirty = true;
+		m_renderer.release(allocation);
+		if (result.mesh.empty())
+			continue;
+
+		allocation = m_renderer.upload(result.mesh);
+		m_lastUploads++;
+		m_lastUploadBytes += result.mesh.vertices.size() * sizeof(ChunkVertex) + result.mesh.indices.size() * sizeof(uint32_t);
+	}
+}
+
+void ChunkWorld::rebuildDrawables()
+{
+	m_bounds.clear();
+	m_drawables.clear();
+	for (const auto& entry : m_loaded)
+	{
+		if (entry.second.empty())
+			continue;
+
+		const ChunkCoord& coord = entry.first;
+		const glm::vec3 corner = glm::vec3(glm::dvec3(coord.x, coord.y, coord.z) * static_cast<double>(VoxelChunk::SIZE) - m_boundsOrigin);
+		m_bounds.add(corner, corner + glm::vec3(static_cast<float>(VoxelChunk::SIZE)));
+		m_drawables.emplace_back(coord, entry.second);
+	}
+	m_visible.resize(m_drawables.size());
+	m_drawablesDirty = false;
+}
+
+void ChunkWorld::render(const Frustum& frustum, const glm::dvec3& origin)
+{
+	PROFILE_SCOPE("world render");
+	if (m_drawablesDirty || origin != m_boundsOrigin)
+	{
+		m_boundsOrigin = origin;
+		rebuildDrawables();
+	}
+
+	m_lastDrawn = frustum.cull(m_bounds, m_visible.data());
+	m_renderer.begin();
+	for (size_t i = 0; i < m_lastDrawn; i++)
+	{
+		// Subtracted in double precision, only the small difference is a float
+		const ChunkCoord& coord = m_drawables[m_visible[i]].first;
+		const glm::vec3 corner = glm::vec3(glm::dvec3(coord.x, coord.y, coord.z) * static_cast<double>(VoxelChunk::SIZE) - origin);
+		m_renderer.add(m_drawables[m_visible[i]].second, corner);
+	}
+	m_renderer.submit();
+}
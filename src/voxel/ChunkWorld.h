@@ -0,0 +1,99 @@
+/**
+ * @file    ChunkWorld.h
+ * @brief   Streams terrain chunks around the camera and renders them
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __CHUNKWORLD_H__
+#define __CHUNKWORLD_H__
+
+#include "util/Common.h"
+#include "voxel/ChunkJobSystem.h"
+#include "voxel/ChunkRenderer.h"
+#include "util/Frustum.h"
+
+/**
+ * Keeps the chunks within the view radius of the camera requested on the ChunkJobSystem,
+ * which loads the saved ones through the ChunkStreamer (when there is a save directory),
+ * and uploads finished meshes into the ChunkRenderer on the main thread under a per-frame
+ * budget so a burst of completed jobs is spread over several frames. Jobs and chunks that
+ * fall out of range when the camera crosses a chunk border are cancelled or unloaded.
+ */
+class ChunkWorld
+{
+	public:
+		struct Settings
+		{
+			int viewRadius;            // chunks, horizontally
+			int verticalRadius;        // chunks, vertically
+			size_t uploadBudgetBytes;  // mesh bytes uploaded per frame at most
+			size_t maxUploadsPerFrame;
+			size_t threads;            // workers, 0 for automatic
+			ChunkRenderer::Settings renderer;
+			ChunkStreamer::Settings streamer;  // an empty directory saves and loads nothing
+		};
+
+		ChunkWorld(const TerrainGenerator& generator, const Settings& settings);
+		~ChunkWorld();
+
+		// Call once per frame on the GL thread
+		void update(const glm::dvec3& cameraPosition);
+		// Draw the loaded meshes inside the frustum with the chunk shader in use. The frustum
+		// and the chunk offsets are relative to the camera's floating origin.
+		void render(const Frustum& frustum, const glm::dvec3& origin);
+
+		inline ChunkStore& getStore() { return m_store; }
+		inline const ChunkJobSystem& getJobs() const { return m_jobs; }
+		// Null without a save directory
+		inline const ChunkStreamer* getStreamer() const { return m_streamer.get(); }
+		inline const ChunkRenderer& getRenderer() const { return m_renderer; }
+		inline size_t getLoadedCount() const { return m_loaded.size(); }
+		// The chunk came back from the jobs, a missing one in the store is really air
+		inline bool isLoaded(const ChunkCoord& coord) const { return m_loaded.count(coord) != 0; }
+		inline size_t getLastFrameUploads() const { return m_lastUploads; }
+		inline size_t getLastFrameUploadBytes() const { return m_lastUploadBytes; }
+		inline size_t getLastFrameDrawn() const { return m_lastDrawn; }
+		inline size_t getLastFrameCulled() const { return m_drawables.size() - m_lastDrawn; }
+	private:
+		Settings m_settings;
+		ChunkStore m_store;
+		std::unique_ptr<ChunkStreamer> m_streamer;  // before m_jobs, whose workers use it
+		ChunkJobSystem m_jobs;
+		ChunkRenderer m_renderer;
+
+		// Every chunk that came back from the jobs, with its mesh (empty when it has no faces)
+		std::unordered_map<ChunkCoord, ChunkRenderer::Allocation, ChunkCoordHash> m_loaded;
+
+		// Loaded meshes with their bounds relative to m_boundsOrigin, rebuilt when chunks are
+		// uploaded or unloaded or the origin moves
+		BoxBatch m_bounds;
+		glm::dvec3 m_boundsOrigin;
+		std::vector<std::pair<ChunkCoord, ChunkRenderer::Allocation>> m_drawables;
+		std::vector<uint32_t> m_visible;
+		bool m_drawablesDirty;
+		size_t m_lastDrawn;
+
+		ChunkCoord m_center;
+		bool m_hasCenter;
+		size_t m_lastUploads;
+		size_t m_lastUploadBytes;
+
+		bool inRange(const ChunkCoord& coord, int margin) const;
+		void recenter(const ChunkCoord& center, const glm::dvec3& cameraPosition);
+		void rebuildDrawables();
+};
+#endif // __CHUNKWORLD_H__
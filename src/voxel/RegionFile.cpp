@@ -0,0 +1,480 @@
+/**
+ * @file    RegionFile.cpp
+ * @brief   Chunks of a region packed into one memory-mapped file
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "voxel/RegionFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// File layout: header, CHUNKS table entries, payloads
+static const uint32_t REGION_MAGIC = 0x47525856; // "VXRG"
+static const uint32_t REGION_VERSION = 2;
+
+struct RegionHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t chunkSize;    // VoxelChunk::SIZE the file was written with
+	uint32_t regionSize;   // RegionFile::REGION
+	uint32_t generatorSeed;
+	uint32_t generatorVersion;
+};
+
+static const size_t TABLE_OFFSET = sizeof(RegionHeader);
+static const size_t PAYLOAD_OFFSET = TABLE_OFFSET + RegionFile::CHUNKS * 2 * sizeof(uint32_t);
+
+// Superseded bytes save() tolerates before compacting, besides the live bytes
+static const size_t COMPACT_SLACK = 256 * 1024;
+
+// Payload encodings, the first byte of a payload
+enum PayloadEncoding
+{
+	PAYLOAD_UNIFORM,  // one little-endian Voxel
+	PAYLOAD_PALETTE,  // palette size - 1, Voxels, then runs of a palette index byte and a length
+	PAYLOAD_DIRECT    // runs of a Voxel and a length
+};
+
+// Run lengths are stored minus one as LEB128, a single byte for runs up to 128
+static void putLength(std::vector<uint8_t>& out, size_t length)
+{
+	size_t value = length - 1;
+	while (value >= 0x80)
+	{
+		out.push_back(static_cast<uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<uint8_t>(value));
+}
+
+static inline void putVoxel(std::vector<uint8_t>& out, Voxel voxel)
+{
+	out.push_back(static_cast<uint8_t>(voxel));
+	out.push_back(static_cast<uint8_t>(voxel >> 8));
+}
+
+static bool writeAll(int file, const void* data, size_t bytes, size_t offset)
+{
+	const uint8_t* cursor = static_cast<const uint8_t*>(data);
+	while (bytes > 0)
+	{
+		const ssize_t written = pwrite(file, cursor, bytes, static_cast<off_t>(offset));
+		if (written <= 0)
+			return false;
+		cursor += written;
+		offset += written;
+		bytes -= written;
+	}
+	return true;
+}
+
+// Make a rename in the directory of path durable; the renamed file is complete either way
+static void syncDirectory(const std::string& path)
+{
+	const size_t slash = path.find_last_of('/');
+	const std::string directory = slash == std::string::npos ? "." : path.substr(0, slash + 1);
+	const int file = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+	if (file < 0)
+		return;
+	fsync(file);
+	::close(file);
+}
+
+RegionFile::RegionFile() :
+	m_generator{0, 0}, m_file(-1), m_map(nullptr), m_mapBytes(0), m_fileBytes(0), m_liveBytes(0), m_appends(0), m_compactions(0),
+	m_failedCompactions(0)
+{
+	std::memset(m_table, 0, sizeof(m_table));
+}
+
+RegionFile::~RegionFile()
+{
+	close();
+}
+
+bool RegionFile::open(const std::string& path, const Generator& generator)
+{
+	close();
+	m_file = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+	if (m_file < 0)
+		return false;
+	m_path = path;
+	m_generator = generator;
+
+	struct stat status;
+	if (fstat(m_file, &status) != 0)
+	{
+		close();
+		return false;
+	}
+	m_fileBytes = static_cast<size_t>(status.st_size);
+
+	if (m_fileBytes == 0)
+	{
+		// New file, an empty table
+		const RegionHeader header = { REGION_MAGIC, REGION_VERSION, VoxelChunk::SIZE, REGION, generator.seed, generator.version };
+		std::vector<uint8_t> empty(PAYLOAD_OFFSET, 0);
+		std::memcpy(empty.data(), &header, sizeof(header));
+		if (!writeAll(m_file, empty.data(), empty.size(), 0))
+		{
+			close();
+			return false;
+		}
+		m_fileBytes = PAYLOAD_OFFSET;
+	}
+
+	if (m_fileBytes < PAYLOAD_OFFSET || !map())
+	{
+		close();
+		return false;
+	}
+
+	RegionHeader header;
+	std::memcpy(&header, m_map, sizeof(header));
+	if (header.magic != REGION_MAGIC || header.version != REGION_VERSION ||
+		header.chunkSize != VoxelChunk::SIZE || header.regionSize != REGION ||
+		header.generatorSeed != generator.seed || header.generatorVersion != generator.version)
+	{
+		close();
+		return false;
+	}
+
+	// Entries past the end of the file are from a write that did not finish
+	std::memcpy(m_table, m_map + TABLE_OFFSET, sizeof(m_table));
+	for (Entry& entry : m_table)
+	{
+		if (entry.bytes != 0 && (entry.offset < PAYLOAD_OFFSET || static_cast<size_t>(entry.offset) + entry.bytes > m_fileBytes))
+			entry.bytes = 0;
+		m_liveBytes += entry.bytes;
+	}
+	return true;
+}
+
+void RegionFile::close()
+{
+	unmap();
+	if (m_file >= 0)
+		::close(m_file);
+	m_file = -1;
+	m_fileBytes = 0;
+	m_liveBytes = 0;
+	m_appends = 0;
+	m_compactions = 0;
+	m_failedCompactions = 0;
+	std::memset(m_table, 0, sizeof(m_table));
+}
+
+bool RegionFile::map()
+{
+	unmap();
+	void* address = mmap(nullptr, m_fileBytes, PROT_READ, MAP_SHARED, m_file, 0);
+	if (address == MAP_FAILED)
+		return false;
+	m_map = static_cast<const uint8_t*>(address);
+	m_mapBytes = m_fileBytes;
+	return true;
+}
+
+void RegionFile::unmap()
+{
+	if (m_map)
+		munmap(const_cast<uint8_t*>(m_map), m_mapBytes);
+	m_map = nullptr;
+	m_mapBytes = 0;
+}
+
+bool RegionFile::read(const ChunkCoord& coord, const uint8_t*& data, size_t& bytes)
+{
+	const Entry& entry = m_table[slotOf(coord)];
+	if (!isOpen() || entry.bytes == 0)
+		return false;
+
+	// Appends grow the file past the mapping, map it again once something there is read
+	if (static_cast<size_t>(entry.offset) + entry.bytes > m_mapBytes && !map())
+		return false;
+
+	data = m_map + entry.offset;
+	bytes = entry.bytes;
+	return true;
+}
+
+bool RegionFile::load(const ChunkCoord& coord, VoxelChunk& chunk)
+{
+	const uint8_t* data;
+	size_t bytes;
+	if (!read(coord, data, bytes))
+		return false;
+
+	// Uniform chunks skip the voxel array altogether
+	if (bytes == 3 && data[0] == PAYLOAD_UNIFORM)
+	{
+		chunk.fill(static_cast<Voxel>(data[1] | (data[2] << 8)));
+		return true;
+	}
+
+	m_voxels.resize(VoxelChunk::VOLUME);
+	if (!decode(data, bytes, m_voxels.data()))
+		return false;
+	chunk.load(m_voxels.data());
+	return true;
+}
+
+bool RegionFile::save(const ChunkCoord& coord, const VoxelChunk& chunk)
+{
+	m_payload.clear();
+	encode(chunk, m_payload);
+	return write(coord, m_payload.data(), m_payload.size());
+}
+
+bool RegionFile::write(const ChunkCoord& coord, const uint8_t* data, size_t bytes)
+{
+	if (!isOpen() || bytes == 0 || m_fileBytes + bytes > UINT32_MAX)
+		return false;
+
+	// Payload first: until the entry is overwritten the old payload stays the valid one
+	const int slot = slotOf(coord);
+	if (!writeAll(m_file, data, bytes, m_fileBytes))
+		return false;
+
+	Entry& entry = m_table[slot];
+	m_liveBytes += bytes - entry.bytes;
+	entry.offset = static_cast<uint32_t>(m_fileBytes);
+	entry.bytes = static_cast<uint32_t>(bytes);
+	m_fileBytes += bytes;
+	m_appends++;
+	if (!writeEntry(slot))
+		return false;
+
+	// The chunk is saved, a failed compaction leaves the file as it was
+	const size_t dead = m_fileBytes - PAYLOAD_OFFSET - m_liveBytes;
+	if (dead > m_liveBytes + COMPACT_SLACK && !compact())
+		m_failedCompactions++;
+	return true;
+}
+
+void RegionFile::erase(const ChunkCoord& coord)
+{
+	const int slot = slotOf(coord);
+	if (!isOpen() || m_table[slot].bytes == 0)
+		return;
+
+	m_liveBytes -= m_table[slot].bytes;
+	m_table[slot].offset = 0;
+	m_table[slot].bytes = 0;
+	writeEntry(slot);
+}
+
+bool RegionFile::writeEntry(int slot)
+{
+	return writeAll(m_file, &m_table[slot], sizeof(Entry), TABLE_OFFSET + slot * sizeof(Entry));
+}
+
+bool RegionFile::compact()
+{
+	if (!isOpen())
+		return false;
+	if (m_mapBytes < m_fileBytes && !map())
+		return false;
+
+	// Live payloads in slot order, so neighbouring chunks end up next to each other
+	Entry table[CHUNKS];
+	std::vector<uint8_t> contents(PAYLOAD_OFFSET);
+	contents.reserve(PAYLOAD_OFFSET + m_liveBytes);
+	for (int slot = 0; slot < CHUNKS; slot++)
+	{
+		const Entry& entry = m_table[slot];
+		table[slot].offset = entry.bytes != 0 ? static_cast<uint32_t>(contents.size()) : 0;
+		table[slot].bytes = entry.bytes;
+		contents.insert(contents.end(), m_map + entry.offset, m_map + entry.offset + entry.bytes);
+	}
+	const RegionHeader header = { REGION_MAGIC, REGION_VERSION, VoxelChunk::SIZE, REGION, m_generator.seed, m_generator.version };
+	std::memcpy(contents.data(), &header, sizeof(header));
+	std::memcpy(contents.data() + TABLE_OFFSET, table, sizeof(table));
+
+	// Write to a temporary file first, a crash must not leave a truncated region behind;
+	// it reaches the disk before the rename, or the rename could land without its contents
+	const std::string temporary = m_path + ".tmp";
+	const int file = ::open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (file < 0)
+		return false;
+	if (!writeAll(file, contents.data(), contents.size(), 0) || fsync(file) != 0 ||
+		std::rename(temporary.c_str(), m_path.c_str()) != 0)
+	{
+		::close(file);
+		std::remove(temporary.c_str());
+		return false;
+	}
+	syncDirectory(m_path);
+
+	unmap();
+	::close(m_file);
+	m_file = file;
+	m_fileBytes = contents.size();
+	std::memcpy(m_table, table, sizeof(m_table));
+	m_compactions++;
+	return map();
+}
+
+RegionFile::Stats RegionFile::getStats() const
+{
+	Stats stats = {};
+	for (const Entry& entry : m_table)
+		stats.chunks += entry.bytes != 0 ? 1 : 0;
+	stats.liveBytes = m_liveBytes;
+	stats.fileBytes = m_fileBytes;
+	stats.appends = m_appends;
+	stats.compactions = m_compactions;
+	stats.failedCompactions = m_failedCompactions;
+	return stats;
+}
+
+void RegionFile::encode(const VoxelChunk& chunk, std::vector<uint8_t>& out)
+{
+	if (chunk.isUniform())
+	{
+		out.push_back(PAYLOAD_UNIFORM);
+		putVoxel(out, chunk.getUniformValue());
+		return;
+	}
+
+	std::vector<Voxel> voxels(VoxelChunk::VOLUME);
+	chunk.copyTo(voxels.data());
+	encode(voxels.data(), out);
+}
+
+void RegionFile::encode(const Voxel* voxels, std::vector<uint8_t>& out)
+{
+	// Runs along x first, the fastest moving axis of index()
+	std::vector<std::pair<Voxel, uint32_t>> runs;
+	std::vector<Voxel> palette;
+	for (size_t i = 0; i < VoxelChunk::VOLUME; )
+	{
+		size_t end = i + 1;
+		while (end < VoxelChunk::VOLUME && voxels[end] == voxels[i])
+			end++;
+		runs.push_back(std::make_pair(voxels[i], static_cast<uint32_t>(end - i)));
+		palette.push_back(voxels[i]);
+		i = end;
+	}
+
+	if (runs.size() == 1)
+	{
+		out.push_back(PAYLOAD_UNIFORM);
+		putVoxel(out, voxels[0]);
+		return;
+	}
+
+	std::sort(palette.begin(), palette.end());
+	palette.erase(std::unique(palette.begin(), palette.end()), palette.end());
+
+	if (palette.size() > 256)
+	{
+		out.push_back(PAYLOAD_DIRECT);
+		for (const std::pair<Voxel, uint32_t>& run : runs)
+		{
+			putVoxel(out, run.first);
+			putLength(out, run.second);
+		}
+		return;
+	}
+
+	out.push_back(PAYLOAD_PALETTE);
+	out.push_back(static_cast<uint8_t>(palette.size() - 1));
+	for (Voxel voxel : palette)
+		putVoxel(out, voxel);
+	for (const std::pair<Voxel, uint32_t>& run : runs)
+	{
+		out.push_back(static_cast<uint8_t>(std::lower_bound(palette.begin(), palette.end(), run.first) - palette.begin()));
+		putLength(out, run.second);
+	}
+}
+
+bool RegionFile::decode(const uint8_t* data, size_t bytes, Voxel* voxels)
+{
+	const uint8_t* cursor = data;
+	const uint8_t* end = data + bytes;
+	if (cursor == end)
+		return false;
+
+	const uint8_t encoding = *cursor++;
+	if (encoding == PAYLOAD_UNIFORM)
+	{
+		if (end - cursor != 2)
+			return false;
+		std::fill(voxels, voxels + VoxelChunk::VOLUME, static_cast<Voxel>(cursor[0] | (cursor[1] << 8)));
+		return true;
+	}
+	if (encoding != PAYLOAD_PALETTE && encoding != PAYLOAD_DIRECT)
+		return false;
+
+	Voxel palette[256];
+	size_t paletteSize = 0;
+	if (encoding == PAYLOAD_PALETTE)
+	{
+		if (cursor == end)
+			return false;
+		paletteSize = static_cast<size_t>(*cursor++) + 1;
+		if (static_cast<size_t>(end - cursor) < paletteSize * 2)
+			return false;
+		for (size_t i = 0; i < paletteSize; i++, cursor += 2)
+			palette[i] = static_cast<Voxel>(cursor[0] | (cursor[1] << 8));
+	}
+
+	size_t filled = 0;
+	while (cursor != end)
+	{
+		Voxel voxel;
+		if (encoding == PAYLOAD_PALETTE)
+		{
+			if (*cursor >= paletteSize)
+				return false;
+			voxel = palette[*cursor++];
+		}
+		else
+		{
+			if (end - cursor < 2)
+				return false;
+			voxel = static_cast<Voxel>(cursor[0] | (cursor[1] << 8));
+			cursor += 2;
+		}
+
+		size_t length = 0;
+		for (int shift = 0; ; shift += 7)
+		{
+			if (cursor == end || shift > 21)
+				return false;
+			const uint8_t byte = *cursor++;
+			length |= static_cast<size_t>(byte & 0x7F) << shift;
+			if (!(byte & 0x80))
+				break;
+		}
+		length++;
+
+		if (length > VoxelChunk::VOLUME - filled)
+			return false;
+		std::fill(voxels + filled, voxels + filled + length, voxel);
+		filled += length;
+	}
+	return filled == VoxelChunk::VOLUME;
+}
@@ -0,0 +1,142 @@
+/**
+ * @file    RegionFile.h
+ * @brief   Chunks of a region packed into one memory-mapped file
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __REGIONFILE_H__
+#define __REGIONFILE_H__
+
+#include "voxel/ChunkStore.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * One file holds the REGION^3 chunks of a region: a header, a fixed table with the
+ * offset and length of every chunk's payload, then the payloads. A payload is a run
+ * length encoding of the chunk's voxels in index() order, through a palette of at most
+ * 256 values when there are that few (see encode()).
+ *
+ * Reads go through a read-only mapping of the file, so a payload is only copied when it
+ * gets decoded. Writes append the new payload and then overwrite its table entry, which
+ * leaves the previous payload valid until the entry points elsewhere; the superseded
+ * bytes are reclaimed by compact(), which save() runs once they outgrow the live ones.
+ * The header records the terrain generator the chunks came from, a file written by
+ * another one is not opened since its chunks would not match their generated
+ * neighbours. POSIX only. Not thread-safe, and payload views are invalidated by save()
+ * and compact().
+ */
+class RegionFile
+{
+	public:
+		static const int REGION_BITS = 3;
+		static const int REGION = 1 << REGION_BITS;
+		static const int CHUNKS = REGION * REGION * REGION;
+
+		// Terrain generator the chunks of a file came from
+		struct Generator
+		{
+			uint32_t seed;
+			uint32_t version;
+		};
+
+		struct Stats
+		{
+			size_t chunks;
+			size_t liveBytes;      // payloads the table points at
+			size_t fileBytes;      // header and table included
+			size_t appends;        // since open()
+			size_t compactions;
+			size_t failedCompactions;  // run by save(), whose payload was written regardless
+		};
+
+		RegionFile();
+		~RegionFile();
+
+		RegionFile(const RegionFile&) = delete;
+		RegionFile& operator=(const RegionFile&) = delete;
+
+		// Region of a chunk, and the chunk's slot in it
+		inline static ChunkCoord regionOf(const ChunkCoord& c)
+		{
+			return { c.x >> REGION_BITS, c.y >> REGION_BITS, c.z >> REGION_BITS };
+		}
+		inline static int slotOf(const ChunkCoord& c)
+		{
+			const int mask = REGION - 1;
+			return (c.x & mask) | ((c.y & mask) << REGION_BITS) | ((c.z & mask) << (2 * REGION_BITS));
+		}
+
+		// Opens or creates the file, false if it can't be, is not a region file or holds
+		// chunks of another generator
+		bool open(const std::string& path, const Generator& generator);
+		void close();
+		inline bool isOpen() const { return m_file >= 0; }
+
+		inline bool contains(const ChunkCoord& coord) const { return m_table[slotOf(coord)].bytes != 0; }
+
+		// Encoded payload of a chunk, pointing into the mapping; false if the chunk was never saved
+		bool read(const ChunkCoord& coord, const uint8_t*& data, size_t& bytes);
+		// Decoded chunk, false if it was never saved or its payload is corrupt
+		bool load(const ChunkCoord& coord, VoxelChunk& chunk);
+
+		// False if the payload or its entry could not be written, a failed compaction
+		// afterwards only shows in the stats
+		bool save(const ChunkCoord& coord, const VoxelChunk& chunk);
+		// Append an already encoded payload
+		bool write(const ChunkCoord& coord, const uint8_t* data, size_t bytes);
+		void erase(const ChunkCoord& coord);
+
+		// Rewrite the file with only the live payloads, through a temporary file that is
+		// synced before it replaces the region
+		bool compact();
+
+		Stats getStats() const;
+
+		// Payload of VOLUME voxels in index() order, appended to out
+		static void encode(const Voxel* voxels, std::vector<uint8_t>& out);
+		static void encode(const VoxelChunk& chunk, std::vector<uint8_t>& out);
+		// False if data is not a complete payload of VOLUME voxels
+		static bool decode(const uint8_t* data, size_t bytes, Voxel* voxels);
+	private:
+		struct Entry
+		{
+			uint32_t offset;
+			uint32_t bytes;       // 0 for a chunk that was never saved
+		};
+
+		std::string m_path;
+		Generator m_generator;
+		int m_file;
+		const uint8_t* m_map;
+		size_t m_mapBytes;
+		size_t m_fileBytes;
+		size_t m_liveBytes;
+		size_t m_appends;
+		size_t m_compactions;
+		size_t m_failedCompactions;
+		Entry m_table[CHUNKS];
+
+		std::vector<uint8_t> m_payload;
+		std::vector<Voxel> m_voxels;
+
+		bool map();
+		void unmap();
+		bool writeEntry(int slot);
+};
+#endif // __REGIONFILE_H__
@@ -0,0 +1,114 @@
+/**
+ * @file    RegionStore.cpp
+ * @brief   Directory of region files keyed by region coordinate
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "voxel/RegionStore.h"
+
+#include <filesystem>
+
+RegionStore::RegionStore(const std::string& directory, const RegionFile::Generator& generator) :
+	m_directory(directory), m_generator(generator), m_created(false)
+{
+
+}
+
+RegionFile* RegionStore::region(const ChunkCoord& coord)
+{
+	const ChunkCoord key = RegionFile::regionOf(coord);
+	auto it = m_regions.find(key);
+	if (it != m_regions.end())
+		return it->second.get();
+
+	if (!m_created)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(m_directory, error);
+		m_created = true;
+	}
+
+	const std::string path = m_directory + "/r." + std::to_string(key.x) + "." + std::to_string(key.y) + "." +
+		std::to_string(key.z) + ".vxr";
+	std::unique_ptr<RegionFile> file(new RegionFile());
+	if (!file->open(path, m_generator))
+		file.reset();
+	return m_regions.emplace(key, std::move(file)).first->second.get();
+}
+
+bool RegionStore::contains(const ChunkCoord& coord)
+{
+	RegionFile* file = region(coord);
+	return file && file->contains(coord);
+}
+
+bool RegionStore::load(const ChunkCoord& coord, VoxelChunk& chunk)
+{
+	RegionFile* file = region(coord);
+	return file && file->load(coord, chunk);
+}
+
+bool RegionStore::save(const ChunkCoord& coord, const VoxelChunk& chunk)
+{
+	RegionFile* file = region(coord);
+	return file && file->save(coord, chunk);
+}
+
+bool RegionStore::write(const ChunkCoord& coord, const uint8_t* data, size_t bytes)
+{
+	RegionFile* file = region(coord);
+	return file && file->write(coord, data, bytes);
+}
+
+bool RegionStore::read(const ChunkCoord& coord, const uint8_t*& data, size_t& bytes)
+{
+	RegionFile* file = region(coord);
+	return file && file->read(coord, data, bytes);
+}
+
+void RegionStore::compact()
+{
+	for (auto& region : m_regions)
+		if (region.second)
+			region.second->compact();
+}
+
+void RegionStore::close()
+{
+	m_regions.clear();
+}
+
+RegionStore::Stats RegionStore::getStats() const
+{
+	Stats stats = {};
+	for (const auto& region : m_regions)
+	{
+		if (!region.second)
+		{
+			stats.rejected++;
+			continue;
+		}
+		stats.regions++;
+		const RegionFile::Stats file = region.second->getStats();
+		stats.chunks += file.chunks;
+		stats.liveBytes += file.liveBytes;
+		stats.fileBytes += file.fileBytes;
+		stats.compactions += file.compactions;
+		stats.failedCompactions += file.failedCompactions;
+	}
+	return stats;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file    RegionStore.h
+ * @brief   Directory of region files keyed by region coordinate
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __REGIONSTORE_H__
+#define __REGIONSTORE_H__
+
+#include "voxel/RegionFile.h"
+
+#include <memory>
+#include <unordered_map>
+
+/**
+ * Saved chunks of a world: region (x, y, z) is the file "r.x.y.z.vxr" in the directory,
+ * opened on first use and kept open. A chunk that was never saved loads as a miss, so
+ * the caller generates it instead, and so does every chunk of a region file written by
+ * another generator; such a file is left as it is. Not thread-safe, like RegionFile.
+ */
+class RegionStore
+{
+	public:
+		struct Stats
+		{
+			size_t regions;        // open region files
+			size_t rejected;       // region files that could not be opened or are of another generator
+			size_t chunks;
+			size_t liveBytes;
+			size_t fileBytes;
+			size_t compactions;
+			size_t failedCompactions;
+		};
+
+		RegionStore(const std::string& directory, const RegionFile::Generator& generator);
+
+		bool contains(const ChunkCoord& coord);
+		bool load(const ChunkCoord& coord, VoxelChunk& chunk);
+		bool save(const ChunkCoord& coord, const VoxelChunk& chunk);
+		// Store an already encoded payload
+		bool write(const ChunkCoord& coord, const uint8_t* data, size_t bytes);
+		// Encoded payload, valid until the next save to the same region
+		bool read(const ChunkCoord& coord, const uint8_t*& data, size_t& bytes);
+
+		// Compact every open region
+		void compact();
+		// Close every region file, they reopen on the next access
+		void close();
+
+		Stats getStats() const;
+		inline const std::string& getDirectory() const { return m_directory; }
+	private:
+		std::string m_directory;
+		RegionFile::Generator m_generator;
+		bool m_created;
+		// Null for a region whose file was rejected, it is not retried until close()
+		std::unordered_map<ChunkCoord, std::unique_ptr<RegionFile>, ChunkCoordHash> m_regions;
+
+		// Null if the file can't be opened
+		RegionFile* region(const ChunkCoord& coord);
+};
+#endif // __REGIONSTORE_H__
@@ -0,0 +1,392 @@
+/**
+ * @file    SparseVoxelOctree.cpp
+ * @brief   Sparse voxel octree and DAG for large and distant bodies
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "voxel/SparseVoxelOctree.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+// Noise bodies are sampled in bricks of BRICK^3 voxels once their nodes get that small
+static const int BRICK = 8;
+// Float slack on the density bounds, in voxels
+static const float BOUND_MARGIN = 1.0f;
+
+class SparseVoxelOctree::Builder
+{
+	public:
+		explicit Builder(SparseVoxelOctree& tree) : m_tree(tree) {}
+
+		// Leaf when all 8 children are the same voxel, otherwise a new or shared node
+		uint32_t node(const uint32_t children[8]);
+		// Subtree of the size^3 block at x, y, z of a 2^sideBits cube in VoxelChunk order
+		uint32_t dense(const Voxel* voxels, int sideBits, int x, int y, int z, int size);
+		uint32_t chunks(const ChunkStore& store, const ChunkCoord& origin, int x, int y, int z, int size);
+		uint32_t noise(const SimplexNoise& noise, const NoiseBody& body, int x, int y, int z, int size);
+	private:
+		struct NodeHash
+		{
+			inline size_t operator()(const Node& node) const
+			{
+				uint64_t h = 0xcbf29ce484222325ull;
+				for (uint32_t child : node.children)
+					h = (h ^ child) * 0x100000001b3ull;
+				return static_cast<size_t>(h ^ (h >> 32));
+			}
+		};
+		struct NodeEqual
+		{
+			inline bool operator()(const Node& a, const Node& b) const
+			{
+				return std::equal(a.children, a.children + 8, b.children);
+			}
+		};
+
+		SparseVoxelOctree& m_tree;
+		std::unordered_map<Node, uint32_t, NodeHash, NodeEqual> m_unique;
+		std::vector<Voxel> m_voxels;
+};
+
+uint32_t SparseVoxelOctree::Builder::node(const uint32_t children[8])
+{
+	if ((children[0] & LEAF) && std::all_of(children + 1, children + 8, [&](uint32_t c) { return c == children[0]; }))
+		return children[0];
+
+	Node node;
+	std::copy(children, children + 8, node.children);
+	if (m_tree.m_settings.deduplicate)
+	{
+		auto it = m_unique.find(node);
+		if (it != m_unique.end())
+		{
+			m_tree.m_shared++;
+			return it->second;
+		}
+	}
+
+	// Most common solid child, when at least half of them are solid
+	Voxel coarse[8];
+	int solid = 0;
+	for (int i = 0; i < 8; i++)
+		if ((coarse[solid] = m_tree.coarseOf(children[i])) != VOXEL_AIR)
+			solid++;
+	Voxel value = VOXEL_AIR;
+	if (solid >= 4)
+	{
+		int best = 0;
+		for (int i = 0; i < solid; i++)
+		{
+			const int count = static_cast<int>(std::count(coarse, coarse + solid, coarse[i]));
+			if (count > best)
+			{
+				best = count;
+				value = coarse[i];
+			}
+		}
+	}
+
+	const uint32_t index = static_cast<uint32_t>(m_tree.m_nodes.size());
+	m_tree.m_nodes.push_back(node);
+	m_tree.m_coarse.push_back(value);
+	if (m_tree.m_settings.deduplicate)
+		m_unique.emplace(node, index);
+	return index;
+}
+
+uint32_t SparseVoxelOctree::Builder::dense(const Voxel* voxels, int sideBits, int x, int y, int z, int size)
+{
+	if (size == 1)
+		return LEAF | voxels[x | (y << sideBits) | (z << (2 * sideBits))];
+
+	const int half = size / 2;
+	uint32_t children[8];
+	for (int i = 0; i < 8; i++)
+		children[i] = dense(voxels, sideBits, x + (i & 1) * half, y + ((i >> 1) & 1) * half, z + (i >> 2) * half, half);
+	return node(children);
+}
+
+uint32_t SparseVoxelOctree::Builder::chunks(const ChunkStore& store, const ChunkCoord& origin, int x, int y, int z, int size)
+{
+	if (size == VoxelChunk::SIZE)
+	{
+		const VoxelChunk* chunk = store.getChunk({ origin.x + (x >> VoxelChunk::SIZE_BITS),
+			origin.y + (y >> VoxelChunk::SIZE_BITS), origin.z + (z >> VoxelChunk::SIZE_BITS) });
+		if (!chunk)
+			return LEAF | VOXEL_AIR;
+		if (chunk->isUniform())
+			return LEAF | chunk->getUniformValue();
+		m_voxels.resize(VoxelChunk::VOLUME);
+		chunk->copyTo(m_voxels.data());
+		return dense(m_voxels.data(), VoxelChunk::SIZE_BITS, 0, 0, 0, VoxelChunk::SIZE);
+	}
+
+	const int half = size / 2;
+	uint32_t children[8];
+	for (int i = 0; i < 8; i++)
+		children[i] = chunks(store, origin, x + (i & 1) * half, y + ((i >> 1) & 1) * half, z + (i >> 2) * half, half);
+	return node(children);
+}
+
+uint32_t SparseVoxelOctree::Builder::noise(const SimplexNoise& noise, const NoiseBody& body, int x, int y, int z, int size)
+{
+	// Nearest and farthest voxel center of the node from the body center
+	const glm::vec3 center(static_cast<float>(m_tree.getSide()) * 0.5f);
+	const glm::vec3 lo(x + 0.5f, y + 0.5f, z + 0.5f), hi = lo + glm::vec3(static_cast<float>(size - 1));
+	const glm::vec3 nearest = glm::clamp(center, lo, hi) - center;
+	const glm::vec3 farthest = glm::max(glm::abs(lo - center), glm::abs(hi - center));
+	const float slack = std::abs(body.roughness) + BOUND_MARGIN;
+	if (glm::length(nearest) > body.radius + slack)
+		return LEAF | VOXEL_AIR;
+	if (glm::length(farthest) < body.radius - slack)
+		return LEAF | body.material;
+
+	if (size <= BRICK)
+	{
+		m_voxels.resize(static_cast<size_t>(size) * size * size);
+		sampleBody(noise, body, m_tree.getLevels(), glm::ivec3(x, y, z), size, m_voxels.data());
+		int sideBits = 0;
+		while ((1 << sideBits) < size)
+			sideBits++;
+		return dense(m_voxels.data(), sideBits, 0, 0, 0, size);
+	}
+
+	const int half = size / 2;
+	uint32_t children[8];
+	for (int i = 0; i < 8; i++)
+		children[i] = this->noise(noise, body, x + (i & 1) * half, y + ((i >> 1) & 1) * half, z + (i >> 2) * half, half);
+	return node(children);
+}
+
+SparseVoxelOctree::SparseVoxelOctree(const Settings& settings) :
+	m_settings(settings),
+	m_root(LEAF | VOXEL_AIR),
+	m_shared(0),
+	m_buildMs(0.0)
+{
+	m_settings.levels = std::min(std::max(m_settings.levels, 0), MAX_LEVELS);
+}
+
+void SparseVoxelOctree::build(const ChunkStore& store, const ChunkCoord& origin)
+{
+	const auto start = std::chrono::steady_clock::now();
+	m_nodes.clear();
+	m_coarse.clear();
+	m_shared = 0;
+
+	{
+		Builder builder(*this);
+		m_root = m_settings.levels >= VoxelChunk::SIZE_BITS ? builder.chunks(store, origin, 0, 0, 0, getSide()) : LEAF | VOXEL_AIR;
+	}
+	m_nodes.shrink_to_fit();
+	m_coarse.shrink_to_fit();
+	m_buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void SparseVoxelOctree::build(const SimplexNoise& noise, const NoiseBody& body)
+{
+	const auto start = std::chrono::steady_clock::now();
+	m_nodes.clear();
+	m_coarse.clear();
+	m_shared = 0;
+
+	{
+		Builder builder(*this);
+		m_root = builder.noise(noise, body, 0, 0, 0, getSide());
+	}
+	m_nodes.shrink_to_fit();
+	m_coarse.shrink_to_fit();
+	m_buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void SparseVoxelOctree::sampleBody(const SimplexNoise& noise, const NoiseBody& body, int levels,
+	const glm::ivec3& min, int size, Voxel* voxels)
+{
+	const size_t count = static_cast<size_t>(size) * size * size;
+	std::vector<float> density(count);
+	noise.fractalGrid(body.octaves, density.data(), size, size, size,
+		min.x + 0.5f, min.y + 0.5f, min.z + 0.5f, 1.0f, size, static_cast<size_t>(size) * size);
+
+	const glm::vec3 center(static_cast<float>(1 << levels) * 0.5f);
+	size_t i = 0;
+	for (int z = 0; z < size; z++)
+		for (int y = 0; y < size; y++)
+			for (int x = 0; x < size; x++, i++)
+			{
+				const glm::vec3 offset = glm::vec3(min.x + x + 0.5f, min.y + y + 0.5f, min.z + z + 0.5f) - center;
+				voxels[i] = body.radius - glm::length(offset) + body.roughness * density[i] > 0.0f ? body.material : VOXEL_AIR;
+			}
+}
+
+Voxel SparseVoxelOctree::get(int x, int y, int z) const
+{
+	const int side = getSide();
+	if (x < 0 || y < 0 || z < 0 || x >= side || y >= side || z >= side)
+		return VOXEL_AIR;
+
+	uint32_t word = m_root;
+	for (int bit = m_settings.levels - 1; !(word & LEAF); bit--)
+		word = m_nodes[word].children[((x >> bit) & 1) | (((y >> bit) & 1) << 1) | (((z >> bit) & 1) << 2)];
+	return static_cast<Voxel>(word);
+}
+
+bool SparseVoxelOctree::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+	Hit& hit, int maxDepth) const
+{
+	Ray ray;
+	ray.origin = origin;
+	ray.direction = direction;
+	ray.maxDepth = maxDepth;
+
+	// Clip the ray to the cube
+	const float side = static_cast<float>(getSide());
+	float t0 = 0.0f, t1 = maxDistance;
+	int axis = -1;
+	for (int i = 0; i < 3; i++)
+	{
+		if (direction[i] == 0.0f)
+		{
+			ray.inverse[i] = std::numeric_limits<float>::infinity();
+			if (origin[i] < 0.0f || origin[i] >= side)
+				return false;
+			continue;
+		}
+		ray.inverse[i] = 1.0f / direction[i];
+		float enter = -origin[i] * ray.inverse[i], exit = (side - origin[i]) * ray.inverse[i];
+		if (enter > exit)
+			std::swap(enter, exit);
+		if (enter > t0)
+		{
+			t0 = enter;
+			axis = i;
+		}
+		t1 = std::min(t1, exit);
+	}
+	if (t0 > t1)
+		return false;
+	return raycast(m_root, glm::vec3(0.0f), side, 0, t0, t1, axis, ray, hit);
+}
+
+bool SparseVoxelOctree::raycast(uint32_t word, const glm::vec3& min, float size, int depth, float t0, float t1,
+	int axis, const Ray& ray, Hit& hit) const
+{
+	if ((word & LEAF) || depth == ray.maxDepth)
+	{
+		const Voxel voxel = coarseOf(word);
+		if (voxel == VOXEL_AIR)
+			return false;
+		hit.distance = t0;
+		hit.voxel = voxel;
+		hit.cell = glm::ivec3(min);
+		hit.size = static_cast<int>(size);
+		hit.normal = glm::ivec3(0);
+		if (axis >= 0)
+			hit.normal[axis] = ray.direction[axis] > 0.0f ? -1 : 1;
+		return true;
+	}
+
+	// Parameters where the ray crosses the three middle planes, and the child it
+	// starts in; front to back, the children follow by flipping the crossed axis
+	const float half = size * 0.5f;
+	const glm::vec3 mid = min + glm::vec3(half);
+	float tm[3];
+	int child = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		if (ray.direction[i] == 0.0f)
+		{
+			tm[i] = std::numeric_limits<float>::infinity();
+			child |= (ray.origin[i] >= mid[i]) << i;
+			continue;
+		}
+		tm[i] = (mid[i] - ray.origin[i]) * ray.inverse[i];
+		child |= (ray.direction[i] > 0.0f ? tm[i] <= t0 : tm[i] > t0) << i;
+	}
+
+	const Node& node = m_nodes[word];
+	float t = t0;
+	for (;;)
+	{
+		float exit = t1;
+		int next = -1;
+		for (int i = 0; i < 3; i++)
+		{
+			const bool ahead = ray.direction[i] > 0.0f ? !((child >> i) & 1) : ray.direction[i] < 0.0f && ((child >> i) & 1);
+			if (ahead && tm[i] < exit)
+			{
+				exit = tm[i];
+				next = i;
+			}
+		}
+
+		const glm::vec3 childMin(min.x + (child & 1) * half, min.y + ((child >> 1) & 1) * half, min.z + (child >> 2) * half);
+		if (raycast(node.children[child], childMin, half, depth + 1, t, exit, axis, ray, hit))
+			return true;
+		if (next < 0)
+			return false;
+		child ^= 1 << next;
+		axis = next;
+		t = exit;
+	}
+}
+
+void SparseVoxelOctree::selectLod(const glm::vec3& viewer, float detail, std::vector<LodCell>& cells) const
+{
+	cells.clear();
+	selectLod(m_root, glm::ivec3(0), getSide(), viewer, detail, cells);
+}
+
+void SparseVoxelOctree::selectLod(uint32_t word, const glm::ivec3& min, int size, const glm::vec3& viewer,
+	float detail, std::vector<LodCell>& cells) const
+{
+	if (!(word & LEAF))
+	{
+		const glm::vec3 lo(min), hi = lo + glm::vec3(static_cast<float>(size));
+		const float distance = glm::length(glm::max(glm::max(lo - viewer, viewer - hi), glm::vec3(0.0f)));
+		if (static_cast<float>(size) > detail * distance)
+		{
+			const int half = size / 2;
+			const Node& node = m_nodes[word];
+			for (int i = 0; i < 8; i++)
+				selectLod(node.children[i], min + glm::ivec3((i & 1) * half, ((i >> 1) & 1) * half, (i >> 2) * half),
+					half, viewer, detail, cells);
+			return;
+		}
+	}
+
+	const Voxel voxel = coarseOf(word);
+	if (voxel != VOXEL_AIR)
+		cells.push_back({ min, size, voxel });
+}
+
+SparseVoxelOctree::Stats SparseVoxelOctree::getStats() const
+{
+	Stats stats;
+	stats.nodes = m_nodes.size();
+	stats.leaves = (m_root & LEAF) ? 1 : 0;
+	for (const Node& node : m_nodes)
+		stats.leaves += std::count_if(node.children, node.children + 8, [](uint32_t c) { return (c & LEAF) != 0; });
+	stats.sharedNodes = m_shared;
+	stats.bytes = sizeof(SparseVoxelOctree) + m_nodes.capacity() * sizeof(Node) + m_coarse.capacity() * sizeof(Voxel);
+	stats.bytesPerVoxel = stats.bytes / std::pow(8.0, m_settings.levels);
+	stats.buildMs = m_buildMs;
+	return stats;
+}
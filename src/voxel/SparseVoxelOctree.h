@@ -0,0 +1,152 @@
+/**
+ * @file    SparseVoxelOctree.h
+ * @brief   Sparse voxel octree and DAG for large and distant bodies
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __SPARSEVOXELOCTREE_H__
+#define __SPARSEVOXELOCTREE_H__
+
+#include "util/Math3D.h"
+#include "util/SimplexNoise.h"
+#include "voxel/ChunkStore.h"
+
+#include <vector>
+
+/**
+ * Cube of 2^levels voxels per side as an octree whose uniform subtrees collapse into a
+ * single leaf, so solid interiors and empty space cost one word however large they are.
+ * A node holds 8 child words, child x | y << 1 | z << 2 of its halves; a word is either
+ * a leaf voxel (LEAF bit set) or the index of another node. With deduplication every
+ * distinct subtree is stored once and shared by all its occurrences, which turns the
+ * tree into a DAG.
+ *
+ * Every node also keeps a coarse voxel standing for its subtree: the most common solid
+ * child when at least half of the children are solid, air otherwise. Raycasts and the
+ * level of detail query read it instead of descending into subtrees too small to matter.
+ *
+ * Coordinates are in voxels from the lower corner of the cube. Immutable once built,
+ * build again to change it; the const methods are safe to call from several threads.
+ */
+class SparseVoxelOctree
+{
+	public:
+		static constexpr int MAX_LEVELS = 20;
+
+		struct Settings
+		{
+			int levels;          // of subdivision, the cube is 2^levels voxels per side
+			bool deduplicate;    // share identical subtrees (DAG)
+		};
+
+		// Body centered in the cube, solid where
+		// radius - distance to the center + roughness * fractal(voxel center) > 0
+		struct NoiseBody
+		{
+			float radius;        // of the mean surface, voxels
+			float roughness;     // surface goes radius +- roughness
+			size_t octaves;
+			Voxel material;
+		};
+
+		struct Stats
+		{
+			size_t nodes;
+			size_t leaves;        // child words holding a voxel, air included
+			size_t sharedNodes;   // subtrees found already stored while building
+			size_t bytes;         // nodes, coarse voxels and the object
+			double bytesPerVoxel; // over the whole cube
+			double buildMs;
+		};
+
+		struct Hit
+		{
+			float distance;       // along the ray, to where it enters the cell
+			Voxel voxel;
+			glm::ivec3 cell;      // lower corner of the leaf or coarse node hit
+			int size;             // its side, 1 for a single voxel
+			glm::ivec3 normal;    // of the face entered through, zero when starting inside
+		};
+
+		struct LodCell
+		{
+			glm::ivec3 min;
+			int size;
+			Voxel voxel;
+		};
+
+		explicit SparseVoxelOctree(const Settings& settings);
+
+		// The chunks of store from chunk origin on, which lands at the lower corner;
+		// missing chunks are air. Needs levels >= VoxelChunk::SIZE_BITS.
+		void build(const ChunkStore& store, const ChunkCoord& origin);
+		// Density of noise at the voxel centers, only sampled in the nodes the surface
+		// can cross given the noise stays within -1 to 1
+		void build(const SimplexNoise& noise, const NoiseBody& body);
+
+		// Voxels of the size^3 block at min of a body in a 2^levels cube, in VoxelChunk
+		// index order; what build() samples, for flat chunks of the same body
+		static void sampleBody(const SimplexNoise& noise, const NoiseBody& body, int levels,
+			const glm::ivec3& min, int size, Voxel* voxels);
+
+		// Air outside the cube
+		Voxel get(int x, int y, int z) const;
+
+		// First solid cell along a ray of unit direction within maxDistance. Nodes maxDepth
+		// levels below the root count as leaves holding their coarse voxel, -1 for full detail.
+		bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+			Hit& hit, int maxDepth = -1) const;
+
+		// Solid cells covering the body, coarse nodes as soon as their side is at most
+		// detail times their distance to the viewer, leaves where the tree ends first
+		void selectLod(const glm::vec3& viewer, float detail, std::vector<LodCell>& cells) const;
+
+		inline int getLevels() const { return m_settings.levels; }
+		inline int getSide() const { return 1 << m_settings.levels; }
+		Stats getStats() const;
+	private:
+		static const uint32_t LEAF = 0x80000000u;
+
+		struct Node
+		{
+			uint32_t children[8];
+		};
+
+		struct Ray
+		{
+			glm::vec3 origin, direction, inverse;
+			int maxDepth;
+		};
+
+		// Build state, only alive during build()
+		class Builder;
+
+		Settings m_settings;
+		uint32_t m_root;
+		std::vector<Node> m_nodes;
+		std::vector<Voxel> m_coarse;  // per node
+		size_t m_shared;
+		double m_buildMs;
+
+		inline Voxel coarseOf(uint32_t word) const { return (word & LEAF) ? static_cast<Voxel>(word) : m_coarse[word]; }
+
+		bool raycast(uint32_t word, const glm::vec3& min, float size, int depth, float t0, float t1,
+			int axis, const Ray& ray, Hit& hit) const;
+		void selectLod(uint32_t word, const glm::ivec3& min, int size, const glm::vec3& viewer,
+			float detail, std::vector<LodCell>& cells) const;
+};
+#endif // __SPARSEVOXELOCTREE_H__
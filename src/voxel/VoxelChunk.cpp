@@ -0,0 +1,234 @@
+/**
+ * @file    VoxelChunk.cpp
+ * @brief   Fixed-size voxel chunk with palette compressed storage
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "voxel/VoxelChunk.h"
+
+#include <algorithm>
+
+static const size_t NO_ENTRY = static_cast<size_t>(-1);
+static const size_t MAX_PALETTE = 256;
+
+// Smallest of 1, 2, 4, 8 bits able to index entries palette slots
+static int bitsFor(size_t entries)
+{
+	int bits = 1;
+	while ((size_t(1) << bits) < entries)
+		bits *= 2;
+	return bits;
+}
+
+VoxelChunk::VoxelChunk(Voxel fill) :
+	m_bits(0), m_shift(0), m_direct(false), m_uniform(fill)
+{
+
+}
+
+void VoxelChunk::set(size_t index, Voxel voxel)
+{
+	if (m_bits == 0)
+	{
+		if (voxel == m_uniform)
+			return;
+
+		// Split the uniform chunk: every voxel references entry 0
+		m_palette.assign(1, m_uniform);
+		m_counts.assign(1, static_cast<uint32_t>(VOLUME));
+		m_bits = 1;
+		m_shift = 6;
+		m_words.assign(VOLUME / 64, 0);
+	}
+
+	if (m_direct)
+	{
+		writeIndex(index, voxel);
+		return;
+	}
+
+	const size_t previous = readIndex(index);
+	if (m_palette[previous] == voxel)
+		return;
+
+	const size_t entry = paletteEntry(voxel);
+	if (entry == NO_ENTRY)
+	{
+		// The palette overflowed and the chunk switched to direct storage
+		writeIndex(index, voxel);
+		return;
+	}
+
+	m_counts[previous]--;
+	m_counts[entry]++;
+	writeIndex(index, entry);
+
+	if (m_counts[entry] == VOLUME)
+		fill(voxel);
+}
+
+size_t VoxelChunk::paletteEntry(Voxel voxel)
+{
+	size_t freeSlot = NO_ENTRY;
+	for (size_t i = 0; i < m_palette.size(); i++)
+	{
+		if (m_counts[i] == 0)
+		{
+			if (freeSlot == NO_ENTRY)
+				freeSlot = i;
+		}
+		else if (m_palette[i] == voxel)
+			return i;
+	}
+
+	if (freeSlot != NO_ENTRY)
+	{
+		m_palette[freeSlot] = voxel;
+		return freeSlot;
+	}
+
+	if (m_palette.size() == MAX_PALETTE)
+	{
+		resize(16, true);
+		return NO_ENTRY;
+	}
+
+	if (m_palette.size() == (size_t(1) << m_bits))
+		resize(m_bits * 2, false);
+
+	m_palette.push_back(voxel);
+	m_counts.push_back(0);
+	return m_palette.size() - 1;
+}
+
+void VoxelChunk::resize(int bits, bool direct)
+{
+	// A uniform chunk references entry 0 everywhere
+	std::vector<uint16_t> entries(VOLUME, 0);
+	if (m_bits != 0)
+	{
+		for (size_t i = 0; i < VOLUME; i++)
+			entries[i] = static_cast<uint16_t>(readIndex(i));
+	}
+
+	if (direct && !m_direct && m_bits != 0)
+	{
+		for (size_t i = 0; i < VOLUME; i++)
+			entries[i] = m_palette[entries[i]];
+		std::vector<Voxel>().swap(m_palette);
+		std::vector<uint32_t>().swap(m_counts);
+	}
+
+	m_bits = bits;
+	m_shift = 6;
+	while ((1 << (6 - m_shift)) < bits)
+		m_shift--;
+	m_direct = direct;
+	m_words.assign(VOLUME * bits / 64, 0);
+
+	for (size_t i = 0; i < VOLUME; i++)
+		writeIndex(i, entries[i]);
+}
+
+void VoxelChunk::fill(Voxel voxel)
+{
+	m_bits = 0;
+	m_shift = 0;
+	m_direct = false;
+	m_uniform = voxel;
+	std::vector<Voxel>().swap(m_palette);
+	std::vector<uint32_t>().swap(m_counts);
+	std::vector<uint64_t>().swap(m_words);
+}
+
+void VoxelChunk::load(const Voxel* voxels)
+{
+	// Distinct values, as a bitset over the whole Voxel range
+	std::vector<uint64_t> present(65536 / 64, 0);
+	size_t distinct = 0;
+	for (size_t i = 0; i < VOLUME; i++)
+	{
+		uint64_t& word = present[voxels[i] >> 6];
+		const uint64_t bit = uint64_t(1) << (voxels[i] & 63);
+		if (!(word & bit))
+		{
+			word |= bit;
+			distinct++;
+		}
+	}
+
+	if (distinct == 1)
+	{
+		fill(voxels[0]);
+		return;
+	}
+
+	if (distinct > MAX_PALETTE)
+	{
+		fill(VOXEL_AIR);
+		resize(16, true);
+		for (size_t i = 0; i < VOLUME; i++)
+			writeIndex(i, voxels[i]);
+		return;
+	}
+
+	// Sorted palette, so entries can be found with a binary search
+	fill(VOXEL_AIR);
+	m_palette.reserve(distinct);
+	for (size_t w = 0; w < present.size(); w++)
+		for (uint64_t bits = present[w]; bits; bits &= bits - 1)
+			m_palette.push_back(static_cast<Voxel>(w * 64 + __builtin_ctzll(bits)));
+	m_counts.assign(distinct, 0);
+
+	resize(bitsFor(distinct), false);
+	for (size_t i = 0; i < VOLUME; i++)
+	{
+		const size_t entry = std::lower_bound(m_palette.begin(), m_palette.end(), voxels[i]) - m_palette.begin();
+		m_counts[entry]++;
+		writeIndex(i, entry);
+	}
+}
+
+void VoxelChunk::copyTo(Voxel* voxels) const
+{
+	if (m_bits == 0)
+	{
+		std::fill(voxels, voxels + VOLUME, m_uniform);
+		return;
+	}
+
+	for (size_t i = 0; i < VOLUME; i++)
+		voxels[i] = get(i);
+}
+
+void VoxelChunk::compact()
+{
+	if (m_bits == 0)
+		return;
+
+	std::vector<Voxel> voxels(VOLUME);
+	copyTo(voxels.data());
+	load(voxels.data());
+}
+
+size_t VoxelChunk::getMemoryUsage() const
+{
+	return sizeof(VoxelChunk)
+		+ m_palette.capacity() * sizeof(Voxel)
+		+ m_counts.capacity() * sizeof(uint32_t)
+		+ m_words.capacity() * sizeof(uint64_t);
+}
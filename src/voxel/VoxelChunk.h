@@ -0,0 +1,112 @@
+/**
+ * @file    VoxelChunk.h
+ * @brief   Fixed-size voxel chunk with palette compressed storage
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __VOXELCHUNK_H__
+#define __VOXELCHUNK_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Voxel material id, 0 is air
+typedef uint16_t Voxel;
+const Voxel VOXEL_AIR = 0;
+
+/**
+ * Cube of SIZE^3 voxels, stored in one of three ways:
+ *  - uniform: a single value for the whole chunk, no per-voxel storage (air, deep rock)
+ *  - paletted: the distinct values in a palette, and per-voxel palette indices bit-packed
+ *    at 1, 2, 4 or 8 bits so an index never straddles two words
+ *  - direct: more than 256 distinct values, voxels stored as 16-bit values
+ * The storage widens as new values are written. A paletted chunk drops back to uniform
+ * as soon as one value covers the whole chunk; a direct one keeps no per-value counts
+ * and only narrows through compact(). Voxel (x, y, z) is at index x + y*SIZE +
+ * z*SIZE*SIZE, the layout of NoiseFieldGenerator volumes.
+ */
+class VoxelChunk
+{
+	public:
+		static const int SIZE_BITS = 5;
+		static const int SIZE = 1 << SIZE_BITS;
+		static const size_t VOLUME = SIZE * SIZE * SIZE;
+
+		explicit VoxelChunk(Voxel fill = VOXEL_AIR);
+
+		inline static size_t index(int x, int y, int z) { return x | (y << SIZE_BITS) | (z << (2 * SIZE_BITS)); }
+
+		inline Voxel get(int x, int y, int z) const { return get(index(x, y, z)); }
+		inline void set(int x, int y, int z, Voxel voxel) { set(index(x, y, z), voxel); }
+
+		inline Voxel get(size_t index) const
+		{
+			if (m_bits == 0)
+				return m_uniform;
+			const size_t entry = readIndex(index);
+			return m_direct ? static_cast<Voxel>(entry) : m_palette[entry];
+		}
+		void set(size_t index, Voxel voxel);
+
+		// Replace the whole chunk with a single value
+		void fill(Voxel voxel);
+
+		// Bulk conversions from/to VOLUME voxels in index() order
+		void load(const Voxel* voxels);
+		void copyTo(Voxel* voxels) const;
+
+		// Rebuild the palette from the voxels actually present, narrowing the storage when possible
+		void compact();
+
+		inline bool isUniform() const { return m_bits == 0; }
+		inline bool isDirect() const { return m_direct; }
+		inline Voxel getUniformValue() const { return m_uniform; }
+		inline int getBitsPerVoxel() const { return m_bits; }
+		inline size_t getPaletteSize() const { return m_bits == 0 ? 1 : m_palette.size(); }
+
+		// Heap and object bytes held by this chunk
+		size_t getMemoryUsage() const;
+	private:
+		int m_bits;
+		int m_shift;   // log2 of the indices per word
+		bool m_direct;
+		Voxel m_uniform;
+
+		std::vector<Voxel> m_palette;
+		std::vector<uint32_t> m_counts;  // voxels referencing each palette entry, 0 means free slot
+		std::vector<uint64_t> m_words;
+
+		inline size_t readIndex(size_t index) const
+		{
+			const size_t mask = (size_t(1) << m_bits) - 1;
+			const size_t word = index >> m_shift;
+			const int offset = static_cast<int>(index & ((size_t(1) << m_shift) - 1)) * m_bits;
+			return static_cast<size_t>(m_words[word] >> offset) & mask;
+		}
+		inline void writeIndex(size_t index, size_t entry)
+		{
+			const uint64_t mask = (uint64_t(1) << m_bits) - 1;
+			const size_t word = index >> m_shift;
+			const int offset = static_cast<int>(index & ((size_t(1) << m_shift) - 1)) * m_bits;
+			m_words[word] = (m_words[word] & ~(mask << offset)) | (static_cast<uint64_t>(entry) << offset);
+		}
+
+		size_t paletteEntry(Voxel voxel);
+		void resize(int bits, bool direct);
+};
+#endif // __VOXELCHUNK_H__
@@ -0,0 +1,178 @@
+/**
+ * @file    VoxelRaycaster.cpp
+ * @brief   Voxel ray traversal over the chunk store for picking and line of sight
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "voxel/VoxelRaycaster.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static const int SIZE = VoxelChunk::SIZE;
+// Segments per parallelFor() index, enough to outweigh handing out the task
+static const size_t SEGMENT_BLOCK = 256;
+
+VoxelRaycaster::VoxelRaycaster(const ChunkStore& store) :
+	m_store(store)
+{
+
+}
+
+size_t VoxelRaycaster::lineOfSight(const Segment* segments, size_t count, uint8_t* visible, ThreadPool* pool) const
+{
+	auto block = [&](size_t index) {
+		Hit hit;
+		const size_t end = std::min(count, (index + 1) * SEGMENT_BLOCK);
+		for (size_t i = index * SEGMENT_BLOCK; i < end; i++)
+		{
+			// A hit in the voxel holding to, or one only reached at to (on a face of the
+			// voxel past it), does not block; a hit in the voxel holding from always does
+			const glm::dvec3& from = segments[i].from;
+			const glm::dvec3& to = segments[i].to;
+			const glm::dvec3 direction = to - from;
+			const double length = glm::length(direction);
+			const glm::ivec3 target(static_cast<int>(std::floor(to.x)), static_cast<int>(std::floor(to.y)), static_cast<int>(std::floor(to.z)));
+			visible[i] = !raycast(from, direction, length, hit) ||
+				(hit.normal != glm::ivec3(0) && (hit.cell == target || hit.distance >= length));
+		}
+	};
+
+	const size_t blocks = (count + SEGMENT_BLOCK - 1) / SEGMENT_BLOCK;
+	if (pool)
+		pool->parallelFor(blocks, block);
+	else
+		for (size_t i = 0; i < blocks; i++)
+			block(i);
+	return static_cast<size_t>(std::count(visible, visible + count, 1));
+}
+
+bool VoxelRaycaster::raycast(const glm::dvec3& origin, const glm::dvec3& direction, double maxDistance, Hit& hit) const
+{
+	const double length = glm::length(direction);
+	if (!(length > 0.0))
+		return false;
+
+	const glm::dvec3 d = direction / length;
+	glm::ivec3 step;
+	glm::dvec3 inverse;
+	for (int i = 0; i < 3; i++)
+	{
+		step[i] = d[i] > 0.0 ? 1 : d[i] < 0.0 ? -1 : 0;
+		inverse[i] = step[i] ? 1.0 / d[i] : std::numeric_limits<double>::infinity();
+	}
+
+	glm::ivec3 voxel(static_cast<int>(std::floor(origin.x)), static_cast<int>(std::floor(origin.y)), static_cast<int>(std::floor(origin.z)));
+	double t = 0.0;
+	int axis = -1;
+
+	auto report = [&](Voxel value) {
+		hit.cell = voxel;
+		hit.normal = glm::ivec3(0);
+		if (axis >= 0)
+			hit.normal[axis] = -step[axis];
+		hit.distance = t;
+		hit.voxel = value;
+		return true;
+	};
+
+	// Consecutive voxels mostly share a chunk
+	const auto& chunks = m_store.getChunks();
+	ChunkCoord lastCoord = { 0, 0, 0 };
+	const VoxelChunk* lastChunk = nullptr;
+	bool looked = false;
+
+	for (;;)
+	{
+		const ChunkCoord coord = ChunkStore::chunkOf(voxel.x, voxel.y, voxel.z);
+		if (!looked || coord != lastCoord)
+		{
+			auto it = chunks.find(coord);
+			lastChunk = it == chunks.end() ? nullptr : it->second.get();
+			lastCoord = coord;
+			looked = true;
+		}
+		const VoxelChunk* chunk = lastChunk;
+
+		if (chunk && chunk->isUniform() && chunk->getUniformValue() != VOXEL_AIR)
+			return report(chunk->getUniformValue());
+
+		const glm::ivec3 base(voxel.x & ~(SIZE - 1), voxel.y & ~(SIZE - 1), voxel.z & ~(SIZE - 1));
+		if (!chunk || chunk->isUniform())
+		{
+			// Leave through the nearest exit face. The voxel entered is found by clamping the
+			// exit point into the chunk so rounding cannot pick one outside of it; on a voxel
+			// boundary, moving down an axis enters the lower voxel.
+			double exit = std::numeric_limits<double>::infinity();
+			int next = -1;
+			for (int i = 0; i < 3; i++)
+			{
+				if (!step[i])
+					continue;
+				const double bound = (base[i] + (step[i] > 0 ? SIZE : 0) - origin[i]) * inverse[i];
+				if (bound < exit)
+				{
+					exit = bound;
+					next = i;
+				}
+			}
+			if (next < 0 || exit > maxDistance)
+				return false;
+
+			t = std::max(t, exit);
+			axis = next;
+			for (int i = 0; i < 3; i++)
+			{
+				if (i == next)
+					voxel[i] = step[i] > 0 ? base[i] + SIZE : base[i] - 1;
+				else
+				{
+					const double p = origin[i] + d[i] * t;
+					const int entered = static_cast<int>(step[i] < 0 ? std::ceil(p) - 1.0 : std::floor(p));
+					voxel[i] = std::min(std::max(entered, base[i]), base[i] + SIZE - 1);
+				}
+			}
+			continue;
+		}
+
+		// Voxel by voxel through the chunk
+		glm::dvec3 tMax, tDelta;
+		for (int i = 0; i < 3; i++)
+		{
+			tMax[i] = step[i] ? (voxel[i] + (step[i] > 0 ? 1 : 0) - origin[i]) * inverse[i] : std::numeric_limits<double>::infinity();
+			tDelta[i] = std::abs(inverse[i]);
+		}
+
+		for (;;)
+		{
+			const Voxel value = chunk->get(voxel.x & (SIZE - 1), voxel.y & (SIZE - 1), voxel.z & (SIZE - 1));
+			if (value != VOXEL_AIR)
+				return report(value);
+
+			const int next = tMax.x < tMax.y ? (tMax.x < tMax.z ? 0 : 2) : (tMax.y < tMax.z ? 1 : 2);
+			if (tMax[next] > maxDistance)
+				return false;
+			t = std::max(t, tMax[next]);
+			axis = next;
+			voxel[next] += step[next];
+			tMax[next] += tDelta[next];
+			if (static_cast<unsigned>(voxel[next] - base[next]) >= static_cast<unsigned>(SIZE))
+				break;
+		}
+	}
+}
@@ -0,0 +1,64 @@
+/**
+ * @file    VoxelRaycaster.h
+ * @brief   Voxel ray traversal over the chunk store for picking and line of sight
+ *
+ * Voxspatium, 3D game engine for creative space-themed games
+ * Copyright (C) 2021  Evert "Diamond" Prants <evert.prants@lunasqu.ee>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __VOXELRAYCASTER_H__
+#define __VOXELRAYCASTER_H__
+
+#include "util/Math3D.h"
+#include "util/ThreadPool.h"
+#include "voxel/ChunkStore.h"
+
+/**
+ * Amanatides-Woo voxel traversal over a ChunkStore, for picking and line of sight.
+ * Uniform chunks are the store's uniform regions: missing and air chunks are crossed
+ * in one step, and a solid one is a hit where the ray enters it, so only mixed chunks
+ * are walked voxel by voxel. Safe to use from several threads while the store is not
+ * modified.
+ */
+class VoxelRaycaster
+{
+	public:
+		struct Hit
+		{
+			glm::ivec3 cell;      // world voxel hit
+			glm::ivec3 normal;    // of the face entered through, zero when starting inside
+			double distance;      // along the ray, to where it enters the voxel
+			Voxel voxel;
+		};
+
+		struct Segment
+		{
+			glm::dvec3 from, to;
+		};
+
+		explicit VoxelRaycaster(const ChunkStore& store);
+
+		// First solid voxel along the ray within maxDistance, direction of any length
+		bool raycast(const glm::dvec3& origin, const glm::dvec3& direction, double maxDistance, Hit& hit) const;
+
+		// visible[i] is 1 when no solid voxel lies between the segment's ends, the voxel
+		// holding from included and the one holding to excluded (unless it is the same),
+		// so a target inside a solid voxel can be seen. Returns how many are visible.
+		// Spread over the pool in blocks of segments when there is one.
+		size_t lineOfSight(const Segment* segments, size_t count, uint8_t* visible, ThreadPool* pool = nullptr) const;
+	private:
+		const ChunkStore& m_store;
+};
+#endif // __VOXELRAYCASTER_H__